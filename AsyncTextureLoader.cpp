@@ -0,0 +1,303 @@
+//--------------------------------------------------------------------------------------
+// File: AsyncTextureLoader.cpp
+//
+// Background DDS texture loading. Worker threads do the file I/O, header parsing and
+// resource creation; Update() is the single point where upload copies are recorded and
+// submitted to the copy queue. Each request's future resolves at submission, and the
+// loader keeps the texture alive until its copy has completed.
+//--------------------------------------------------------------------------------------
+
+#include "AsyncTextureLoader.h"
+
+#include <exception>
+#include <string>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void ThrowIfFailed(HRESULT hr)
+	{
+		if (FAILED(hr))
+		{
+			throw std::exception();
+		}
+	}
+}
+
+struct AsyncTextureLoader::Request
+{
+	std::wstring						fileName;
+	size_t								maxsize;
+	DDS_LOADER_FLAGS					loadFlags;
+	std::promise<TextureLoadResult>		promise;
+
+	// Filled in by the worker
+	HRESULT								hr;
+	ComPtr<ID3D12Resource>				texture;
+	std::unique_ptr<uint8_t[]>			ddsData;
+	std::vector<D3D12_SUBRESOURCE_DATA>	subresources;
+	DDS_ALPHA_MODE						alphaMode;
+	DDS_CONVERSION						conversion;		// done by the upload copy
+	bool								generateMips;	// likewise
+
+	// Filled in at submission
+	UINT64								fenceValue;
+};
+
+AsyncTextureLoader::AsyncTextureLoader(ID3D12Device* device, UploadRingBuffer* uploadRing, ResourceStateManager* states,
+	unsigned int workerCount) :
+	m_device(device),
+	m_uploadRing(uploadRing),
+	m_states(states),
+	m_fenceValue(0),
+	m_fenceEvent(nullptr),
+	m_pending(0)
+{
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+
+	ThrowIfFailed(m_device->CreateFence(m_fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	ComPtr<ID3D12CommandAllocator> allocator;
+	ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)));
+	ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+	ThrowIfFailed(m_commandList->Close());
+	m_allocators.emplace_back(m_fenceValue, allocator);
+
+	m_workers.reset(new ThreadPool(workerCount));
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	// Joining the workers first means every request has reached m_ready, so Flush can
+	// submit all of them and nothing is released while the GPU still reads it. The pool
+	// itself stays until the members go, as the batch copies in Flush still use it.
+	m_workers->Shutdown();
+	Flush();
+
+	CloseHandle(m_fenceEvent);
+}
+
+TextureLoadFuture AsyncTextureLoader::LoadDDSFromFile(const wchar_t* fileName, size_t maxsize, DDS_LOADER_FLAGS loadFlags)
+{
+	auto request = std::make_shared<Request>();
+	request->fileName = fileName ? fileName : L"";
+	request->maxsize = maxsize;
+	request->loadFlags = loadFlags;
+	request->hr = E_PENDING;
+	request->alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+	request->conversion = DDS_CONVERSION_NONE;
+	request->generateMips = false;
+	request->fenceValue = 0;
+
+	TextureLoadFuture future = request->promise.get_future().share();
+
+	{
+		std::lock_guard<std::mutex> lock(m_readyMutex);
+		++m_pending;
+	}
+
+	ThreadPool* workers = m_workers.get();
+	workers->Enqueue([this, request, workers]()
+	{
+		request->hr = LoadDDSTextureFromFile12(m_device.Get(), request->fileName.c_str(),
+			request->texture, request->ddsData, request->subresources, request->maxsize, &request->alphaMode, &request->conversion,
+			&request->generateMips, request->loadFlags, workers);
+
+		{
+			std::lock_guard<std::mutex> lock(m_readyMutex);
+			m_ready.push_back(request);
+			--m_pending;
+		}
+		m_readyChanged.notify_all();
+	});
+
+	return future;
+}
+
+void AsyncTextureLoader::Update()
+{
+	m_releaseQueue.Collect();
+
+	std::vector<std::shared_ptr<Request>> ready;
+	{
+		std::lock_guard<std::mutex> lock(m_readyMutex);
+		ready.swap(m_ready);
+	}
+
+	if (!ready.empty())
+	{
+		Submit(ready);
+	}
+}
+
+void AsyncTextureLoader::Flush()
+{
+	for (;;)
+	{
+		Update();
+
+		std::unique_lock<std::mutex> lock(m_readyMutex);
+		if (m_pending == 0 && m_ready.empty())
+		{
+			break;
+		}
+
+		m_readyChanged.wait(lock, [this] { return !m_ready.empty() || m_pending == 0; });
+	}
+
+	WaitForFence(m_fenceValue);
+	m_releaseQueue.Collect();
+}
+
+void AsyncTextureLoader::QueueWait(ID3D12CommandQueue* queue, const TextureLoadResult& result) const
+{
+	if (queue && !IsUploadComplete(result))
+	{
+		ThrowIfFailed(queue->Wait(m_fence.Get(), result.fenceValue));
+	}
+}
+
+void AsyncTextureLoader::Submit(std::vector<std::shared_ptr<Request>>& ready)
+{
+	// Requests that failed on the worker resolve straight away
+	std::vector<std::shared_ptr<Request>> recorded;
+	std::vector<TextureUpload12> uploads;
+	for (auto& request : ready)
+	{
+		if (FAILED(request->hr))
+		{
+			Resolve(*request);
+			continue;
+		}
+
+		const TextureUpload12 upload = { request->texture.Get(), request->subresources.data(),
+			static_cast<UINT>(request->subresources.size()), request->conversion, request->generateMips };
+		uploads.push_back(upload);
+		recorded.push_back(request);
+	}
+
+	if (recorded.empty())
+	{
+		return;
+	}
+
+	// The whole set shares one upload heap and one pair of barrier batches
+	ComPtr<ID3D12CommandAllocator> allocator = AcquireAllocator(m_fence->GetCompletedValue());
+	ComPtr<ID3D12Resource> uploadHeap;
+
+	HRESULT hr = allocator ? m_commandList->Reset(allocator.Get(), nullptr) : E_OUTOFMEMORY;
+	if (SUCCEEDED(hr))
+	{
+		hr = UploadTextureBatch12(m_device.Get(), m_commandList.Get(), uploads.data(), uploads.size(), uploadHeap, m_uploadRing, m_workers.get(), m_states);
+
+		HRESULT hrClose = m_commandList->Close();
+		if (SUCCEEDED(hr))
+			hr = hrClose;
+	}
+
+	for (auto& request : recorded)
+	{
+		// The subresources now live in the upload heap, so the file contents can go
+		request->ddsData.reset();
+		request->subresources.clear();
+
+		if (FAILED(hr))
+		{
+			if (m_states)
+				m_states->Unregister(request->texture.Get());
+
+			request->hr = hr;
+			Resolve(*request);
+		}
+	}
+
+	if (FAILED(hr))
+	{
+		if (allocator)
+			m_allocators.emplace_back(m_fenceValue, allocator);
+		return;
+	}
+
+	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), ++m_fenceValue));
+
+	if (m_states)
+	{
+		m_states->Decay();
+	}
+
+	if (m_uploadRing)
+	{
+		m_uploadRing->Submit(m_fence.Get(), m_fenceValue);
+	}
+
+	// A batch the ring had no room for owns its upload heap until the copies have executed,
+	// and the textures stay alive until then whatever their owners do
+	m_releaseQueue.Enqueue(std::move(uploadHeap), m_fence.Get(), m_fenceValue);
+
+	for (auto& request : recorded)
+	{
+		m_releaseQueue.Enqueue(request->texture, m_fence.Get(), m_fenceValue);
+		request->fenceValue = m_fenceValue;
+		Resolve(*request);
+	}
+
+	m_allocators.emplace_back(m_fenceValue, allocator);
+}
+
+void AsyncTextureLoader::Resolve(Request& request)
+{
+	request.ddsData.reset();
+	request.subresources.clear();
+
+	if (FAILED(request.hr))
+	{
+		request.texture = nullptr;
+		request.alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+		request.fenceValue = 0;
+	}
+
+	TextureLoadResult result = { request.hr, request.texture, request.alphaMode, request.fenceValue };
+	request.promise.set_value(result);
+}
+
+void AsyncTextureLoader::WaitForFence(UINT64 value)
+{
+	if (m_fence->GetCompletedValue() < value)
+	{
+		ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_fenceEvent));
+		WaitForSingleObject(m_fenceEvent, INFINITE);
+	}
+}
+
+ComPtr<ID3D12CommandAllocator> AsyncTextureLoader::AcquireAllocator(UINT64 completedValue)
+{
+	for (auto it = m_allocators.begin(); it != m_allocators.end(); ++it)
+	{
+		if (it->first <= completedValue)
+		{
+			ComPtr<ID3D12CommandAllocator> allocator = it->second;
+			m_allocators.erase(it);
+			return SUCCEEDED(allocator->Reset()) ? allocator : nullptr;
+		}
+	}
+
+	ComPtr<ID3D12CommandAllocator> allocator;
+	if (FAILED(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator))))
+	{
+		return nullptr;
+	}
+
+	return allocator;
+}
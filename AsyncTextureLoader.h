@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------
+// File: AsyncTextureLoader.h
+//
+// Background DDS texture loading. Worker threads do the file I/O, header parsing and
+// resource creation; Update() is the single point where upload copies are recorded and
+// submitted, to the loader's own copy queue so they never hold up rendering. Each
+// request's future resolves at submission with the copy fence value the texture is
+// ready at; a frame that uses it waits for just that value, on the GPU or the CPU.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "DDSTextureLoader.h"
+#include "DeferredReleaseQueue.h"
+#include "ResourceStateManager.h"
+#include "ThreadPool.h"
+#include "UploadRingBuffer.h"
+
+namespace DirectX
+{
+	struct TextureLoadResult
+	{
+		HRESULT									hr;
+		Microsoft::WRL::ComPtr<ID3D12Resource>	texture;	// COMMON, promoted to PIXEL_SHADER_RESOURCE on first use
+		DDS_ALPHA_MODE							alphaMode;
+		UINT64									fenceValue;	// On the copy fence; 0 if the load failed
+	};
+
+	typedef std::shared_future<TextureLoadResult> TextureLoadFuture;
+
+	class AsyncTextureLoader
+	{
+	public:
+		// Uploads are staged through uploadRing when one is given; it must outlive the loader.
+		// Likewise states: the textures are registered with it in COMMON as they are
+		// uploaded, so the frame's transitions of them start from there. The caller
+		// unregisters them before releasing them.
+		AsyncTextureLoader(_In_ ID3D12Device* device, _In_opt_ UploadRingBuffer* uploadRing = nullptr,
+			_In_opt_ ResourceStateManager* states = nullptr, unsigned int workerCount = 0);
+		~AsyncTextureLoader();
+
+		AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+		AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+		// Queues a load; safe to call from any thread. FORCE_SRGB, COMPRESS_BC and
+		// FOOTPRINT_CACHE apply. The BC encoder and DDSZ unpacking spread over the worker pool.
+		TextureLoadFuture LoadDDSFromFile(_In_z_ const wchar_t* fileName, size_t maxsize = 0,
+			DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT);
+
+		// Uploads everything the workers have finished preparing as one batch in a single
+		// command list, and resolves those requests. Call it from the thread that submits
+		// frames, e.g. once per frame.
+		void Update();
+
+		// Blocks until every queued request has been uploaded and its copy has completed.
+		void Flush();
+
+		// Makes queue wait on the GPU until the texture's copy has completed, so the next
+		// command lists executed on it can use the texture. Only that copy is waited for, and
+		// nothing at all once it has completed.
+		void QueueWait(_In_ ID3D12CommandQueue* queue, const TextureLoadResult& result) const;
+
+		// Whether the texture can be used without a wait
+		bool IsUploadComplete(const TextureLoadResult& result) const { return m_fence->GetCompletedValue() >= result.fenceValue; }
+
+		ID3D12Fence* GetFence() const { return m_fence.Get(); }
+
+	private:
+		struct Request;
+
+		void Submit(std::vector<std::shared_ptr<Request>>& ready);
+		void Resolve(Request& request);
+		void WaitForFence(UINT64 value);
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> AcquireAllocator(UINT64 completedValue);
+
+		Microsoft::WRL::ComPtr<ID3D12Device>				m_device;
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue>			m_commandQueue;
+		UploadRingBuffer*									m_uploadRing;
+		ResourceStateManager*								m_states;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_commandList;
+		Microsoft::WRL::ComPtr<ID3D12Fence>					m_fence;
+		UINT64												m_fenceValue;
+		HANDLE												m_fenceEvent;
+
+		// Each allocator is reusable once the fence value it was submitted with completes
+		std::vector<std::pair<UINT64, Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>> m_allocators;
+
+		std::mutex								m_readyMutex;
+		std::condition_variable					m_readyChanged;
+		std::vector<std::shared_ptr<Request>>	m_ready;		// prepared by a worker, not yet submitted
+		unsigned int							m_pending;		// still queued or running on a worker
+
+		DeferredReleaseQueue					m_releaseQueue;	// textures and dedicated upload heaps of submitted batches
+
+		std::unique_ptr<ThreadPool>				m_workers;		// file loads, plus the upload copies of large batches
+	};
+}
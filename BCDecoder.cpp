@@ -0,0 +1,761 @@
+//--------------------------------------------------------------------------------------
+// File: BCDecoder.cpp
+//
+// Block decoders follow the D3D11 functional specification. BC1-BC5 palettes are built
+// with integer rounding; BC7 endpoints are blended for all 64 channels of a block at
+// once with SSE2 or NEON. Blocks decode to 8 bits per channel first, and 16F output
+// widens those through lookup tables.
+//--------------------------------------------------------------------------------------
+
+#include "BCDecoder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BCDEC_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define BCDEC_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// Below this many destination bytes a mip is decoded on the calling thread
+	const size_t PARALLEL_DECODE_THRESHOLD = 256 * 1024;
+	const uint32_t DECODE_BAND_BLOCK_ROWS = 8;
+
+	enum BLOCK_KIND
+	{
+		BLOCK_UNKNOWN = 0,
+		BLOCK_BC1,
+		BLOCK_BC2,
+		BLOCK_BC3,
+		BLOCK_BC4_UNORM,
+		BLOCK_BC4_SNORM,
+		BLOCK_BC5_UNORM,
+		BLOCK_BC5_SNORM,
+		BLOCK_BC7,
+	};
+
+	BLOCK_KIND GetBlockKind(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return BLOCK_BC1;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			return BLOCK_BC2;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return BLOCK_BC3;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+			return BLOCK_BC4_UNORM;
+
+		case DXGI_FORMAT_BC4_SNORM:
+			return BLOCK_BC4_SNORM;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+			return BLOCK_BC5_UNORM;
+
+		case DXGI_FORMAT_BC5_SNORM:
+			return BLOCK_BC5_SNORM;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return BLOCK_BC7;
+
+		default:
+			return BLOCK_UNKNOWN;
+		}
+	}
+
+	inline bool IsSigned(BLOCK_KIND kind)
+	{
+		return kind == BLOCK_BC4_SNORM || kind == BLOCK_BC5_SNORM;
+	}
+
+	inline size_t GetBlockBytes(BLOCK_KIND kind)
+	{
+		return (kind == BLOCK_BC1 || kind == BLOCK_BC4_UNORM || kind == BLOCK_BC4_SNORM) ? 8 : 16;
+	}
+
+	inline uint16_t Load16(const uint8_t* p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+	inline uint32_t Load32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+	inline uint64_t Load64(const uint8_t* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	// 16 pixels, row-major, four channels each. SNORM blocks hold two's complement bytes.
+	typedef uint8_t BlockPixels[16][4];
+
+
+	//----------------------------------------------------------------------------------
+	// BC1-BC5
+	//----------------------------------------------------------------------------------
+
+	void Expand565(uint16_t c, uint8_t rgba[4])
+	{
+		const uint32_t r = (c >> 11) & 0x1f;
+		const uint32_t g = (c >> 5) & 0x3f;
+		const uint32_t b = c & 0x1f;
+		rgba[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+		rgba[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+		rgba[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+		rgba[3] = 255;
+	}
+
+	// BC2 and BC3 always use four colors, whatever the endpoint order
+	void DecodeColorBlock(const uint8_t* src, bool allowTransparent, BlockPixels out)
+	{
+		const uint16_t c0 = Load16(src);
+		const uint16_t c1 = Load16(src + 2);
+		const uint32_t indices = Load32(src + 4);
+
+		uint8_t palette[4][4];
+		Expand565(c0, palette[0]);
+		Expand565(c1, palette[1]);
+
+		if (c0 > c1 || !allowTransparent)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+				palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+			}
+			palette[2][3] = 255;
+			palette[3][3] = 255;
+		}
+		else
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c] + 1) / 2);
+			}
+			palette[2][3] = 255;
+			memset(palette[3], 0, 4);
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			memcpy(out[i], palette[(indices >> (2 * i)) & 3], 4);
+		}
+	}
+
+	// Rounds a / d to nearest, halves away from zero
+	inline int DivideRound(int a, int d)
+	{
+		return (a >= 0) ? (a + d / 2) / d : -((-a + d / 2) / d);
+	}
+
+	// One BC4 channel into byte c of every pixel
+	void DecodeChannelBlock(const uint8_t* src, bool isSigned, BlockPixels out, int c)
+	{
+		int palette[8];
+		if (isSigned)
+		{
+			// -128 is an alias of -127
+			palette[0] = std::max<int>(static_cast<int8_t>(src[0]), -127);
+			palette[1] = std::max<int>(static_cast<int8_t>(src[1]), -127);
+		}
+		else
+		{
+			palette[0] = src[0];
+			palette[1] = src[1];
+		}
+
+		if (palette[0] > palette[1])
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = DivideRound((7 - i) * palette[0] + i * palette[1], 7);
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = DivideRound((5 - i) * palette[0] + i * palette[1], 5);
+			palette[6] = isSigned ? -127 : 0;
+			palette[7] = isSigned ? 127 : 255;
+		}
+
+		// 48 bits of 3-bit indices
+		const uint64_t indices = Load64(src) >> 16;
+		for (int i = 0; i < 16; ++i)
+		{
+			out[i][c] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	void DecodeExplicitAlpha(const uint8_t* src, BlockPixels out)
+	{
+		const uint64_t alpha = Load64(src);
+		for (int i = 0; i < 16; ++i)
+		{
+			out[i][3] = static_cast<uint8_t>(((alpha >> (4 * i)) & 0xf) * 17);
+		}
+	}
+
+
+	//----------------------------------------------------------------------------------
+	// BC7
+	//----------------------------------------------------------------------------------
+
+	struct BC7ModeInfo
+	{
+		uint8_t subsets;
+		uint8_t partitionBits;
+		uint8_t rotationBits;
+		uint8_t indexSelectionBits;
+		uint8_t colorBits;
+		uint8_t alphaBits;
+		uint8_t endpointPBits;      // One per endpoint
+		uint8_t sharedPBits;        // One per subset
+		uint8_t indexBits;
+		uint8_t indexBits2;         // Second index set of modes 4 and 5
+	};
+
+	const BC7ModeInfo g_BC7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	// Bit i is the subset of pixel i
+	const uint16_t g_BC7Partitions2[64] =
+	{
+		0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+		0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+		0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+		0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+		0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+		0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+		0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+		0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+	};
+
+	// Bits 2i and 2i + 1 are the subset of pixel i
+	const uint32_t g_BC7Partitions3[64] =
+	{
+		0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+		0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+		0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+		0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+		0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+		0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+		0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+		0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+	};
+
+	// Anchor pixels of subset 1 (two subsets), and of subsets 1 and 2 (three subsets).
+	// Subset 0 always anchors at pixel 0. An anchor's index drops its top bit.
+	const uint8_t g_BC7Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+	};
+
+	const uint8_t g_BC7Anchors3[2][64] =
+	{
+		{
+			 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+			 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+			 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+			 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+		},
+		{
+			15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+			15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+			15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+			15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+		},
+	};
+
+	const uint8_t g_BC7Weights2[4] = { 0, 21, 43, 64 };
+	const uint8_t g_BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint8_t g_BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	inline const uint8_t* GetBC7Weights(uint32_t indexBits)
+	{
+		return (indexBits == 2) ? g_BC7Weights2 : (indexBits == 3) ? g_BC7Weights3 : g_BC7Weights4;
+	}
+
+	class BlockBits
+	{
+	public:
+		explicit BlockBits(const uint8_t* block) : m_low(Load64(block)), m_high(Load64(block + 8)), m_pos(0) {}
+
+		// count is at most 8
+		uint32_t Read(uint32_t count)
+		{
+			uint64_t bits;
+			if (m_pos >= 64)
+				bits = m_high >> (m_pos - 64);
+			else if (m_pos + count <= 64)
+				bits = m_low >> m_pos;
+			else
+				bits = (m_low >> m_pos) | (m_high << (64 - m_pos));
+
+			m_pos += count;
+			return static_cast<uint32_t>(bits) & ((1u << count) - 1);
+		}
+
+	private:
+		uint64_t m_low;
+		uint64_t m_high;
+		uint32_t m_pos;
+	};
+
+	// Widens an n-bit endpoint to 8 bits by repeating its top bits
+	inline uint16_t ExpandBits(uint32_t value, uint32_t bits)
+	{
+		value <<= (8 - bits);
+		return static_cast<uint16_t>(value | (value >> bits));
+	}
+
+	// out = ((64 - w) * e0 + w * e1 + 32) >> 6 for 64 channels
+	void BlendEndpoints(const uint16_t e0[64], const uint16_t e1[64], const uint16_t weights[64], uint8_t* out)
+	{
+#if defined(BCDEC_SSE2)
+		const __m128i full = _mm_set1_epi16(64);
+		const __m128i round = _mm_set1_epi16(32);
+		for (int i = 0; i < 64; i += 16)
+		{
+			__m128i v[2];
+			for (int j = 0; j < 2; ++j)
+			{
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e0 + i + j * 8));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e1 + i + j * 8));
+				const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i + j * 8));
+				const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(full, w), a), _mm_mullo_epi16(w, b));
+				v[j] = _mm_srli_epi16(_mm_add_epi16(sum, round), 6);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v[0], v[1]));
+		}
+#elif defined(BCDEC_NEON)
+		const uint16x8_t full = vdupq_n_u16(64);
+		for (int i = 0; i < 64; i += 8)
+		{
+			const uint16x8_t a = vld1q_u16(e0 + i);
+			const uint16x8_t b = vld1q_u16(e1 + i);
+			const uint16x8_t w = vld1q_u16(weights + i);
+			const uint16x8_t sum = vmlaq_u16(vmulq_u16(vsubq_u16(full, w), a), w, b);
+			vst1_u8(out + i, vmovn_u16(vrshrq_n_u16(sum, 6)));
+		}
+#else
+		for (int i = 0; i < 64; ++i)
+		{
+			out[i] = static_cast<uint8_t>(((64 - weights[i]) * e0[i] + weights[i] * e1[i] + 32) >> 6);
+		}
+#endif
+	}
+
+	void DecodeBC7Block(const uint8_t* src, BlockPixels out)
+	{
+		// A block with no mode bit set is reserved and decodes to transparent black
+		if (!src[0])
+		{
+			memset(out, 0, sizeof(BlockPixels));
+			return;
+		}
+
+		uint32_t mode = 0;
+		while (mode < 7 && !(src[0] & (1u << mode)))
+			++mode;
+
+		const BC7ModeInfo& info = g_BC7Modes[mode];
+		BlockBits bits(src);
+		bits.Read(mode + 1);
+
+		const uint32_t partition = bits.Read(info.partitionBits);
+		const uint32_t rotation = bits.Read(info.rotationBits);
+		const uint32_t indexSelection = bits.Read(info.indexSelectionBits);
+
+		// [subset][endpoint][channel]
+		uint32_t endpoints[3][2][4] = {};
+		for (int c = 0; c < 3; ++c)
+		{
+			for (uint32_t s = 0; s < info.subsets; ++s)
+			{
+				endpoints[s][0][c] = bits.Read(info.colorBits);
+				endpoints[s][1][c] = bits.Read(info.colorBits);
+			}
+		}
+		if (info.alphaBits)
+		{
+			for (uint32_t s = 0; s < info.subsets; ++s)
+			{
+				endpoints[s][0][3] = bits.Read(info.alphaBits);
+				endpoints[s][1][3] = bits.Read(info.alphaBits);
+			}
+		}
+
+		uint32_t pbits[3][2] = {};
+		const bool hasPBits = info.endpointPBits || info.sharedPBits;
+		for (uint32_t s = 0; s < info.subsets; ++s)
+		{
+			if (info.endpointPBits)
+			{
+				pbits[s][0] = bits.Read(1);
+				pbits[s][1] = bits.Read(1);
+			}
+			else if (info.sharedPBits)
+			{
+				pbits[s][0] = pbits[s][1] = bits.Read(1);
+			}
+		}
+
+		uint16_t palette[3][2][4];
+		for (uint32_t s = 0; s < info.subsets; ++s)
+		{
+			for (int e = 0; e < 2; ++e)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					palette[s][e][c] = hasPBits
+						? ExpandBits((endpoints[s][e][c] << 1) | pbits[s][e], info.colorBits + 1u)
+						: ExpandBits(endpoints[s][e][c], info.colorBits);
+				}
+
+				if (!info.alphaBits)
+					palette[s][e][3] = 255;
+				else if (hasPBits)
+					palette[s][e][3] = ExpandBits((endpoints[s][e][3] << 1) | pbits[s][e], info.alphaBits + 1u);
+				else
+					palette[s][e][3] = ExpandBits(endpoints[s][e][3], info.alphaBits);
+			}
+		}
+
+		uint8_t subsetOf[16];
+		bool anchor[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			if (info.subsets == 2)
+				subsetOf[i] = static_cast<uint8_t>((g_BC7Partitions2[partition] >> i) & 1);
+			else if (info.subsets == 3)
+				subsetOf[i] = static_cast<uint8_t>((g_BC7Partitions3[partition] >> (2 * i)) & 3);
+			else
+				subsetOf[i] = 0;
+
+			anchor[i] = (i == 0)
+				|| (info.subsets == 2 && i == g_BC7Anchors2[partition])
+				|| (info.subsets == 3 && (i == g_BC7Anchors3[0][partition] || i == g_BC7Anchors3[1][partition]));
+		}
+
+		uint32_t indices[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			indices[i] = bits.Read(info.indexBits - (anchor[i] ? 1u : 0u));
+		}
+
+		// Modes 4 and 5 weight color and alpha separately; the selection bit swaps the sets
+		const uint8_t* colorWeights = GetBC7Weights(info.indexBits);
+		const uint8_t* alphaWeights = colorWeights;
+		uint32_t indices2[16];
+		const uint32_t* colorIndices = indices;
+		const uint32_t* alphaIndices = indices;
+		if (info.indexBits2)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				indices2[i] = bits.Read(info.indexBits2 - (i == 0 ? 1u : 0u));
+			}
+
+			alphaIndices = indices2;
+			alphaWeights = GetBC7Weights(info.indexBits2);
+			if (indexSelection)
+			{
+				std::swap(colorIndices, alphaIndices);
+				std::swap(colorWeights, alphaWeights);
+			}
+		}
+
+		uint16_t e0[64];
+		uint16_t e1[64];
+		uint16_t weights[64];
+		for (int i = 0; i < 16; ++i)
+		{
+			const uint32_t s = subsetOf[i];
+			for (int c = 0; c < 4; ++c)
+			{
+				e0[i * 4 + c] = palette[s][0][c];
+				e1[i * 4 + c] = palette[s][1][c];
+			}
+
+			weights[i * 4 + 0] = weights[i * 4 + 1] = weights[i * 4 + 2] = colorWeights[colorIndices[i]];
+			weights[i * 4 + 3] = alphaWeights[alphaIndices[i]];
+		}
+
+		BlendEndpoints(e0, e1, weights, &out[0][0]);
+
+		// Rotation swaps alpha with red, green or blue after interpolation
+		if (rotation)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				std::swap(out[i][3], out[i][rotation - 1]);
+			}
+		}
+	}
+
+
+	//----------------------------------------------------------------------------------
+	void DecodeBlock(BLOCK_KIND kind, const uint8_t* src, BlockPixels out)
+	{
+		switch (kind)
+		{
+		case BLOCK_BC1:
+			DecodeColorBlock(src, true, out);
+			break;
+
+		case BLOCK_BC2:
+			DecodeColorBlock(src + 8, false, out);
+			DecodeExplicitAlpha(src, out);
+			break;
+
+		case BLOCK_BC3:
+			DecodeColorBlock(src + 8, false, out);
+			DecodeChannelBlock(src, false, out, 3);
+			break;
+
+		case BLOCK_BC4_UNORM:
+		case BLOCK_BC4_SNORM:
+			for (int i = 0; i < 16; ++i)
+			{
+				out[i][1] = out[i][2] = 0;
+				out[i][3] = (kind == BLOCK_BC4_SNORM) ? 127 : 255;
+			}
+			DecodeChannelBlock(src, kind == BLOCK_BC4_SNORM, out, 0);
+			break;
+
+		case BLOCK_BC5_UNORM:
+		case BLOCK_BC5_SNORM:
+			for (int i = 0; i < 16; ++i)
+			{
+				out[i][2] = 0;
+				out[i][3] = (kind == BLOCK_BC5_SNORM) ? 127 : 255;
+			}
+			DecodeChannelBlock(src, kind == BLOCK_BC5_SNORM, out, 0);
+			DecodeChannelBlock(src + 8, kind == BLOCK_BC5_SNORM, out, 1);
+			break;
+
+		case BLOCK_BC7:
+			DecodeBC7Block(src, out);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+
+	//----------------------------------------------------------------------------------
+	// 16F output
+	//----------------------------------------------------------------------------------
+
+	// Exact for zero and for normal halves, which covers every value the tables hold
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		if (!(bits & 0x7fffffff))
+			return static_cast<uint16_t>(sign);
+
+		const uint32_t exponent = ((bits >> 23) & 0xff) - 127 + 15;
+		const uint32_t mantissa = bits & 0x7fffff;
+
+		// Round to nearest even; a carry out of the mantissa bumps the exponent
+		uint32_t half = (exponent << 10) | (mantissa >> 13);
+		const uint32_t rest = mantissa & 0x1fff;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			++half;
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	struct HalfTables
+	{
+		uint16_t unorm[256];
+		uint16_t srgb[256];
+		uint16_t snorm[256];    // Indexed by the two's complement byte
+
+		HalfTables()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const float c = i / 255.0f;
+				unorm[i] = FloatToHalf(c);
+				srgb[i] = FloatToHalf((c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f));
+				snorm[i] = FloatToHalf(std::max(static_cast<int8_t>(i), static_cast<int8_t>(-127)) / 127.0f);
+			}
+		}
+	};
+
+	const HalfTables& GetHalfTables()
+	{
+		static const HalfTables s_tables;
+		return s_tables;
+	}
+
+
+	//----------------------------------------------------------------------------------
+	struct DecodeJob
+	{
+		BLOCK_KIND          kind;
+		const uint8_t*      src;
+		size_t              srcRowPitch;
+		uint32_t            width;
+		uint32_t            height;
+		uint8_t*            dest;
+		size_t              destRowPitch;
+		const uint16_t*     halfTable;      // Null for 8-bit output
+		bool                linearAlpha;    // Alpha goes through the unorm table even when color is sRGB
+	};
+
+	void StoreBlock(const DecodeJob& job, const BlockPixels pixels, uint32_t bx, uint32_t by)
+	{
+		const uint32_t columns = std::min(4u, job.width - bx * 4);
+		const uint32_t rows = std::min(4u, job.height - by * 4);
+		const size_t bytesPerPixel = job.halfTable ? 8 : 4;
+
+		for (uint32_t y = 0; y < rows; ++y)
+		{
+			uint8_t* row = job.dest + job.destRowPitch * (by * 4 + y) + size_t(bx) * 4 * bytesPerPixel;
+			if (!job.halfTable)
+			{
+				memcpy(row, pixels[y * 4], columns * 4);
+				continue;
+			}
+
+			const uint16_t* alphaTable = job.linearAlpha ? GetHalfTables().unorm : job.halfTable;
+			for (uint32_t x = 0; x < columns; ++x)
+			{
+				const uint8_t* p = pixels[y * 4 + x];
+				const uint16_t half[4] = { job.halfTable[p[0]], job.halfTable[p[1]], job.halfTable[p[2]], alphaTable[p[3]] };
+				memcpy(row + x * 8, half, sizeof(half));
+			}
+		}
+	}
+
+	void DecodeBlockRows(const DecodeJob& job, uint32_t firstRow, uint32_t lastRow)
+	{
+		const uint32_t blocksWide = (job.width + 3) / 4;
+		const size_t blockBytes = GetBlockBytes(job.kind);
+
+		BlockPixels pixels;
+		for (uint32_t by = firstRow; by < lastRow; ++by)
+		{
+			const uint8_t* block = job.src + job.srcRowPitch * by;
+			for (uint32_t bx = 0; bx < blocksWide; ++bx, block += blockBytes)
+			{
+				DecodeBlock(job.kind, block, pixels);
+				StoreBlock(job, pixels, bx, by);
+			}
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsBCDecodeSupported(DXGI_FORMAT bcFormat, DXGI_FORMAT destFormat)
+{
+	const BLOCK_KIND kind = GetBlockKind(bcFormat);
+	if (kind == BLOCK_UNKNOWN)
+		return false;
+
+	switch (destFormat)
+	{
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		return true;
+
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+		return IsSigned(kind);
+
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		return !IsSigned(kind);
+
+	default:
+		return false;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::DecodeBC(DXGI_FORMAT bcFormat,
+	const uint8_t* src,
+	size_t srcRowPitch,
+	uint32_t width,
+	uint32_t height,
+	DXGI_FORMAT destFormat,
+	uint8_t* dest,
+	size_t destRowPitch,
+	ThreadPool* pool)
+{
+	if (!src || !dest || !IsBCDecodeSupported(bcFormat, destFormat))
+		return false;
+
+	if (!width || !height)
+		return true;
+
+	DecodeJob job;
+	job.kind = GetBlockKind(bcFormat);
+	job.src = src;
+	job.srcRowPitch = srcRowPitch;
+	job.width = width;
+	job.height = height;
+	job.dest = dest;
+	job.destRowPitch = destRowPitch;
+	job.halfTable = nullptr;
+	job.linearAlpha = false;
+
+	if (destFormat == DXGI_FORMAT_R16G16B16A16_FLOAT)
+	{
+		const HalfTables& tables = GetHalfTables();
+		const bool srgb = (bcFormat == DXGI_FORMAT_BC1_UNORM_SRGB || bcFormat == DXGI_FORMAT_BC2_UNORM_SRGB
+			|| bcFormat == DXGI_FORMAT_BC3_UNORM_SRGB || bcFormat == DXGI_FORMAT_BC7_UNORM_SRGB);
+
+		job.halfTable = IsSigned(job.kind) ? tables.snorm : srgb ? tables.srgb : tables.unorm;
+		job.linearAlpha = srgb;
+	}
+
+	const uint32_t blocksHigh = (height + 3) / 4;
+	const size_t destBytes = size_t(width) * height * (job.halfTable ? 8 : 4);
+
+	if (!pool || destBytes < PARALLEL_DECODE_THRESHOLD)
+	{
+		DecodeBlockRows(job, 0, blocksHigh);
+		return true;
+	}
+
+	const size_t bands = (blocksHigh + DECODE_BAND_BLOCK_ROWS - 1) / DECODE_BAND_BLOCK_ROWS;
+	pool->ParallelFor(bands, [&job, blocksHigh](size_t band)
+	{
+		const uint32_t first = static_cast<uint32_t>(band) * DECODE_BAND_BLOCK_ROWS;
+		DecodeBlockRows(job, first, std::min(first + DECODE_BAND_BLOCK_ROWS, blocksHigh));
+	});
+
+	return true;
+}
@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------------------
+// File: BCDecoder.h
+//
+// CPU decoder for the block-compressed formats BC1-BC5 and BC7, for software fallback,
+// thumbnails and validating GPU output. Like DDSLayout it needs no device or windows.h,
+// so a mip described by ParseDDS can be decoded straight from the file data.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DirectX
+{
+	class ThreadPool;
+
+	// True when DecodeBC can turn bcFormat into destFormat:
+	//  - UNORM, _SRGB and TYPELESS sources go to R8G8B8A8_UNORM or R8G8B8A8_UNORM_SRGB
+	//    unchanged, or to R16G16B16A16_FLOAT (linearized for _SRGB sources)
+	//  - BC4_SNORM and BC5_SNORM go to R8G8B8A8_SNORM or R16G16B16A16_FLOAT
+	bool IsBCDecodeSupported(DXGI_FORMAT bcFormat, DXGI_FORMAT destFormat);
+
+	// Decodes one width x height mip. src holds the blocks with srcRowPitch bytes per row of
+	// blocks (DDSSubresourceLayout::rowPitch); dest receives width x height pixels. Missing
+	// channels read as 0, and alpha as 1. Rows of blocks are spread over pool when the mip
+	// is large enough. Returns false for an unsupported format pair or a null pointer.
+	bool DecodeBC(DXGI_FORMAT bcFormat,
+	              const uint8_t* src,
+	              size_t srcRowPitch,
+	              uint32_t width,
+	              uint32_t height,
+	              DXGI_FORMAT destFormat,
+	              uint8_t* dest,
+	              size_t destRowPitch,
+	              ThreadPool* pool = nullptr);
+}
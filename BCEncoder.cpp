@@ -0,0 +1,642 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.cpp
+//
+// Both encoders follow the same steps. They fit a line through the block's colors,
+// quantize its ends to the format's endpoints, and pick each pixel's nearest palette
+// entry. BC_ENCODE_HIGH then refits the endpoints by least squares against those
+// indices and keeps the refit while it lowers the squared error. Palettes are built
+// exactly as BCDecoder builds them.
+//--------------------------------------------------------------------------------------
+
+#include "BCEncoder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Images with fewer blocks than this are encoded on the calling thread
+	const uint32_t PARALLEL_ENCODE_BLOCKS = 1024;
+	const uint32_t ENCODE_BAND_BLOCK_ROWS = 4;
+
+	const int REFINE_PASSES = 2;
+
+	enum SOURCE_LAYOUT
+	{
+		SOURCE_UNKNOWN = 0,
+		SOURCE_RGBA,
+		SOURCE_BGRA,
+		SOURCE_BGRX,
+	};
+
+	SOURCE_LAYOUT GetSourceLayout(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			return SOURCE_RGBA;
+
+		case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			return SOURCE_BGRA;
+
+		case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return SOURCE_BGRX;
+
+		default:
+			return SOURCE_UNKNOWN;
+		}
+	}
+
+	bool IsBC1(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC1_TYPELESS || format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB;
+	}
+
+	bool IsBC7(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC7_TYPELESS || format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB;
+	}
+
+	// 16 pixels in RGBA order
+	typedef uint8_t BlockPixels[16][4];
+
+	void LoadBlock(SOURCE_LAYOUT layout, const uint8_t* src, size_t srcRowPitch,
+		uint32_t width, uint32_t height, uint32_t bx, uint32_t by, BlockPixels out)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint8_t* row = src + srcRowPitch * std::min(by * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint8_t* p = row + size_t(std::min(bx * 4 + x, width - 1)) * 4;
+				uint8_t* q = out[y * 4 + x];
+				if (layout == SOURCE_RGBA)
+				{
+					memcpy(q, p, 4);
+				}
+				else
+				{
+					q[0] = p[2];
+					q[1] = p[1];
+					q[2] = p[0];
+					q[3] = (layout == SOURCE_BGRX) ? 255 : p[3];
+				}
+			}
+		}
+	}
+
+
+	//----------------------------------------------------------------------------------
+	// Line fitting shared by both formats; channels is 3 for BC1 and 4 for BC7
+	//----------------------------------------------------------------------------------
+
+	// Endpoints at the extremes of the block's projection onto its principal axis. The
+	// fast path takes the axis from the bounding box, flipping channels that fall as the
+	// widest one rises; the high-quality path runs power iteration on the covariance.
+	void FitLine(const BlockPixels pixels, int channels, BC_ENCODE_QUALITY quality, float e0[4], float e1[4])
+	{
+		float mean[4] = {};
+		float lo[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float hi[4] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < channels; ++c)
+			{
+				const float v = pixels[i][c];
+				mean[c] += v;
+				lo[c] = std::min(lo[c], v);
+				hi[c] = std::max(hi[c], v);
+			}
+		}
+		for (int c = 0; c < channels; ++c)
+			mean[c] /= 16.0f;
+
+		float cov[4][4] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			float d[4];
+			for (int c = 0; c < channels; ++c)
+				d[c] = pixels[i][c] - mean[c];
+
+			for (int c = 0; c < channels; ++c)
+				for (int k = c; k < channels; ++k)
+					cov[c][k] += d[c] * d[k];
+		}
+		for (int c = 0; c < channels; ++c)
+			for (int k = 0; k < c; ++k)
+				cov[c][k] = cov[k][c];
+
+		int widest = 0;
+		for (int c = 1; c < channels; ++c)
+		{
+			if (hi[c] - lo[c] > hi[widest] - lo[widest])
+				widest = c;
+		}
+
+		float axis[4] = {};
+		for (int c = 0; c < channels; ++c)
+			axis[c] = (cov[widest][c] < 0.0f) ? lo[c] - hi[c] : hi[c] - lo[c];
+
+		if (quality == BC_ENCODE_HIGH)
+		{
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[4] = {};
+				float length = 0.0f;
+				for (int c = 0; c < channels; ++c)
+				{
+					for (int k = 0; k < channels; ++k)
+						next[c] += cov[c][k] * axis[k];
+					length = std::max(length, fabsf(next[c]));
+				}
+
+				// A flat block has no axis; keep the bounding box one
+				if (length < 1e-6f)
+					break;
+
+				for (int c = 0; c < channels; ++c)
+					axis[c] = next[c] / length;
+			}
+		}
+
+		float length2 = 0.0f;
+		for (int c = 0; c < channels; ++c)
+			length2 += axis[c] * axis[c];
+
+		if (length2 < 1e-6f)
+		{
+			for (int c = 0; c < channels; ++c)
+				e0[c] = e1[c] = mean[c];
+			return;
+		}
+
+		float tmin = 0.0f;
+		float tmax = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channels; ++c)
+				t += (pixels[i][c] - mean[c]) * axis[c];
+
+			tmin = std::min(tmin, t);
+			tmax = std::max(tmax, t);
+		}
+
+		for (int c = 0; c < channels; ++c)
+		{
+			e0[c] = std::min(std::max(mean[c] + axis[c] * tmax / length2, 0.0f), 255.0f);
+			e1[c] = std::min(std::max(mean[c] + axis[c] * tmin / length2, 0.0f), 255.0f);
+		}
+	}
+
+	// Least-squares endpoints for fixed indices; t[i] is pixel i's position along the line
+	// from e0 (0) to e1 (1). Returns false when the indices don't pin down a line.
+	bool RefitLine(const BlockPixels pixels, int channels, const float t[16], float e0[4], float e1[4])
+	{
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		float x[4] = {};
+		float y[4] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			const float s = 1.0f - t[i];
+			a += s * s;
+			b += s * t[i];
+			c += t[i] * t[i];
+			for (int k = 0; k < channels; ++k)
+			{
+				x[k] += s * pixels[i][k];
+				y[k] += t[i] * pixels[i][k];
+			}
+		}
+
+		const float det = a * c - b * b;
+		if (fabsf(det) < 1e-6f)
+			return false;
+
+		for (int k = 0; k < channels; ++k)
+		{
+			e0[k] = std::min(std::max((c * x[k] - b * y[k]) / det, 0.0f), 255.0f);
+			e1[k] = std::min(std::max((a * y[k] - b * x[k]) / det, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	// Picks the nearest of count palette entries for every pixel; returns the total error
+	uint32_t AssignIndices(const BlockPixels pixels, int channels, const uint8_t palette[][4], int count, uint8_t indices[16])
+	{
+		uint32_t total = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			uint32_t best = UINT32_MAX;
+			for (int j = 0; j < count; ++j)
+			{
+				uint32_t error = 0;
+				for (int c = 0; c < channels; ++c)
+				{
+					const int d = int(pixels[i][c]) - int(palette[j][c]);
+					error += uint32_t(d * d);
+				}
+
+				if (error < best)
+				{
+					best = error;
+					indices[i] = static_cast<uint8_t>(j);
+				}
+			}
+			total += best;
+		}
+
+		return total;
+	}
+
+
+	//----------------------------------------------------------------------------------
+	// BC1
+	//----------------------------------------------------------------------------------
+
+	uint16_t To565(const float c[4])
+	{
+		const uint32_t r = static_cast<uint32_t>(c[0] * 31.0f / 255.0f + 0.5f);
+		const uint32_t g = static_cast<uint32_t>(c[1] * 63.0f / 255.0f + 0.5f);
+		const uint32_t b = static_cast<uint32_t>(c[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void Expand565(uint16_t c, uint8_t rgba[4])
+	{
+		const uint32_t r = (c >> 11) & 0x1f;
+		const uint32_t g = (c >> 5) & 0x3f;
+		const uint32_t b = c & 0x1f;
+		rgba[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+		rgba[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+		rgba[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+		rgba[3] = 255;
+	}
+
+	// Four-color palette in decoder order: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+	void GetBC1Palette(uint16_t c0, uint16_t c1, uint8_t palette[4][4])
+	{
+		Expand565(c0, palette[0]);
+		Expand565(c1, palette[1]);
+		for (int c = 0; c < 4; ++c)
+		{
+			palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+			palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+		}
+	}
+
+	struct BC1Candidate
+	{
+		uint16_t    c0;
+		uint16_t    c1;
+		uint8_t     indices[16];
+		uint32_t    error;
+	};
+
+	void EvaluateBC1(const BlockPixels pixels, const float e0[4], const float e1[4], BC1Candidate& candidate)
+	{
+		candidate.c0 = To565(e0);
+		candidate.c1 = To565(e1);
+
+		uint8_t palette[4][4];
+		GetBC1Palette(candidate.c0, candidate.c1, palette);
+		candidate.error = AssignIndices(pixels, 3, palette, 4, candidate.indices);
+	}
+
+	void EncodeBC1Block(const BlockPixels pixels, BC_ENCODE_QUALITY quality, uint8_t* dest)
+	{
+		float e0[4], e1[4];
+		FitLine(pixels, 3, quality, e0, e1);
+
+		BC1Candidate best;
+		EvaluateBC1(pixels, e0, e1, best);
+
+		if (quality == BC_ENCODE_HIGH)
+		{
+			static const float s_positions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			for (int pass = 0; pass < REFINE_PASSES && best.error; ++pass)
+			{
+				float t[16];
+				for (int i = 0; i < 16; ++i)
+					t[i] = s_positions[best.indices[i]];
+
+				BC1Candidate refit;
+				if (!RefitLine(pixels, 3, t, e0, e1))
+					break;
+
+				EvaluateBC1(pixels, e0, e1, refit);
+				if (refit.error >= best.error)
+					break;
+
+				best = refit;
+			}
+		}
+
+		// c0 > c1 selects the four-color mode; equal endpoints only have index 0 to offer
+		uint32_t indexBits = 0;
+		if (best.c0 < best.c1)
+		{
+			std::swap(best.c0, best.c1);
+			for (int i = 0; i < 16; ++i)
+				indexBits |= uint32_t(best.indices[i] ^ 1) << (2 * i);
+		}
+		else if (best.c0 > best.c1)
+		{
+			for (int i = 0; i < 16; ++i)
+				indexBits |= uint32_t(best.indices[i]) << (2 * i);
+		}
+
+		memcpy(dest, &best.c0, 2);
+		memcpy(dest + 2, &best.c1, 2);
+		memcpy(dest + 4, &indexBits, 4);
+	}
+
+
+	//----------------------------------------------------------------------------------
+	// BC7 mode 6
+	//----------------------------------------------------------------------------------
+
+	const uint8_t g_BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Candidate
+	{
+		uint8_t     endpoints[2][4];    // 7 bits per channel
+		uint8_t     pbits[2];
+		uint8_t     indices[16];
+		uint32_t    error;
+	};
+
+	void QuantizeBC7Endpoint(const float e[4], uint32_t pbit, uint8_t quantized[4])
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			const int q = static_cast<int>((e[c] - float(pbit)) / 2.0f + 0.5f);
+			quantized[c] = static_cast<uint8_t>(std::min(std::max(q, 0), 127));
+		}
+	}
+
+	void EvaluateBC7(const BlockPixels pixels, const float e0[4], const float e1[4], uint32_t p0, uint32_t p1, BC7Candidate& candidate)
+	{
+		QuantizeBC7Endpoint(e0, p0, candidate.endpoints[0]);
+		QuantizeBC7Endpoint(e1, p1, candidate.endpoints[1]);
+		candidate.pbits[0] = static_cast<uint8_t>(p0);
+		candidate.pbits[1] = static_cast<uint8_t>(p1);
+
+		int a[4], b[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			a[c] = (candidate.endpoints[0][c] << 1) | int(p0);
+			b[c] = (candidate.endpoints[1][c] << 1) | int(p1);
+		}
+
+		uint8_t palette[16][4];
+		for (int j = 0; j < 16; ++j)
+		{
+			const int w = g_BC7Weights4[j];
+			for (int c = 0; c < 4; ++c)
+				palette[j][c] = static_cast<uint8_t>(((64 - w) * a[c] + w * b[c] + 32) >> 6);
+		}
+
+		candidate.error = AssignIndices(pixels, 4, palette, 16, candidate.indices);
+	}
+
+	// The fast path gives each endpoint the p-bit nearer its own values; the high-quality
+	// path tries all four pairs against the whole block. Alpha 255 is only reachable with
+	// a p-bit of 1, so an opaque endpoint always takes it and stays exactly opaque.
+	void EvaluateBC7PBits(const BlockPixels pixels, const float e0[4], const float e1[4], BC_ENCODE_QUALITY quality, BC7Candidate& best)
+	{
+		const bool opaque[2] = { e0[3] >= 255.0f, e1[3] >= 255.0f };
+
+		if (quality == BC_ENCODE_HIGH)
+		{
+			best.error = UINT32_MAX;
+			for (uint32_t pbits = 0; pbits < 4; ++pbits)
+			{
+				if ((opaque[0] && !(pbits & 1)) || (opaque[1] && !(pbits >> 1)))
+					continue;
+
+				BC7Candidate candidate;
+				EvaluateBC7(pixels, e0, e1, pbits & 1, pbits >> 1, candidate);
+				if (candidate.error < best.error)
+					best = candidate;
+			}
+			return;
+		}
+
+		uint32_t p[2];
+		const float* e[2] = { e0, e1 };
+		for (int k = 0; k < 2; ++k)
+		{
+			float error[2] = {};
+			for (uint32_t pbit = 0; pbit < 2; ++pbit)
+			{
+				uint8_t q[4];
+				QuantizeBC7Endpoint(e[k], pbit, q);
+				for (int c = 0; c < 4; ++c)
+				{
+					const float d = e[k][c] - float((q[c] << 1) | pbit);
+					error[pbit] += d * d;
+				}
+			}
+			p[k] = (opaque[k] || error[1] < error[0]) ? 1u : 0u;
+		}
+
+		EvaluateBC7(pixels, e0, e1, p[0], p[1], best);
+	}
+
+	class BlockWriter
+	{
+	public:
+		explicit BlockWriter(uint8_t* block) : m_block(block), m_pos(0) { memset(block, 0, 16); }
+
+		void Write(uint32_t value, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; ++i, ++m_pos)
+			{
+				if ((value >> i) & 1)
+					m_block[m_pos >> 3] |= static_cast<uint8_t>(1u << (m_pos & 7));
+			}
+		}
+
+	private:
+		uint8_t* m_block;
+		uint32_t m_pos;
+	};
+
+	void EncodeBC7Block(const BlockPixels pixels, BC_ENCODE_QUALITY quality, uint8_t* dest)
+	{
+		float e0[4], e1[4];
+		FitLine(pixels, 4, quality, e0, e1);
+
+		BC7Candidate best;
+		EvaluateBC7PBits(pixels, e0, e1, quality, best);
+
+		if (quality == BC_ENCODE_HIGH)
+		{
+			for (int pass = 0; pass < REFINE_PASSES && best.error; ++pass)
+			{
+				float t[16];
+				for (int i = 0; i < 16; ++i)
+					t[i] = g_BC7Weights4[best.indices[i]] / 64.0f;
+
+				if (!RefitLine(pixels, 4, t, e0, e1))
+					break;
+
+				BC7Candidate refit;
+				EvaluateBC7PBits(pixels, e0, e1, quality, refit);
+				if (refit.error >= best.error)
+					break;
+
+				best = refit;
+			}
+		}
+
+		// Pixel 0's index is stored without its top bit, so it must be below 8
+		if (best.indices[0] & 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			std::swap(best.pbits[0], best.pbits[1]);
+			for (int i = 0; i < 16; ++i)
+				best.indices[i] = static_cast<uint8_t>(15 - best.indices[i]);
+		}
+
+		BlockWriter writer(dest);
+		writer.Write(1u << 6, 7);
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(best.endpoints[0][c], 7);
+			writer.Write(best.endpoints[1][c], 7);
+		}
+		writer.Write(best.pbits[0], 1);
+		writer.Write(best.pbits[1], 1);
+
+		writer.Write(best.indices[0], 3);
+		for (int i = 1; i < 16; ++i)
+			writer.Write(best.indices[i], 4);
+	}
+
+
+	//----------------------------------------------------------------------------------
+	struct EncodeJob
+	{
+		SOURCE_LAYOUT       layout;
+		const uint8_t*      src;
+		size_t              srcRowPitch;
+		uint32_t            width;
+		uint32_t            height;
+		bool                bc7;
+		uint8_t*            dest;
+		size_t              destRowPitch;
+		BC_ENCODE_QUALITY   quality;
+	};
+
+	void EncodeBlockRows(const EncodeJob& job, uint32_t firstRow, uint32_t lastRow)
+	{
+		const uint32_t blocksWide = (job.width + 3) / 4;
+		const size_t blockBytes = job.bc7 ? 16 : 8;
+
+		BlockPixels pixels;
+		for (uint32_t by = firstRow; by < lastRow; ++by)
+		{
+			uint8_t* block = job.dest + job.destRowPitch * by;
+			for (uint32_t bx = 0; bx < blocksWide; ++bx, block += blockBytes)
+			{
+				LoadBlock(job.layout, job.src, job.srcRowPitch, job.width, job.height, bx, by, pixels);
+				if (job.bc7)
+					EncodeBC7Block(pixels, job.quality, block);
+				else
+					EncodeBC1Block(pixels, job.quality, block);
+			}
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsBCEncodeSource(DXGI_FORMAT format)
+{
+	return GetSourceLayout(format) != SOURCE_UNKNOWN;
+}
+
+bool DirectX::IsOpaqueImage(DXGI_FORMAT format, const uint8_t* src, size_t srcRowPitch, uint32_t width, uint32_t height)
+{
+	const SOURCE_LAYOUT layout = GetSourceLayout(format);
+	if (layout == SOURCE_BGRX)
+		return true;
+
+	if (layout == SOURCE_UNKNOWN || !src)
+		return false;
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const uint8_t* row = src + srcRowPitch * y;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			if (row[x * 4 + 3] != 255)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::EncodeBC(DXGI_FORMAT srcFormat,
+	const uint8_t* src,
+	size_t srcRowPitch,
+	uint32_t width,
+	uint32_t height,
+	DXGI_FORMAT bcFormat,
+	uint8_t* dest,
+	size_t destRowPitch,
+	BC_ENCODE_QUALITY quality,
+	ThreadPool* pool)
+{
+	const SOURCE_LAYOUT layout = GetSourceLayout(srcFormat);
+	if (!src || !dest || layout == SOURCE_UNKNOWN || (!IsBC1(bcFormat) && !IsBC7(bcFormat)))
+		return false;
+
+	if (!width || !height)
+		return true;
+
+	EncodeJob job;
+	job.layout = layout;
+	job.src = src;
+	job.srcRowPitch = srcRowPitch;
+	job.width = width;
+	job.height = height;
+	job.bc7 = IsBC7(bcFormat);
+	job.dest = dest;
+	job.destRowPitch = destRowPitch;
+	job.quality = quality;
+
+	const uint32_t blocksWide = (width + 3) / 4;
+	const uint32_t blocksHigh = (height + 3) / 4;
+
+	if (!pool || blocksWide * blocksHigh < PARALLEL_ENCODE_BLOCKS)
+	{
+		EncodeBlockRows(job, 0, blocksHigh);
+		return true;
+	}
+
+	const size_t bands = (blocksHigh + ENCODE_BAND_BLOCK_ROWS - 1) / ENCODE_BAND_BLOCK_ROWS;
+	pool->ParallelFor(bands, [&job, blocksHigh](size_t band)
+	{
+		const uint32_t first = static_cast<uint32_t>(band) * ENCODE_BAND_BLOCK_ROWS;
+		EncodeBlockRows(job, first, std::min(first + ENCODE_BAND_BLOCK_ROWS, blocksHigh));
+	});
+
+	return true;
+}
@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.h
+//
+// Load-time BC1 and BC7 encoder for uncompressed 8-bit textures. It favours speed over
+// the last fraction of a dB: BC7 uses mode 6 only (one subset, RGBA endpoints with
+// p-bits, 4-bit indices). Both fit their endpoints along an axis through each block,
+// taken from its bounding box in BC_ENCODE_FAST mode; BC_ENCODE_HIGH uses the principal
+// axis and refines the endpoints by least squares. Round trips through BCDecoder
+// reproduce what the GPU samples.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DirectX
+{
+	class ThreadPool;
+
+	enum BC_ENCODE_QUALITY
+	{
+		BC_ENCODE_FAST = 0,     // Axis from the block's bounding box, no refinement
+		BC_ENCODE_HIGH,         // Principal axis plus least-squares endpoint refinement
+	};
+
+	// R8G8B8A8, B8G8R8A8 and B8G8R8X8, in their UNORM, _SRGB and TYPELESS forms
+	bool IsBCEncodeSource(DXGI_FORMAT format);
+
+	// True when no pixel of the image has alpha below 255 (always for B8G8R8X8)
+	bool IsOpaqueImage(DXGI_FORMAT format, const uint8_t* src, size_t srcRowPitch, uint32_t width, uint32_t height);
+
+	// Encodes one width x height image to bcFormat (BC1 or BC7, any variant), writing
+	// destRowPitch bytes per row of blocks. Partial blocks at the right and bottom edges
+	// repeat the last column and row. BC1 output is always opaque. Rows of blocks are
+	// spread over pool. Returns false for an unsupported format or a null pointer.
+	bool EncodeBC(DXGI_FORMAT srcFormat,
+	              const uint8_t* src,
+	              size_t srcRowPitch,
+	              uint32_t width,
+	              uint32_t height,
+	              DXGI_FORMAT bcFormat,
+	              uint8_t* dest,
+	              size_t destRowPitch,
+	              BC_ENCODE_QUALITY quality = BC_ENCODE_FAST,
+	              ThreadPool* pool = nullptr);
+}
@@ -12,10 +12,21 @@
 #include <dxgi1_4.h>
 #include <D3Dcompiler.h>
 #include <DirectXMath.h>
+#include <algorithm>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <wrl.h>
 #include "resource.h"
 #include "DDSTextureLoader.h"
+#include "AsyncTextureLoader.h"
+#include "DeferredReleaseQueue.h"
+#include "GeometryHeap.h"
+#include "PlacedResourceAllocator.h"
+#include "TextureCache.h"
+#include "ResidencyManager.h"
+#include "ResourceStateManager.h"
+#include "UploadRingBuffer.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -67,13 +78,15 @@ ComPtr<ID3D12GraphicsCommandList>	m_commandList;
 // Depth/Stencil
 ComPtr<ID3D12DescriptorHeap>		m_dsvHeap;
 ComPtr<ID3D12Resource>				m_depthStencil;
+CD3DX12_RESOURCE_DESC				m_depthStencilDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, m_width, m_height, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
 
 // App resources.
-ComPtr<ID3D12Resource>				m_vertexBuffer;
+std::unique_ptr<DirectX::PlacedResourceAllocator>	m_placedResources;	// Heap blocks shared by small resources
+std::unique_ptr<DirectX::GeometryHeap>	m_geometryHeap;		// Static vertices and indices, in video memory
 D3D12_VERTEX_BUFFER_VIEW			m_vertexBufferView;
-ComPtr<ID3D12Resource>				m_indexBuffer;
 D3D12_INDEX_BUFFER_VIEW				m_indexBufferView;
-ComPtr<ID3D12Resource>				m_constantBuffer;
+std::unique_ptr<DirectX::UploadRingBuffer>	m_uploadRing;
+D3D12_GPU_VIRTUAL_ADDRESS			m_constantBufferAddress = 0;
 SceneConstantBuffer					m_constantBufferData;
 UINT8*								m_pCbvDataBegin = NULL;
 
@@ -82,16 +95,31 @@ UINT								m_frameIndex;
 HANDLE								m_fenceEvent;
 ComPtr<ID3D12Fence>					m_fence;
 UINT64								m_fenceValue;
+DirectX::DeferredReleaseQueue		m_releaseQueue;			// Objects the GPU may still be reading
+std::unique_ptr<DirectX::ResourceStateManager>	m_resourceStates;	// Every barrier the sample records
 
 //Texture Resources
 ComPtr<ID3D12Resource>				textureBuffer;
-ComPtr<ID3D12Resource>				textureBufferUploadHeap;
+std::unique_ptr<DirectX::AsyncTextureLoader>	m_textureLoader;
+std::unique_ptr<DirectX::TextureCache>		m_textureCache;
+DirectX::TextureHandle				m_texture;
+DirectX::TextureHandle				m_textureReload;		// Smaller or larger copy asked for by the residency manager
+UINT								m_textureReloadTopMip = 0;	// Mip of the full chain m_textureReload starts at
+UINT								m_textureTopMip = 0;	// Likewise for textureBuffer
+UINT								m_textureMaxSize = 0;	// Largest dimension with every mip
+
+// Residency
+std::unique_ptr<DirectX::ResidencyManager>	m_residency;
+std::vector<UINT32>					m_frameResidency;		// Used by every frame
+UINT32								m_textureResidency = 0;
+std::unordered_map<ID3D12Heap*, UINT32>	m_heapResidency;		// The placed resources' blocks
 
 void OnInit();
 void OnUpdate();
 void OnRender();
 void OnDestroy();
 void WaitForPreviousFrame();
+void CreateTextureView();
 
 void ThrowIfFailed(HRESULT hr);
 void GetHardwareAdapter(IDXGIFactory2* pFactory, IDXGIAdapter1** ppAdapter);
@@ -115,10 +143,14 @@ void OnInit()
 	ComPtr<IDXGIFactory4> factory;
 	ThrowIfFailed(CreateDXGIFactory1(IID_PPV_ARGS(&factory)));
 
+	// Reports the video memory budget to the residency manager, where supported.
+	ComPtr<IDXGIAdapter3> adapter;
+
 	if (m_useWarpDevice)
 	{
 		ComPtr<IDXGIAdapter> warpAdapter;
 		ThrowIfFailed(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
+		warpAdapter.As(&adapter);
 
 		ThrowIfFailed(D3D12CreateDevice(
 			warpAdapter.Get(),
@@ -130,6 +162,7 @@ void OnInit()
 	{
 		ComPtr<IDXGIAdapter1> hardwareAdapter;
 		GetHardwareAdapter(factory.Get(), &hardwareAdapter);
+		hardwareAdapter.As(&adapter);
 
 		ThrowIfFailed(D3D12CreateDevice(
 			hardwareAdapter.Get(),
@@ -145,6 +178,47 @@ void OnInit()
 
 	ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
 
+	// Barriers are asked for by state and recorded in batches; nothing the sample records
+	// transitions a resource by hand.
+	m_resourceStates.reset(new DirectX::ResourceStateManager(m_device.Get()));
+
+	// Texture uploads, geometry and per-frame constants are all staged through one upload ring.
+	m_uploadRing.reset(new DirectX::UploadRingBuffer(m_device.Get(), 16 * 1024 * 1024));
+
+	// Resources that would otherwise each get an implicit heap are placed in shared ones.
+	// The only one is the depth buffer, so the blocks are sized for it: a resource is
+	// placed only if it fits in half a block.
+	const UINT64 depthStencilSize = m_device->GetResourceAllocationInfo(0, 1, &m_depthStencilDesc).SizeInBytes;
+	m_placedResources.reset(new DirectX::PlacedResourceAllocator(m_device.Get(), 2 * depthStencilSize));
+
+	// Static meshes are sub-allocated from one DEFAULT heap buffer.
+	m_geometryHeap.reset(new DirectX::GeometryHeap(m_device.Get(), 4 * 1024 * 1024, m_resourceStates.get(), m_uploadRing.get()));
+
+	// Every frame waits for the previous one, so nothing the GPU still uses is ever evicted.
+	m_residency.reset(new DirectX::ResidencyManager(m_device.Get(), adapter.Get()));
+	m_frameResidency.push_back(m_residency->RegisterResource(m_uploadRing->GetResource(), DirectX::RESIDENCY_PRIORITY_PINNED));
+	m_frameResidency.push_back(m_residency->RegisterResource(m_geometryHeap->GetResource(), DirectX::RESIDENCY_PRIORITY_HIGH));
+
+	// Placed resources go resident with their block, so the blocks are what is registered.
+	m_placedResources->SetHeapCallback([](ID3D12Heap* heap, bool created)
+	{
+		if (created)
+		{
+			m_heapResidency[heap] = m_residency->RegisterHeap(heap, DirectX::RESIDENCY_PRIORITY_HIGH);
+		}
+		else
+		{
+			m_residency->Unregister(m_heapResidency[heap]);
+			m_heapResidency.erase(heap);
+		}
+	});
+
+	// Start loading the texture now so the file I/O and parsing overlap the rest of the setup.
+	// Its copies run on the loader's own copy queue, alongside the frames.
+	m_textureLoader.reset(new DirectX::AsyncTextureLoader(m_device.Get(), m_uploadRing.get(), m_resourceStates.get()));
+	m_textureCache.reset(new DirectX::TextureCache(m_textureLoader.get()));
+	m_texture = m_textureCache->Load(L"TS.dds");
+
 	// Describe and create the swap chain.
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc		= {};
 	swapChainDesc.BufferCount				= FrameCount;
@@ -206,6 +280,7 @@ void OnInit()
 		{
 			ThrowIfFailed(m_swapChain->GetBuffer(n, IID_PPV_ARGS(&m_renderTargets[n])));
 			m_device->CreateRenderTargetView(m_renderTargets[n].Get(), nullptr, rtvHandle);
+			m_resourceStates->Register(m_renderTargets[n].Get(), D3D12_RESOURCE_STATE_PRESENT);
 			rtvHandle.Offset(1, m_rtvDescriptorSize);
 		}
 	}
@@ -330,19 +405,18 @@ void OnInit()
 		depthOptimizedClearValue.DepthStencil.Depth		= 1.0f;
 		depthOptimizedClearValue.DepthStencil.Stencil	= 0;
 
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, m_width, m_height, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL),
+		ThrowIfFailed(m_placedResources->CreateResource(
+			D3D12_HEAP_TYPE_DEFAULT,
+			m_depthStencilDesc,
 			D3D12_RESOURCE_STATE_DEPTH_WRITE,
 			&depthOptimizedClearValue,
-			IID_PPV_ARGS(&m_depthStencil)
+			m_depthStencil
 		));
 
 		m_device->CreateDepthStencilView(m_depthStencil.Get(), &depthStencilDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
 	}
 
-	// Create the vertex buffer.
+	// Create the vertex and index buffers.
 	{
 		// Define the geometry for a cube.
 		Vertex triangleVertices[] =
@@ -356,34 +430,6 @@ void OnInit()
 			
 		};
 
-		const UINT vertexBufferSize = sizeof(triangleVertices);
-
-		// Note: using upload heaps to transfer static data like vert buffers is not recommended. Every time the GPU needs it, the upload heap will be marshalled over. 
-		// Please read up on Default Heap usage. An upload heap is used here for code simplicity and because there are very few verts to actually transfer.
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_vertexBuffer)));
-
-		// Copy the triangle data to the vertex buffer.
-		UINT8* pVertexDataBegin;
-		CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
-		ThrowIfFailed(m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
-		memcpy(pVertexDataBegin, triangleVertices, sizeof(triangleVertices));
-		m_vertexBuffer->Unmap(0, nullptr);
-
-		// Initialize the vertex buffer view.
-		m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-		m_vertexBufferView.StrideInBytes  = sizeof(Vertex);
-		m_vertexBufferView.SizeInBytes    = vertexBufferSize;
-	}
-
-	// Create the index buffer.
-	{
-
 		DWORD indices[] =
 		{
 			0, 1, 2,
@@ -392,70 +438,42 @@ void OnInit()
 			
 		};
 
-		int IndexBufferSize = sizeof(indices);
-
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(IndexBufferSize),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_indexBuffer)));
+		// Both live in the geometry heap, in video memory, and are filled by one copy from the
+		// upload ring.
+		const DirectX::GeometryUpload uploads[] =
+		{
+			{ triangleVertices, sizeof(triangleVertices), sizeof(float) },
+			{ indices, sizeof(indices), sizeof(DWORD) },
+		};
+		DirectX::GeometryAllocation geometry[_countof(uploads)];
+		ComPtr<ID3D12Resource> geometryUploadHeap;
+		ThrowIfFailed(m_geometryHeap->Upload(m_commandList.Get(), uploads, _countof(uploads), geometry, geometryUploadHeap));
+		m_releaseQueue.Enqueue(std::move(geometryUploadHeap), m_fence.Get(), m_fenceValue);
 
-		// Copy the indices to the index buffer.
-		UINT8* pIndexDataBegin;
-		CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
-		ThrowIfFailed(m_indexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pIndexDataBegin)));
-		memcpy(pIndexDataBegin, indices, sizeof(indices));
-		m_indexBuffer->Unmap(0, nullptr);
+		// Initialize the vertex buffer view.
+		m_vertexBufferView.BufferLocation = geometry[0].gpuAddress;
+		m_vertexBufferView.StrideInBytes  = sizeof(Vertex);
+		m_vertexBufferView.SizeInBytes    = static_cast<UINT>(geometry[0].size);
 
 		// Describe the index buffer view.
-		m_indexBufferView.BufferLocation	= m_indexBuffer->GetGPUVirtualAddress();
+		m_indexBufferView.BufferLocation	= geometry[1].gpuAddress;
 		m_indexBufferView.Format			= DXGI_FORMAT_R32_UINT;
-		m_indexBufferView.SizeInBytes		= IndexBufferSize;
-	}
-
-	// Create the texture buffer ( Frank LUNA's Style ).
-	{
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(
-			m_device.Get(),
-			m_commandList.Get(),
-			L"TS.dds",
-			textureBuffer,
-			textureBufferUploadHeap));		
-
-		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		srvDesc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format							= textureBuffer->GetDesc().Format;
-		srvDesc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MostDetailedMip		= 0;
-		srvDesc.Texture2D.MipLevels				= textureBuffer->GetDesc().MipLevels;
-		srvDesc.Texture2D.ResourceMinLODClamp	= 0.0f;
-		m_device->CreateShaderResourceView(textureBuffer.Get(), &srvDesc, m_descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+		m_indexBufferView.SizeInBytes		= static_cast<UINT>(geometry[1].size);
 	}
 
 	// Now we execute the command list to upload the initial assets
+	m_resourceStates->FlushAll(m_commandList.Get());
 	m_commandList->Close();
 	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
 	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	m_resourceStates->Decay();
 
-	// Create the constant buffer.
-	{
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(1024 * 64),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_constantBuffer)));
-
-		// Initialize and map the constant buffers. We don't unmap this until the
-		// app closes. Keeping things mapped for the lifetime of the resource is okay.
-		ZeroMemory(&m_constantBufferData, sizeof(m_constantBufferData));
-
-		CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
-		ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pCbvDataBegin)));
-	}
+	// The staged geometry can be reclaimed from the ring once the upload has executed.
+	m_uploadRing->Submit(m_fence.Get(), m_fenceValue);
+	WaitForPreviousFrame();
+
+	// The constant buffers are allocated from the upload ring every frame in OnUpdate.
+	ZeroMemory(&m_constantBufferData, sizeof(m_constantBufferData));
 
 	m_viewport.Width		= static_cast<float>(m_width);
 	m_viewport.Height		= static_cast<float>(m_height);
@@ -487,10 +505,22 @@ void OnInit()
 // Update frame-based values.
 void OnUpdate()
 {
+	m_releaseQueue.Collect();
+	m_placedResources->Collect();
+
+	// Let the texture loader stage its uploads first, so the ring hands out this frame's
+	// constants after them and reclaims both in submission order.
+	m_textureLoader->Update();
+
 	//
 	// Constant Buffer Settings for Cube
 	//
 
+	DirectX::UploadAllocation constants;
+	ThrowIfFailed(m_uploadRing->Allocate(6 * 256, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, constants));
+	m_pCbvDataBegin			= constants.cpuAddress;
+	m_constantBufferAddress	= constants.gpuAddress;
+
 	rotation += 0.01;
 	XMMATRIX mRotate = XMMatrixRotationY(rotation);
 	XMMATRIX mTranslate = XMMatrixTranslation(0.0f,-2.0f,0.0f);
@@ -527,6 +557,29 @@ void OnUpdate()
 // Render the scene.
 void OnRender()
 {
+	// Pick up the cube's texture once the loader reports it resident.
+	if (!textureBuffer && m_texture->load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		CreateTextureView();
+	}
+
+	// Swap in the copy the residency manager asked for once its upload has completed, so
+	// the frame never waits on it. The texture it replaces is kept until the last frame
+	// that drew with it has completed.
+	if (m_textureReload && m_textureReload->load.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+		&& m_textureLoader->IsUploadComplete(m_textureReload->load.get()))
+	{
+		// A reload the cache served from the same texture is still registered, and in use
+		if (m_textureReload->load.get().texture != textureBuffer)
+		{
+			m_resourceStates->Unregister(textureBuffer.Get());
+		}
+		m_releaseQueue.Enqueue(std::move(textureBuffer), m_fence.Get(), m_fenceValue - 1);
+		m_texture = std::move(m_textureReload);
+		m_textureTopMip = m_textureReloadTopMip;
+		CreateTextureView();
+	}
+
 	// Command list allocators can only be reset when the associated 
 	// command lists have finished execution on the GPU; apps should use 
 	// fences to determine GPU execution progress.
@@ -545,8 +598,15 @@ void OnRender()
 	m_commandList->RSSetViewports(1, &m_viewport);
 	m_commandList->RSSetScissorRects(1, &m_scissorRect);
 
-	// Indicate that the back buffer will be used as a render target.
-	m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	// Indicate that the back buffer will be used as a render target. A texture that has just
+	// arrived isn't sampled before the clears are done, so it starts its transition here and
+	// finishes it before the draws; after that it has nothing left to transition.
+	m_resourceStates->Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	if (textureBuffer)
+	{
+		m_resourceStates->BeginTransition(textureBuffer.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+	m_resourceStates->Flush(m_commandList.Get());
 
 	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
 	CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
@@ -559,43 +619,107 @@ void OnRender()
 	m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	// Set Cube's Constant Buffer (for Rotation), DescriptorTable (for Texture), Vertex, Index Buffers and Render
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress());
-	m_commandList->SetGraphicsRootDescriptorTable(1, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
-	m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-	m_commandList->IASetIndexBuffer(&m_indexBufferView);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+	// The cube is only drawn once its texture has finished uploading.
+	if (textureBuffer)
+	{
+		m_resourceStates->Transition(textureBuffer.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_resourceStates->Transition(m_geometryHeap->GetResource(), DirectX::GeometryHeap::READ_STATE);
+		m_resourceStates->Flush(m_commandList.Get());
+
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress);
+		m_commandList->SetGraphicsRootDescriptorTable(1, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+		m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+		m_commandList->IASetIndexBuffer(&m_indexBufferView);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() +256);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress +256);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() + 2*256);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress + 2*256);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() + 3 * 256);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress + 3 * 256);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() + 4 * 256);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress + 4 * 256);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBuffer->GetGPUVirtualAddress() + 5 * 256);
-	m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+		m_commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferAddress + 5 * 256);
+		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+	}
 
 	// Indicate that the back buffer will now be used to present.
-	m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	m_resourceStates->Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT);
+	m_resourceStates->FlushAll(m_commandList.Get());
 
 	ThrowIfFailed(m_commandList->Close());
 
+	// Everything the frame references has to be resident before it executes.
+	for (UINT32 object : m_frameResidency)
+	{
+		m_residency->Use(object);
+	}
+	for (const auto& heap : m_heapResidency)
+	{
+		m_residency->Use(heap.second);
+	}
+	if (textureBuffer)
+	{
+		m_residency->Use(m_textureResidency);
+	}
+	ThrowIfFailed(m_residency->Update());
+
 	// Execute the command list.
 	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
 	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	m_resourceStates->Decay();
 
 	// Present the frame.
 	ThrowIfFailed(m_swapChain->Present(1, 0));
 
+	// This frame's constants are reclaimed once the fence signalled below has passed.
+	m_uploadRing->Submit(m_fence.Get(), m_fenceValue);
 	WaitForPreviousFrame();
 }
 
 
+void CreateTextureView()
+{
+	const DirectX::TextureLoadResult& result = m_texture->load.get();
+	ThrowIfFailed(result.hr);
+	textureBuffer = result.texture;
+
+	// The next frame is the first to sample it: hold that frame on the GPU until this
+	// texture's copy is done, and only this one.
+	m_textureLoader->QueueWait(m_commandQueue.Get(), result);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format							= textureBuffer->GetDesc().Format;
+	srvDesc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip		= 0;
+	srvDesc.Texture2D.MipLevels				= textureBuffer->GetDesc().MipLevels;
+	srvDesc.Texture2D.ResourceMinLODClamp	= 0.0f;
+	m_device->CreateShaderResourceView(textureBuffer.Get(), &srvDesc, m_descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+
+	if (m_textureResidency)
+	{
+		m_residency->Replace(m_textureResidency, textureBuffer.Get(), m_textureTopMip);
+		return;
+	}
+
+	// Under memory pressure the texture is reloaded without its top mips, down to the last one.
+	const D3D12_RESOURCE_DESC desc = textureBuffer->GetDesc();
+	m_textureMaxSize = static_cast<UINT>(std::max<UINT64>(desc.Width, desc.Height));
+	m_textureResidency = m_residency->RegisterTexture(textureBuffer.Get(), DirectX::RESIDENCY_PRIORITY_NORMAL,
+		desc.MipLevels - 1, [](UINT topMip)
+	{
+		m_textureReload = m_textureCache->Load(L"TS.dds", topMip ? std::max<UINT>(m_textureMaxSize >> topMip, 1) : 0);
+		m_textureReloadTopMip = topMip;
+	});
+}
+
+
 void WaitForPreviousFrame()
 {
 	// WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
@@ -622,6 +746,22 @@ void OnDestroy()
 {
 	// Ensure that the GPU is no longer referencing resources that are about to be cleaned up by the destructor.
 	WaitForPreviousFrame();
+	m_releaseQueue.Collect();
+
+	m_placedResources->SetHeapCallback(nullptr);
+	m_heapResidency.clear();
+	m_residency.reset();
+	m_geometryHeap.reset();
+	m_depthStencil.Reset();
+	m_placedResources.reset();
+
+	// Waits for any upload still in flight before releasing the loader's resources.
+	m_textureReload.reset();
+	m_texture.reset();
+	m_textureCache.reset();
+	m_textureLoader.reset();
+	m_uploadRing.reset();
+	m_resourceStates.reset();
 
 	CloseHandle(m_fenceEvent);
 }
@@ -0,0 +1,223 @@
+//--------------------------------------------------------------------------------------
+// File: DDSConvert.cpp
+//
+// Row converters for legacy DDS pixel layouts: an SSE2 or NEON main loop and a scalar
+// loop for the tail (and for other targets).
+//--------------------------------------------------------------------------------------
+
+#include "DDSConvert.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DDS_CONVERT_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DDS_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	inline uint32_t Load32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+	inline uint16_t Load16(const uint8_t* p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+	inline void Store32(uint8_t* p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+	inline void Store16(uint8_t* p, uint16_t v) { memcpy(p, &v, sizeof(v)); }
+
+	// Fills in an alpha channel the file doesn't have
+	size_t SetAlpha32(const uint8_t* src, uint8_t* dest, size_t pixels, uint32_t alpha)
+	{
+		size_t i = 0;
+#if defined(DDS_CONVERT_SSE2)
+		const __m128i mask = _mm_set1_epi32(static_cast<int>(alpha));
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_or_si128(v, mask));
+		}
+#elif defined(DDS_CONVERT_NEON)
+		const uint32x4_t mask = vdupq_n_u32(alpha);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			vst1q_u8(dest + i * 4, vreinterpretq_u8_u32(vorrq_u32(vreinterpretq_u32_u8(vld1q_u8(src + i * 4)), mask)));
+		}
+#endif
+		return i;
+	}
+
+	size_t SetAlpha16(const uint8_t* src, uint8_t* dest, size_t pixels, uint16_t alpha)
+	{
+		size_t i = 0;
+#if defined(DDS_CONVERT_SSE2)
+		const __m128i mask = _mm_set1_epi16(static_cast<short>(alpha));
+		for (; i + 8 <= pixels; i += 8)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2), _mm_or_si128(v, mask));
+		}
+#elif defined(DDS_CONVERT_NEON)
+		const uint16x8_t mask = vdupq_n_u16(alpha);
+		for (; i + 8 <= pixels; i += 8)
+		{
+			vst1q_u8(dest + i * 2, vreinterpretq_u8_u16(vorrq_u16(vreinterpretq_u16_u8(vld1q_u8(src + i * 2)), mask)));
+		}
+#endif
+		return i;
+	}
+
+	// Swaps the 10-bit red and blue fields; green and alpha stay put
+	inline uint32_t SwapRB10(uint32_t v)
+	{
+		return (v & 0xc00ffc00) | ((v & 0x3ff) << 20) | ((v >> 20) & 0x3ff);
+	}
+
+	size_t SwapRB10Vector(const uint8_t* src, uint8_t* dest, size_t pixels)
+	{
+		size_t i = 0;
+#if defined(DDS_CONVERT_SSE2)
+		const __m128i keep = _mm_set1_epi32(static_cast<int>(0xc00ffc00));
+		const __m128i field = _mm_set1_epi32(0x3ff);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			const __m128i red = _mm_slli_epi32(_mm_and_si128(v, field), 20);
+			const __m128i blue = _mm_and_si128(_mm_srli_epi32(v, 20), field);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+				_mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(red, blue)));
+		}
+#elif defined(DDS_CONVERT_NEON)
+		const uint32x4_t keep = vdupq_n_u32(0xc00ffc00);
+		const uint32x4_t field = vdupq_n_u32(0x3ff);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(src + i * 4));
+			const uint32x4_t red = vshlq_n_u32(vandq_u32(v, field), 20);
+			const uint32x4_t blue = vandq_u32(vshrq_n_u32(v, 20), field);
+			vst1q_u8(dest + i * 4, vreinterpretq_u8_u32(vorrq_u32(vandq_u32(v, keep), vorrq_u32(red, blue))));
+		}
+#endif
+		return i;
+	}
+
+	// A4L4 -> R8G8B8A8: each nibble is widened by repeating it (x * 17), then the luminance
+	// goes to R, G and B
+	inline uint32_t ExpandA4L4(uint8_t v)
+	{
+		const uint32_t l = (v & 0x0f) * 17u;
+		const uint32_t a = (v >> 4) * 17u;
+		return l | (l << 8) | (l << 16) | (a << 24);
+	}
+
+	size_t ExpandA4L4Vector(const uint8_t* src, uint8_t* dest, size_t pixels)
+	{
+		size_t i = 0;
+#if defined(DDS_CONVERT_SSE2)
+		const __m128i low = _mm_set1_epi8(0x0f);
+		for (; i + 16 <= pixels; i += 16)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i l4 = _mm_and_si128(v, low);
+			const __m128i a4 = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+			const __m128i l8 = _mm_or_si128(l4, _mm_slli_epi16(l4, 4));
+			const __m128i a8 = _mm_or_si128(a4, _mm_slli_epi16(a4, 4));
+
+			const __m128i llLo = _mm_unpacklo_epi8(l8, l8);
+			const __m128i llHi = _mm_unpackhi_epi8(l8, l8);
+			const __m128i laLo = _mm_unpacklo_epi8(l8, a8);
+			const __m128i laHi = _mm_unpackhi_epi8(l8, a8);
+
+			__m128i* out = reinterpret_cast<__m128i*>(dest + i * 4);
+			_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(llLo, laLo));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(llLo, laLo));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(llHi, laHi));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(llHi, laHi));
+		}
+#elif defined(DDS_CONVERT_NEON)
+		const uint8x16_t low = vdupq_n_u8(0x0f);
+		for (; i + 16 <= pixels; i += 16)
+		{
+			const uint8x16_t v = vld1q_u8(src + i);
+			const uint8x16_t l4 = vandq_u8(v, low);
+			const uint8x16_t a4 = vshrq_n_u8(v, 4);
+			const uint8x16_t l8 = vorrq_u8(l4, vshlq_n_u8(l4, 4));
+
+			uint8x16x4_t rgba;
+			rgba.val[0] = l8;
+			rgba.val[1] = l8;
+			rgba.val[2] = l8;
+			rgba.val[3] = vorrq_u8(a4, vshlq_n_u8(a4, 4));
+			vst4q_u8(dest + i * 4, rgba);
+		}
+#endif
+		return i;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+size_t DirectX::GetLegacySourceBytesPerPixel(DDS_CONVERSION conversion)
+{
+	switch (conversion)
+	{
+	case DDS_CONVERSION_X8B8G8R8:
+	case DDS_CONVERSION_A2R10G10B10:
+		return 4;
+
+	case DDS_CONVERSION_X1R5G5B5:
+	case DDS_CONVERSION_X4R4G4B4:
+		return 2;
+
+	case DDS_CONVERSION_A4L4:
+		return 1;
+
+	default:
+		return 0;
+	}
+}
+
+size_t DirectX::GetLegacyDestBytesPerPixel(DDS_CONVERSION conversion)
+{
+	return (conversion == DDS_CONVERSION_A4L4) ? 4 : GetLegacySourceBytesPerPixel(conversion);
+}
+
+
+//--------------------------------------------------------------------------------------
+void DirectX::ConvertLegacyRow(DDS_CONVERSION conversion,
+	const uint8_t* src,
+	uint8_t* dest,
+	size_t pixels)
+{
+	size_t i = 0;
+	switch (conversion)
+	{
+	case DDS_CONVERSION_X8B8G8R8:
+		for (i = SetAlpha32(src, dest, pixels, 0xff000000); i < pixels; ++i)
+			Store32(dest + i * 4, Load32(src + i * 4) | 0xff000000);
+		break;
+
+	case DDS_CONVERSION_A2R10G10B10:
+		for (i = SwapRB10Vector(src, dest, pixels); i < pixels; ++i)
+			Store32(dest + i * 4, SwapRB10(Load32(src + i * 4)));
+		break;
+
+	case DDS_CONVERSION_X1R5G5B5:
+		for (i = SetAlpha16(src, dest, pixels, 0x8000); i < pixels; ++i)
+			Store16(dest + i * 2, static_cast<uint16_t>(Load16(src + i * 2) | 0x8000));
+		break;
+
+	case DDS_CONVERSION_X4R4G4B4:
+		for (i = SetAlpha16(src, dest, pixels, 0xf000); i < pixels; ++i)
+			Store16(dest + i * 2, static_cast<uint16_t>(Load16(src + i * 2) | 0xf000));
+		break;
+
+	case DDS_CONVERSION_A4L4:
+		for (i = ExpandA4L4Vector(src, dest, pixels); i < pixels; ++i)
+			Store32(dest + i * 4, ExpandA4L4(src[i]));
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,25 @@
+//--------------------------------------------------------------------------------------
+// File: DDSConvert.h
+//
+// Row converters for the legacy DDS pixel layouts that have no DXGI twin (see
+// DDS_CONVERSION). The loaders run them while copying into the upload footprint, so a
+// converted texture costs no more passes over its data than a native one.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "DDSLayout.h"
+
+namespace DirectX
+{
+	// Bytes one pixel takes in the file and after conversion; 0 for DDS_CONVERSION_NONE
+	size_t GetLegacySourceBytesPerPixel(DDS_CONVERSION conversion);
+	size_t GetLegacyDestBytesPerPixel(DDS_CONVERSION conversion);
+
+	// Converts one row of pixels. src and dest need no particular alignment and must not
+	// overlap unless they are the same pointer and the conversion doesn't expand.
+	void ConvertLegacyRow(DDS_CONVERSION conversion,
+	                      const uint8_t* src,
+	                      uint8_t* dest,
+	                      size_t pixels);
+}
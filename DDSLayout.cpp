@@ -0,0 +1,591 @@
+//--------------------------------------------------------------------------------------
+// File: DDSLayout.cpp
+//
+// Device-independent DDS parsing: validates the headers and describes the texture and
+// where every subresource lives in the file, without a graphics device or windows.h.
+// The D3D12 loader builds on it, and tools can use it to scan textures offline.
+//--------------------------------------------------------------------------------------
+
+#include "DDSLayout.h"
+#include "DDS.h"
+#include "DXGIFormatTraits.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Direct3D 11.x / 12 hardware limits; DDS metadata beyond them is not trusted
+	const uint32_t MAX_MIP_LEVELS           = 15;
+	const uint32_t MAX_TEXTURE1D_DIMENSION  = 16384;
+	const uint32_t MAX_TEXTURE2D_DIMENSION  = 16384;
+	const uint32_t MAX_TEXTURECUBE_DIMENSION = 16384;
+	const uint32_t MAX_TEXTURE3D_DIMENSION  = 2048;
+	const uint32_t MAX_ARRAY_SIZE           = 2048;
+
+	struct LegacyFormat
+	{
+		uint32_t        pixelFlags;
+		uint32_t        bitCount;
+		uint32_t        masks[4];       // R, G, B, A
+		DDS_CONVERSION  conversion;
+		DXGI_FORMAT     fileFormat;     // Same size per pixel as the file data
+		DXGI_FORMAT     format;         // What it converts to
+	};
+
+	const LegacyFormat g_LegacyFormats[] =
+	{
+		{ DDS_RGB,       32, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 }, DDS_CONVERSION_X8B8G8R8,    DXGI_FORMAT_R8G8B8A8_UNORM,    DXGI_FORMAT_R8G8B8A8_UNORM },
+		{ DDS_RGB,       32, { 0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000 }, DDS_CONVERSION_A2R10G10B10, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_R10G10B10A2_UNORM },
+		{ DDS_RGB,       16, { 0x00007c00, 0x000003e0, 0x0000001f, 0x00000000 }, DDS_CONVERSION_X1R5G5B5,    DXGI_FORMAT_B5G5R5A1_UNORM,    DXGI_FORMAT_B5G5R5A1_UNORM },
+		{ DDS_RGB,       16, { 0x00000f00, 0x000000f0, 0x0000000f, 0x00000000 }, DDS_CONVERSION_X4R4G4B4,    DXGI_FORMAT_B4G4R4A4_UNORM,    DXGI_FORMAT_B4G4R4A4_UNORM },
+		{ DDS_LUMINANCE,  8, { 0x0000000f, 0x00000000, 0x00000000, 0x000000f0 }, DDS_CONVERSION_A4L4,        DXGI_FORMAT_R8_UNORM,          DXGI_FORMAT_R8G8B8A8_UNORM },
+	};
+
+	const LegacyFormat* FindLegacyFormat(const DDS_PIXELFORMAT& ddpf)
+	{
+		for (const auto& legacy : g_LegacyFormats)
+		{
+			if ((ddpf.flags & legacy.pixelFlags) &&
+				ddpf.RGBBitCount == legacy.bitCount &&
+				ddpf.RBitMask == legacy.masks[0] &&
+				ddpf.GBitMask == legacy.masks[1] &&
+				ddpf.BBitMask == legacy.masks[2] &&
+				ddpf.ABitMask == legacy.masks[3])
+			{
+				return &legacy;
+			}
+		}
+
+		return nullptr;
+	}
+
+	uint32_t GetAlphaModeValue(const DDS_HEADER* header)
+	{
+		if (header->ddspf.flags & DDS_FOURCC)
+		{
+			if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)
+			{
+				auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>((const char*)header + sizeof(DDS_HEADER));
+				const uint32_t mode = d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK;
+				return (mode <= 4) ? mode : 0;
+			}
+			else if ((MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC)
+				|| (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC))
+			{
+				return 2;	// DDS_ALPHA_MODE_PREMULTIPLIED
+			}
+		}
+
+		return 0;
+	}
+
+	// fileFormat is the format that sizes the bit data, which differs from layout.format
+	// only for legacy conversions
+	DDS_PARSE_STATUS GetTextureShape(const DDS_HEADER* header, uint32_t flags, DDSTextureLayout& layout, DXGI_FORMAT& fileFormat)
+	{
+		layout.width = header->width;
+		layout.height = header->height;
+		layout.depth = header->depth;
+		layout.mipCount = header->mipMapCount ? header->mipMapCount : 1;
+		layout.arraySize = 1;
+		layout.format = DXGI_FORMAT_UNKNOWN;
+		layout.conversion = DDS_CONVERSION_NONE;
+		layout.dimension = DDS_TEXTURE_DIMENSION_UNKNOWN;
+		layout.isCubeMap = false;
+
+		if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+		{
+			auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>((const char*)header + sizeof(DDS_HEADER));
+
+			layout.arraySize = d3d10ext->arraySize;
+			if (layout.arraySize == 0)
+				return DDS_PARSE_INVALID_DATA;
+
+			switch (d3d10ext->dxgiFormat)
+			{
+			case DXGI_FORMAT_AI44:
+			case DXGI_FORMAT_IA44:
+			case DXGI_FORMAT_P8:
+			case DXGI_FORMAT_A8P8:
+				return DDS_PARSE_NOT_SUPPORTED;
+
+			default:
+				if (GetBitsPerPixel(d3d10ext->dxgiFormat) == 0)
+					return DDS_PARSE_NOT_SUPPORTED;
+			}
+
+			layout.format = d3d10ext->dxgiFormat;
+
+			switch (d3d10ext->resourceDimension)
+			{
+			case DDS_DIMENSION_TEXTURE1D:
+				if ((header->flags & DDS_HEIGHT) && layout.height != 1)
+					return DDS_PARSE_INVALID_DATA;
+				layout.height = layout.depth = 1;
+				layout.dimension = DDS_TEXTURE_DIMENSION_1D;
+				break;
+
+			case DDS_DIMENSION_TEXTURE2D:
+				if (d3d10ext->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+				{
+					if (layout.arraySize > MAX_ARRAY_SIZE / 6)
+						return DDS_PARSE_NOT_SUPPORTED;
+					layout.arraySize *= 6;
+					layout.isCubeMap = true;
+				}
+				layout.depth = 1;
+				layout.dimension = DDS_TEXTURE_DIMENSION_2D;
+				break;
+
+			case DDS_DIMENSION_TEXTURE3D:
+				if (!(header->flags & DDS_HEADER_FLAGS_VOLUME))
+					return DDS_PARSE_INVALID_DATA;
+				if (layout.arraySize > 1)
+					return DDS_PARSE_NOT_SUPPORTED;
+				layout.dimension = DDS_TEXTURE_DIMENSION_3D;
+				break;
+
+			default:
+				return DDS_PARSE_NOT_SUPPORTED;
+			}
+		}
+		else
+		{
+			layout.format = GetDXGIFormat(header->ddspf);
+
+			if (layout.format == DXGI_FORMAT_UNKNOWN && (flags & DDS_PARSE_FLAGS_CONVERT_LEGACY))
+			{
+				if (const LegacyFormat* legacy = FindLegacyFormat(header->ddspf))
+				{
+					layout.format = legacy->format;
+					layout.conversion = legacy->conversion;
+					fileFormat = legacy->fileFormat;
+				}
+			}
+
+			if (layout.format == DXGI_FORMAT_UNKNOWN)
+				return DDS_PARSE_NOT_SUPPORTED;
+
+			if (header->flags & DDS_HEADER_FLAGS_VOLUME)
+			{
+				layout.dimension = DDS_TEXTURE_DIMENSION_3D;
+			}
+			else
+			{
+				if (header->caps2 & DDS_CUBEMAP)
+				{
+					if ((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+						return DDS_PARSE_NOT_SUPPORTED;
+					layout.arraySize = 6;
+					layout.isCubeMap = true;
+				}
+
+				layout.depth = 1;
+				layout.dimension = DDS_TEXTURE_DIMENSION_2D;
+			}
+		}
+
+		if (layout.conversion == DDS_CONVERSION_NONE)
+			fileFormat = layout.format;
+
+		// Bound sizes (for security purposes we don't trust DDS file metadata larger than the D3D 11.x hardware requirements)
+		if (layout.mipCount > MAX_MIP_LEVELS)
+			return DDS_PARSE_NOT_SUPPORTED;
+
+		switch (layout.dimension)
+		{
+		case DDS_TEXTURE_DIMENSION_1D:
+			if ((layout.arraySize > MAX_ARRAY_SIZE) ||
+				(layout.width > MAX_TEXTURE1D_DIMENSION))
+				return DDS_PARSE_NOT_SUPPORTED;
+			break;
+
+		case DDS_TEXTURE_DIMENSION_2D:
+			if (layout.isCubeMap)
+			{
+				// This is the right bound because arraySize is (NumCubes*6) here
+				if ((layout.arraySize > MAX_ARRAY_SIZE) ||
+					(layout.width > MAX_TEXTURECUBE_DIMENSION) ||
+					(layout.height > MAX_TEXTURECUBE_DIMENSION))
+					return DDS_PARSE_NOT_SUPPORTED;
+			}
+			else if ((layout.arraySize > MAX_ARRAY_SIZE) ||
+				(layout.width > MAX_TEXTURE2D_DIMENSION) ||
+				(layout.height > MAX_TEXTURE2D_DIMENSION))
+			{
+				return DDS_PARSE_NOT_SUPPORTED;
+			}
+			break;
+
+		case DDS_TEXTURE_DIMENSION_3D:
+			if ((layout.arraySize > 1) ||
+				(layout.width > MAX_TEXTURE3D_DIMENSION) ||
+				(layout.height > MAX_TEXTURE3D_DIMENSION) ||
+				(layout.depth > MAX_TEXTURE3D_DIMENSION))
+				return DDS_PARSE_NOT_SUPPORTED;
+			break;
+
+		default:
+			return DDS_PARSE_NOT_SUPPORTED;
+		}
+
+		return DDS_PARSE_OK;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+DDS_PARSE_STATUS DirectX::ParseDDS(const uint8_t* data,
+	size_t dataSize,
+	DDSTextureLayout& layout,
+	uint64_t fileSize,
+	uint32_t flags)
+{
+	layout = DDSTextureLayout();
+
+	if (!data)
+		return DDS_PARSE_INVALID_ARG;
+
+	if (!fileSize)
+		fileSize = dataSize;
+
+	if (fileSize < dataSize)
+		return DDS_PARSE_NOT_DDS;
+
+	DDS_PARSE_STATUS status = GetDDSHeaderSize(data, dataSize, layout.headerSize);
+	if (status != DDS_PARSE_OK)
+		return status;
+
+	auto header = reinterpret_cast<const DDS_HEADER*>(data + sizeof(uint32_t));
+
+	DXGI_FORMAT fileFormat = DXGI_FORMAT_UNKNOWN;
+	status = GetTextureShape(header, flags, layout, fileFormat);
+	if (status != DDS_PARSE_OK)
+		return status;
+
+	layout.alphaMode = GetAlphaModeValue(header);
+
+	// Walk the subresources in file order: every mip of slice 0, then slice 1, ...
+	const uint64_t available = fileSize - layout.headerSize;
+	layout.subresources.resize(size_t(layout.mipCount) * layout.arraySize);
+
+	uint64_t offset = 0;
+	size_t index = 0;
+	for (uint32_t j = 0; j < layout.arraySize; ++j)
+	{
+		uint32_t w = layout.width;
+		uint32_t h = layout.height;
+		uint32_t d = layout.depth;
+		for (uint32_t i = 0; i < layout.mipCount; ++i, ++index)
+		{
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			size_t numRows = 0;
+			GetFormatSurfaceInfo(w, h, fileFormat, &numBytes, &rowBytes, &numRows);
+
+			const uint64_t subresourceBytes = uint64_t(numBytes) * d;
+			if (subresourceBytes > available - offset)
+			{
+				layout.subresources.clear();
+				return DDS_PARSE_END_OF_FILE;
+			}
+
+			DDSSubresourceLayout& sub = layout.subresources[index];
+			sub.offset = offset;
+			sub.rowPitch = rowBytes;
+			sub.slicePitch = numBytes;
+			sub.numRows = static_cast<uint32_t>(numRows);
+			sub.width = w;
+			sub.height = h;
+			sub.depth = d;
+
+			offset += subresourceBytes;
+
+			w = (w > 1) ? (w >> 1) : 1;
+			h = (h > 1) ? (h >> 1) : 1;
+			d = (d > 1) ? (d >> 1) : 1;
+		}
+	}
+
+	layout.bitSize = offset;
+
+	return DDS_PARSE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+DDS_PARSE_STATUS DirectX::GetDDSHeaderSize(const uint8_t* data, size_t dataSize, size_t& headerSize)
+{
+	headerSize = 0;
+
+	if (!data)
+		return DDS_PARSE_INVALID_ARG;
+
+	// Need at least enough data to fill the header and magic number to be a valid DDS
+	if (dataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+		return DDS_PARSE_NOT_DDS;
+
+	// DDS files always start with the same magic number ("DDS ")
+	uint32_t dwMagicNumber = *reinterpret_cast<const uint32_t*>(data);
+	if (dwMagicNumber != DDS_MAGIC)
+		return DDS_PARSE_NOT_DDS;
+
+	auto header = reinterpret_cast<const DDS_HEADER*>(data + sizeof(uint32_t));
+
+	// Verify header to validate DDS file
+	if (header->size != sizeof(DDS_HEADER) ||
+		header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+		return DDS_PARSE_NOT_DDS;
+
+	// Check for DX10 extension
+	bool bDXT10Header = false;
+	if ((header->ddspf.flags & DDS_FOURCC) &&
+		(MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+	{
+		// Must be long enough for both headers and magic value
+		if (dataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+			return DDS_PARSE_NOT_DDS;
+
+		bDXT10Header = true;
+	}
+
+	headerSize = sizeof(uint32_t)
+		+ sizeof(DDS_HEADER)
+		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+
+	return DDS_PARSE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+uint32_t DirectX::GetFirstRetainedMip(const DDSTextureLayout& layout, size_t maxsize)
+{
+	if (!maxsize || layout.mipCount <= 1 || layout.subresources.empty())
+		return 0;
+
+	for (uint32_t i = 0; i < layout.mipCount; ++i)
+	{
+		const DDSSubresourceLayout& sub = layout.subresources[i];
+		if (sub.width <= maxsize && sub.height <= maxsize && sub.depth <= maxsize)
+			return i;
+	}
+
+	return layout.mipCount;
+}
+
+
+//--------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------
+#define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
+
+DXGI_FORMAT DirectX::GetDXGIFormat( const DDS_PIXELFORMAT& ddpf )
+{
+    if (ddpf.flags & DDS_RGB)
+    {
+        // Note that sRGB formats are written using the "DX10" extended header
+
+        switch (ddpf.RGBBitCount)
+        {
+        case 32:
+            if (ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0xff000000))
+            {
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            }
+
+            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0xff000000))
+            {
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            }
+
+            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0x00000000))
+            {
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
+
+            // Note that many common DDS reader/writers (including D3DX) swap the
+            // the RED/BLUE masks for 10:10:10:2 formats. We assume
+            // below that the 'backwards' header mask is being used since it is most
+            // likely written by D3DX. The more robust solution is to use the 'DX10'
+            // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+            // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+            if (ISBITMASK(0x3ff00000,0x000ffc00,0x000003ff,0xc0000000))
+            {
+                return DXGI_FORMAT_R10G10B10A2_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+            if (ISBITMASK(0x0000ffff,0xffff0000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R16G16_UNORM;
+            }
+
+            if (ISBITMASK(0xffffffff,0x00000000,0x00000000,0x00000000))
+            {
+                // Only 32-bit color channel format in D3D9 was R32F
+                return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
+            }
+            break;
+
+        case 24:
+            // No 24bpp DXGI formats aka D3DFMT_R8G8B8
+            break;
+
+        case 16:
+            if (ISBITMASK(0x7c00,0x03e0,0x001f,0x8000))
+            {
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            }
+            if (ISBITMASK(0xf800,0x07e0,0x001f,0x0000))
+            {
+                return DXGI_FORMAT_B5G6R5_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
+
+            if (ISBITMASK(0x0f00,0x00f0,0x000f,0xf000))
+            {
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+            }
+
+            // No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
+
+            // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+            break;
+        }
+    }
+    else if (ddpf.flags & DDS_LUMINANCE)
+    {
+        if (8 == ddpf.RGBBitCount)
+        {
+            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+
+            // No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
+        }
+
+        if (16 == ddpf.RGBBitCount)
+        {
+            if (ISBITMASK(0x0000ffff,0x00000000,0x00000000,0x00000000))
+            {
+                return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x0000ff00))
+            {
+                return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
+            }
+        }
+    }
+    else if (ddpf.flags & DDS_ALPHA)
+    {
+        if (8 == ddpf.RGBBitCount)
+        {
+            return DXGI_FORMAT_A8_UNORM;
+        }
+    }
+    else if (ddpf.flags & DDS_FOURCC)
+    {
+        if (MAKEFOURCC( 'D', 'X', 'T', '1' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC1_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '3' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '5' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+
+        // While pre-multiplied alpha isn't directly supported by the DXGI formats,
+        // they are basically the same as these BC formats so they can be mapped
+        if (MAKEFOURCC( 'D', 'X', 'T', '2' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if (MAKEFOURCC( 'D', 'X', 'T', '4' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+
+        if (MAKEFOURCC( 'A', 'T', 'I', '1' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '4', 'U' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '4', 'S' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC4_SNORM;
+        }
+
+        if (MAKEFOURCC( 'A', 'T', 'I', '2' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '5', 'U' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if (MAKEFOURCC( 'B', 'C', '5', 'S' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_BC5_SNORM;
+        }
+
+        // BC6H and BC7 are written using the "DX10" extended header
+
+        if (MAKEFOURCC( 'R', 'G', 'B', 'G' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_R8G8_B8G8_UNORM;
+        }
+        if (MAKEFOURCC( 'G', 'R', 'G', 'B' ) == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_G8R8_G8B8_UNORM;
+        }
+
+        if (MAKEFOURCC('Y','U','Y','2') == ddpf.fourCC)
+        {
+            return DXGI_FORMAT_YUY2;
+        }
+
+        // Check for D3DFORMAT enums being set here
+        switch( ddpf.fourCC )
+        {
+        case 36: // D3DFMT_A16B16G16R16
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+
+        case 110: // D3DFMT_Q16W16V16U16
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+
+        case 111: // D3DFMT_R16F
+            return DXGI_FORMAT_R16_FLOAT;
+
+        case 112: // D3DFMT_G16R16F
+            return DXGI_FORMAT_R16G16_FLOAT;
+
+        case 113: // D3DFMT_A16B16G16R16F
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+        case 114: // D3DFMT_R32F
+            return DXGI_FORMAT_R32_FLOAT;
+
+        case 115: // D3DFMT_G32R32F
+            return DXGI_FORMAT_R32G32_FLOAT;
+
+        case 116: // D3DFMT_A32B32G32R32F
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+#undef ISBITMASK
@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------
+// File: DDSLayout.h
+//
+// Device-independent DDS parsing: validates the headers and describes the texture and
+// where every subresource lives in the file, without a graphics device or windows.h.
+// The D3D12 loader builds on it, and tools can use it to scan textures offline.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct DDS_PIXELFORMAT;
+
+namespace DirectX
+{
+	enum DDS_PARSE_STATUS
+	{
+		DDS_PARSE_OK            = 0,
+		DDS_PARSE_INVALID_ARG,              // Null data
+		DDS_PARSE_NOT_DDS,                  // Bad magic number, header size or truncated headers
+		DDS_PARSE_INVALID_DATA,             // Headers contradict themselves
+		DDS_PARSE_NOT_SUPPORTED,            // Valid DDS, but not something the loaders handle
+		DDS_PARSE_END_OF_FILE,              // Bit data shorter than the headers describe
+		DDS_PARSE_OUT_OF_MEMORY,            // Couldn't allocate the unpacked data (ExpandDDSZ)
+	};
+
+	enum DDS_PARSE_FLAGS
+	{
+		DDS_PARSE_FLAGS_NONE            = 0x0,
+		DDS_PARSE_FLAGS_CONVERT_LEGACY  = 0x1,  // Accept the legacy layouts DDS_CONVERSION covers
+	};
+
+	// Legacy pixel layouts with no DXGI twin. The layout reports the format they convert
+	// to; the bit data has to go through ConvertLegacyRow on its way to the GPU.
+	enum DDS_CONVERSION
+	{
+		DDS_CONVERSION_NONE = 0,
+		DDS_CONVERSION_X8B8G8R8,            // -> R8G8B8A8_UNORM, alpha set opaque
+		DDS_CONVERSION_A2R10G10B10,         // -> R10G10B10A2_UNORM, red and blue swapped
+		DDS_CONVERSION_X1R5G5B5,            // -> B5G5R5A1_UNORM, alpha set opaque
+		DDS_CONVERSION_X4R4G4B4,            // -> B4G4R4A4_UNORM, alpha set opaque
+		DDS_CONVERSION_A4L4,                // -> R8G8B8A8_UNORM, luminance copied to RGB
+	};
+
+	enum DDS_TEXTURE_DIMENSION
+	{
+		DDS_TEXTURE_DIMENSION_UNKNOWN   = 0,
+		DDS_TEXTURE_DIMENSION_1D        = 2,    // Same values as D3D12_RESOURCE_DIMENSION
+		DDS_TEXTURE_DIMENSION_2D        = 3,
+		DDS_TEXTURE_DIMENSION_3D        = 4,
+	};
+
+	struct DDSSubresourceLayout
+	{
+		uint64_t    offset;         // From the start of the bit data
+		uint64_t    rowPitch;       // Bytes per row of pixels or blocks in the file, unpadded
+		uint64_t    slicePitch;     // Bytes per depth slice in the file
+		uint32_t    numRows;        // Rows of pixels or blocks per depth slice
+		uint32_t    width;
+		uint32_t    height;
+		uint32_t    depth;
+	};
+
+	struct DDSTextureLayout
+	{
+		uint32_t                width;
+		uint32_t                height;
+		uint32_t                depth;          // 1 unless 3D
+		uint32_t                mipCount;
+		uint32_t                arraySize;      // Includes the six faces of each cube
+		DXGI_FORMAT             format;
+		DDS_CONVERSION          conversion;     // How the bit data becomes format; usually NONE
+		DDS_TEXTURE_DIMENSION   dimension;
+		bool                    isCubeMap;
+		uint32_t                alphaMode;      // DDS_ALPHA_MODE value, 0 (unknown) if not recorded
+		size_t                  headerSize;     // Magic number plus headers; the bit data follows
+		uint64_t                bitSize;        // Bytes of bit data the subresources cover
+
+		// One entry per subresource in D3D12 order: mip + slice * mipCount
+		std::vector<DDSSubresourceLayout> subresources;
+	};
+
+	// data starts at the magic number. It is normally the whole file; pass fileSize when it
+	// only holds the headers, and the subresources are still checked against the full file.
+	// flags is a combination of DDS_PARSE_FLAGS.
+	DDS_PARSE_STATUS ParseDDS(const uint8_t* data,
+	                          size_t dataSize,
+	                          DDSTextureLayout& layout,
+	                          uint64_t fileSize = 0,
+	                          uint32_t flags = DDS_PARSE_FLAGS_NONE);
+
+	// Just the header checks ParseDDS starts with: the magic number, the header sizes and
+	// room for the DX10 extension. headerSize is set to where the bit data starts.
+	DDS_PARSE_STATUS GetDDSHeaderSize(const uint8_t* data, size_t dataSize, size_t& headerSize);
+
+	// First mip whose dimensions all fit within maxsize (0 when maxsize is 0 or the texture
+	// has a single mip); returns layout.mipCount when none fits.
+	uint32_t GetFirstRetainedMip(const DDSTextureLayout& layout, size_t maxsize);
+
+	// Maps a legacy (non-DX10) pixel format to DXGI; DXGI_FORMAT_UNKNOWN if there is none
+	DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+}
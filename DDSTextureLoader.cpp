@@ -20,10 +20,25 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 #include <wrl.h>
 
 #include "DDSTextureLoader.h" 
+#include "BCEncoder.h"
+#include "DDS.h"
+#include "DDSLayout.h"
+#include "DDSZ.h"
+#include "DDSConvert.h"
+#include "DXGIFormatTraits.h"
+#include "MipGenerator.h"
+#include "ResourceStateManager.h"
+#include "TextureFootprints.h"
+#include "ThreadPool.h"
+#include "UploadRingBuffer.h"
 
 using namespace Microsoft::WRL;
 
@@ -33,93 +48,6 @@ using namespace Microsoft::WRL;
 
 using namespace DirectX;
 
-//--------------------------------------------------------------------------------------
-// Macros
-//--------------------------------------------------------------------------------------
-#ifndef MAKEFOURCC
-    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
-                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
-                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
-#endif /* defined(MAKEFOURCC) */
-
-//--------------------------------------------------------------------------------------
-// DDS file structure definitions
-//
-// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
-//--------------------------------------------------------------------------------------
-#pragma pack(push,1)
-
-const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
-
-struct DDS_PIXELFORMAT
-{
-    uint32_t    size;
-    uint32_t    flags;
-    uint32_t    fourCC;
-    uint32_t    RGBBitCount;
-    uint32_t    RBitMask;
-    uint32_t    GBitMask;
-    uint32_t    BBitMask;
-    uint32_t    ABitMask;
-};
-
-#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
-#define DDS_RGB         0x00000040  // DDPF_RGB
-#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
-#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
-
-#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
-
-#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
-#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
-
-#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
-#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
-#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
-#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
-#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
-#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
-
-#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
-                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
-                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
-
-#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
-
-enum DDS_MISC_FLAGS2
-{
-    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
-};
-
-struct DDS_HEADER
-{
-    uint32_t        size;
-    uint32_t        flags;
-    uint32_t        height;
-    uint32_t        width;
-    uint32_t        pitchOrLinearSize;
-    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
-    uint32_t        mipMapCount;
-    uint32_t        reserved1[11];
-    DDS_PIXELFORMAT ddspf;
-    uint32_t        caps;
-    uint32_t        caps2;
-    uint32_t        caps3;
-    uint32_t        caps4;
-    uint32_t        reserved2;
-};
-
-struct DDS_HEADER_DXT10
-{
-    DXGI_FORMAT     dxgiFormat;
-    uint32_t        resourceDimension;
-    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
-    uint32_t        arraySize;
-    uint32_t        miscFlags2;
-};
-
-#pragma pack(pop)
-
 //--------------------------------------------------------------------------------------
 namespace
 {
@@ -130,6 +58,10 @@ typedef public std::unique_ptr<void, handle_closer> ScopedHandle;
 
 inline HANDLE safe_handle( HANDLE h ) { return (h == INVALID_HANDLE_VALUE) ? 0 : h; }
 
+struct view_unmapper { void operator()(const void* p) { if (p) UnmapViewOfFile(p); } };
+
+typedef std::unique_ptr<const void, view_unmapper> ScopedFileView;
+
 template<UINT TNameLength>
 inline void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char (&name)[TNameLength])
 {
@@ -144,33 +76,27 @@ inline void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char
 };
 
 //--------------------------------------------------------------------------------------
-static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
-                                        std::unique_ptr<uint8_t[]>& ddsData,
-                                        DDS_HEADER** header,
-                                        uint8_t** bitData,
-                                        size_t* bitSize
-                                      )
+// Opens a DDS file for reading and returns its size
+//--------------------------------------------------------------------------------------
+static HRESULT OpenDDSFile( _In_z_ const wchar_t* fileName,
+                            ScopedHandle& hFile,
+                            LARGE_INTEGER& fileSize
+                          )
 {
-    if (!header || !bitData || !bitSize)
-    {
-        return E_POINTER;
-    }
-
-    // open the file
 #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
-    ScopedHandle hFile( safe_handle( CreateFile2( fileName,
-                                                  GENERIC_READ,
-                                                  FILE_SHARE_READ,
-                                                  OPEN_EXISTING,
-                                                  nullptr ) ) );
+    hFile.reset( safe_handle( CreateFile2( fileName,
+                                           GENERIC_READ,
+                                           FILE_SHARE_READ,
+                                           OPEN_EXISTING,
+                                           nullptr ) ) );
 #else
-    ScopedHandle hFile( safe_handle( CreateFileW( fileName,
-                                                  GENERIC_READ,
-                                                  FILE_SHARE_READ,
-                                                  nullptr,
-                                                  OPEN_EXISTING,
-                                                  FILE_ATTRIBUTE_NORMAL,
-                                                  nullptr ) ) );
+    hFile.reset( safe_handle( CreateFileW( fileName,
+                                           GENERIC_READ,
+                                           FILE_SHARE_READ,
+                                           nullptr,
+                                           OPEN_EXISTING,
+                                           FILE_ATTRIBUTE_NORMAL,
+                                           nullptr ) ) );
 #endif
 
     if ( !hFile )
@@ -178,8 +104,7 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
         return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    // Get the file size
-    LARGE_INTEGER FileSize = { 0 };
+    fileSize.QuadPart = 0;
 
 #if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
     FILE_STANDARD_INFO fileInfo;
@@ -187,11 +112,71 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
     {
         return HRESULT_FROM_WIN32( GetLastError() );
     }
-    FileSize = fileInfo.EndOfFile;
+    fileSize = fileInfo.EndOfFile;
 #else
-    GetFileSizeEx( hFile.get(), &FileSize );
+    GetFileSizeEx( hFile.get(), &fileSize );
 #endif
 
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Positional read (the handle is synchronous, so this returns once the data is in place)
+//--------------------------------------------------------------------------------------
+static HRESULT ReadFileAt( _In_ HANDLE hFile,
+                           _In_ uint64_t offset,
+                           _Out_writes_bytes_(size) void* dest,
+                           _In_ size_t size
+                         )
+{
+    auto ptr = static_cast<uint8_t*>( dest );
+    while ( size > 0 )
+    {
+        const DWORD chunk = static_cast<DWORD>( std::min<size_t>( size, 0x40000000 ) );
+
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>( offset );
+        ov.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+
+        DWORD bytesRead = 0;
+        if ( !ReadFile( hFile, ptr, chunk, &bytesRead, &ov ) )
+        {
+            return HRESULT_FROM_WIN32( GetLastError() );
+        }
+
+        if ( bytesRead < chunk )
+        {
+            return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+        }
+
+        ptr += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Opens a DDS file that is to be read or mapped whole, rejecting files too large for a
+// 32-bit size or too small to hold the headers
+//--------------------------------------------------------------------------------------
+static HRESULT OpenWholeDDSFile( _In_z_ const wchar_t* fileName,
+                                 ScopedHandle& hFile,
+                                 DWORD& fileSize
+                               )
+{
+    fileSize = 0;
+
+    LARGE_INTEGER FileSize = { 0 };
+    HRESULT hr = OpenDDSFile( fileName, hFile, FileSize );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
     // File is too big for 32-bit allocation, so reject read
     if (FileSize.HighPart > 0)
     {
@@ -204,8 +189,91 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
         return E_FAIL;
     }
 
+    fileSize = FileSize.LowPart;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Unpacks the contents of a DDSZ file into ddsData, which then holds the plain DDS file
+// it was packed from. dataSize is updated to match.
+//--------------------------------------------------------------------------------------
+static HRESULT ExpandDDSZFileData( _In_reads_bytes_(dataSize) const uint8_t* fileData,
+                                   size_t& dataSize,
+                                   std::unique_ptr<uint8_t[]>& ddsData,
+                                   _In_opt_ ThreadPool* pool
+                                 )
+{
+    std::unique_ptr<uint8_t[]> expanded;
+    switch ( ExpandDDSZ( fileData, dataSize, expanded, dataSize, pool ) )
+    {
+    case DDS_PARSE_OK:
+        break;
+
+    case DDS_PARSE_OUT_OF_MEMORY:
+        return E_OUTOFMEMORY;
+
+    default:
+        return E_FAIL;
+    }
+
+    ddsData = std::move( expanded );
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Validates the headers of a whole DDS file in memory and points header and bitData into
+// it. Both the read and the mapped paths come through here, so they accept the same files.
+//--------------------------------------------------------------------------------------
+static HRESULT GetTextureDataFromFileData( _In_reads_bytes_(dataSize) const uint8_t* ddsData,
+                                           size_t dataSize,
+                                           const DDS_HEADER** header,
+                                           const uint8_t** bitData,
+                                           size_t* bitSize
+                                         )
+{
+    size_t headerSize = 0;
+    if (GetDDSHeaderSize( ddsData, dataSize, headerSize ) != DDS_PARSE_OK)
+    {
+        return E_FAIL;
+    }
+
+    // setup the pointers in the process request
+    *header = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
+    *bitData = ddsData + headerSize;
+    *bitSize = dataSize - headerSize;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// DDSZ files are unpacked to the plain DDS file they were packed from, across pool
+//--------------------------------------------------------------------------------------
+static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
+                                        std::unique_ptr<uint8_t[]>& ddsData,
+                                        DDS_HEADER** header,
+                                        uint8_t** bitData,
+                                        size_t* bitSize,
+                                        _In_opt_ ThreadPool* pool = nullptr
+                                      )
+{
+    if (!header || !bitData || !bitSize)
+    {
+        return E_POINTER;
+    }
+
+    ScopedHandle hFile;
+    DWORD fileSize = 0;
+    HRESULT hr = OpenWholeDDSFile( fileName, hFile, fileSize );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
     // create enough space for the file data
-    ddsData.reset( new (std::nothrow) uint8_t[ FileSize.LowPart ] );
+    ddsData.reset( new (std::nothrow) uint8_t[ fileSize ] );
     if (!ddsData)
     {
         return E_OUTOFMEMORY;
@@ -215,7 +283,7 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
     DWORD BytesRead = 0;
     if (!ReadFile( hFile.get(),
                    ddsData.get(),
-                   FileSize.LowPart,
+                   fileSize,
                    &BytesRead,
                    nullptr
                  ))
@@ -223,49 +291,100 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
         return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    if (BytesRead < FileSize.LowPart)
+    if (BytesRead < fileSize)
     {
         return E_FAIL;
     }
 
-    // DDS files always start with the same magic number ("DDS ")
-    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData.get() );
-    if (dwMagicNumber != DDS_MAGIC)
+    size_t dataSize = fileSize;
+
+    if (*reinterpret_cast<const uint32_t*>( ddsData.get() ) == DDSZ_MAGIC)
     {
-        return E_FAIL;
+        hr = ExpandDDSZFileData( ddsData.get(), dataSize, ddsData, pool );
+        if ( FAILED(hr) )
+        {
+            return hr;
+        }
+    }
+
+    // The buffer belongs to the caller, so the pointers into it may be writable
+    const DDS_HEADER* fileHeader = nullptr;
+    const uint8_t* fileBits = nullptr;
+    hr = GetTextureDataFromFileData( ddsData.get(), dataSize, &fileHeader, &fileBits, bitSize );
+    if ( FAILED(hr) )
+    {
+        return hr;
     }
 
-    auto hdr = reinterpret_cast<DDS_HEADER*>( ddsData.get() + sizeof( uint32_t ) );
+    *header = const_cast<DDS_HEADER*>( fileHeader );
+    *bitData = const_cast<uint8_t*>( fileBits );
 
-    // Verify header to validate DDS file
-    if (hdr->size != sizeof(DDS_HEADER) ||
-        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Maps the file read-only instead of copying it into a heap buffer, so the subresource
+// data later handed to UpdateSubresources points straight into the mapped view. A DDSZ
+// file can't be used in place: it is unpacked from the view into ddsData, and the view
+// is released.
+//--------------------------------------------------------------------------------------
+static HRESULT MapTextureDataFromFile( _In_z_ const wchar_t* fileName,
+                                       ScopedFileView& ddsView,
+                                       std::unique_ptr<uint8_t[]>& ddsData,
+                                       const DDS_HEADER** header,
+                                       const uint8_t** bitData,
+                                       size_t* bitSize,
+                                       _In_opt_ ThreadPool* pool = nullptr
+                                     )
+{
+    if (!header || !bitData || !bitSize)
     {
-        return E_FAIL;
+        return E_POINTER;
     }
 
-    // Check for DX10 extension
-    bool bDXT10Header = false;
-    if ((hdr->ddspf.flags & DDS_FOURCC) &&
-        (MAKEFOURCC( 'D', 'X', '1', '0' ) == hdr->ddspf.fourCC))
+    ScopedHandle hFile;
+    DWORD fileSize = 0;
+    HRESULT hr = OpenWholeDDSFile( fileName, hFile, fileSize );
+    if ( FAILED(hr) )
     {
-        // Must be long enough for both headers and magic value
-        if (FileSize.LowPart < ( sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10) ) )
+        return hr;
+    }
+
+    // The view keeps the mapping object alive, so the mapping handle can be closed on return
+    ScopedHandle hMapping( CreateFileMappingW( hFile.get(),
+                                               nullptr,
+                                               PAGE_READONLY,
+                                               0,
+                                               0,
+                                               nullptr ) );
+    if ( !hMapping )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    ddsView.reset( MapViewOfFile( hMapping.get(), FILE_MAP_READ, 0, 0, 0 ) );
+    if ( !ddsView )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    auto fileData = static_cast<const uint8_t*>( ddsView.get() );
+    size_t dataSize = fileSize;
+
+    if (*reinterpret_cast<const uint32_t*>( fileData ) == DDSZ_MAGIC)
+    {
+        hr = ExpandDDSZFileData( fileData, dataSize, ddsData, pool );
+        ddsView.reset();
+        if ( FAILED(hr) )
         {
-            return E_FAIL;
+            return hr;
         }
 
-        bDXT10Header = true;
+        fileData = ddsData.get();
     }
 
-    // setup the pointers in the process request
-    *header = hdr;
-    ptrdiff_t offset = sizeof( uint32_t ) + sizeof( DDS_HEADER )
-                       + (bDXT10Header ? sizeof( DDS_HEADER_DXT10 ) : 0);
-    *bitData = ddsData.get() + offset;
-    *bitSize = FileSize.LowPart - offset;
-
-    return S_OK;
+    return GetTextureDataFromFileData( fileData, dataSize, header, bitData, bitSize );
 }
 
 
@@ -274,148 +393,7 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
 //--------------------------------------------------------------------------------------
 static size_t BitsPerPixel( _In_ DXGI_FORMAT fmt )
 {
-    switch( fmt )
-    {
-    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
-    case DXGI_FORMAT_R32G32B32A32_FLOAT:
-    case DXGI_FORMAT_R32G32B32A32_UINT:
-    case DXGI_FORMAT_R32G32B32A32_SINT:
-        return 128;
-
-    case DXGI_FORMAT_R32G32B32_TYPELESS:
-    case DXGI_FORMAT_R32G32B32_FLOAT:
-    case DXGI_FORMAT_R32G32B32_UINT:
-    case DXGI_FORMAT_R32G32B32_SINT:
-        return 96;
-
-    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
-    case DXGI_FORMAT_R16G16B16A16_FLOAT:
-    case DXGI_FORMAT_R16G16B16A16_UNORM:
-    case DXGI_FORMAT_R16G16B16A16_UINT:
-    case DXGI_FORMAT_R16G16B16A16_SNORM:
-    case DXGI_FORMAT_R16G16B16A16_SINT:
-    case DXGI_FORMAT_R32G32_TYPELESS:
-    case DXGI_FORMAT_R32G32_FLOAT:
-    case DXGI_FORMAT_R32G32_UINT:
-    case DXGI_FORMAT_R32G32_SINT:
-    case DXGI_FORMAT_R32G8X24_TYPELESS:
-    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
-    case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
-    case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
-    case DXGI_FORMAT_Y416:
-    case DXGI_FORMAT_Y210:
-    case DXGI_FORMAT_Y216:
-        return 64;
-
-    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
-    case DXGI_FORMAT_R10G10B10A2_UNORM:
-    case DXGI_FORMAT_R10G10B10A2_UINT:
-    case DXGI_FORMAT_R11G11B10_FLOAT:
-    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
-    case DXGI_FORMAT_R8G8B8A8_UNORM:
-    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-    case DXGI_FORMAT_R8G8B8A8_UINT:
-    case DXGI_FORMAT_R8G8B8A8_SNORM:
-    case DXGI_FORMAT_R8G8B8A8_SINT:
-    case DXGI_FORMAT_R16G16_TYPELESS:
-    case DXGI_FORMAT_R16G16_FLOAT:
-    case DXGI_FORMAT_R16G16_UNORM:
-    case DXGI_FORMAT_R16G16_UINT:
-    case DXGI_FORMAT_R16G16_SNORM:
-    case DXGI_FORMAT_R16G16_SINT:
-    case DXGI_FORMAT_R32_TYPELESS:
-    case DXGI_FORMAT_D32_FLOAT:
-    case DXGI_FORMAT_R32_FLOAT:
-    case DXGI_FORMAT_R32_UINT:
-    case DXGI_FORMAT_R32_SINT:
-    case DXGI_FORMAT_R24G8_TYPELESS:
-    case DXGI_FORMAT_D24_UNORM_S8_UINT:
-    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
-    case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
-    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
-    case DXGI_FORMAT_R8G8_B8G8_UNORM:
-    case DXGI_FORMAT_G8R8_G8B8_UNORM:
-    case DXGI_FORMAT_B8G8R8A8_UNORM:
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-    case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
-    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
-    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
-    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
-    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-    case DXGI_FORMAT_AYUV:
-    case DXGI_FORMAT_Y410:
-    case DXGI_FORMAT_YUY2:
-        return 32;
-
-    case DXGI_FORMAT_P010:
-    case DXGI_FORMAT_P016:
-        return 24;
-
-    case DXGI_FORMAT_R8G8_TYPELESS:
-    case DXGI_FORMAT_R8G8_UNORM:
-    case DXGI_FORMAT_R8G8_UINT:
-    case DXGI_FORMAT_R8G8_SNORM:
-    case DXGI_FORMAT_R8G8_SINT:
-    case DXGI_FORMAT_R16_TYPELESS:
-    case DXGI_FORMAT_R16_FLOAT:
-    case DXGI_FORMAT_D16_UNORM:
-    case DXGI_FORMAT_R16_UNORM:
-    case DXGI_FORMAT_R16_UINT:
-    case DXGI_FORMAT_R16_SNORM:
-    case DXGI_FORMAT_R16_SINT:
-    case DXGI_FORMAT_B5G6R5_UNORM:
-    case DXGI_FORMAT_B5G5R5A1_UNORM:
-    case DXGI_FORMAT_A8P8:
-    case DXGI_FORMAT_B4G4R4A4_UNORM:
-        return 16;
-
-    case DXGI_FORMAT_NV12:
-    case DXGI_FORMAT_420_OPAQUE:
-    case DXGI_FORMAT_NV11:
-        return 12;
-
-    case DXGI_FORMAT_R8_TYPELESS:
-    case DXGI_FORMAT_R8_UNORM:
-    case DXGI_FORMAT_R8_UINT:
-    case DXGI_FORMAT_R8_SNORM:
-    case DXGI_FORMAT_R8_SINT:
-    case DXGI_FORMAT_A8_UNORM:
-    case DXGI_FORMAT_AI44:
-    case DXGI_FORMAT_IA44:
-    case DXGI_FORMAT_P8:
-        return 8;
-
-    case DXGI_FORMAT_R1_UNORM:
-        return 1;
-
-    case DXGI_FORMAT_BC1_TYPELESS:
-    case DXGI_FORMAT_BC1_UNORM:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:
-    case DXGI_FORMAT_BC4_TYPELESS:
-    case DXGI_FORMAT_BC4_UNORM:
-    case DXGI_FORMAT_BC4_SNORM:
-        return 4;
-
-    case DXGI_FORMAT_BC2_TYPELESS:
-    case DXGI_FORMAT_BC2_UNORM:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:
-    case DXGI_FORMAT_BC3_TYPELESS:
-    case DXGI_FORMAT_BC3_UNORM:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:
-    case DXGI_FORMAT_BC5_TYPELESS:
-    case DXGI_FORMAT_BC5_UNORM:
-    case DXGI_FORMAT_BC5_SNORM:
-    case DXGI_FORMAT_BC6H_TYPELESS:
-    case DXGI_FORMAT_BC6H_UF16:
-    case DXGI_FORMAT_BC6H_SF16:
-    case DXGI_FORMAT_BC7_TYPELESS:
-    case DXGI_FORMAT_BC7_UNORM:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:
-        return 8;
-
-    default:
-        return 0;
-    }
+    return GetBitsPerPixel( fmt );
 }
 
 
@@ -429,429 +407,72 @@ static void GetSurfaceInfo( _In_ size_t width,
                             _Out_opt_ size_t* outRowBytes,
                             _Out_opt_ size_t* outNumRows )
 {
-    size_t numBytes = 0;
-    size_t rowBytes = 0;
-    size_t numRows = 0;
-
-    bool bc = false;
-    bool packed = false;
-    bool planar = false;
-    size_t bpe = 0;
-    switch (fmt)
-    {
-    case DXGI_FORMAT_BC1_TYPELESS:
-    case DXGI_FORMAT_BC1_UNORM:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:
-    case DXGI_FORMAT_BC4_TYPELESS:
-    case DXGI_FORMAT_BC4_UNORM:
-    case DXGI_FORMAT_BC4_SNORM:
-        bc=true;
-        bpe = 8;
-        break;
-
-    case DXGI_FORMAT_BC2_TYPELESS:
-    case DXGI_FORMAT_BC2_UNORM:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:
-    case DXGI_FORMAT_BC3_TYPELESS:
-    case DXGI_FORMAT_BC3_UNORM:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:
-    case DXGI_FORMAT_BC5_TYPELESS:
-    case DXGI_FORMAT_BC5_UNORM:
-    case DXGI_FORMAT_BC5_SNORM:
-    case DXGI_FORMAT_BC6H_TYPELESS:
-    case DXGI_FORMAT_BC6H_UF16:
-    case DXGI_FORMAT_BC6H_SF16:
-    case DXGI_FORMAT_BC7_TYPELESS:
-    case DXGI_FORMAT_BC7_UNORM:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:
-        bc = true;
-        bpe = 16;
-        break;
-
-    case DXGI_FORMAT_R8G8_B8G8_UNORM:
-    case DXGI_FORMAT_G8R8_G8B8_UNORM:
-    case DXGI_FORMAT_YUY2:
-        packed = true;
-        bpe = 4;
-        break;
-
-    case DXGI_FORMAT_Y210:
-    case DXGI_FORMAT_Y216:
-        packed = true;
-        bpe = 8;
-        break;
+    GetFormatSurfaceInfo( width, height, fmt, outNumBytes, outRowBytes, outNumRows );
+}
 
-    case DXGI_FORMAT_NV12:
-    case DXGI_FORMAT_420_OPAQUE:
-        planar = true;
-        bpe = 2;
-        break;
 
-    case DXGI_FORMAT_P010:
-    case DXGI_FORMAT_P016:
-        planar = true;
-        bpe = 4;
-        break;
-    }
+//--------------------------------------------------------------------------------------
+static DXGI_FORMAT MakeSRGB( _In_ DXGI_FORMAT format )
+{
+    return GetSRGBFormat( format );
+}
 
-    if (bc)
-    {
-        size_t numBlocksWide = 0;
-        if (width > 0)
-        {
-            numBlocksWide = std::max<size_t>( 1, (width + 3) / 4 );
-        }
-        size_t numBlocksHigh = 0;
-        if (height > 0)
-        {
-            numBlocksHigh = std::max<size_t>( 1, (height + 3) / 4 );
-        }
-        rowBytes = numBlocksWide * bpe;
-        numRows = numBlocksHigh;
-        numBytes = rowBytes * numBlocksHigh;
-    }
-    else if (packed)
-    {
-        rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
-        numRows = height;
-        numBytes = rowBytes * height;
-    }
-    else if ( fmt == DXGI_FORMAT_NV11 )
-    {
-        rowBytes = ( ( width + 3 ) >> 2 ) * 4;
-        numRows = height * 2; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
-        numBytes = rowBytes * numRows;
-    }
-    else if (planar)
-    {
-        rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
-        numBytes = ( rowBytes * height ) + ( ( rowBytes * height + 1 ) >> 1 );
-        numRows = height + ( ( height + 1 ) >> 1 );
-    }
-    else
-    {
-        size_t bpp = BitsPerPixel( fmt );
-        rowBytes = ( width * bpp + 7 ) / 8; // round up to nearest byte
-        numRows = height;
-        numBytes = rowBytes * height;
-    }
 
-    if (outNumBytes)
-    {
-        *outNumBytes = numBytes;
-    }
-    if (outRowBytes)
-    {
-        *outRowBytes = rowBytes;
-    }
-    if (outNumRows)
+//--------------------------------------------------------------------------------------
+static HRESULT FillInitData( _In_ size_t width,
+                             _In_ size_t height,
+                             _In_ size_t depth,
+                             _In_ size_t mipCount,
+                             _In_ size_t arraySize,
+                             _In_ DXGI_FORMAT format,
+                             _In_ size_t maxsize,
+                             _In_ size_t bitSize,
+                             _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                             _Out_ size_t& twidth,
+                             _Out_ size_t& theight,
+                             _Out_ size_t& tdepth,
+                             _Out_ size_t& skipMip,
+                             _Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData )
+{
+    if ( !bitData || !initData )
     {
-        *outNumRows = numRows;
+        return E_POINTER;
     }
-}
 
+    skipMip = 0;
+    twidth = 0;
+    theight = 0;
+    tdepth = 0;
 
-//--------------------------------------------------------------------------------------
-#define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
+    size_t NumBytes = 0;
+    size_t RowBytes = 0;
+    const uint8_t* pSrcBits = bitData;
+    const uint8_t* pEndBits = bitData + bitSize;
 
-static DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf )
-{
-    if (ddpf.flags & DDS_RGB)
+    size_t index = 0;
+    for( size_t j = 0; j < arraySize; j++ )
     {
-        // Note that sRGB formats are written using the "DX10" extended header
-
-        switch (ddpf.RGBBitCount)
+        size_t w = width;
+        size_t h = height;
+        size_t d = depth;
+        for( size_t i = 0; i < mipCount; i++ )
         {
-        case 32:
-            if (ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0xff000000))
-            {
-                return DXGI_FORMAT_R8G8B8A8_UNORM;
-            }
+            GetSurfaceInfo( w,
+                            h,
+                            format,
+                            &NumBytes,
+                            &RowBytes,
+                            nullptr
+                          );
 
-            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0xff000000))
+            if ( (mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize) )
             {
-                return DXGI_FORMAT_B8G8R8A8_UNORM;
-            }
-
-            if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0x00000000))
-            {
-                return DXGI_FORMAT_B8G8R8X8_UNORM;
-            }
-
-            // No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
-
-            // Note that many common DDS reader/writers (including D3DX) swap the
-            // the RED/BLUE masks for 10:10:10:2 formats. We assume
-            // below that the 'backwards' header mask is being used since it is most
-            // likely written by D3DX. The more robust solution is to use the 'DX10'
-            // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
-
-            // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
-            if (ISBITMASK(0x3ff00000,0x000ffc00,0x000003ff,0xc0000000))
-            {
-                return DXGI_FORMAT_R10G10B10A2_UNORM;
-            }
-
-            // No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
-
-            if (ISBITMASK(0x0000ffff,0xffff0000,0x00000000,0x00000000))
-            {
-                return DXGI_FORMAT_R16G16_UNORM;
-            }
-
-            if (ISBITMASK(0xffffffff,0x00000000,0x00000000,0x00000000))
-            {
-                // Only 32-bit color channel format in D3D9 was R32F
-                return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
-            }
-            break;
-
-        case 24:
-            // No 24bpp DXGI formats aka D3DFMT_R8G8B8
-            break;
-
-        case 16:
-            if (ISBITMASK(0x7c00,0x03e0,0x001f,0x8000))
-            {
-                return DXGI_FORMAT_B5G5R5A1_UNORM;
-            }
-            if (ISBITMASK(0xf800,0x07e0,0x001f,0x0000))
-            {
-                return DXGI_FORMAT_B5G6R5_UNORM;
-            }
-
-            // No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
-
-            if (ISBITMASK(0x0f00,0x00f0,0x000f,0xf000))
-            {
-                return DXGI_FORMAT_B4G4R4A4_UNORM;
-            }
-
-            // No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
-
-            // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
-            break;
-        }
-    }
-    else if (ddpf.flags & DDS_LUMINANCE)
-    {
-        if (8 == ddpf.RGBBitCount)
-        {
-            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x00000000))
-            {
-                return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
-            }
-
-            // No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
-        }
-
-        if (16 == ddpf.RGBBitCount)
-        {
-            if (ISBITMASK(0x0000ffff,0x00000000,0x00000000,0x00000000))
-            {
-                return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
-            }
-            if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x0000ff00))
-            {
-                return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
-            }
-        }
-    }
-    else if (ddpf.flags & DDS_ALPHA)
-    {
-        if (8 == ddpf.RGBBitCount)
-        {
-            return DXGI_FORMAT_A8_UNORM;
-        }
-    }
-    else if (ddpf.flags & DDS_FOURCC)
-    {
-        if (MAKEFOURCC( 'D', 'X', 'T', '1' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC1_UNORM;
-        }
-        if (MAKEFOURCC( 'D', 'X', 'T', '3' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC2_UNORM;
-        }
-        if (MAKEFOURCC( 'D', 'X', 'T', '5' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC3_UNORM;
-        }
-
-        // While pre-multiplied alpha isn't directly supported by the DXGI formats,
-        // they are basically the same as these BC formats so they can be mapped
-        if (MAKEFOURCC( 'D', 'X', 'T', '2' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC2_UNORM;
-        }
-        if (MAKEFOURCC( 'D', 'X', 'T', '4' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC3_UNORM;
-        }
-
-        if (MAKEFOURCC( 'A', 'T', 'I', '1' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC4_UNORM;
-        }
-        if (MAKEFOURCC( 'B', 'C', '4', 'U' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC4_UNORM;
-        }
-        if (MAKEFOURCC( 'B', 'C', '4', 'S' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC4_SNORM;
-        }
-
-        if (MAKEFOURCC( 'A', 'T', 'I', '2' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC5_UNORM;
-        }
-        if (MAKEFOURCC( 'B', 'C', '5', 'U' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC5_UNORM;
-        }
-        if (MAKEFOURCC( 'B', 'C', '5', 'S' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_BC5_SNORM;
-        }
-
-        // BC6H and BC7 are written using the "DX10" extended header
-
-        if (MAKEFOURCC( 'R', 'G', 'B', 'G' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_R8G8_B8G8_UNORM;
-        }
-        if (MAKEFOURCC( 'G', 'R', 'G', 'B' ) == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_G8R8_G8B8_UNORM;
-        }
-
-        if (MAKEFOURCC('Y','U','Y','2') == ddpf.fourCC)
-        {
-            return DXGI_FORMAT_YUY2;
-        }
-
-        // Check for D3DFORMAT enums being set here
-        switch( ddpf.fourCC )
-        {
-        case 36: // D3DFMT_A16B16G16R16
-            return DXGI_FORMAT_R16G16B16A16_UNORM;
-
-        case 110: // D3DFMT_Q16W16V16U16
-            return DXGI_FORMAT_R16G16B16A16_SNORM;
-
-        case 111: // D3DFMT_R16F
-            return DXGI_FORMAT_R16_FLOAT;
-
-        case 112: // D3DFMT_G16R16F
-            return DXGI_FORMAT_R16G16_FLOAT;
-
-        case 113: // D3DFMT_A16B16G16R16F
-            return DXGI_FORMAT_R16G16B16A16_FLOAT;
-
-        case 114: // D3DFMT_R32F
-            return DXGI_FORMAT_R32_FLOAT;
-
-        case 115: // D3DFMT_G32R32F
-            return DXGI_FORMAT_R32G32_FLOAT;
-
-        case 116: // D3DFMT_A32B32G32R32F
-            return DXGI_FORMAT_R32G32B32A32_FLOAT;
-        }
-    }
-
-    return DXGI_FORMAT_UNKNOWN;
-}
-
-
-//--------------------------------------------------------------------------------------
-static DXGI_FORMAT MakeSRGB( _In_ DXGI_FORMAT format )
-{
-    switch( format )
-    {
-    case DXGI_FORMAT_R8G8B8A8_UNORM:
-        return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC1_UNORM:
-        return DXGI_FORMAT_BC1_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC2_UNORM:
-        return DXGI_FORMAT_BC2_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC3_UNORM:
-        return DXGI_FORMAT_BC3_UNORM_SRGB;
-
-    case DXGI_FORMAT_B8G8R8A8_UNORM:
-        return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
-
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-        return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC7_UNORM:
-        return DXGI_FORMAT_BC7_UNORM_SRGB;
-
-    default:
-        return format;
-    }
-}
-
-
-//--------------------------------------------------------------------------------------
-static HRESULT FillInitData( _In_ size_t width,
-                             _In_ size_t height,
-                             _In_ size_t depth,
-                             _In_ size_t mipCount,
-                             _In_ size_t arraySize,
-                             _In_ DXGI_FORMAT format,
-                             _In_ size_t maxsize,
-                             _In_ size_t bitSize,
-                             _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                             _Out_ size_t& twidth,
-                             _Out_ size_t& theight,
-                             _Out_ size_t& tdepth,
-                             _Out_ size_t& skipMip,
-                             _Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData )
-{
-    if ( !bitData || !initData )
-    {
-        return E_POINTER;
-    }
-
-    skipMip = 0;
-    twidth = 0;
-    theight = 0;
-    tdepth = 0;
-
-    size_t NumBytes = 0;
-    size_t RowBytes = 0;
-    const uint8_t* pSrcBits = bitData;
-    const uint8_t* pEndBits = bitData + bitSize;
-
-    size_t index = 0;
-    for( size_t j = 0; j < arraySize; j++ )
-    {
-        size_t w = width;
-        size_t h = height;
-        size_t d = depth;
-        for( size_t i = 0; i < mipCount; i++ )
-        {
-            GetSurfaceInfo( w,
-                            h,
-                            format,
-                            &NumBytes,
-                            &RowBytes,
-                            nullptr
-                          );
-
-            if ( (mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize) )
-            {
-                if ( !twidth )
-                {
-                    twidth = w;
-                    theight = h;
-                    tdepth = d;
-                }
+                if ( !twidth )
+                {
+                    twidth = w;
+                    theight = h;
+                    tdepth = d;
+                }
 
                 assert(index < mipCount * arraySize);
                 _Analysis_assume_(index < mipCount * arraySize);
@@ -894,103 +515,6 @@ static HRESULT FillInitData( _In_ size_t width,
     return (index > 0) ? S_OK : E_FAIL;
 }
 
-static HRESULT FillInitData12(_In_ size_t width,
-	_In_ size_t height,
-	_In_ size_t depth,
-	_In_ size_t mipCount,
-	_In_ size_t arraySize,
-	_In_ DXGI_FORMAT format,
-	_In_ size_t maxsize,
-	_In_ size_t bitSize,
-	_In_reads_bytes_(bitSize) const uint8_t* bitData,
-	_Out_ size_t& twidth,
-	_Out_ size_t& theight,
-	_Out_ size_t& tdepth,
-	_Out_ size_t& skipMip,
-	_Out_writes_(mipCount*arraySize) D3D12_SUBRESOURCE_DATA* initData
-	)
-{
-	if (!bitData || !initData)
-	{
-		return E_POINTER;
-	}
-
-	skipMip = 0;
-	twidth = 0;
-	theight = 0;
-	tdepth = 0;
-
-	size_t NumBytes = 0;
-	size_t RowBytes = 0;
-	const uint8_t* pSrcBits = bitData;
-	const uint8_t* pEndBits = bitData + bitSize;
-
-	size_t index = 0;
-	for (size_t j = 0; j < arraySize; j++)
-	{
-		size_t w = width;
-		size_t h = height;
-		size_t d = depth;
-		for (size_t i = 0; i < mipCount; i++)
-		{
-			GetSurfaceInfo(w,
-				h,
-				format,
-				&NumBytes,
-				&RowBytes,
-				nullptr
-				);
-
-			if ((mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize))
-			{
-				if (!twidth)
-				{
-					twidth = w;
-					theight = h;
-					tdepth = d;
-				}
-
-				assert(index < mipCount * arraySize);
-				_Analysis_assume_(index < mipCount * arraySize);
-				initData[index]./*pSysMem*/pData = (const void*)pSrcBits;
-				initData[index]./*SysMemPitch*/RowPitch = static_cast<UINT>(RowBytes);
-				initData[index]./*SysMemSlicePitch*/SlicePitch = static_cast<UINT>(NumBytes);
-				++index;
-			}
-			else if (!j)
-			{
-				// Count number of skipped mipmaps (first item only)
-				++skipMip;
-			}
-
-			if (pSrcBits + (NumBytes*d) > pEndBits)
-			{
-				return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-			}
-
-			pSrcBits += NumBytes * d;
-
-			w = w >> 1;
-			h = h >> 1;
-			d = d >> 1;
-			if (w == 0)
-			{
-				w = 1;
-			}
-			if (h == 0)
-			{
-				h = 1;
-			}
-			if (d == 0)
-			{
-				d = 1;
-			}
-		}
-	}
-
-	return (index > 0) ? S_OK : E_FAIL;
-}
-
 //--------------------------------------------------------------------------------------
 static HRESULT CreateD3DResources( _In_ ID3D11Device* d3dDevice,
                                    _In_ uint32_t resDim,
@@ -1227,9 +751,10 @@ static HRESULT CreateD3DResources( _In_ ID3D11Device* d3dDevice,
     return hr;
 }
 
-static HRESULT CreateD3DResources12(
-	ID3D12Device* device,
-	ID3D12GraphicsCommandList* cmdList,
+//--------------------------------------------------------------------------------------
+// Creates the default-heap texture in the COMMON state; the caller records the upload
+static HRESULT CreateTextureResource12(
+	_In_ ID3D12Device* device,
 	_In_ uint32_t resDim,
 	_In_ size_t width,
 	_In_ size_t height,
@@ -1237,19 +762,11 @@ static HRESULT CreateD3DResources12(
 	_In_ size_t mipCount,
 	_In_ size_t arraySize,
 	_In_ DXGI_FORMAT format,
-	_In_ bool forceSRGB,
-	_In_ bool isCubeMap,
-	_In_reads_opt_(mipCount*arraySize) D3D12_SUBRESOURCE_DATA* initData,
-	ComPtr<ID3D12Resource>& texture,
-	ComPtr<ID3D12Resource>& textureUploadHeap
-	)
+	ComPtr<ID3D12Resource>& texture)
 {
 	if (device == nullptr)
 		return E_POINTER;
 
-	if (forceSRGB)
-		format = MakeSRGB(format);
-
 	HRESULT hr = E_FAIL;
 	switch (resDim)
 	{
@@ -1281,36 +798,6 @@ static HRESULT CreateD3DResources12(
 		if (FAILED(hr))
 		{
 			texture = nullptr;
-			return hr;
-		}
-		else
-		{
-			const UINT num2DSubresources = texDesc.DepthOrArraySize * texDesc.MipLevels;
-			const UINT64 uploadBufferSize = GetRequiredIntermediateSize(texture.Get(), 0, num2DSubresources);
-
-			hr = device->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-				D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(&textureUploadHeap));
-			if (FAILED(hr))
-			{
-				texture = nullptr;
-				return hr;
-			}
-			else
-			{
-				cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture.Get(),
-					D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-
-				// Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
-				UpdateSubresources(cmdList, texture.Get(), textureUploadHeap.Get(), 0, 0, num2DSubresources, initData);
-
-				cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture.Get(),
-					D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-			}
 		}
 	} break;
 	}
@@ -1318,30 +805,494 @@ static HRESULT CreateD3DResources12(
 	return hr;
 }
 
-
 //--------------------------------------------------------------------------------------
-static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
-                                     _In_opt_ ID3D11DeviceContext* d3dContext,
-                                     _In_ const DDS_HEADER* header,
-                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                                     _In_ size_t bitSize,
-                                     _In_ size_t maxsize,
-                                     _In_ D3D11_USAGE usage,
-                                     _In_ unsigned int bindFlags,
-                                     _In_ unsigned int cpuAccessFlags,
-                                     _In_ unsigned int miscFlags,
-                                     _In_ bool forceSRGB,
-                                     _Outptr_opt_ ID3D11Resource** texture,
-                                     _Outptr_opt_ ID3D11ShaderResourceView** textureView )
+// Upload copies are cut into bands of whole rows within one depth slice. Below the
+// threshold the copy stays on the calling thread, where handing it off costs more than
+// it saves; above it each band is roughly PARALLEL_COPY_BAND_BYTES.
+//--------------------------------------------------------------------------------------
+static const SIZE_T PARALLEL_COPY_THRESHOLD = 4 * 1024 * 1024;
+static const SIZE_T PARALLEL_COPY_BAND_BYTES = 512 * 1024;
+
+struct UploadCopyBand12
 {
-    HRESULT hr = S_OK;
+	const uint8_t*	src;
+	uint8_t*		dest;
+	SIZE_T			srcRowPitch;
+	SIZE_T			destRowPitch;
+	SIZE_T			rowSize;
+	UINT			numRows;
+	DDS_CONVERSION	conversion;
+	UINT			pixels;			// Per row, when converting
+};
 
-    UINT width = header->width;
-    UINT height = header->height;
-    UINT depth = header->depth;
+static void AddUploadCopyBands12(
+	std::vector<UploadCopyBand12>& bands,
+	_In_ uint8_t* dest,
+	const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout,
+	_In_ UINT numRows,
+	_In_ SIZE_T rowSize,
+	const D3D12_SUBRESOURCE_DATA& src,
+	_In_ DDS_CONVERSION conversion,
+	_In_ SIZE_T bandBytes)
+{
+	const SIZE_T destSlicePitch = SIZE_T(layout.Footprint.RowPitch) * numRows;
+	const UINT rowsPerBand = static_cast<UINT>(std::max<SIZE_T>(1,
+		std::min<SIZE_T>(numRows, bandBytes / std::max<SIZE_T>(rowSize, 1))));
 
-    uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
-    UINT arraySize = 1;
+	for (UINT z = 0; z < layout.Footprint.Depth; ++z)
+	{
+		for (UINT y = 0; y < numRows; y += rowsPerBand)
+		{
+			UploadCopyBand12 band;
+			band.src = static_cast<const uint8_t*>(src.pData) + SIZE_T(src.SlicePitch) * z + SIZE_T(src.RowPitch) * y;
+			band.dest = dest + destSlicePitch * z + SIZE_T(layout.Footprint.RowPitch) * y;
+			band.srcRowPitch = SIZE_T(src.RowPitch);
+			band.destRowPitch = layout.Footprint.RowPitch;
+			band.rowSize = rowSize;
+			band.numRows = std::min<UINT>(rowsPerBand, numRows - y);
+			band.conversion = conversion;
+			band.pixels = layout.Footprint.Width;
+			bands.push_back(band);
+		}
+	}
+}
+
+static void CopyUploadBand12(const UploadCopyBand12& band)
+{
+	if (band.conversion != DDS_CONVERSION_NONE)
+	{
+		for (UINT y = 0; y < band.numRows; ++y)
+		{
+			ConvertLegacyRow(band.conversion, band.src + band.srcRowPitch * y, band.dest + band.destRowPitch * y, band.pixels);
+		}
+		return;
+	}
+
+	// Source rows already padded to the footprint pitch (e.g. from the footprint cache)
+	// copy as one run; the padding after the last row is left alone
+	if (band.srcRowPitch == band.destRowPitch && band.srcRowPitch >= band.rowSize)
+	{
+		memcpy(band.dest, band.src, band.destRowPitch * (band.numRows - 1) + band.rowSize);
+		return;
+	}
+
+	for (UINT y = 0; y < band.numRows; ++y)
+	{
+		memcpy(band.dest + band.destRowPitch * y, band.src + band.srcRowPitch * y, band.rowSize);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Footprints are worked out on the CPU; only formats the CPU path doesn't model (stencil
+// planes) go to the device
+//--------------------------------------------------------------------------------------
+static HRESULT GetUploadFootprints12(
+	_In_ ID3D12Device* device,
+	const D3D12_RESOURCE_DESC& texDesc,
+	_In_ UINT numSubresources,
+	_In_ UINT64 baseOffset,
+	_Out_writes_(numSubresources) D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+	_Out_writes_(numSubresources) UINT* numRows,
+	_Out_writes_(numSubresources) UINT64* rowSizes,
+	_Out_ UINT64* totalBytes)
+{
+	HRESULT hr = GetCopyableFootprints12(texDesc, 0, numSubresources, baseOffset, layouts, numRows, rowSizes, totalBytes);
+	if (hr == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+	{
+		device->GetCopyableFootprints(&texDesc, 0, numSubresources, baseOffset, layouts, numRows, rowSizes, totalBytes);
+		hr = (*totalBytes == UINT64(-1)) ? E_INVALIDARG : S_OK;
+	}
+
+	return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Upload space for one submission: a slice of the ring when one is given and has room,
+// otherwise a dedicated committed buffer returned in uploadHeap, which the caller must
+// keep alive until the copy has executed.
+//--------------------------------------------------------------------------------------
+static HRESULT AcquireUploadSpace12(
+	_In_ ID3D12Device* device,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_ UINT64 size,
+	ComPtr<ID3D12Resource>& uploadHeap,
+	UploadAllocation& allocation)
+{
+	uploadHeap = nullptr;
+
+	if (uploadRing && SUCCEEDED(uploadRing->Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, allocation)))
+	{
+		return S_OK;
+	}
+
+	if (size > SIZE_MAX)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	HRESULT hr = device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&uploadHeap));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	uint8_t* pData = nullptr;
+	CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
+	hr = uploadHeap->Map(0, &readRange, reinterpret_cast<void**>(&pData));
+	if (FAILED(hr))
+	{
+		uploadHeap = nullptr;
+		return hr;
+	}
+
+	allocation.resource = uploadHeap.Get();
+	allocation.offset = 0;
+	allocation.cpuAddress = pData;
+	allocation.gpuAddress = uploadHeap->GetGPUVirtualAddress();
+
+	return S_OK;
+}
+
+// Dedicated upload heaps are only mapped while they are filled; the ring stays mapped
+static void EndUploadWrites12(_In_opt_ ID3D12Resource* uploadHeap)
+{
+	if (uploadHeap)
+	{
+		uploadHeap->Unmap(0, nullptr);
+	}
+}
+
+// The states the upload copies are tracked in: the caller's, so the textures carry on from
+// where the upload leaves them in the command lists it records next, or one of their own
+static ResourceStateManager* GetUploadStates12(
+	_In_ ID3D12Device* device,
+	_In_opt_ ResourceStateManager* states,
+	std::unique_ptr<ResourceStateManager>& localStates)
+{
+	if (!states)
+	{
+		localStates.reset(new ResourceStateManager(device));
+		states = localStates.get();
+	}
+	return states;
+}
+
+// Asks for the state a texture is left in after its upload copies. A copy command list
+// can't use PIXEL_SHADER_RESOURCE; there the texture decays back to COMMON when the list
+// completes, without a barrier, and the direct queue that first samples it promotes it.
+static void TransitionUploaded12(
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_ ResourceStateManager* states,
+	_In_ ID3D12Resource* texture)
+{
+	if (cmdList->GetType() != D3D12_COMMAND_LIST_TYPE_COPY)
+	{
+		states->Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+}
+
+// Records the COMMON -> COPY_DEST -> PIXEL_SHADER_RESOURCE upload of one texture whose
+// footprints, placed from offset 0, have been filled in allocation
+static void RecordUploadCopies12(
+	_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_ ID3D12Resource* texture,
+	const UploadAllocation& allocation,
+	_In_reads_(numSubresources) const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+	_In_ UINT numSubresources,
+	_In_opt_ ResourceStateManager* states)
+{
+	std::unique_ptr<ResourceStateManager> localStates;
+	states = GetUploadStates12(device, states, localStates);
+
+	// COPY_DEST is a promotion from COMMON, so only the transition after the copies is a barrier
+	states->Register(texture, D3D12_RESOURCE_STATE_COMMON);
+	states->Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	states->Flush(cmdList);
+
+	for (UINT i = 0; i < numSubresources; ++i)
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = layouts[i];
+		layout.Offset += allocation.offset;
+
+		CD3DX12_TEXTURE_COPY_LOCATION Dst(texture, i);
+		CD3DX12_TEXTURE_COPY_LOCATION Src(allocation.resource, layout);
+		cmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+	}
+
+	TransitionUploaded12(cmdList, states, texture);
+	states->Flush(cmdList);
+}
+
+//--------------------------------------------------------------------------------------
+// Size of one half of the scratch GenerateUploadMips12 needs: the texture's mip 1.
+//--------------------------------------------------------------------------------------
+static size_t GetMipScratchSize12(const D3D12_RESOURCE_DESC& texDesc)
+{
+	return std::max<size_t>(static_cast<size_t>(texDesc.Width >> 1), 1) * (GetBitsPerPixel(texDesc.Format) / 8)
+		* std::max<size_t>(texDesc.Height >> 1, 1);
+}
+
+//--------------------------------------------------------------------------------------
+// Fills mips 1.. of every array slice of a texture whose upload carries only mip 0. Each
+// level is filtered from the one above it into scratch, never read back from the
+// write-combined upload heap, and then copied into its footprint. Levels alternate
+// between the two halves of scratch.
+//--------------------------------------------------------------------------------------
+static void GenerateUploadMips12(
+	const TextureUpload12& upload,
+	const D3D12_RESOURCE_DESC& texDesc,
+	_In_ uint8_t* uploadBase,
+	_In_ const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+	_Inout_ uint8_t* scratch,
+	_In_opt_ ThreadPool* pool)
+{
+	const size_t bytesPerPixel = GetBitsPerPixel(texDesc.Format) / 8;
+	const size_t scratchBytes = GetMipScratchSize12(texDesc);
+
+	for (UINT slice = 0; slice < texDesc.DepthOrArraySize; ++slice)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(upload.subresources[slice].pData);
+		size_t srcRowPitch = static_cast<size_t>(upload.subresources[slice].RowPitch);
+		UINT width = static_cast<UINT>(texDesc.Width);
+		UINT height = texDesc.Height;
+
+		for (UINT level = 1; level < texDesc.MipLevels; ++level)
+		{
+			const UINT destWidth = std::max<UINT>(width >> 1, 1);
+			const UINT destHeight = std::max<UINT>(height >> 1, 1);
+			const size_t destRowPitch = size_t(destWidth) * bytesPerPixel;
+			uint8_t* dest = scratch + scratchBytes * (level & 1);
+
+			DownsampleBox(texDesc.Format, src, srcRowPitch, width, height, dest, destRowPitch, pool);
+
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = layouts[slice * texDesc.MipLevels + level];
+			for (UINT y = 0; y < destHeight; ++y)
+			{
+				memcpy(uploadBase + layout.Offset + SIZE_T(layout.Footprint.RowPitch) * y, dest + destRowPitch * y, destRowPitch);
+			}
+
+			src = dest;
+			srcRowPitch = destRowPitch;
+			width = destWidth;
+			height = destHeight;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Records the COMMON -> COPY_DEST -> PIXEL_SHADER_RESOURCE upload of a set of textures
+// created by CreateTextureResource12. Every footprint is computed up front and placed in
+// a single upload heap, and the transitions after the copies go out as one batched
+// ResourceBarrier call.
+// The subresource data is copied into the upload heap before this returns, so only the
+// upload heap has to outlive the command list.
+//--------------------------------------------------------------------------------------
+static HRESULT RecordTextureBatchUpload12(
+	_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_reads_(count) const TextureUpload12* uploads,
+	_In_ size_t count,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_opt_ ThreadPool* copyPool,
+	_In_opt_ ResourceStateManager* states,
+	ComPtr<ID3D12Resource>& uploadHeap)
+{
+	if (!device || !cmdList || !uploads)
+		return E_POINTER;
+
+	// Generated mips have footprints but no source subresources
+	std::unique_ptr<UINT[]> footprintCounts(new (std::nothrow) UINT[count]);
+	if (!footprintCounts)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	size_t totalSubresources = 0;
+	size_t mipScratchBytes = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (!uploads[i].texture || !uploads[i].subresources || !uploads[i].numSubresources)
+			return E_INVALIDARG;
+
+		footprintCounts[i] = uploads[i].numSubresources;
+		if (uploads[i].generateMips)
+		{
+			const D3D12_RESOURCE_DESC texDesc = uploads[i].texture->GetDesc();
+			if (texDesc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D ||
+				uploads[i].numSubresources != texDesc.DepthOrArraySize ||
+				uploads[i].conversion != DDS_CONVERSION_NONE ||
+				!IsMipGenerationSupported(texDesc.Format))
+				return E_INVALIDARG;
+
+			footprintCounts[i] = UINT(texDesc.MipLevels) * texDesc.DepthOrArraySize;
+			mipScratchBytes = std::max<size_t>(mipScratchBytes, GetMipScratchSize12(texDesc));
+		}
+
+		totalSubresources += footprintCounts[i];
+	}
+
+	if (!totalSubresources)
+		return S_OK;
+
+	std::unique_ptr<D3D12_PLACED_SUBRESOURCE_FOOTPRINT[]> layouts(new (std::nothrow) D3D12_PLACED_SUBRESOURCE_FOOTPRINT[totalSubresources]);
+	std::unique_ptr<UINT[]> numRows(new (std::nothrow) UINT[totalSubresources]);
+	std::unique_ptr<UINT64[]> rowSizes(new (std::nothrow) UINT64[totalSubresources]);
+	std::unique_ptr<uint8_t[]> mipScratch(mipScratchBytes ? new (std::nothrow) uint8_t[mipScratchBytes * 2] : nullptr);
+	if (!layouts || !numRows || !rowSizes || (mipScratchBytes && !mipScratch))
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	// Lay every texture out back to back, each one starting on a placement boundary
+	UINT64 uploadBufferSize = 0;
+	for (size_t i = 0, first = 0; i < count; first += footprintCounts[i], ++i)
+	{
+		const D3D12_RESOURCE_DESC texDesc = uploads[i].texture->GetDesc();
+		const UINT64 baseOffset = (uploadBufferSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1)
+			& ~static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+
+		UINT64 textureSize = 0;
+		HRESULT hr = GetUploadFootprints12(device, texDesc, footprintCounts[i], baseOffset,
+			&layouts[first], &numRows[first], &rowSizes[first], &textureSize);
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		uploadBufferSize = baseOffset + textureSize;
+	}
+
+	UploadAllocation allocation;
+	HRESULT hr = AcquireUploadSpace12(device, uploadRing, uploadBufferSize, uploadHeap, allocation);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Small batches go out as one band per depth slice on this thread
+	const SIZE_T bandBytes = (copyPool && uploadBufferSize >= PARALLEL_COPY_THRESHOLD)
+		? PARALLEL_COPY_BAND_BYTES : SIZE_MAX;
+
+	std::vector<UploadCopyBand12> bands;
+	for (size_t i = 0, first = 0; i < count; first += footprintCounts[i], ++i)
+	{
+		// With generated mips the sources are mip 0 of each slice
+		const UINT stride = footprintCounts[i] / uploads[i].numSubresources;
+		for (UINT j = 0; j < uploads[i].numSubresources; ++j)
+		{
+			const size_t index = first + size_t(j) * stride;
+			AddUploadCopyBands12(bands, allocation.cpuAddress + layouts[index].Offset, layouts[index], numRows[index],
+				SIZE_T(rowSizes[index]), uploads[i].subresources[j], uploads[i].conversion, bandBytes);
+		}
+	}
+
+	if (bandBytes != SIZE_MAX && bands.size() > 1)
+	{
+		copyPool->ParallelFor(bands.size(), [&bands](size_t i) { CopyUploadBand12(bands[i]); });
+	}
+	else
+	{
+		for (const auto& band : bands)
+		{
+			CopyUploadBand12(band);
+		}
+	}
+
+	for (size_t i = 0, first = 0; i < count; first += footprintCounts[i], ++i)
+	{
+		if (uploads[i].generateMips)
+		{
+			GenerateUploadMips12(uploads[i], uploads[i].texture->GetDesc(), allocation.cpuAddress,
+				&layouts[first], mipScratch.get(), copyPool);
+		}
+	}
+
+	EndUploadWrites12(uploadHeap.Get());
+
+	// Rebase the footprints onto the allocation for the copies
+	for (size_t i = 0; i < totalSubresources; ++i)
+	{
+		layouts[i].Offset += allocation.offset;
+	}
+
+	// A texture listed twice is only transitioned once
+	std::unique_ptr<ResourceStateManager> localStates;
+	states = GetUploadStates12(device, states, localStates);
+	for (size_t i = 0; i < count; ++i)
+	{
+		states->Register(uploads[i].texture, D3D12_RESOURCE_STATE_COMMON);
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		states->Transition(uploads[i].texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+	states->Flush(cmdList);
+
+	for (size_t i = 0, first = 0; i < count; first += footprintCounts[i], ++i)
+	{
+		for (UINT j = 0; j < footprintCounts[i]; ++j)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION Dst(uploads[i].texture, j);
+			CD3DX12_TEXTURE_COPY_LOCATION Src(allocation.resource, layouts[first + j]);
+			cmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		TransitionUploaded12(cmdList, states, uploads[i].texture);
+	}
+	states->Flush(cmdList);
+
+	return S_OK;
+}
+
+static HRESULT RecordTextureUpload12(
+	_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_ ID3D12Resource* texture,
+	_In_reads_(numSubresources) const D3D12_SUBRESOURCE_DATA* initData,
+	_In_ UINT numSubresources,
+	_In_ DDS_CONVERSION conversion,
+	_In_ bool generateMips,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	ComPtr<ID3D12Resource>& textureUploadHeap)
+{
+	const TextureUpload12 upload = { texture, initData, numSubresources, conversion, generateMips };
+	return RecordTextureBatchUpload12(device, cmdList, &upload, 1, uploadRing, nullptr, nullptr, textureUploadHeap);
+}
+
+
+//--------------------------------------------------------------------------------------
+static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
+                                     _In_opt_ ID3D11DeviceContext* d3dContext,
+                                     _In_ const DDS_HEADER* header,
+                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                                     _In_ size_t bitSize,
+                                     _In_ size_t maxsize,
+                                     _In_ D3D11_USAGE usage,
+                                     _In_ unsigned int bindFlags,
+                                     _In_ unsigned int cpuAccessFlags,
+                                     _In_ unsigned int miscFlags,
+                                     _In_ bool forceSRGB,
+                                     _Outptr_opt_ ID3D11Resource** texture,
+                                     _Outptr_opt_ ID3D11ShaderResourceView** textureView )
+{
+    HRESULT hr = S_OK;
+
+    UINT width = header->width;
+    UINT height = header->height;
+    UINT depth = header->depth;
+
+    uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    UINT arraySize = 1;
     DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
     bool isCubeMap = false;
 
@@ -1669,205 +1620,279 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
     return hr;
 }
 
-static HRESULT CreateTextureFromDDS12(
-	_In_ ID3D12Device* device,
-	_In_opt_ ID3D12GraphicsCommandList* cmdList,
-	_In_ const DDS_HEADER* header,
-	_In_reads_bytes_(bitSize) const uint8_t* bitData,
-	_In_ size_t bitSize,
-	_In_ size_t maxsize,
-	_In_ bool forceSRGB,
-	ComPtr<ID3D12Resource>& texture,
-	ComPtr<ID3D12Resource>& textureUploadHeap)
+//--------------------------------------------------------------------------------------
+static HRESULT GetParseResult12(_In_ DDS_PARSE_STATUS status)
 {
-	HRESULT hr = S_OK;
+	switch (status)
+	{
+	case DDS_PARSE_OK:
+		return S_OK;
 
-	UINT width = header->width;
-	UINT height = header->height;
-	UINT depth = header->depth;
+	case DDS_PARSE_INVALID_ARG:
+		return E_INVALIDARG;
 
-	uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
-	UINT arraySize = 1;
-	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-	bool isCubeMap = false;
+	case DDS_PARSE_NOT_DDS:
+		return E_FAIL;
 
-	size_t mipCount = header->mipMapCount;
-	if (0 == mipCount) mipCount = 1;
+	case DDS_PARSE_INVALID_DATA:
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
 
-	if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
-	{
-		auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>((const char*)header + sizeof(DDS_HEADER));
+	case DDS_PARSE_END_OF_FILE:
+		return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
 
-		arraySize = d3d10ext->arraySize;
-		if (arraySize == 0)
-			return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	case DDS_PARSE_OUT_OF_MEMORY:
+		return E_OUTOFMEMORY;
 
-		switch (d3d10ext->dxgiFormat)
-		{
-		case DXGI_FORMAT_AI44:
-		case DXGI_FORMAT_IA44:
-		case DXGI_FORMAT_P8:
-		case DXGI_FORMAT_A8P8:
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-
-		default:
-			if (BitsPerPixel(d3d10ext->dxgiFormat) == 0)
-				return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-		}
+	default:
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+}
 
-		format = d3d10ext->dxgiFormat;
+// Parses the DDS image (data starts at the magic number) and works out how many top mips
+// maxsize drops; shared by every D3D12 load path
+static HRESULT GetTextureLayout12(
+	_In_reads_bytes_(dataSize) const uint8_t* data,
+	_In_ size_t dataSize,
+	_In_ uint64_t fileSize,
+	_In_ size_t maxsize,
+	DDSTextureLayout& layout,
+	_Out_ UINT& skipMip)
+{
+	skipMip = 0;
 
-		switch (d3d10ext->resourceDimension)
-		{
-		case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
-			if ((header->flags & DDS_HEIGHT) && height != 1)
-				return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
-			height = depth = 1;
-			break;
+	HRESULT hr = GetParseResult12(ParseDDS(data, dataSize, layout, fileSize, DDS_PARSE_FLAGS_CONVERT_LEGACY));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
 
-		case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
-			if (d3d10ext->miscFlag & D3D11_RESOURCE_MISC_TEXTURECUBE)
-			{
-				arraySize *= 6;
-				isCubeMap = true;
-			}
-			depth = 1;
-			break;
+	skipMip = GetFirstRetainedMip(layout, maxsize);
+	if (skipMip >= layout.mipCount)
+	{
+		return E_FAIL;
+	}
 
-		case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
-			if (!(header->flags & DDS_HEADER_FLAGS_VOLUME))
-				return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
-			if (arraySize > 1)
-				return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-			break;
+	return S_OK;
+}
 
-		default:
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-		}
+// Files with a single mip of an 8-bit format get their chain built on the CPU during the
+// upload (see GenerateUploadMips12)
+static bool ShouldGenerateMips12(const DDSTextureLayout& layout)
+{
+	return layout.mipCount == 1
+		&& layout.dimension == DDS_TEXTURE_DIMENSION_2D
+		&& layout.conversion == DDS_CONVERSION_NONE
+		&& (layout.width > 1 || layout.height > 1)
+		&& IsMipGenerationSupported(layout.format);
+}
 
-		switch (d3d10ext->resourceDimension)
-		{
-		case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
-			resDim = D3D12_RESOURCE_DIMENSION_TEXTURE1D;
-			break;
-		case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
-			resDim = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-			break;
-		case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
-			resDim = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
-			break;
-		}
+// maxsize for a texture whose chain is generated: mip 0 of each slice is filtered down to
+// the first level of the chain that fits, into data, and the subresources and the
+// layout's mip 0 are pointed at it. The texture is then created at that size and the
+// upload builds the rest of the chain from there. format is the texture's, with any
+// forced sRGB applied, so these levels are averaged in the same space as the rest.
+static HRESULT ReduceGeneratedMip12(
+	_In_ size_t maxsize,
+	_In_ DXGI_FORMAT format,
+	_In_opt_ ThreadPool* pool,
+	DDSTextureLayout& layout,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	std::unique_ptr<uint8_t[]>& data)
+{
+	if (!maxsize || (layout.width <= maxsize && layout.height <= maxsize))
+	{
+		return S_OK;
 	}
-	else
+
+	UINT width = layout.width;
+	UINT height = layout.height;
+	UINT levels = 0;
+	while (width > maxsize || height > maxsize)
 	{
-		format = GetDXGIFormat(header->ddspf);
+		width = std::max<UINT>(width >> 1, 1);
+		height = std::max<UINT>(height >> 1, 1);
+		++levels;
+	}
 
-		if (format == DXGI_FORMAT_UNKNOWN)
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	// Levels above the last alternate between the two halves of scratch, after the slices
+	const size_t bytesPerPixel = GetBitsPerPixel(layout.format) / 8;
+	const size_t rowPitch = size_t(width) * bytesPerPixel;
+	const size_t sliceBytes = rowPitch * height;
+	const size_t scratchBytes = (levels > 1)
+		? std::max<size_t>(layout.width >> 1, 1) * std::max<size_t>(layout.height >> 1, 1) * bytesPerPixel : 0;
 
-		if (header->flags & DDS_HEADER_FLAGS_VOLUME)
-		{
-			resDim = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
-		}
-		else
+	std::unique_ptr<uint8_t[]> reduced(new (std::nothrow) uint8_t[sliceBytes * subresources.size() + scratchBytes * 2]);
+	if (!reduced)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	uint8_t* scratch = reduced.get() + sliceBytes * subresources.size();
+	for (size_t slice = 0; slice < subresources.size(); ++slice)
+	{
+		D3D12_SUBRESOURCE_DATA& sub = subresources[slice];
+		const uint8_t* src = static_cast<const uint8_t*>(sub.pData);
+		size_t srcRowPitch = static_cast<size_t>(sub.RowPitch);
+		UINT srcWidth = layout.width;
+		UINT srcHeight = layout.height;
+
+		for (UINT level = 1; level <= levels; ++level)
 		{
-			if (header->caps2 & DDS_CUBEMAP)
-			{
-				if ((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
-					return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-				arraySize = 6;
-				isCubeMap = true;
-			}
+			const UINT destWidth = std::max<UINT>(srcWidth >> 1, 1);
+			const UINT destHeight = std::max<UINT>(srcHeight >> 1, 1);
+			const size_t destRowPitch = size_t(destWidth) * bytesPerPixel;
+			uint8_t* dest = (level == levels) ? reduced.get() + sliceBytes * slice : scratch + scratchBytes * (level & 1);
 
-			depth = 1;
-			resDim = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+			DownsampleBox(format, src, srcRowPitch, srcWidth, srcHeight, dest, destRowPitch, pool);
+
+			src = dest;
+			srcRowPitch = destRowPitch;
+			srcWidth = destWidth;
+			srcHeight = destHeight;
 		}
 
-		assert(BitsPerPixel(format) != 0);
+		sub.pData = reduced.get() + sliceBytes * slice;
+		sub.RowPitch = static_cast<LONG_PTR>(rowPitch);
+		sub.SlicePitch = static_cast<LONG_PTR>(sliceBytes);
+
+		DDSSubresourceLayout& top = layout.subresources[slice];
+		top.offset = sliceBytes * slice;
+		top.rowPitch = rowPitch;
+		top.slicePitch = sliceBytes;
+		top.numRows = height;
+		top.width = width;
+		top.height = height;
 	}
 
-	// Bound sizes (for security purposes we don't trust DDS file metadata larger than the D3D 11.x hardware requirements)
-	if (mipCount > D3D12_REQ_MIP_LEVELS)
-	{
-		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-	}
+	layout.width = width;
+	layout.height = height;
+	layout.bitSize = sliceBytes * subresources.size();
+	data = std::move(reduced);
+	return S_OK;
+}
 
-	switch (resDim)
+// Creates the texture for the mips that survive maxsize, or for the full chain when the
+// mips are to be generated
+static HRESULT CreateTextureFromLayout12(
+	_In_ ID3D12Device* device,
+	const DDSTextureLayout& layout,
+	_In_ UINT skipMip,
+	_In_ bool forceSRGB,
+	_In_ bool generateMips,
+	ComPtr<ID3D12Resource>& texture)
+{
+	const DDSSubresourceLayout& top = layout.subresources[skipMip];
+	const DXGI_FORMAT format = forceSRGB ? MakeSRGB(layout.format) : layout.format;
+	const size_t mipCount = generateMips ? GetMipChainLength(top.width, top.height) : layout.mipCount - skipMip;
+
+	return CreateTextureResource12(device, static_cast<uint32_t>(layout.dimension),
+		top.width, top.height, top.depth, mipCount, layout.arraySize, format, texture);
+}
+
+//--------------------------------------------------------------------------------------
+// Validates the header, creates the texture in the COMMON state and points the
+// subresource data into bitData. Records no commands, so it is safe on any thread.
+// generateMips reports a texture created with a full chain whose upload must build
+// mips 1.. from the subresources, which then hold only mip 0. When maxsize cuts into a
+// generated chain, that mip 0 is a filtered copy held by mipData, which must then
+// outlive the subresources.
+//--------------------------------------------------------------------------------------
+static HRESULT PrepareTextureFromDDS12(
+	_In_ ID3D12Device* device,
+	_In_ const DDS_HEADER* header,
+	_In_reads_bytes_(bitSize) const uint8_t* bitData,
+	_In_ size_t bitSize,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	_In_ bool allowMipGeneration,
+	ComPtr<ID3D12Resource>& texture,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	std::unique_ptr<uint8_t[]>& mipData,
+	_Out_ DDS_CONVERSION& conversion,
+	_Out_ bool& generateMips)
+{
+	conversion = DDS_CONVERSION_NONE;
+	generateMips = false;
+	mipData.reset();
+
+	// Every caller hands over one contiguous DDS image, so the magic number sits just
+	// in front of the header
+	const uint8_t* ddsData = reinterpret_cast<const uint8_t*>(header) - sizeof(uint32_t);
+	const size_t ddsDataSize = static_cast<size_t>(bitData + bitSize - ddsData);
+
+	DDSTextureLayout layout;
+	UINT skipMip = 0;
+	HRESULT hr = GetTextureLayout12(ddsData, ddsDataSize, 0, maxsize, layout, skipMip);
+	if (FAILED(hr))
 	{
-	case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
-		if ((arraySize > D3D12_REQ_TEXTURE1D_ARRAY_AXIS_DIMENSION) ||
-			(width > D3D12_REQ_TEXTURE1D_U_DIMENSION))
-		{
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-		}
-		break;
+		return hr;
+	}
 
-	case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
-		if (isCubeMap)
-		{
-			// This is the right bound because we set arraySize to (NumCubes*6) above
-			if ((arraySize > D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION) ||
-				(width > D3D12_REQ_TEXTURECUBE_DIMENSION) ||
-				(height > D3D12_REQ_TEXTURECUBE_DIMENSION))
-			{
-				return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-			}
-		}
-		else if ((arraySize > D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION) ||
-			(width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION) ||
-			(height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION))
-		{
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-		}
-		break;
+	const UINT retainedMips = layout.mipCount - skipMip;
+	subresources.resize(size_t(retainedMips) * layout.arraySize);
 
-	case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
-		if ((arraySize > 1) ||
-			(width > D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION) ||
-			(height > D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION) ||
-			(depth > D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION))
+	for (UINT j = 0; j < layout.arraySize; ++j)
+	{
+		for (UINT i = 0; i < retainedMips; ++i)
 		{
-			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+			const DDSSubresourceLayout& src = layout.subresources[j * layout.mipCount + skipMip + i];
+			D3D12_SUBRESOURCE_DATA& initData = subresources[j * retainedMips + i];
+			initData.pData = bitData + src.offset;
+			initData.RowPitch = static_cast<LONG_PTR>(src.rowPitch);
+			initData.SlicePitch = static_cast<LONG_PTR>(src.slicePitch);
 		}
-		break;
-
-	default:
-		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
 	}
 
-	// Create the texture
-	std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData(
-		new (std::nothrow) D3D12_SUBRESOURCE_DATA[mipCount * arraySize]
-		);
-
-	if (!initData)
+	const bool generate = allowMipGeneration && ShouldGenerateMips12(layout);
+	if (generate)
 	{
-		return E_OUTOFMEMORY;
+		hr = ReduceGeneratedMip12(maxsize, forceSRGB ? MakeSRGB(layout.format) : layout.format, nullptr,
+			layout, subresources, mipData);
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = CreateTextureFromLayout12(device, layout, skipMip, forceSRGB, generate, texture);
+	}
+	if (FAILED(hr))
+	{
+		subresources.clear();
+		mipData.reset();
+		return hr;
 	}
 
-	size_t skipMip = 0;
-	size_t twidth = 0;
-	size_t theight = 0;
-	size_t tdepth = 0;
+	conversion = layout.conversion;
+	generateMips = generate;
+	return S_OK;
+}
 
-	hr = FillInitData12(
-		width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
-		twidth, theight, tdepth, skipMip, initData.get()
-		);
+static HRESULT CreateTextureFromDDS12(
+	_In_ ID3D12Device* device,
+	_In_opt_ ID3D12GraphicsCommandList* cmdList,
+	_In_ const DDS_HEADER* header,
+	_In_reads_bytes_(bitSize) const uint8_t* bitData,
+	_In_ size_t bitSize,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap)
+{
+	std::vector<D3D12_SUBRESOURCE_DATA> initData;
+	std::unique_ptr<uint8_t[]> mipData;
+	DDS_CONVERSION conversion = DDS_CONVERSION_NONE;
+	bool generateMips = false;
+	HRESULT hr = PrepareTextureFromDDS12(device, header, bitData, bitSize, maxsize, forceSRGB, true,
+		texture, initData, mipData, conversion, generateMips);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
 
-	if (SUCCEEDED(hr))
+	hr = RecordTextureUpload12(device, cmdList, texture.Get(),
+		initData.data(), static_cast<UINT>(initData.size()), conversion, generateMips, uploadRing, textureUploadHeap);
+	if (FAILED(hr))
 	{
-		hr = CreateD3DResources12(
-			device, cmdList,
-			resDim, twidth, theight, tdepth,
-			mipCount - skipMip,
-			arraySize,
-			format,
-			false, // forceSRGB
-			isCubeMap,
-			initData.get(),
-			texture, 
-			textureUploadHeap);
+		texture = nullptr;
 	}
 
 	return hr;
@@ -1898,7 +1923,1274 @@ static DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header )
         }
     }
 
-    return DDS_ALPHA_MODE_UNKNOWN;
+    return DDS_ALPHA_MODE_UNKNOWN;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Locates the header and bit data of a DDS file that is already in memory
+//--------------------------------------------------------------------------------------
+static HRESULT GetTextureDataFromMemory12(
+	_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+	_In_ size_t ddsDataSize,
+	const DDS_HEADER** header,
+	const uint8_t** bitData,
+	size_t* bitSize)
+{
+	// Need at least enough data to fill the header and magic number to be a valid DDS
+	if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t)))
+	{
+		return E_FAIL;
+	}
+
+	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData);
+	if (dwMagicNumber != DDS_MAGIC)
+	{
+		return E_FAIL;
+	}
+
+	auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+
+	// Verify header to validate DDS file
+	if (hdr->size != sizeof(DDS_HEADER) ||
+		hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		return E_FAIL;
+	}
+
+	// Check for DX10 extension
+	bool bDXT10Header = false;
+	if ((hdr->ddspf.flags & DDS_FOURCC) &&
+		(MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+	{
+		// Must be long enough for both headers and magic value
+		if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+		{
+			return E_FAIL;
+		}
+
+		bDXT10Header = true;
+	}
+
+	ptrdiff_t offset = sizeof(uint32_t)
+		+ sizeof(DDS_HEADER)
+		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+
+	*header = hdr;
+	*bitData = ddsData + offset;
+	*bitSize = ddsDataSize - offset;
+
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Opens a DDS file and reads just its headers, leaving the bit data on disk
+//--------------------------------------------------------------------------------------
+struct DDSFileHeader12
+{
+	// Enough for a DDSZ file to report the size of its chunk table too
+	uint8_t	data[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10) + sizeof(DDSZ_HEADER)];
+	size_t	dataSize;		// bytes of data actually read
+	size_t	fileSize;
+};
+
+static HRESULT ReadDDSFileHeader12(
+	_In_z_ const wchar_t* fileName,
+	ScopedHandle& hFile,
+	DDSFileHeader12& fileHeader)
+{
+	LARGE_INTEGER fileSize = { 0 };
+	HRESULT hr = OpenDDSFile(fileName, hFile, fileSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Need at least enough data to fill the header and magic number to be a valid DDS
+	if (static_cast<uint64_t>(fileSize.QuadPart) < (sizeof(uint32_t) + sizeof(DDS_HEADER)) ||
+		static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+	{
+		return E_FAIL;
+	}
+
+	memset(fileHeader.data, 0, sizeof(fileHeader.data));
+	fileHeader.fileSize = static_cast<size_t>(fileSize.QuadPart);
+	fileHeader.dataSize = std::min<size_t>(fileHeader.fileSize, sizeof(fileHeader.data));
+
+	// The headers are validated by ParseDDS along with the rest of the layout
+	return ReadFileAt(hFile.get(), 0, fileHeader.data, fileHeader.dataSize);
+}
+
+static bool IsDDSZFile12(const DDSFileHeader12& fileHeader)
+{
+	return GetDDSZHeaderSize(fileHeader.data, fileHeader.dataSize) != 0;
+}
+
+// GetTextureLayout12 for a DDSZ file: reads the chunk table and describes the texture the
+// chunks unpack to
+static HRESULT GetDDSZLayout12(
+	_In_ HANDLE hFile,
+	const DDSFileHeader12& fileHeader,
+	_In_ size_t maxsize,
+	DDSZLayout& layout,
+	_Out_ UINT& skipMip)
+{
+	skipMip = 0;
+
+	const size_t headerSize = GetDDSZHeaderSize(fileHeader.data, fileHeader.dataSize);
+	if (!headerSize || headerSize > fileHeader.fileSize)
+	{
+		return E_FAIL;
+	}
+
+	std::unique_ptr<uint8_t[]> headerData(new (std::nothrow) uint8_t[headerSize]);
+	if (!headerData)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	HRESULT hr = ReadFileAt(hFile, 0, headerData.get(), headerSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	hr = GetParseResult12(ParseDDSZ(headerData.get(), headerSize, layout, fileHeader.fileSize, DDS_PARSE_FLAGS_CONVERT_LEGACY));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	skipMip = GetFirstRetainedMip(layout.texture, maxsize);
+	if (skipMip >= layout.texture.mipCount)
+	{
+		return E_FAIL;
+	}
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+// Reads the payloads of the chunks in the mips skipMip leaves, one read per run of
+// payloads that sit next to each other in the file, then hands each chunk to unpack with
+// the chunks spread over pool
+//--------------------------------------------------------------------------------------
+typedef std::function<HRESULT(const DDSZChunkLayout& chunk, const uint8_t* payload)> DDSZChunkHandler12;
+
+static HRESULT ReadDDSZChunks12(
+	_In_ HANDLE hFile,
+	const DDSZLayout& layout,
+	_In_ UINT skipMip,
+	_In_opt_ ThreadPool* pool,
+	const DDSZChunkHandler12& unpack)
+{
+	std::vector<const DDSZChunkLayout*> chunks;
+	size_t packedBytes = 0;
+	for (const DDSZChunkLayout& chunk : layout.chunks)
+	{
+		if (chunk.subresource % layout.texture.mipCount >= skipMip)
+		{
+			chunks.push_back(&chunk);
+			packedBytes += chunk.packedSize;
+		}
+	}
+
+	if (chunks.empty())
+	{
+		return S_OK;
+	}
+
+	std::unique_ptr<uint8_t[]> packed(new (std::nothrow) uint8_t[packedBytes]);
+	if (!packed)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	std::vector<const uint8_t*> payloads(chunks.size());
+	uint8_t* pDest = packed.get();
+	for (size_t i = 0; i < chunks.size();)
+	{
+		size_t end = i + 1;
+		size_t runBytes = chunks[i]->packedSize;
+		while (end < chunks.size() && chunks[end]->fileOffset == chunks[end - 1]->fileOffset + chunks[end - 1]->packedSize)
+		{
+			runBytes += chunks[end]->packedSize;
+			++end;
+		}
+
+		HRESULT hr = ReadFileAt(hFile, chunks[i]->fileOffset, pDest, runBytes);
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		for (; i < end; ++i)
+		{
+			payloads[i] = pDest;
+			pDest += chunks[i]->packedSize;
+		}
+	}
+
+	std::atomic<HRESULT> result(S_OK);
+	auto body = [&](size_t i)
+	{
+		const HRESULT hr = unpack(*chunks[i], payloads[i]);
+		if (FAILED(hr))
+			result = hr;
+	};
+
+	if (pool && chunks.size() > 1)
+	{
+		pool->ParallelFor(chunks.size(), body);
+	}
+	else
+	{
+		for (size_t i = 0; i < chunks.size(); ++i)
+			body(i);
+	}
+
+	return result;
+}
+
+
+//--------------------------------------------------------------------------------------
+// maxsize path: reads only the mips that survive the size cap. Their byte ranges follow
+// from the header alone, and the retained mips of each array slice sit next to each
+// other in the file, so this is one positional read per slice into a compact buffer.
+// A DDSZ file only has the chunks of those mips read, and unpacks them across pool.
+//--------------------------------------------------------------------------------------
+static HRESULT LoadRetainedTextureFromFile12(
+	_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* fileName,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	_In_ bool allowMipGeneration,
+	ComPtr<ID3D12Resource>& texture,
+	std::unique_ptr<uint8_t[]>& bitData,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	_Out_ DDS_CONVERSION& conversion,
+	_Out_ bool& generateMips,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode,
+	_In_opt_ ThreadPool* pool)
+{
+	conversion = DDS_CONVERSION_NONE;
+	generateMips = false;
+
+	ScopedHandle hFile;
+	DDSFileHeader12 fileHeader;
+	HRESULT hr = ReadDDSFileHeader12(fileName, hFile, fileHeader);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	DDSZLayout packedLayout;
+	DDSTextureLayout& layout = packedLayout.texture;
+	const bool packed = IsDDSZFile12(fileHeader);
+	UINT skipMip = 0;
+	hr = packed
+		? GetDDSZLayout12(hFile.get(), fileHeader, maxsize, packedLayout, skipMip)
+		: GetTextureLayout12(fileHeader.data, fileHeader.dataSize, fileHeader.fileSize, maxsize, layout, skipMip);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	const UINT retainedMips = layout.mipCount - skipMip;
+
+	size_t totalBytes = 0;
+	for (UINT j = 0; j < layout.arraySize; ++j)
+	{
+		const DDSSubresourceLayout& first = layout.subresources[j * layout.mipCount + skipMip];
+		const DDSSubresourceLayout& last = layout.subresources[j * layout.mipCount + layout.mipCount - 1];
+		totalBytes += static_cast<size_t>(last.offset + last.slicePitch * last.depth - first.offset);
+	}
+
+	bitData.reset(new (std::nothrow) uint8_t[totalBytes]);
+	if (!bitData)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	subresources.resize(size_t(retainedMips) * layout.arraySize);
+
+	uint8_t* pDest = bitData.get();
+	for (UINT j = 0; j < layout.arraySize && SUCCEEDED(hr); ++j)
+	{
+		const DDSSubresourceLayout& first = layout.subresources[j * layout.mipCount + skipMip];
+		const DDSSubresourceLayout& last = layout.subresources[j * layout.mipCount + layout.mipCount - 1];
+		const size_t rangeBytes = static_cast<size_t>(last.offset + last.slicePitch * last.depth - first.offset);
+
+		if (!packed)
+		{
+			hr = ReadFileAt(hFile.get(), layout.headerSize + first.offset, pDest, rangeBytes);
+		}
+
+		for (UINT i = 0; i < retainedMips; ++i)
+		{
+			const DDSSubresourceLayout& src = layout.subresources[j * layout.mipCount + skipMip + i];
+			D3D12_SUBRESOURCE_DATA& initData = subresources[j * retainedMips + i];
+			initData.pData = pDest + (src.offset - first.offset);
+			initData.RowPitch = static_cast<LONG_PTR>(src.rowPitch);
+			initData.SlicePitch = static_cast<LONG_PTR>(src.slicePitch);
+		}
+
+		pDest += rangeBytes;
+	}
+
+	if (packed && SUCCEEDED(hr))
+	{
+		// Every slice keeps the same mips, so each takes the same share of bitData
+		const size_t sliceBytes = totalBytes / layout.arraySize;
+		hr = ReadDDSZChunks12(hFile.get(), packedLayout, skipMip, pool,
+			[&](const DDSZChunkLayout& chunk, const uint8_t* payload) -> HRESULT
+		{
+			const UINT slice = chunk.subresource / layout.mipCount;
+			const DDSSubresourceLayout& first = layout.subresources[slice * layout.mipCount + skipMip];
+			uint8_t* dest = bitData.get() + slice * sliceBytes + static_cast<size_t>(chunk.offset - first.offset);
+
+			return DecompressDDSZChunk(packedLayout, chunk, payload, dest) ? S_OK : HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+		});
+	}
+
+	const bool generate = allowMipGeneration && ShouldGenerateMips12(layout);
+	if (generate && SUCCEEDED(hr))
+	{
+		hr = ReduceGeneratedMip12(maxsize, forceSRGB ? MakeSRGB(layout.format) : layout.format, pool,
+			layout, subresources, bitData);
+	}
+	if (SUCCEEDED(hr))
+	{
+		hr = CreateTextureFromLayout12(device, layout, skipMip, forceSRGB, generate, texture);
+	}
+
+	if (FAILED(hr))
+	{
+		bitData.reset();
+		subresources.clear();
+		return hr;
+	}
+
+	conversion = layout.conversion;
+	generateMips = generate;
+	if (alphaMode)
+		*alphaMode = static_cast<DDS_ALPHA_MODE>(layout.alphaMode);
+
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// DDS_LOADER_COMPRESS_BC: uncompressed files are encoded on load and cached next to the
+// source, so only the first load pays for the encoder
+//--------------------------------------------------------------------------------------
+static std::wstring GetBCCacheFileName12(_In_z_ const wchar_t* fileName, _In_ DDS_LOADER_FLAGS loadFlags)
+{
+	std::wstring cacheName(fileName);
+	cacheName += (loadFlags & DDS_LOADER_COMPRESS_BC_QUALITY) ? L".bc-hq.dds" : L".bc.dds";
+	return cacheName;
+}
+
+static bool IsCacheFileCurrent12(_In_z_ const wchar_t* fileName, _In_z_ const wchar_t* cacheName)
+{
+	WIN32_FILE_ATTRIBUTE_DATA source;
+	WIN32_FILE_ATTRIBUTE_DATA cache;
+	if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &source) ||
+		!GetFileAttributesExW(cacheName, GetFileExInfoStandard, &cache))
+	{
+		return false;
+	}
+
+	return CompareFileTime(&cache.ftLastWriteTime, &source.ftLastWriteTime) >= 0;
+}
+
+// Best effort: the image goes to a temporary file that is renamed into place, so readers
+// never see a partial cache. When two loaders build the same cache at once, the second
+// cannot open the temporary file and skips the write. Shared with the footprint cache.
+static void WriteCacheFile12(_In_z_ const wchar_t* cacheName, _In_reads_bytes_(size) const uint8_t* data, _In_ size_t size)
+{
+	const std::wstring tempName = std::wstring(cacheName) + L".tmp";
+
+	bool written = false;
+	{
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+		ScopedHandle hFile(safe_handle(CreateFile2(tempName.c_str(),
+			GENERIC_WRITE,
+			0,
+			CREATE_ALWAYS,
+			nullptr)));
+#else
+		ScopedHandle hFile(safe_handle(CreateFileW(tempName.c_str(),
+			GENERIC_WRITE,
+			0,
+			nullptr,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr)));
+#endif
+		if (!hFile)
+		{
+			return;
+		}
+
+		written = true;
+		while (size > 0 && written)
+		{
+			const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 0x40000000));
+			DWORD bytesWritten = 0;
+			written = WriteFile(hFile.get(), data, chunk, &bytesWritten, nullptr) && bytesWritten == chunk;
+			data += chunk;
+			size -= chunk;
+		}
+	}
+
+	if (!written || !MoveFileExW(tempName.c_str(), cacheName, MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(tempName.c_str());
+	}
+}
+
+// Builds a DX10-header DDS image holding the BC-encoded texture. A single-mip source gets
+// its chain from DownsampleBox first; BC1 is chosen when the whole image is opaque.
+static HRESULT EncodeBCTextureData12(
+	const DDSTextureLayout& layout,
+	_In_ const uint8_t* bitData,
+	_In_ BC_ENCODE_QUALITY quality,
+	_In_opt_ ThreadPool* pool,
+	std::unique_ptr<uint8_t[]>& ddsData,
+	_Out_ size_t& ddsDataSize)
+{
+	ddsDataSize = 0;
+
+	const bool generateMips = layout.mipCount == 1 && IsMipGenerationSupported(layout.format);
+	const uint32_t mipCount = generateMips ? GetMipChainLength(layout.width, layout.height) : layout.mipCount;
+
+	// Generated mips average opaque pixels, so they stay opaque too
+	bool opaque = true;
+	for (size_t i = 0; i < layout.subresources.size() && opaque; ++i)
+	{
+		const DDSSubresourceLayout& src = layout.subresources[i];
+		opaque = IsOpaqueImage(layout.format, bitData + src.offset, static_cast<size_t>(src.rowPitch), src.width, src.height);
+	}
+
+	DXGI_FORMAT bcFormat = opaque ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC7_UNORM;
+	if (layout.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ||
+		layout.format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+		layout.format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+	{
+		bcFormat = MakeSRGB(bcFormat);
+	}
+	const size_t blockBytes = opaque ? 8 : 16;
+
+	size_t bcBytes = 0;
+	for (uint32_t i = 0; i < mipCount; ++i)
+	{
+		const size_t width = std::max<size_t>(layout.width >> i, 1);
+		const size_t height = std::max<size_t>(layout.height >> i, 1);
+		bcBytes += ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+	bcBytes *= layout.arraySize;
+
+	const size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+	ddsData.reset(new (std::nothrow) uint8_t[headerSize + bcBytes]);
+	if (!ddsData)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	// Generated levels ping-pong between two buffers the size of mip 1
+	std::unique_ptr<uint8_t[]> scratch;
+	const size_t scratchBytes = size_t(std::max<uint32_t>(layout.width / 2, 1)) * std::max<uint32_t>(layout.height / 2, 1) * 4;
+	if (generateMips)
+	{
+		scratch.reset(new (std::nothrow) uint8_t[scratchBytes * 2]);
+		if (!scratch)
+		{
+			ddsData.reset();
+			return E_OUTOFMEMORY;
+		}
+	}
+
+	memcpy(ddsData.get(), &DDS_MAGIC, sizeof(uint32_t));
+	auto header = reinterpret_cast<DDS_HEADER*>(ddsData.get() + sizeof(uint32_t));
+	auto ext = reinterpret_cast<DDS_HEADER_DXT10*>(ddsData.get() + sizeof(uint32_t) + sizeof(DDS_HEADER));
+	memset(header, 0, sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10));
+
+	header->size = sizeof(DDS_HEADER);
+	header->flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP | DDS_HEADER_FLAGS_LINEARSIZE;
+	header->height = layout.height;
+	header->width = layout.width;
+	header->pitchOrLinearSize = static_cast<uint32_t>(((layout.width + 3) / 4) * ((layout.height + 3) / 4) * blockBytes);
+	header->mipMapCount = mipCount;
+	header->ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header->ddspf.flags = DDS_FOURCC;
+	header->ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	header->caps = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
+	if (layout.isCubeMap)
+	{
+		header->caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+		header->caps2 = DDS_CUBEMAP_ALLFACES;
+	}
+
+	ext->dxgiFormat = bcFormat;
+	ext->resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	ext->miscFlag = layout.isCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+	ext->arraySize = layout.isCubeMap ? layout.arraySize / 6 : layout.arraySize;
+	ext->miscFlags2 = layout.alphaMode & DDS_MISC_FLAGS2_ALPHA_MODE_MASK;
+
+	uint8_t* dest = ddsData.get() + headerSize;
+	for (uint32_t j = 0; j < layout.arraySize; ++j)
+	{
+		const DDSSubresourceLayout& top = layout.subresources[j * layout.mipCount];
+		const uint8_t* src = bitData + top.offset;
+		size_t srcRowPitch = static_cast<size_t>(top.rowPitch);
+		uint32_t width = top.width;
+		uint32_t height = top.height;
+
+		for (uint32_t i = 0; i < mipCount; ++i)
+		{
+			if (i > 0)
+			{
+				const uint32_t mipWidth = std::max<uint32_t>(width / 2, 1);
+				const uint32_t mipHeight = std::max<uint32_t>(height / 2, 1);
+				if (generateMips)
+				{
+					uint8_t* mip = scratch.get() + ((i & 1) ? 0 : scratchBytes);
+					DownsampleBox(layout.format, src, srcRowPitch, width, height, mip, size_t(mipWidth) * 4, pool);
+					src = mip;
+					srcRowPitch = size_t(mipWidth) * 4;
+				}
+				else
+				{
+					const DDSSubresourceLayout& mip = layout.subresources[j * layout.mipCount + i];
+					src = bitData + mip.offset;
+					srcRowPitch = static_cast<size_t>(mip.rowPitch);
+				}
+				width = mipWidth;
+				height = mipHeight;
+			}
+
+			const size_t destRowPitch = ((width + 3) / 4) * blockBytes;
+			EncodeBC(layout.format, src, srcRowPitch, width, height, bcFormat, dest, destRowPitch, quality, pool);
+			dest += destRowPitch * ((height + 3) / 4);
+		}
+	}
+
+	ddsDataSize = headerSize + bcBytes;
+	return S_OK;
+}
+
+// Drop-in for LoadTextureDataFromFile under DDS_LOADER_COMPRESS_BC. Returns the cache when
+// it is current, otherwise the freshly encoded image (cached on the way out), or the file
+// itself when the encoder does not take it.
+static HRESULT LoadBCTextureDataFromFile12(
+	_In_z_ const wchar_t* fileName,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_In_opt_ ThreadPool* pool,
+	std::unique_ptr<uint8_t[]>& ddsData,
+	DDS_HEADER** header,
+	uint8_t** bitData,
+	size_t* bitSize)
+{
+	if (!header || !bitData || !bitSize)
+	{
+		return E_POINTER;
+	}
+
+	const std::wstring cacheName = GetBCCacheFileName12(fileName, loadFlags);
+	DDSTextureLayout layout;
+
+	// A cache that fails to parse is rebuilt below
+	if (IsCacheFileCurrent12(fileName, cacheName.c_str()) &&
+		SUCCEEDED(LoadTextureDataFromFile(cacheName.c_str(), ddsData, header, bitData, bitSize, pool)) &&
+		ParseDDS(ddsData.get(), static_cast<size_t>(*bitData + *bitSize - ddsData.get()), layout) == DDS_PARSE_OK)
+	{
+		return S_OK;
+	}
+
+	HRESULT hr = LoadTextureDataFromFile(fileName, ddsData, header, bitData, bitSize, pool);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// D3D12 wants BC textures whose top level is a whole number of blocks
+	if (ParseDDS(ddsData.get(), static_cast<size_t>(*bitData + *bitSize - ddsData.get()), layout) != DDS_PARSE_OK ||
+		layout.dimension != DDS_TEXTURE_DIMENSION_2D ||
+		!IsBCEncodeSource(layout.format) ||
+		(layout.width % 4) != 0 ||
+		(layout.height % 4) != 0)
+	{
+		return S_OK;
+	}
+
+	const BC_ENCODE_QUALITY quality = (loadFlags & DDS_LOADER_COMPRESS_BC_QUALITY) ? BC_ENCODE_HIGH : BC_ENCODE_FAST;
+
+	std::unique_ptr<uint8_t[]> bcData;
+	size_t bcDataSize = 0;
+	hr = EncodeBCTextureData12(layout, *bitData, quality, pool, bcData, bcDataSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	WriteCacheFile12(cacheName.c_str(), bcData.get(), bcDataSize);
+
+	const size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+	ddsData = std::move(bcData);
+	*header = reinterpret_cast<DDS_HEADER*>(ddsData.get() + sizeof(uint32_t));
+	*bitData = ddsData.get() + headerSize;
+	*bitSize = bcDataSize - headerSize;
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// DDS_LOADER_FOOTPRINT_CACHE: the upload image of a texture, laid out exactly as
+// GetCopyableFootprints12 places it from offset 0, is cached next to the source. Loads
+// that find the cache current skip the row repacking and read the image in one go.
+//--------------------------------------------------------------------------------------
+static const uint32_t FOOTPRINT_CACHE_MAGIC = 0x46534444; // "DDSF"
+static const uint32_t FOOTPRINT_CACHE_VERSION = 2;   // 2: maxsize cuts into generated chains
+
+struct FootprintCacheHeader12
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	format;			// DXGI_FORMAT of the texture, so after FORCE_SRGB
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	arraySize;
+	uint32_t	mipLevels;
+	uint32_t	alphaMode;		// DDS_ALPHA_MODE
+	uint64_t	imageSize;		// The upload image that follows the header
+};
+
+// Everything that changes the image goes into the name, so callers asking for different
+// maxsizes or flags don't overwrite each other's cache
+static std::wstring GetFootprintCacheFileName12(_In_z_ const wchar_t* fileName, _In_ size_t maxsize, _In_ DDS_LOADER_FLAGS loadFlags)
+{
+	std::wstring cacheName(fileName);
+	if (maxsize)
+		cacheName += L"." + std::to_wstring(maxsize);
+	if (loadFlags & DDS_LOADER_FORCE_SRGB)
+		cacheName += L".srgb";
+	if (loadFlags & DDS_LOADER_COMPRESS_BC)
+		cacheName += (loadFlags & DDS_LOADER_COMPRESS_BC_QUALITY) ? L".bc-hq" : L".bc";
+	cacheName += L".upload";
+	return cacheName;
+}
+
+struct FootprintLayout12
+{
+	std::unique_ptr<D3D12_PLACED_SUBRESOURCE_FOOTPRINT[]>	layouts;
+	std::unique_ptr<UINT[]>									numRows;
+	std::unique_ptr<UINT64[]>								rowSizes;
+	UINT													numSubresources;
+	UINT64													totalBytes;
+};
+
+static HRESULT GetFootprintLayout12(
+	_In_ ID3D12Device* device,
+	const D3D12_RESOURCE_DESC& texDesc,
+	FootprintLayout12& footprints)
+{
+	footprints.numSubresources = UINT(texDesc.MipLevels) * texDesc.DepthOrArraySize;
+	footprints.layouts.reset(new (std::nothrow) D3D12_PLACED_SUBRESOURCE_FOOTPRINT[footprints.numSubresources]);
+	footprints.numRows.reset(new (std::nothrow) UINT[footprints.numSubresources]);
+	footprints.rowSizes.reset(new (std::nothrow) UINT64[footprints.numSubresources]);
+	if (!footprints.layouts || !footprints.numRows || !footprints.rowSizes)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	return GetUploadFootprints12(device, texDesc, footprints.numSubresources, 0,
+		footprints.layouts.get(), footprints.numRows.get(), footprints.rowSizes.get(), &footprints.totalBytes);
+}
+
+// Checks a cache header against the size of its file and against the footprints its
+// description gives today, so a cache written under other placement rules is rebuilt,
+// then creates the texture
+static HRESULT OpenFootprintCache12(
+	_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* cacheName,
+	ScopedHandle& hFile,
+	FootprintCacheHeader12& header,
+	FootprintLayout12& footprints,
+	ComPtr<ID3D12Resource>& texture)
+{
+	LARGE_INTEGER fileSize = {};
+	HRESULT hr = OpenDDSFile(cacheName, hFile, fileSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	if (uint64_t(fileSize.QuadPart) < sizeof(header))
+	{
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	hr = ReadFileAt(hFile.get(), 0, &header, sizeof(header));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	if (header.magic != FOOTPRINT_CACHE_MAGIC ||
+		header.version != FOOTPRINT_CACHE_VERSION ||
+		header.imageSize != uint64_t(fileSize.QuadPart) - sizeof(header) ||
+		!header.width || !header.height ||
+		!header.arraySize || header.arraySize > D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION ||
+		!header.mipLevels || header.mipLevels > D3D12_REQ_MIP_LEVELS)
+	{
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	const D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(header.format),
+		header.width, header.height, static_cast<UINT16>(header.arraySize), static_cast<UINT16>(header.mipLevels));
+
+	hr = GetFootprintLayout12(device, texDesc, footprints);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	if (footprints.totalBytes != header.imageSize)
+	{
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	return CreateTextureResource12(device, D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+		header.width, header.height, 1, header.mipLevels, header.arraySize, static_cast<DXGI_FORMAT>(header.format), texture);
+}
+
+// Subresource data over an image in footprint layout: the rows keep their padding, so the
+// upload copies each slice as one run
+static void GetFootprintSubresources12(
+	_In_ const uint8_t* image,
+	const FootprintLayout12& footprints,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+	subresources.resize(footprints.numSubresources);
+	for (UINT i = 0; i < footprints.numSubresources; ++i)
+	{
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = footprints.layouts[i];
+		subresources[i].pData = image + layout.Offset;
+		subresources[i].RowPitch = static_cast<LONG_PTR>(layout.Footprint.RowPitch);
+		subresources[i].SlicePitch = static_cast<LONG_PTR>(UINT64(layout.Footprint.RowPitch) * footprints.numRows[i]);
+	}
+}
+
+// Cache hit with the copies recorded here: the image is read straight into the upload heap
+static HRESULT StreamFootprintCache12(
+	_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_z_ const wchar_t* cacheName,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode)
+{
+	ScopedHandle hFile;
+	FootprintCacheHeader12 header;
+	FootprintLayout12 footprints;
+	HRESULT hr = OpenFootprintCache12(device, cacheName, hFile, header, footprints, texture);
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	UploadAllocation allocation;
+	hr = AcquireUploadSpace12(device, uploadRing, header.imageSize, textureUploadHeap, allocation);
+	if (SUCCEEDED(hr))
+	{
+		hr = ReadFileAt(hFile.get(), sizeof(header), allocation.cpuAddress, static_cast<size_t>(header.imageSize));
+		EndUploadWrites12(textureUploadHeap.Get());
+	}
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		textureUploadHeap = nullptr;
+		return hr;
+	}
+
+	RecordUploadCopies12(device, cmdList, texture.Get(), allocation, footprints.layouts.get(), footprints.numSubresources, nullptr);
+
+	if (alphaMode)
+		*alphaMode = static_cast<DDS_ALPHA_MODE>(header.alphaMode);
+
+	return S_OK;
+}
+
+// Cache hit for the split and batch loaders: the image is read into memory whole
+static HRESULT LoadFootprintCache12(
+	_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* cacheName,
+	ComPtr<ID3D12Resource>& texture,
+	std::unique_ptr<uint8_t[]>& image,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	_Out_ DDS_ALPHA_MODE& alphaMode)
+{
+	ScopedHandle hFile;
+	FootprintCacheHeader12 header;
+	FootprintLayout12 footprints;
+	HRESULT hr = OpenFootprintCache12(device, cacheName, hFile, header, footprints, texture);
+	if (SUCCEEDED(hr) && header.imageSize > SIZE_MAX)
+	{
+		hr = E_OUTOFMEMORY;
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		image.reset(new (std::nothrow) uint8_t[static_cast<size_t>(header.imageSize)]);
+		hr = image ? ReadFileAt(hFile.get(), sizeof(header), image.get(), static_cast<size_t>(header.imageSize)) : E_OUTOFMEMORY;
+	}
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		image.reset();
+		return hr;
+	}
+
+	GetFootprintSubresources12(image.get(), footprints, subresources);
+	alphaMode = static_cast<DDS_ALPHA_MODE>(header.alphaMode);
+	return S_OK;
+}
+
+// Cache miss: loads the source the usual way (through the BC cache under COMPRESS_BC),
+// builds its upload image in memory, converting legacy layouts and generating mips as the
+// upload would, and writes it out. Textures whose subresources don't map one to one
+// onto the texture's (volumes) return ERROR_NOT_SUPPORTED and take the usual path.
+static HRESULT BuildFootprintCache12(
+	_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* fileName,
+	_In_z_ const wchar_t* cacheName,
+	_In_ size_t maxsize,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_In_opt_ ThreadPool* pool,
+	ComPtr<ID3D12Resource>& texture,
+	std::unique_ptr<uint8_t[]>& image,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	_Out_ DDS_ALPHA_MODE& alphaMode)
+{
+	std::unique_ptr<uint8_t[]> ddsData;
+	DDS_HEADER* header = nullptr;
+	uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
+	HRESULT hr = (loadFlags & DDS_LOADER_COMPRESS_BC)
+		? LoadBCTextureDataFromFile12(fileName, loadFlags, pool, ddsData, &header, &bitData, &bitSize)
+		: LoadTextureDataFromFile(fileName, ddsData, &header, &bitData, &bitSize, pool);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	std::vector<D3D12_SUBRESOURCE_DATA> fileSubresources;
+	std::unique_ptr<uint8_t[]> mipData;
+	TextureUpload12 upload = {};
+	hr = PrepareTextureFromDDS12(device, header, bitData, bitSize, maxsize, (loadFlags & DDS_LOADER_FORCE_SRGB) != 0, true,
+		texture, fileSubresources, mipData, upload.conversion, upload.generateMips);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	upload.texture = texture.Get();
+	upload.subresources = fileSubresources.data();
+	upload.numSubresources = static_cast<UINT>(fileSubresources.size());
+
+	const D3D12_RESOURCE_DESC texDesc = texture->GetDesc();
+	FootprintLayout12 footprints;
+	hr = GetFootprintLayout12(device, texDesc, footprints);
+
+	// With generated mips the sources are mip 0 of each slice
+	const UINT stride = upload.generateMips ? texDesc.MipLevels : 1;
+	if (SUCCEEDED(hr) && size_t(upload.numSubresources) * stride != footprints.numSubresources)
+	{
+		hr = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+	if (SUCCEEDED(hr) && footprints.totalBytes > SIZE_MAX - sizeof(FootprintCacheHeader12))
+	{
+		hr = E_OUTOFMEMORY;
+	}
+
+	// Zeroed, so the row padding written to disk is deterministic
+	std::unique_ptr<uint8_t[]> cacheData;
+	std::unique_ptr<uint8_t[]> mipScratch;
+	if (SUCCEEDED(hr))
+	{
+		cacheData.reset(new (std::nothrow) uint8_t[sizeof(FootprintCacheHeader12) + static_cast<size_t>(footprints.totalBytes)]());
+		if (upload.generateMips)
+		{
+			mipScratch.reset(new (std::nothrow) uint8_t[GetMipScratchSize12(texDesc) * 2]);
+		}
+
+		if (!cacheData || (upload.generateMips && !mipScratch))
+		{
+			hr = E_OUTOFMEMORY;
+		}
+	}
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	uint8_t* imageBase = cacheData.get() + sizeof(FootprintCacheHeader12);
+
+	const SIZE_T bandBytes = (pool && footprints.totalBytes >= PARALLEL_COPY_THRESHOLD)
+		? PARALLEL_COPY_BAND_BYTES : SIZE_MAX;
+
+	std::vector<UploadCopyBand12> bands;
+	for (UINT j = 0; j < upload.numSubresources; ++j)
+	{
+		const UINT index = j * stride;
+		AddUploadCopyBands12(bands, imageBase + footprints.layouts[index].Offset, footprints.layouts[index],
+			footprints.numRows[index], SIZE_T(footprints.rowSizes[index]), fileSubresources[j], upload.conversion, bandBytes);
+	}
+
+	if (bandBytes != SIZE_MAX && bands.size() > 1)
+	{
+		pool->ParallelFor(bands.size(), [&bands](size_t i) { CopyUploadBand12(bands[i]); });
+	}
+	else
+	{
+		for (const auto& band : bands)
+		{
+			CopyUploadBand12(band);
+		}
+	}
+
+	if (upload.generateMips)
+	{
+		GenerateUploadMips12(upload, texDesc, imageBase, footprints.layouts.get(), mipScratch.get(), pool);
+	}
+
+	FootprintCacheHeader12* cacheHeader = reinterpret_cast<FootprintCacheHeader12*>(cacheData.get());
+	cacheHeader->magic = FOOTPRINT_CACHE_MAGIC;
+	cacheHeader->version = FOOTPRINT_CACHE_VERSION;
+	cacheHeader->format = static_cast<uint32_t>(texDesc.Format);
+	cacheHeader->width = static_cast<uint32_t>(texDesc.Width);
+	cacheHeader->height = texDesc.Height;
+	cacheHeader->arraySize = texDesc.DepthOrArraySize;
+	cacheHeader->mipLevels = texDesc.MipLevels;
+	cacheHeader->alphaMode = static_cast<uint32_t>(GetAlphaMode(header));
+	cacheHeader->imageSize = footprints.totalBytes;
+
+	WriteCacheFile12(cacheName, cacheData.get(), sizeof(FootprintCacheHeader12) + static_cast<size_t>(footprints.totalBytes));
+
+	GetFootprintSubresources12(imageBase, footprints, subresources);
+	alphaMode = static_cast<DDS_ALPHA_MODE>(cacheHeader->alphaMode);
+	image = std::move(cacheData);
+	return S_OK;
+}
+
+// Split and batch loaders under FOOTPRINT_CACHE. The subresources come back in footprint
+// layout with neither conversion nor mip generation left to do. ERROR_NOT_SUPPORTED
+// means the texture can't be cached and should be loaded the usual way.
+static HRESULT LoadFootprintCachedTexture12(
+	_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* fileName,
+	_In_ size_t maxsize,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_In_opt_ ThreadPool* pool,
+	ComPtr<ID3D12Resource>& texture,
+	std::unique_ptr<uint8_t[]>& image,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	_Out_ DDS_ALPHA_MODE& alphaMode)
+{
+	// A cache that fails its checks is rebuilt
+	const std::wstring cacheName = GetFootprintCacheFileName12(fileName, maxsize, loadFlags);
+	if (IsCacheFileCurrent12(fileName, cacheName.c_str()) &&
+		SUCCEEDED(LoadFootprintCache12(device, cacheName.c_str(), texture, image, subresources, alphaMode)))
+	{
+		return S_OK;
+	}
+
+	return BuildFootprintCache12(device, fileName, cacheName.c_str(), maxsize, loadFlags, pool, texture, image, subresources, alphaMode);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Converts legacy-layout subresources into a new buffer, for callers that upload the
+// subresource data as it is. Rows of these formats are never padded, so each
+// subresource converts as one run of pixels.
+//--------------------------------------------------------------------------------------
+static HRESULT ConvertSubresources12(
+	_In_ DDS_CONVERSION conversion,
+	_In_ ID3D12Resource* texture,
+	std::unique_ptr<uint8_t[]>& data,
+	std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+	const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+	const size_t srcBytesPerPixel = GetLegacySourceBytesPerPixel(conversion);
+	const size_t destBytesPerPixel = GetLegacyDestBytesPerPixel(conversion);
+	if (!srcBytesPerPixel || !desc.MipLevels)
+	{
+		return E_UNEXPECTED;
+	}
+
+	auto getPixels = [&](size_t index)
+	{
+		const size_t depth = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+			? std::max<size_t>(desc.DepthOrArraySize >> (index % desc.MipLevels), 1) : 1;
+		return static_cast<size_t>(subresources[index].SlicePitch) / srcBytesPerPixel * depth;
+	};
+
+	size_t totalBytes = 0;
+	for (size_t i = 0; i < subresources.size(); ++i)
+	{
+		totalBytes += getPixels(i) * destBytesPerPixel;
+	}
+
+	std::unique_ptr<uint8_t[]> converted(new (std::nothrow) uint8_t[totalBytes]);
+	if (!converted)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	uint8_t* pDest = converted.get();
+	for (size_t i = 0; i < subresources.size(); ++i)
+	{
+		const size_t pixels = getPixels(i);
+		D3D12_SUBRESOURCE_DATA& sub = subresources[i];
+
+		ConvertLegacyRow(conversion, static_cast<const uint8_t*>(sub.pData), pDest, pixels);
+
+		sub.pData = pDest;
+		sub.RowPitch = sub.RowPitch / srcBytesPerPixel * destBytesPerPixel;
+		sub.SlicePitch = sub.SlicePitch / srcBytesPerPixel * destBytesPerPixel;
+		pDest += pixels * destBytesPerPixel;
+	}
+
+	data = std::move(converted);
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Streaming path: only the header passes through system memory. Every retained mip/slice
+// whose rows match its footprint's pitch is read from disk directly into the upload heap.
+// Narrower rows, and legacy formats, go through a staging buffer of at most
+// STREAM_STAGING_BYTES, a band of rows per read.
+//
+// A DDSZ file only has its retained payloads read into memory. The chunks are unpacked
+// across pool, each into a small scratch buffer first: LZ4 reads back the bytes it has
+// just written, which is slow on write-combined memory. The rows are then copied out.
+//
+// Files whose mip chain would be generated return ERROR_NOT_SUPPORTED.
+//--------------------------------------------------------------------------------------
+static const SIZE_T STREAM_STAGING_BYTES = 4 * 1024 * 1024;
+
+static HRESULT StreamTextureFromFile12(
+	_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_z_ const wchar_t* fileName,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_opt_ ThreadPool* pool,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode)
+{
+	ScopedHandle hFile;
+	DDSFileHeader12 fileHeader;
+	HRESULT hr = ReadDDSFileHeader12(fileName, hFile, fileHeader);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	DDSZLayout packedLayout;
+	DDSTextureLayout& layout = packedLayout.texture;
+	const bool packed = IsDDSZFile12(fileHeader);
+	UINT skipMip = 0;
+	hr = packed
+		? GetDDSZLayout12(hFile.get(), fileHeader, maxsize, packedLayout, skipMip)
+		: GetTextureLayout12(fileHeader.data, fileHeader.dataSize, fileHeader.fileSize, maxsize, layout, skipMip);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// A chain is generated from mip 0 in system memory, never from the write-combined
+	// upload heap, so such files are left to the maxsize path, which reads just that mip
+	if (ShouldGenerateMips12(layout))
+	{
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+
+	hr = CreateTextureFromLayout12(device, layout, skipMip, forceSRGB, false, texture);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	const D3D12_RESOURCE_DESC texDesc = texture->GetDesc();
+	const UINT retainedMips = layout.mipCount - skipMip;
+	const UINT numSubresources = retainedMips * layout.arraySize;
+
+	std::unique_ptr<D3D12_PLACED_SUBRESOURCE_FOOTPRINT[]> layouts(new (std::nothrow) D3D12_PLACED_SUBRESOURCE_FOOTPRINT[numSubresources]);
+	std::unique_ptr<UINT[]> numRows(new (std::nothrow) UINT[numSubresources]);
+	std::unique_ptr<UINT64[]> rowSizes(new (std::nothrow) UINT64[numSubresources]);
+	if (!layouts || !numRows || !rowSizes)
+	{
+		texture = nullptr;
+		return E_OUTOFMEMORY;
+	}
+
+	UINT64 uploadBufferSize = 0;
+	hr = GetUploadFootprints12(device, texDesc, numSubresources, 0, layouts.get(), numRows.get(), rowSizes.get(), &uploadBufferSize);
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	UploadAllocation allocation;
+	hr = AcquireUploadSpace12(device, uploadRing, uploadBufferSize, textureUploadHeap, allocation);
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	uint8_t* pData = allocation.cpuAddress;
+
+	// Legacy layouts, and rows narrower than the footprint's pitch, are read into staging a
+	// band of rows at a time and spread row by row over the footprint. The band is capped at
+	// STREAM_STAGING_BYTES, but always holds a row of the top retained mip, the widest there is.
+	const bool convert = (layout.conversion != DDS_CONVERSION_NONE);
+	const DDSSubresourceLayout& top = layout.subresources[skipMip];
+	const size_t stagingSize = static_cast<size_t>(std::max<uint64_t>(top.rowPitch,
+		std::min<uint64_t>(STREAM_STAGING_BYTES, top.slicePitch)));
+	std::unique_ptr<uint8_t[]> staging;
+
+	for (UINT i = 0; i < numSubresources && SUCCEEDED(hr); ++i)
+	{
+		const DDSSubresourceLayout& src = layout.subresources[(i / retainedMips) * layout.mipCount + skipMip + i % retainedMips];
+		const UINT64 rowPitch = layouts[i].Footprint.RowPitch;
+		const UINT64 slicePitch = rowPitch * numRows[i];
+		const uint64_t srcOffset = layout.headerSize + src.offset;
+		uint8_t* pDest = pData + layouts[i].Offset;
+
+		if (src.numRows != numRows[i])
+		{
+			hr = E_UNEXPECTED;
+			break;
+		}
+
+		if (!convert && src.rowPitch > rowPitch)
+		{
+			hr = E_UNEXPECTED;
+			break;
+		}
+
+		if (packed)
+		{
+			// Unpacked below, once every footprint has been checked
+			continue;
+		}
+
+		if (!convert && src.rowPitch == rowPitch)
+		{
+			// Tightly packed rows: the whole subresource is one contiguous read
+			hr = ReadFileAt(hFile.get(), srcOffset, pDest, static_cast<size_t>(src.slicePitch * src.depth));
+			continue;
+		}
+
+		if (!staging)
+		{
+			staging.reset(new (std::nothrow) uint8_t[stagingSize]);
+			if (!staging)
+			{
+				hr = E_OUTOFMEMORY;
+				break;
+			}
+		}
+
+		const size_t bandRows = static_cast<size_t>(stagingSize / src.rowPitch);
+		for (size_t z = 0; z < src.depth && SUCCEEDED(hr); ++z)
+		{
+			for (size_t y = 0; y < src.numRows && SUCCEEDED(hr); y += bandRows)
+			{
+				const size_t rows = std::min<size_t>(bandRows, src.numRows - y);
+				hr = ReadFileAt(hFile.get(), srcOffset + z * src.slicePitch + y * src.rowPitch,
+					staging.get(), static_cast<size_t>(rows * src.rowPitch));
+
+				for (size_t r = 0; r < rows && SUCCEEDED(hr); ++r)
+				{
+					const uint8_t* pSrc = staging.get() + r * src.rowPitch;
+					uint8_t* pRow = pDest + z * slicePitch + (y + r) * rowPitch;
+
+					if (convert)
+						ConvertLegacyRow(layout.conversion, pSrc, pRow, layouts[i].Footprint.Width);
+					else
+						memcpy(pRow, pSrc, static_cast<size_t>(src.rowPitch));
+				}
+			}
+		}
+	}
+
+	if (packed && SUCCEEDED(hr))
+	{
+		hr = ReadDDSZChunks12(hFile.get(), packedLayout, skipMip, pool,
+			[&](const DDSZChunkLayout& chunk, const uint8_t* payload) -> HRESULT
+		{
+			std::unique_ptr<uint8_t[]> scratch(new (std::nothrow) uint8_t[chunk.size]);
+			if (!scratch)
+			{
+				return E_OUTOFMEMORY;
+			}
+
+			if (!DecompressDDSZChunk(packedLayout, chunk, payload, scratch.get()))
+			{
+				return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+			}
+
+			const DDSSubresourceLayout& src = layout.subresources[chunk.subresource];
+			const UINT i = (chunk.subresource / layout.mipCount) * retainedMips + chunk.subresource % layout.mipCount - skipMip;
+			const UINT64 rowPitch = layouts[i].Footprint.RowPitch;
+			const size_t rows = static_cast<size_t>(chunk.size / src.rowPitch);
+
+			for (size_t r = 0; r < rows; ++r)
+			{
+				const size_t row = chunk.firstRow + r;
+				const uint8_t* pSrc = scratch.get() + r * src.rowPitch;
+				uint8_t* pDest = pData + layouts[i].Offset + (row / src.numRows) * rowPitch * numRows[i] + (row % src.numRows) * rowPitch;
+
+				if (convert)
+					ConvertLegacyRow(layout.conversion, pSrc, pDest, layouts[i].Footprint.Width);
+				else
+					memcpy(pDest, pSrc, static_cast<size_t>(src.rowPitch));
+			}
+
+			return S_OK;
+		});
+	}
+
+	EndUploadWrites12(textureUploadHeap.Get());
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		textureUploadHeap = nullptr;
+		return hr;
+	}
+
+	RecordUploadCopies12(device, cmdList, texture.Get(), allocation, layouts.get(), numSubresources, nullptr);
+
+	if (alphaMode)
+		*alphaMode = static_cast<DDS_ALPHA_MODE>(layout.alphaMode);
+
+	return S_OK;
 }
 
 
@@ -1928,6 +3220,23 @@ HRESULT DirectX::CreateDDSTextureFromMemory12(
 	_In_ size_t maxsize,
 	_Out_opt_ DDS_ALPHA_MODE* alphaMode
 	)
+{
+	return CreateDDSTextureFromMemory12(device, cmdList, ddsData, ddsDataSize, texture, textureUploadHeap,
+		maxsize, DDS_LOADER_DEFAULT, alphaMode);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemory12(
+	ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+	_In_ size_t ddsDataSize,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap,
+	_In_ size_t maxsize,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode
+	)
 {
 	if (alphaMode)
 		(*alphaMode) = DDS_ALPHA_MODE_UNKNOWN;
@@ -1937,47 +3246,25 @@ HRESULT DirectX::CreateDDSTextureFromMemory12(
 		return E_INVALIDARG;
 	}
 
-	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData);
-	if (dwMagicNumber != DDS_MAGIC)
-	{
-		return E_FAIL;
-	}
-
-	auto header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
-
-	// Verify header to validate DDS file
-	if (header->size != sizeof(DDS_HEADER) ||
-		header->ddspf.size != sizeof(DDS_PIXELFORMAT))
-	{
-		return E_FAIL;
-	}
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
 
-	// Check for DX10 extension
-	bool bDXT10Header = false;
-	if ((header->ddspf.flags & DDS_FOURCC) &&
-		(MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+	HRESULT hr = GetTextureDataFromMemory12(ddsData, ddsDataSize, &header, &bitData, &bitSize);
+	if (FAILED(hr))
 	{
-		// Must be long enough for both headers and magic value
-		if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-		{
-			return E_FAIL;
-		}
-
-		bDXT10Header = true;
+		return hr;
 	}
 
-	ptrdiff_t offset = sizeof(uint32_t)
-		+ sizeof(DDS_HEADER)
-		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-
-	HRESULT hr = CreateTextureFromDDS12(
+	hr = CreateTextureFromDDS12(
 		device,
 		cmdList,
 		header,
-		ddsData + offset,
-		ddsDataSize - offset,
+		bitData,
+		bitSize,
 		maxsize,
-		false,
+		(loadFlags & DDS_LOADER_FORCE_SRGB) != 0,
+		nullptr,
 		texture,
 		textureUploadHeap
 		);
@@ -2141,6 +3428,21 @@ HRESULT DirectX::CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
 	_Out_ ComPtr<ID3D12Resource>& textureUploadHeap,
 	_In_ size_t maxsize,
 	_Out_opt_ DDS_ALPHA_MODE* alphaMode)
+{
+	return CreateDDSTextureFromFile12(device, cmdList, szFileName, texture, textureUploadHeap,
+		maxsize, DDS_LOADER_DEFAULT, alphaMode);
+}
+
+HRESULT DirectX::CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_z_ const wchar_t* szFileName,
+	_Out_ ComPtr<ID3D12Resource>& texture,
+	_Out_ ComPtr<ID3D12Resource>& textureUploadHeap,
+	_In_ size_t maxsize,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_opt_ ThreadPool* pool)
 {
 	if (texture)
 	{
@@ -2160,19 +3462,132 @@ HRESULT DirectX::CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
 		return E_INVALIDARG;
 	}
 
-	DDS_HEADER* header = nullptr;
-	uint8_t* bitData = nullptr;
+	const bool forceSRGB = (loadFlags & DDS_LOADER_FORCE_SRGB) != 0;
+
+	if (loadFlags & DDS_LOADER_FOOTPRINT_CACHE)
+	{
+		const std::wstring cacheName = GetFootprintCacheFileName12(szFileName, maxsize, loadFlags);
+		if (IsCacheFileCurrent12(szFileName, cacheName.c_str()) &&
+			SUCCEEDED(StreamFootprintCache12(device, cmdList, cacheName.c_str(), uploadRing, texture, textureUploadHeap, alphaMode)))
+		{
+			return S_OK;
+		}
+
+		std::unique_ptr<uint8_t[]> image;
+		std::vector<D3D12_SUBRESOURCE_DATA> initData;
+		DDS_ALPHA_MODE cacheAlphaMode = DDS_ALPHA_MODE_UNKNOWN;
+		HRESULT hr = BuildFootprintCache12(device, szFileName, cacheName.c_str(), maxsize, loadFlags, pool,
+			texture, image, initData, cacheAlphaMode);
+		if (SUCCEEDED(hr))
+		{
+			hr = RecordTextureUpload12(device, cmdList, texture.Get(),
+				initData.data(), static_cast<UINT>(initData.size()), DDS_CONVERSION_NONE, false, uploadRing, textureUploadHeap);
+			if (FAILED(hr))
+			{
+				texture = nullptr;
+			}
+			else if (alphaMode)
+			{
+				*alphaMode = cacheAlphaMode;
+			}
+		}
+
+		// Textures the cache doesn't take load as if the flag were not set
+		if (hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+		{
+			return hr;
+		}
+	}
+
+	if (loadFlags & DDS_LOADER_STREAMING)
+	{
+		HRESULT hr = StreamTextureFromFile12(device, cmdList, szFileName, maxsize, forceSRGB, uploadRing, pool, texture, textureUploadHeap, alphaMode);
+
+		// Files that need their chain generated load through the maxsize path below
+		if (hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+		{
+			return hr;
+		}
+	}
+
+	if (loadFlags & DDS_LOADER_COMPRESS_BC)
+	{
+		// The encoded image is built in memory whole, so neither the maxsize read nor the
+		// mapping has anything to save; maxsize still drops the top mips
+		std::unique_ptr<uint8_t[]> ddsData;
+		DDS_HEADER* header = nullptr;
+		uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+		HRESULT hr = LoadBCTextureDataFromFile12(szFileName, loadFlags, pool, ddsData, &header, &bitData, &bitSize);
+		if (SUCCEEDED(hr))
+		{
+			hr = CreateTextureFromDDS12(device, cmdList, header,
+				bitData, bitSize, maxsize, forceSRGB, uploadRing, texture, textureUploadHeap);
+		}
+
+		if (SUCCEEDED(hr) && alphaMode)
+			*alphaMode = GetAlphaMode(header);
+
+		return hr;
+	}
+
+	if ((maxsize && !(loadFlags & DDS_LOADER_MEMORY_MAPPED)) || (loadFlags & DDS_LOADER_STREAMING))
+	{
+		// Only the mips that survive maxsize are read; they are copied into the upload heap
+		// before this returns.
+		std::unique_ptr<uint8_t[]> bitData;
+		std::vector<D3D12_SUBRESOURCE_DATA> initData;
+		DDS_CONVERSION conversion = DDS_CONVERSION_NONE;
+		bool generateMips = false;
+		HRESULT hr = LoadRetainedTextureFromFile12(device, szFileName, maxsize, forceSRGB, true,
+			texture, bitData, initData, conversion, generateMips, alphaMode, pool);
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		hr = RecordTextureUpload12(device, cmdList, texture.Get(),
+			initData.data(), static_cast<UINT>(initData.size()), conversion, generateMips, uploadRing, textureUploadHeap);
+		if (FAILED(hr))
+		{
+			texture = nullptr;
+			if (alphaMode)
+				*alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+		}
+
+		return hr;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
 	size_t bitSize = 0;
 
+	// Only one of these owns the file contents; both must outlive CreateTextureFromDDS12,
+	// which copies the subresources into the upload heap before it returns.
 	std::unique_ptr<uint8_t[]> ddsData;
-	HRESULT hr = LoadTextureDataFromFile(szFileName, ddsData, &header, &bitData, &bitSize);
+	ScopedFileView ddsView;
+
+	HRESULT hr = S_OK;
+	if (loadFlags & DDS_LOADER_MEMORY_MAPPED)
+	{
+		hr = MapTextureDataFromFile(szFileName, ddsView, ddsData, &header, &bitData, &bitSize, pool);
+	}
+	else
+	{
+		DDS_HEADER* fileHeader = nullptr;
+		uint8_t* fileBits = nullptr;
+		hr = LoadTextureDataFromFile(szFileName, ddsData, &fileHeader, &fileBits, &bitSize, pool);
+		header = fileHeader;
+		bitData = fileBits;
+	}
+
 	if (FAILED(hr))
 	{
 		return hr;
 	}
 
 	hr = CreateTextureFromDDS12(device, cmdList, header,
-		bitData, bitSize, maxsize, false, texture, textureUploadHeap);
+		bitData, bitSize, maxsize, forceSRGB, uploadRing, texture, textureUploadHeap);
 
 	if (SUCCEEDED(hr))
 	{
@@ -2228,6 +3643,286 @@ HRESULT DirectX::CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
 	return hr;
 }
 
+HRESULT DirectX::LoadDDSTextureFromFile12(_In_ ID3D12Device* device,
+	_In_z_ const wchar_t* szFileName,
+	_Out_ ComPtr<ID3D12Resource>& texture,
+	_Out_ std::unique_ptr<uint8_t[]>& ddsData,
+	_Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+	_In_ size_t maxsize,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode,
+	_Out_opt_ DDS_CONVERSION* conversion,
+	_Out_opt_ bool* generateMips,
+	_In_ DDS_LOADER_FLAGS loadFlags,
+	_In_opt_ ThreadPool* pool)
+{
+	texture = nullptr;
+	ddsData.reset();
+	subresources.clear();
+	if (alphaMode)
+	{
+		*alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+	}
+	if (conversion)
+	{
+		*conversion = DDS_CONVERSION_NONE;
+	}
+	if (generateMips)
+	{
+		*generateMips = false;
+	}
+
+	if (!device || !szFileName)
+	{
+		return E_INVALIDARG;
+	}
+
+	DDS_CONVERSION fileConversion = DDS_CONVERSION_NONE;
+	DDS_ALPHA_MODE fileAlphaMode = DDS_ALPHA_MODE_UNKNOWN;
+	bool fileGenerateMips = false;
+	const bool forceSRGB = (loadFlags & DDS_LOADER_FORCE_SRGB) != 0;
+	HRESULT hr = S_OK;
+
+	// Textures the footprint cache doesn't take load as if the flag were not set
+	bool cached = false;
+	if (loadFlags & DDS_LOADER_FOOTPRINT_CACHE)
+	{
+		hr = LoadFootprintCachedTexture12(device, szFileName, maxsize, loadFlags, pool,
+			texture, ddsData, subresources, fileAlphaMode);
+		cached = (hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+	}
+
+	if (cached)
+	{
+		// Already in footprint layout, with nothing left to convert or generate
+	}
+	else if (maxsize && !(loadFlags & DDS_LOADER_COMPRESS_BC))
+	{
+		// Only the mips that survive maxsize are read from disk
+		hr = LoadRetainedTextureFromFile12(device, szFileName, maxsize, forceSRGB, generateMips != nullptr,
+			texture, ddsData, subresources, fileConversion, fileGenerateMips, &fileAlphaMode, pool);
+	}
+	else
+	{
+		DDS_HEADER* header = nullptr;
+		uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+
+		if (loadFlags & DDS_LOADER_COMPRESS_BC)
+			hr = LoadBCTextureDataFromFile12(szFileName, loadFlags, pool, ddsData, &header, &bitData, &bitSize);
+		else
+			hr = LoadTextureDataFromFile(szFileName, ddsData, &header, &bitData, &bitSize, pool);
+
+		std::unique_ptr<uint8_t[]> mipData;
+		if (SUCCEEDED(hr))
+		{
+			hr = PrepareTextureFromDDS12(device, header, bitData, bitSize, maxsize, forceSRGB, generateMips != nullptr,
+				texture, subresources, mipData, fileConversion, fileGenerateMips);
+		}
+		if (SUCCEEDED(hr))
+		{
+			fileAlphaMode = GetAlphaMode(header);
+
+			// The header lives in the file data, so this waits until the alpha mode is read
+			if (mipData)
+				ddsData = std::move(mipData);
+		}
+	}
+
+	if (SUCCEEDED(hr) && fileConversion != DDS_CONVERSION_NONE)
+	{
+		if (conversion)
+			*conversion = fileConversion;
+		else
+			hr = ConvertSubresources12(fileConversion, texture.Get(), ddsData, subresources);
+	}
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		ddsData.reset();
+		subresources.clear();
+		if (conversion)
+			*conversion = DDS_CONVERSION_NONE;
+		return hr;
+	}
+
+	if (alphaMode)
+		*alphaMode = fileAlphaMode;
+	if (generateMips)
+		*generateMips = fileGenerateMips;
+
+	return S_OK;
+}
+
+HRESULT DirectX::UploadTextureSubresources12(_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_ ID3D12Resource* texture,
+	_In_reads_(numSubresources) const D3D12_SUBRESOURCE_DATA* subresources,
+	_In_ UINT numSubresources,
+	_Out_ ComPtr<ID3D12Resource>& textureUploadHeap)
+{
+	textureUploadHeap = nullptr;
+
+	if (!device || !cmdList || !texture || !subresources || !numSubresources)
+	{
+		return E_INVALIDARG;
+	}
+
+	return RecordTextureUpload12(device, cmdList, texture, subresources, numSubresources, DDS_CONVERSION_NONE, false, nullptr, textureUploadHeap);
+}
+
+HRESULT DirectX::UploadTextureBatch12(_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_reads_(count) const TextureUpload12* uploads,
+	_In_ size_t count,
+	_Out_ ComPtr<ID3D12Resource>& uploadHeap,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_opt_ ThreadPool* copyPool,
+	_In_opt_ ResourceStateManager* states)
+{
+	uploadHeap = nullptr;
+
+	if (!device || !cmdList || (!uploads && count))
+	{
+		return E_INVALIDARG;
+	}
+
+	return RecordTextureBatchUpload12(device, cmdList, uploads, count, uploadRing, copyPool, states, uploadHeap);
+}
+
+HRESULT DirectX::CreateDDSTextureBatch12(_In_ ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_reads_(count) const DDS_TEXTURE_SOURCE* sources,
+	_In_ size_t count,
+	_Out_writes_(count) ComPtr<ID3D12Resource>* textures,
+	_Out_ ComPtr<ID3D12Resource>& uploadHeap,
+	_Out_writes_opt_(count) DDS_ALPHA_MODE* alphaModes,
+	_Out_writes_opt_(count) HRESULT* results,
+	_In_opt_ UploadRingBuffer* uploadRing,
+	_In_opt_ ThreadPool* copyPool)
+{
+	uploadHeap = nullptr;
+
+	if (!device || !cmdList || ((!sources || !textures) && count))
+	{
+		return E_INVALIDARG;
+	}
+
+	// Everything stays in system memory until the batch has been copied into the upload heap
+	std::vector<std::unique_ptr<uint8_t[]>> fileData(count);
+	std::vector<std::vector<D3D12_SUBRESOURCE_DATA>> subresources(count);
+	std::vector<DDS_CONVERSION> conversions(count, DDS_CONVERSION_NONE);
+	std::vector<TextureUpload12> uploads;
+	uploads.reserve(count);
+
+	HRESULT firstError = S_OK;
+	for (size_t i = 0; i < count; ++i)
+	{
+		textures[i] = nullptr;
+		if (alphaModes)
+			alphaModes[i] = DDS_ALPHA_MODE_UNKNOWN;
+
+		HRESULT hr = E_INVALIDARG;
+		bool generateMips = false;
+		const bool forceSRGB = (sources[i].loadFlags & DDS_LOADER_FORCE_SRGB) != 0;
+
+		// Textures the footprint cache doesn't take load as if the flag were not set
+		bool cached = false;
+		if (sources[i].fileName && (sources[i].loadFlags & DDS_LOADER_FOOTPRINT_CACHE))
+		{
+			DDS_ALPHA_MODE cacheAlphaMode = DDS_ALPHA_MODE_UNKNOWN;
+			hr = LoadFootprintCachedTexture12(device, sources[i].fileName, sources[i].maxsize, sources[i].loadFlags, copyPool,
+				textures[i], fileData[i], subresources[i], cacheAlphaMode);
+			cached = (hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+			if (SUCCEEDED(hr) && alphaModes)
+				alphaModes[i] = cacheAlphaMode;
+		}
+
+		if (cached)
+		{
+			// Already in footprint layout, with nothing left to convert or generate
+		}
+		else if (sources[i].fileName && sources[i].maxsize && !(sources[i].loadFlags & DDS_LOADER_COMPRESS_BC))
+		{
+			// Only the mips that survive maxsize are read from disk
+			hr = LoadRetainedTextureFromFile12(device, sources[i].fileName, sources[i].maxsize, forceSRGB, true,
+				textures[i], fileData[i], subresources[i], conversions[i], generateMips, alphaModes ? &alphaModes[i] : nullptr, copyPool);
+		}
+		else
+		{
+			const DDS_HEADER* header = nullptr;
+			const uint8_t* bitData = nullptr;
+			size_t bitSize = 0;
+
+			if (sources[i].fileName)
+			{
+				DDS_HEADER* fileHeader = nullptr;
+				uint8_t* fileBits = nullptr;
+				if (sources[i].loadFlags & DDS_LOADER_COMPRESS_BC)
+					hr = LoadBCTextureDataFromFile12(sources[i].fileName, sources[i].loadFlags, copyPool, fileData[i], &fileHeader, &fileBits, &bitSize);
+				else
+					hr = LoadTextureDataFromFile(sources[i].fileName, fileData[i], &fileHeader, &fileBits, &bitSize, copyPool);
+				header = fileHeader;
+				bitData = fileBits;
+			}
+			else if (sources[i].ddsData)
+			{
+				hr = GetTextureDataFromMemory12(sources[i].ddsData, sources[i].ddsDataSize, &header, &bitData, &bitSize);
+			}
+
+			std::unique_ptr<uint8_t[]> mipData;
+			if (SUCCEEDED(hr))
+			{
+				hr = PrepareTextureFromDDS12(device, header, bitData, bitSize, sources[i].maxsize, forceSRGB, true,
+					textures[i], subresources[i], mipData, conversions[i], generateMips);
+			}
+
+			if (SUCCEEDED(hr) && alphaModes)
+				alphaModes[i] = GetAlphaMode(header);
+			if (mipData)
+				fileData[i] = std::move(mipData);
+		}
+
+		if (SUCCEEDED(hr))
+		{
+			const TextureUpload12 upload = { textures[i].Get(), subresources[i].data(), static_cast<UINT>(subresources[i].size()), conversions[i], generateMips };
+			uploads.push_back(upload);
+		}
+		else
+		{
+			fileData[i].reset();
+			if (SUCCEEDED(firstError))
+				firstError = hr;
+		}
+
+		if (results)
+			results[i] = hr;
+	}
+
+	if (uploads.empty())
+	{
+		return firstError;
+	}
+
+	HRESULT hr = RecordTextureBatchUpload12(device, cmdList, uploads.data(), uploads.size(), uploadRing, copyPool, nullptr, uploadHeap);
+	if (FAILED(hr))
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (textures[i])
+			{
+				textures[i] = nullptr;
+				if (results)
+					results[i] = hr;
+			}
+		}
+
+		return hr;
+	}
+
+	return firstError;
+}
+
 _Use_decl_annotations_
 HRESULT DirectX::CreateDDSTextureFromFile( ID3D11Device* d3dDevice,
                                            ID3D11DeviceContext* d3dContext,
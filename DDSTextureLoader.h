@@ -25,6 +25,10 @@
 #include <wrl.h>
 #include <d3d11_1.h>
 #include "d3dx12.h"
+#include "DDSLayout.h"
+
+#include <memory>
+#include <vector>
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -46,6 +50,10 @@
 
 namespace DirectX
 {
+    class ResourceStateManager;
+    class ThreadPool;
+    class UploadRingBuffer;
+
     enum DDS_ALPHA_MODE
     {
         DDS_ALPHA_MODE_UNKNOWN       = 0,
@@ -55,6 +63,20 @@ namespace DirectX
         DDS_ALPHA_MODE_CUSTOM        = 4,
     };
 
+    enum DDS_LOADER_FLAGS
+    {
+        DDS_LOADER_DEFAULT             = 0,
+        DDS_LOADER_FORCE_SRGB          = 0x1,   // Create the _SRGB twin of the format (generated mips are then filtered in linear space)
+        DDS_LOADER_COMPRESS_BC         = 0x2,   // Encode 8-bit RGBA/BGRA 2D files to BC1 (opaque) or BC7 and cache the result on disk
+        DDS_LOADER_COMPRESS_BC_QUALITY = 0x4,   // With COMPRESS_BC: refine endpoints (several times slower to encode)
+        DDS_LOADER_FOOTPRINT_CACHE     = 0x8,   // Cache the upload image in footprint layout on disk (takes precedence over STREAMING)
+        DDS_LOADER_MEMORY_MAPPED       = 0x100, // Map the file instead of reading it into a heap copy
+        DDS_LOADER_STREAMING           = 0x200, // Read each subresource straight into the upload heap (takes precedence over MEMORY_MAPPED;
+                                                // a single mip that gets a generated chain is read into memory first)
+    };
+
+    DEFINE_ENUM_FLAG_OPERATORS(DDS_LOADER_FLAGS);
+
     // Standard version
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
@@ -75,6 +97,18 @@ namespace DirectX
 		                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                                 );
 
+	// FORCE_SRGB is the only flag that applies to data already in memory
+	HRESULT CreateDDSTextureFromMemory12(_In_ ID3D12Device* device,
+		                                 _In_ ID3D12GraphicsCommandList* cmdList,
+		                                 _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+		                                 _In_ size_t ddsDataSize,
+		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
+		                                 _In_ size_t maxsize,
+		                                 _In_ DDS_LOADER_FLAGS loadFlags,
+		                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+		                                 );
+
     HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
                                       _In_z_ const wchar_t* szFileName,
                                       _Outptr_opt_ ID3D11Resource** texture,
@@ -92,6 +126,138 @@ namespace DirectX
 		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                               );
 
+	HRESULT CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
+		                               _In_ ID3D12GraphicsCommandList* cmdList,
+		                               _In_z_ const wchar_t* szFileName,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
+		                               _In_ size_t maxsize,
+		                               _In_ DDS_LOADER_FLAGS loadFlags,
+		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+		                               _In_opt_ UploadRingBuffer* uploadRing = nullptr,
+		                               _In_opt_ ThreadPool* pool = nullptr
+		                               );
+
+	// The file loaders also read DDSZ files (see DDSZ.h), whose chunks are unpacked across
+	// pool (copyPool for the batch version). Reads capped by maxsize, and STREAMING, only
+	// read and unpack the chunks of the mips they keep. STREAMING copies each chunk's rows
+	// into the upload heap as soon as the chunk is unpacked.
+	//
+	// DDS_LOADER_COMPRESS_BC applies to the file loaders other than STREAMING. A 2D file in
+	// an 8-bit RGBA/BGRA format whose size is a multiple of 4 is given a full mip chain if it
+	// has one mip, and then encoded to BC1 if every pixel is opaque and BC7 otherwise. The
+	// result is written next to the file as <file>.bc.dds (<file>.bc-hq.dds with
+	// COMPRESS_BC_QUALITY). Later loads use that cache while it is at least as new as the
+	// file. Files the encoder does not take load unchanged.
+	//
+	// DDS_LOADER_FOOTPRINT_CACHE applies to every file loader. The texture's upload image,
+	// rows padded and subresources placed as GetCopyableFootprints lays them out, with
+	// legacy layouts converted and missing mips generated, is written next to the file as
+	// <file>[.<maxsize>][.srgb][.bc|.bc-hq].upload. While that cache is at least as new as
+	// the file, CreateDDSTextureFromFile12 reads it straight into the upload heap in one
+	// read, and the split and batch loaders read it into ddsData with subresources that
+	// upload as one copy per slice. A cache whose footprints no longer match is rebuilt.
+	// Volume textures are loaded as if the flag were not set.
+
+	// Split version: creates the texture (COMMON state) and its subresource data without
+	// recording any commands, so it can run on a worker thread. ddsData owns the memory the
+	// subresources point into and must stay alive until UploadTextureSubresources12 returns.
+	//
+	// Legacy layouts with no DXGI twin (see DDS_CONVERSION) are converted here unless the
+	// caller takes the conversion, in which case the subresources stay in the file layout
+	// and TextureUpload12::conversion converts them during the upload copy.
+	//
+	// A file with a single mip only gets a full chain when the caller asks for
+	// generateMips. If it comes back true, the texture has every level but subresources
+	// hold mip 0 of each array slice, and TextureUpload12::generateMips must be set.
+	// maxsize applies to the generated chain too: the texture starts at its first level
+	// that fits, and mip 0 is filtered down to that level into ddsData.
+	// FORCE_SRGB, COMPRESS_BC and FOOTPRINT_CACHE apply; pool, if given, runs the BC
+	// encoder and unpacks DDSZ chunks.
+	HRESULT LoadDDSTextureFromFile12(_In_ ID3D12Device* device,
+		                             _In_z_ const wchar_t* szFileName,
+		                             _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                             _Out_ std::unique_ptr<uint8_t[]>& ddsData,
+		                             _Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+		                             _In_ size_t maxsize = 0,
+		                             _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+		                             _Out_opt_ DDS_CONVERSION* conversion = nullptr,
+		                             _Out_opt_ bool* generateMips = nullptr,
+		                             _In_ DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT,
+		                             _In_opt_ ThreadPool* pool = nullptr
+		                             );
+
+	HRESULT UploadTextureSubresources12(_In_ ID3D12Device* device,
+		                                _In_ ID3D12GraphicsCommandList* cmdList,
+		                                _In_ ID3D12Resource* texture,
+		                                _In_reads_(numSubresources) const D3D12_SUBRESOURCE_DATA* subresources,
+		                                _In_ UINT numSubresources,
+		                                _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap
+		                                );
+
+	// Batch versions: every texture in the set shares one upload heap. The textures are
+	// promoted from COMMON to COPY_DEST without a barrier, and the COPY_DEST ->
+	// PIXEL_SHADER_RESOURCE transitions go out as one ResourceBarrier call. On a copy
+	// command list the textures decay back to COMMON instead, and are promoted when a
+	// direct queue first samples them.
+	//
+	// UploadTextureBatch12 registers the textures with states when one is given, so the
+	// caller's later transitions start from where the upload leaves them; states must
+	// have nothing pending for another command list, and needs its Decay called after the
+	// list executes. Without one, the upload tracks them on its own.
+	//
+	// Functions taking an UploadRingBuffer stage through it when it has room and only fall
+	// back to a dedicated upload heap (returned as usual) when it does not. The caller
+	// submits the ring with its fence after queuing the command list.
+	//
+	// A returned upload heap is only needed until the copies have executed: hand it to a
+	// DeferredReleaseQueue with the fence value signalled after the command list.
+	//
+	// With a copyPool, large batches are copied into the upload heap in bands of rows
+	// spread over the pool; small ones stay on the calling thread.
+	struct TextureUpload12
+	{
+		ID3D12Resource*                 texture;            // COMMON state, e.g. from LoadDDSTextureFromFile12
+		const D3D12_SUBRESOURCE_DATA*   subresources;
+		UINT                            numSubresources;
+		DDS_CONVERSION                  conversion;         // Applied while copying; zero-initialized to NONE
+		bool                            generateMips;       // Build mips 1.. on the CPU; subresources hold mip 0 of each slice
+	};
+
+	HRESULT UploadTextureBatch12(_In_ ID3D12Device* device,
+		                         _In_ ID3D12GraphicsCommandList* cmdList,
+		                         _In_reads_(count) const TextureUpload12* uploads,
+		                         _In_ size_t count,
+		                         _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& uploadHeap,
+		                         _In_opt_ UploadRingBuffer* uploadRing = nullptr,
+		                         _In_opt_ ThreadPool* copyPool = nullptr,
+		                         _In_opt_ ResourceStateManager* states = nullptr
+		                         );
+
+	struct DDS_TEXTURE_SOURCE
+	{
+		const wchar_t*      fileName;       // Read from disk when set,
+		const uint8_t*      ddsData;        // otherwise parsed from this memory blob
+		size_t              ddsDataSize;
+		size_t              maxsize;
+		DDS_LOADER_FLAGS    loadFlags;      // FORCE_SRGB, and COMPRESS_BC and FOOTPRINT_CACHE for files
+	};
+
+	// textures, alphaModes and results are arrays of count entries. A source that fails to
+	// load is left null and reported in results (if given) without failing the others; the
+	// return value is the first failure, if any.
+	HRESULT CreateDDSTextureBatch12(_In_ ID3D12Device* device,
+		                            _In_ ID3D12GraphicsCommandList* cmdList,
+		                            _In_reads_(count) const DDS_TEXTURE_SOURCE* sources,
+		                            _In_ size_t count,
+		                            _Out_writes_(count) Microsoft::WRL::ComPtr<ID3D12Resource>* textures,
+		                            _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& uploadHeap,
+		                            _Out_writes_opt_(count) DDS_ALPHA_MODE* alphaModes = nullptr,
+		                            _Out_writes_opt_(count) HRESULT* results = nullptr,
+		                            _In_opt_ UploadRingBuffer* uploadRing = nullptr,
+		                            _In_opt_ ThreadPool* copyPool = nullptr
+		                            );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
@@ -0,0 +1,355 @@
+//--------------------------------------------------------------------------------------
+// File: DDSZ.cpp
+//
+// The DDS headers are kept byte for byte, so ParseDDS describes the unpacked texture and
+// the chunk table only has to be checked against it.
+//--------------------------------------------------------------------------------------
+
+#include "DDSZ.h"
+#include "DDS.h"
+#include "LZ4.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Keeps the chunk table within reach of a 32-bit size_t; 4M chunks of the default size
+	// is a terabyte of texture
+	const uint32_t MAX_CHUNKS = 4 * 1024 * 1024;
+
+	// Chunks larger than this are split even if the caller asks for more
+	const size_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+	// Size of the magic number and DDS headers, as in a plain DDS file
+	size_t GetPlainHeaderSize(const uint8_t* data)
+	{
+		auto header = reinterpret_cast<const DDS_HEADER*>(data + sizeof(uint32_t));
+		const bool dx10 = (header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC);
+		return sizeof(uint32_t) + sizeof(DDS_HEADER) + (dx10 ? sizeof(DDS_HEADER_DXT10) : 0);
+	}
+
+	struct PackChunk
+	{
+		uint64_t                offset;
+		uint32_t                size;
+		std::vector<uint8_t>    payload;
+	};
+}
+
+
+//--------------------------------------------------------------------------------------
+size_t DirectX::GetDDSZHeaderSize(const uint8_t* data, size_t dataSize)
+{
+	if (!data || dataSize < sizeof(uint32_t) + sizeof(DDS_HEADER))
+		return 0;
+
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
+	if (magic != DDSZ_MAGIC)
+		return 0;
+
+	const size_t ddsHeaderSize = GetPlainHeaderSize(data);
+	if (dataSize < ddsHeaderSize + sizeof(DDSZ_HEADER))
+		return 0;
+
+	DDSZ_HEADER header;
+	memcpy(&header, data + ddsHeaderSize, sizeof(header));
+	if (header.chunkCount > MAX_CHUNKS)
+		return 0;
+
+	return ddsHeaderSize + sizeof(DDSZ_HEADER) + size_t(header.chunkCount) * sizeof(DDSZ_CHUNK);
+}
+
+
+//--------------------------------------------------------------------------------------
+DDS_PARSE_STATUS DirectX::ParseDDSZ(const uint8_t* data,
+	size_t dataSize,
+	DDSZLayout& layout,
+	uint64_t fileSize,
+	uint32_t flags)
+{
+	layout = DDSZLayout();
+
+	if (!data)
+		return DDS_PARSE_INVALID_ARG;
+
+	if (!fileSize)
+		fileSize = dataSize;
+
+	const size_t headerSize = GetDDSZHeaderSize(data, dataSize);
+	if (!headerSize || dataSize < headerSize || fileSize < dataSize)
+		return DDS_PARSE_NOT_DDS;
+
+	const size_t ddsHeaderSize = GetPlainHeaderSize(data);
+
+	DDSZ_HEADER header;
+	memcpy(&header, data + ddsHeaderSize, sizeof(header));
+	if (header.version != DDSZ_VERSION || header.codec > DDSZ_CODEC_LZ4)
+		return DDS_PARSE_NOT_SUPPORTED;
+
+	// ParseDDS reads the plain file the chunks unpack to: the same headers behind the DDS
+	// magic number, followed by bitSize bytes
+	uint8_t plain[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)];
+	memcpy(plain, &DDS_MAGIC, sizeof(uint32_t));
+	memcpy(plain + sizeof(uint32_t), data + sizeof(uint32_t), ddsHeaderSize - sizeof(uint32_t));
+
+	DDS_PARSE_STATUS status = ParseDDS(plain, ddsHeaderSize, layout.texture, ddsHeaderSize + header.bitSize, flags);
+	if (status != DDS_PARSE_OK)
+		return status;
+
+	if (layout.texture.bitSize != header.bitSize)
+		return DDS_PARSE_INVALID_DATA;
+
+	const std::vector<DDSSubresourceLayout>& subresources = layout.texture.subresources;
+	const uint8_t* table = data + ddsHeaderSize + sizeof(DDSZ_HEADER);
+	layout.chunks.resize(header.chunkCount);
+
+	uint64_t offset = 0;
+	size_t sub = 0;
+	for (uint32_t i = 0; i < header.chunkCount; ++i)
+	{
+		DDSZ_CHUNK entry;
+		memcpy(&entry, table + size_t(i) * sizeof(DDSZ_CHUNK), sizeof(entry));
+
+		if (!entry.size || entry.size > header.maxChunkSize || !entry.packedSize || entry.packedSize > entry.size ||
+			(header.codec == DDSZ_CODEC_NONE && entry.packedSize != entry.size))
+		{
+			status = DDS_PARSE_INVALID_DATA;
+			break;
+		}
+
+		if (entry.fileOffset < headerSize || entry.fileOffset > fileSize || entry.packedSize > fileSize - entry.fileOffset)
+		{
+			status = DDS_PARSE_END_OF_FILE;
+			break;
+		}
+
+		while (sub < subresources.size() && offset >= subresources[sub].offset + subresources[sub].slicePitch * subresources[sub].depth)
+			++sub;
+
+		if (sub == subresources.size())
+		{
+			status = DDS_PARSE_INVALID_DATA;
+			break;
+		}
+
+		// Whole rows of this subresource only
+		const DDSSubresourceLayout& src = subresources[sub];
+		const uint64_t end = src.offset + src.slicePitch * src.depth;
+		if ((offset - src.offset) % src.rowPitch || entry.size % src.rowPitch || entry.size > end - offset)
+		{
+			status = DDS_PARSE_INVALID_DATA;
+			break;
+		}
+
+		DDSZChunkLayout& chunk = layout.chunks[i];
+		chunk.offset = offset;
+		chunk.fileOffset = entry.fileOffset;
+		chunk.size = entry.size;
+		chunk.packedSize = entry.packedSize;
+		chunk.subresource = static_cast<uint32_t>(sub);
+		chunk.firstRow = static_cast<uint32_t>((offset - src.offset) / src.rowPitch);
+
+		offset += entry.size;
+	}
+
+	if (status == DDS_PARSE_OK && offset != header.bitSize)
+		status = DDS_PARSE_INVALID_DATA;
+
+	if (status != DDS_PARSE_OK)
+	{
+		layout = DDSZLayout();
+		return status;
+	}
+
+	layout.codec = header.codec;
+	layout.maxChunkSize = header.maxChunkSize;
+	layout.headerSize = headerSize;
+
+	return DDS_PARSE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::DecompressDDSZChunk(const DDSZLayout& layout, const DDSZChunkLayout& chunk, const uint8_t* packed, uint8_t* dest)
+{
+	if (!packed || !dest)
+		return false;
+
+	if (chunk.packedSize == chunk.size)
+	{
+		memcpy(dest, packed, chunk.size);
+		return true;
+	}
+
+	return layout.codec == DDSZ_CODEC_LZ4 && LZ4DecompressBlock(packed, chunk.packedSize, dest, chunk.size);
+}
+
+
+//--------------------------------------------------------------------------------------
+DDS_PARSE_STATUS DirectX::ExpandDDSZ(const uint8_t* data,
+	size_t dataSize,
+	std::unique_ptr<uint8_t[]>& ddsData,
+	size_t& ddsDataSize,
+	ThreadPool* pool)
+{
+	ddsData.reset();
+	ddsDataSize = 0;
+
+	// The legacy layouts are accepted so that anything PackDDSZ takes comes back out
+	DDSZLayout layout;
+	DDS_PARSE_STATUS status = ParseDDSZ(data, dataSize, layout, 0, DDS_PARSE_FLAGS_CONVERT_LEGACY);
+	if (status != DDS_PARSE_OK)
+		return status;
+
+	const size_t ddsHeaderSize = layout.texture.headerSize;
+	if (layout.texture.bitSize > SIZE_MAX - ddsHeaderSize)
+		return DDS_PARSE_NOT_SUPPORTED;
+
+	const size_t size = ddsHeaderSize + static_cast<size_t>(layout.texture.bitSize);
+	std::unique_ptr<uint8_t[]> expanded(new (std::nothrow) uint8_t[size]);
+	if (!expanded)
+		return DDS_PARSE_OUT_OF_MEMORY;
+
+	memcpy(expanded.get(), &DDS_MAGIC, sizeof(uint32_t));
+	memcpy(expanded.get() + sizeof(uint32_t), data + sizeof(uint32_t), ddsHeaderSize - sizeof(uint32_t));
+
+	uint8_t* bits = expanded.get() + ddsHeaderSize;
+	std::atomic<bool> corrupt(false);
+	auto unpack = [&](size_t i)
+	{
+		const DDSZChunkLayout& chunk = layout.chunks[i];
+		if (!DecompressDDSZChunk(layout, chunk, data + chunk.fileOffset, bits + chunk.offset))
+			corrupt = true;
+	};
+
+	if (pool && layout.chunks.size() > 1)
+	{
+		pool->ParallelFor(layout.chunks.size(), unpack);
+	}
+	else
+	{
+		for (size_t i = 0; i < layout.chunks.size(); ++i)
+			unpack(i);
+	}
+
+	if (corrupt)
+		return DDS_PARSE_INVALID_DATA;
+
+	ddsData = std::move(expanded);
+	ddsDataSize = size;
+	return DDS_PARSE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+DDS_PARSE_STATUS DirectX::PackDDSZ(const uint8_t* ddsData,
+	size_t ddsDataSize,
+	std::vector<uint8_t>& ddszData,
+	DDSZ_CODEC codec,
+	size_t chunkSize,
+	ThreadPool* pool)
+{
+	ddszData.clear();
+
+	if (codec > DDSZ_CODEC_LZ4)
+		return DDS_PARSE_INVALID_ARG;
+
+	DDSTextureLayout layout;
+	DDS_PARSE_STATUS status = ParseDDS(ddsData, ddsDataSize, layout, 0, DDS_PARSE_FLAGS_CONVERT_LEGACY);
+	if (status != DDS_PARSE_OK)
+		return status;
+
+	chunkSize = std::min(std::max<size_t>(chunkSize, 1), MAX_CHUNK_SIZE);
+
+	std::vector<PackChunk> chunks;
+	for (const DDSSubresourceLayout& sub : layout.subresources)
+	{
+		const uint64_t rows = uint64_t(sub.numRows) * sub.depth;
+		const uint64_t rowsPerChunk = std::max<uint64_t>(chunkSize / sub.rowPitch, 1);
+		for (uint64_t row = 0; row < rows; row += rowsPerChunk)
+		{
+			if (chunks.size() == MAX_CHUNKS)
+				return DDS_PARSE_NOT_SUPPORTED;
+
+			PackChunk chunk;
+			chunk.offset = sub.offset + row * sub.rowPitch;
+			chunk.size = static_cast<uint32_t>(std::min(rowsPerChunk, rows - row) * sub.rowPitch);
+			chunks.push_back(std::move(chunk));
+		}
+	}
+
+	const uint8_t* bits = ddsData + layout.headerSize;
+	auto pack = [&](size_t i)
+	{
+		PackChunk& chunk = chunks[i];
+		const uint8_t* src = bits + chunk.offset;
+
+		if (codec == DDSZ_CODEC_LZ4)
+		{
+			chunk.payload.resize(LZ4CompressBound(chunk.size));
+			const size_t packedSize = LZ4CompressBlock(src, chunk.size, chunk.payload.data(), chunk.payload.size());
+			if (packedSize && packedSize < chunk.size)
+			{
+				chunk.payload.resize(packedSize);
+				return;
+			}
+		}
+
+		// Stored as is: the reader tells by the packed size matching the size
+		chunk.payload.assign(src, src + chunk.size);
+	};
+
+	if (pool && chunks.size() > 1)
+	{
+		pool->ParallelFor(chunks.size(), pack);
+	}
+	else
+	{
+		for (size_t i = 0; i < chunks.size(); ++i)
+			pack(i);
+	}
+
+	const size_t ddsHeaderSize = layout.headerSize;
+	const size_t headerSize = ddsHeaderSize + sizeof(DDSZ_HEADER) + chunks.size() * sizeof(DDSZ_CHUNK);
+
+	DDSZ_HEADER header = {};
+	header.version = DDSZ_VERSION;
+	header.codec = codec;
+	header.chunkCount = static_cast<uint32_t>(chunks.size());
+	header.bitSize = layout.bitSize;
+
+	size_t totalSize = headerSize;
+	for (const PackChunk& chunk : chunks)
+	{
+		header.maxChunkSize = std::max(header.maxChunkSize, chunk.size);
+		totalSize += chunk.payload.size();
+	}
+
+	ddszData.resize(totalSize);
+	uint8_t* out = ddszData.data();
+	memcpy(out, &DDSZ_MAGIC, sizeof(uint32_t));
+	memcpy(out + sizeof(uint32_t), ddsData + sizeof(uint32_t), ddsHeaderSize - sizeof(uint32_t));
+	memcpy(out + ddsHeaderSize, &header, sizeof(header));
+
+	uint8_t* table = out + ddsHeaderSize + sizeof(DDSZ_HEADER);
+	uint64_t fileOffset = headerSize;
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		DDSZ_CHUNK entry;
+		entry.fileOffset = fileOffset;
+		entry.packedSize = static_cast<uint32_t>(chunks[i].payload.size());
+		entry.size = chunks[i].size;
+		memcpy(table + i * sizeof(DDSZ_CHUNK), &entry, sizeof(entry));
+
+		memcpy(out + fileOffset, chunks[i].payload.data(), chunks[i].payload.size());
+		fileOffset += entry.packedSize;
+	}
+
+	return DDS_PARSE_OK;
+}
@@ -0,0 +1,109 @@
+//--------------------------------------------------------------------------------------
+// File: DDSZ.h
+//
+// DDSZ: a DDS file whose bit data is stored as independently compressed chunks, so that
+// loaders can unpack them in parallel and skip the mips maxsize drops without reading
+// them. The file is laid out as:
+//
+//   uint32_t           DDSZ_MAGIC ("DDSZ")
+//   DDS_HEADER         unchanged from the source file
+//   DDS_HEADER_DXT10   when the source has one
+//   DDSZ_HEADER
+//   DDSZ_CHUNK         chunkCount of them, covering the bit data in order
+//   chunk payloads
+//
+// A chunk holds whole rows of a single subresource, so it can be unpacked into an upload
+// footprint without its neighbours. Like DDSLayout, this needs no device or windows.h.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "DDSLayout.h"
+
+#include <memory>
+#include <vector>
+
+namespace DirectX
+{
+	class ThreadPool;
+
+	const uint32_t DDSZ_MAGIC = 0x5A534444; // "DDSZ"
+	const uint32_t DDSZ_VERSION = 1;
+	const size_t DDSZ_DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+	enum DDSZ_CODEC
+	{
+		DDSZ_CODEC_NONE = 0,                // Payloads are the bit data as is
+		DDSZ_CODEC_LZ4,                     // LZ4 blocks; a payload as large as its chunk is stored as is
+	};
+
+#pragma pack(push,1)
+	struct DDSZ_HEADER
+	{
+		uint32_t    version;
+		uint32_t    codec;                  // DDSZ_CODEC
+		uint32_t    chunkCount;
+		uint32_t    maxChunkSize;           // Largest unpacked chunk, for sizing scratch buffers
+		uint64_t    bitSize;                // Unpacked bit data
+	};
+
+	struct DDSZ_CHUNK
+	{
+		uint64_t    fileOffset;             // Of the payload
+		uint32_t    packedSize;
+		uint32_t    size;                   // Unpacked
+	};
+#pragma pack(pop)
+
+	struct DDSZChunkLayout
+	{
+		uint64_t    offset;                 // Unpacked, from the start of the bit data
+		uint64_t    fileOffset;
+		uint32_t    size;
+		uint32_t    packedSize;
+		uint32_t    subresource;            // Index into texture.subresources
+		uint32_t    firstRow;               // Counting the rows of every depth slice in turn
+	};
+
+	struct DDSZLayout
+	{
+		DDSTextureLayout                texture;        // The unpacked file, as ParseDDS describes it
+		uint32_t                        codec;
+		uint32_t                        maxChunkSize;
+		size_t                          headerSize;     // Magic number, headers and chunk table
+		std::vector<DDSZChunkLayout>    chunks;
+	};
+
+	// Bytes from the start of the file to the end of the chunk table, i.e. how much to read
+	// before ParseDDSZ. 0 when data is not a DDSZ file or too short to hold its DDSZ_HEADER.
+	size_t GetDDSZHeaderSize(const uint8_t* data, size_t dataSize);
+
+	// data starts at the magic number and holds at least GetDDSZHeaderSize bytes. As with
+	// ParseDDS, pass fileSize when data is only the headers, so the payloads are checked
+	// against the whole file. flags is a combination of DDS_PARSE_FLAGS.
+	DDS_PARSE_STATUS ParseDDSZ(const uint8_t* data,
+	                           size_t dataSize,
+	                           DDSZLayout& layout,
+	                           uint64_t fileSize = 0,
+	                           uint32_t flags = DDS_PARSE_FLAGS_NONE);
+
+	// Unpacks chunk from its payload into dest (chunk.size bytes); false if the payload is corrupt
+	bool DecompressDDSZChunk(const DDSZLayout& layout, const DDSZChunkLayout& chunk, const uint8_t* packed, uint8_t* dest);
+
+	// Rebuilds the plain DDS file a whole DDSZ file was packed from, unpacking the chunks
+	// across pool
+	DDS_PARSE_STATUS ExpandDDSZ(const uint8_t* data,
+	                            size_t dataSize,
+	                            std::unique_ptr<uint8_t[]>& ddsData,
+	                            size_t& ddsDataSize,
+	                            ThreadPool* pool = nullptr);
+
+	// Packs a plain DDS file. Each chunk takes as many whole rows as fit in chunkSize, and
+	// at least one; the chunks are compressed across pool.
+	DDS_PARSE_STATUS PackDDSZ(const uint8_t* ddsData,
+	                          size_t ddsDataSize,
+	                          std::vector<uint8_t>& ddszData,
+	                          DDSZ_CODEC codec = DDSZ_CODEC_LZ4,
+	                          size_t chunkSize = DDSZ_DEFAULT_CHUNK_SIZE,
+	                          ThreadPool* pool = nullptr);
+}
@@ -0,0 +1,241 @@
+//--------------------------------------------------------------------------------------
+// File: DXGIFormatTraits.h
+//
+// Compile-time per-format traits for the DXGI formats the DDS loaders understand, and the
+// surface-size math built on them. Everything is a table lookup plus integer arithmetic,
+// so sizing a subresource costs the same for every format and needs no device.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DirectX
+{
+	enum DXGI_FORMAT_CLASS : uint8_t
+	{
+		DXGI_FORMAT_CLASS_UNKNOWN       = 0,
+		DXGI_FORMAT_CLASS_UNCOMPRESSED  = 1,
+		DXGI_FORMAT_CLASS_BC            = 2,    // 4x4 block compressed
+		DXGI_FORMAT_CLASS_PACKED        = 3,    // Two pixels per element (YUY2 and friends)
+		DXGI_FORMAT_CLASS_PLANAR        = 4,    // Luma plane followed by chroma (NV12, P010, NV11, ...)
+	};
+
+	// A surface is measured in elements: one pixel, one 2x1 packed pair or one 4x4 block.
+	struct DXGIFormatTraits
+	{
+		uint8_t             bitsPerPixel;       // Average over the whole surface, as reported by BitsPerPixel
+		uint8_t             bitsPerElement;
+		uint8_t             log2ElementWidth;
+		uint8_t             log2ElementHeight;
+		uint8_t             log2RowScale;       // NV11 is sized as twice its luma rows
+		uint8_t             chromaPlane;        // 1 when a half-height chroma plane follows the luma rows
+		DXGI_FORMAT_CLASS   formatClass;
+		uint8_t             srgbFormat;         // sRGB twin, or the format itself
+	};
+
+	namespace Internal
+	{
+		// Class template so the table can live in a header with a single definition
+		template <typename T = void>
+		struct DXGIFormatTraitsTable
+		{
+			static constexpr size_t count = DXGI_FORMAT_B4G4R4A4_UNORM + 1;
+
+			// Indexed by DXGI_FORMAT:
+			// bpp, bits/element, log2 width, log2 height, log2 row scale, chroma, class, sRGB twin
+			static constexpr DXGIFormatTraits entries[count] =
+			{
+			{   0,   0, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNKNOWN,      DXGI_FORMAT_UNKNOWN },                     //   0
+			{ 128, 128, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32A32_TYPELESS },       //   1
+			{ 128, 128, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32A32_FLOAT },          //   2
+			{ 128, 128, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32A32_UINT },           //   3
+			{ 128, 128, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32A32_SINT },           //   4
+			{  96,  96, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32_TYPELESS },          //   5
+			{  96,  96, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32_FLOAT },             //   6
+			{  96,  96, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32_UINT },              //   7
+			{  96,  96, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32B32_SINT },              //   8
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_TYPELESS },       //   9
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_FLOAT },          //  10
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_UNORM },          //  11
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_UINT },           //  12
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_SNORM },          //  13
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16B16A16_SINT },           //  14
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32_TYPELESS },             //  15
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32_FLOAT },                //  16
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32_UINT },                 //  17
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G32_SINT },                 //  18
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32G8X24_TYPELESS },           //  19
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_D32_FLOAT_S8X24_UINT },        //  20
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS },    //  21
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_X32_TYPELESS_G8X24_UINT },     //  22
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R10G10B10A2_TYPELESS },        //  23
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R10G10B10A2_UNORM },           //  24
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R10G10B10A2_UINT },            //  25
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R11G11B10_FLOAT },             //  26
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_TYPELESS },           //  27
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },         //  28
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },         //  29
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_UINT },               //  30
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_SNORM },              //  31
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8B8A8_SINT },               //  32
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_TYPELESS },             //  33
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_FLOAT },                //  34
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_UNORM },                //  35
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_UINT },                 //  36
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_SNORM },                //  37
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16G16_SINT },                 //  38
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32_TYPELESS },                //  39
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_D32_FLOAT },                   //  40
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32_FLOAT },                   //  41
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32_UINT },                    //  42
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R32_SINT },                    //  43
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R24G8_TYPELESS },              //  44
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_D24_UNORM_S8_UINT },           //  45
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R24_UNORM_X8_TYPELESS },       //  46
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_X24_TYPELESS_G8_UINT },        //  47
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8_TYPELESS },               //  48
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8_UNORM },                  //  49
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8_UINT },                   //  50
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8_SNORM },                  //  51
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8G8_SINT },                   //  52
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_TYPELESS },                //  53
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_FLOAT },                   //  54
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_D16_UNORM },                   //  55
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_UNORM },                   //  56
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_UINT },                    //  57
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_SNORM },                   //  58
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R16_SINT },                    //  59
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8_TYPELESS },                 //  60
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8_UNORM },                    //  61
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8_UINT },                     //  62
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8_SNORM },                    //  63
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R8_SINT },                     //  64
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_A8_UNORM },                    //  65
+			{   1,   1, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R1_UNORM },                    //  66
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R9G9B9E5_SHAREDEXP },          //  67
+			{  32,  32, 1, 0, 0, 0, DXGI_FORMAT_CLASS_PACKED,       DXGI_FORMAT_R8G8_B8G8_UNORM },             //  68
+			{  32,  32, 1, 0, 0, 0, DXGI_FORMAT_CLASS_PACKED,       DXGI_FORMAT_G8R8_G8B8_UNORM },             //  69
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC1_TYPELESS },                //  70
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC1_UNORM_SRGB },              //  71
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC1_UNORM_SRGB },              //  72
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC2_TYPELESS },                //  73
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC2_UNORM_SRGB },              //  74
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC2_UNORM_SRGB },              //  75
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC3_TYPELESS },                //  76
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC3_UNORM_SRGB },              //  77
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC3_UNORM_SRGB },              //  78
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC4_TYPELESS },                //  79
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC4_UNORM },                   //  80
+			{   4,  64, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC4_SNORM },                   //  81
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC5_TYPELESS },                //  82
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC5_UNORM },                   //  83
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC5_SNORM },                   //  84
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B5G6R5_UNORM },                //  85
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B5G5R5A1_UNORM },              //  86
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB },         //  87
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB },         //  88
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM },  //  89
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8A8_TYPELESS },           //  90
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB },         //  91
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8X8_TYPELESS },           //  92
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB },         //  93
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC6H_TYPELESS },               //  94
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC6H_UF16 },                   //  95
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC6H_SF16 },                   //  96
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC7_TYPELESS },                //  97
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC7_UNORM_SRGB },              //  98
+			{   8, 128, 2, 2, 0, 0, DXGI_FORMAT_CLASS_BC,           DXGI_FORMAT_BC7_UNORM_SRGB },              //  99
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_AYUV },                        // 100
+			{  32,  32, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_Y410 },                        // 101
+			{  64,  64, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_Y416 },                        // 102
+			{  12,  16, 1, 0, 0, 1, DXGI_FORMAT_CLASS_PLANAR,       DXGI_FORMAT_NV12 },                        // 103
+			{  24,  32, 1, 0, 0, 1, DXGI_FORMAT_CLASS_PLANAR,       DXGI_FORMAT_P010 },                        // 104
+			{  24,  32, 1, 0, 0, 1, DXGI_FORMAT_CLASS_PLANAR,       DXGI_FORMAT_P016 },                        // 105
+			{  12,  16, 1, 0, 0, 1, DXGI_FORMAT_CLASS_PLANAR,       DXGI_FORMAT_420_OPAQUE },                  // 106
+			{  32,  32, 1, 0, 0, 0, DXGI_FORMAT_CLASS_PACKED,       DXGI_FORMAT_YUY2 },                        // 107
+			{  64,  64, 1, 0, 0, 0, DXGI_FORMAT_CLASS_PACKED,       DXGI_FORMAT_Y210 },                        // 108
+			{  64,  64, 1, 0, 0, 0, DXGI_FORMAT_CLASS_PACKED,       DXGI_FORMAT_Y216 },                        // 109
+			{  12,  32, 2, 0, 1, 0, DXGI_FORMAT_CLASS_PLANAR,       DXGI_FORMAT_NV11 },                        // 110
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_AI44 },                        // 111
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_IA44 },                        // 112
+			{   8,   8, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_P8 },                          // 113
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_A8P8 },                        // 114
+			{  16,  16, 0, 0, 0, 0, DXGI_FORMAT_CLASS_UNCOMPRESSED, DXGI_FORMAT_B4G4R4A4_UNORM },              // 115
+			};
+		};
+
+		template <typename T>
+		constexpr size_t DXGIFormatTraitsTable<T>::count;
+
+		template <typename T>
+		constexpr DXGIFormatTraits DXGIFormatTraitsTable<T>::entries[DXGIFormatTraitsTable<T>::count];
+	}
+
+	// Formats outside the table (and anything the loaders don't know) map to UNKNOWN's all-zero traits
+	constexpr const DXGIFormatTraits& GetFormatTraits(DXGI_FORMAT fmt)
+	{
+		return Internal::DXGIFormatTraitsTable<>::entries[
+			(static_cast<size_t>(fmt) < Internal::DXGIFormatTraitsTable<>::count) ? static_cast<size_t>(fmt) : 0];
+	}
+
+	constexpr size_t GetBitsPerPixel(DXGI_FORMAT fmt)
+	{
+		return GetFormatTraits(fmt).bitsPerPixel;
+	}
+
+	constexpr bool IsCompressed(DXGI_FORMAT fmt)
+	{
+		return GetFormatTraits(fmt).formatClass == DXGI_FORMAT_CLASS_BC;
+	}
+
+	constexpr DXGI_FORMAT GetSRGBFormat(DXGI_FORMAT fmt)
+	{
+		return (static_cast<size_t>(fmt) < Internal::DXGIFormatTraitsTable<>::count)
+			? static_cast<DXGI_FORMAT>(GetFormatTraits(fmt).srgbFormat) : fmt;
+	}
+
+	// Row pitch, row count and total size of one depth slice of a width x height surface
+	// with no padding. The same arithmetic covers every class:
+	//  - rows are made of whole elements, rounded up to a byte (R1_UNORM is 1 bit);
+	//  - a BC surface always has at least one block in each non-zero dimension;
+	//  - planar formats add a chroma plane of half the luma rows, rounded up.
+	inline void GetFormatSurfaceInfo(size_t width,
+	                                 size_t height,
+	                                 DXGI_FORMAT fmt,
+	                                 size_t* outNumBytes,
+	                                 size_t* outRowBytes,
+	                                 size_t* outNumRows)
+	{
+		const DXGIFormatTraits& traits = GetFormatTraits(fmt);
+
+		const size_t elementsWide = (width + (size_t(1) << traits.log2ElementWidth) - 1) >> traits.log2ElementWidth;
+		const size_t elementsHigh = (height + (size_t(1) << traits.log2ElementHeight) - 1) >> traits.log2ElementHeight;
+
+		const size_t rowBytes = (elementsWide * traits.bitsPerElement + 7) >> 3;
+		const size_t planeBytes = rowBytes * elementsHigh;
+		const size_t numRows = (elementsHigh << traits.log2RowScale) + traits.chromaPlane * ((elementsHigh + 1) >> 1);
+		const size_t numBytes = (planeBytes << traits.log2RowScale) + traits.chromaPlane * ((planeBytes + 1) >> 1);
+
+		if (outNumBytes)
+		{
+			*outNumBytes = numBytes;
+		}
+		if (outRowBytes)
+		{
+			*outRowBytes = rowBytes;
+		}
+		if (outNumRows)
+		{
+			*outNumRows = numRows;
+		}
+	}
+
+	static_assert(GetBitsPerPixel(DXGI_FORMAT_R32G32B32A32_FLOAT) == 128, "format table out of order");
+	static_assert(GetBitsPerPixel(DXGI_FORMAT_BC1_UNORM) == 4, "format table out of order");
+	static_assert(GetBitsPerPixel(DXGI_FORMAT_B4G4R4A4_UNORM) == 16, "format table out of order");
+	static_assert(GetSRGBFormat(DXGI_FORMAT_BC7_UNORM) == DXGI_FORMAT_BC7_UNORM_SRGB, "format table out of order");
+}
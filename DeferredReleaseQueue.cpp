@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------------
+// File: DeferredReleaseQueue.cpp
+//
+// Entries may come from different fences, so Collect checks every one rather than
+// stopping at the first still in use. Each fence is asked for its completed value once
+// per Collect.
+//--------------------------------------------------------------------------------------
+
+#include "DeferredReleaseQueue.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+DeferredReleaseQueue::DeferredReleaseQueue() :
+	m_pendingBufferBytes(0)
+{
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+}
+
+void DeferredReleaseQueue::Enqueue(ComPtr<IUnknown> object, ID3D12Fence* fence, UINT64 fenceValue)
+{
+	if (!object || !fence)
+		return;
+
+	Entry entry;
+	entry.fence = fence;
+	entry.fenceValue = fenceValue;
+	entry.bufferBytes = 0;
+
+	ComPtr<ID3D12Resource> resource;
+	if (SUCCEEDED(object.As(&resource)))
+	{
+		const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			entry.bufferBytes = desc.Width;
+		}
+	}
+
+	entry.object = std::move(object);
+	m_pendingBufferBytes += entry.bufferBytes;
+	m_pending.push_back(std::move(entry));
+}
+
+size_t DeferredReleaseQueue::Collect()
+{
+	if (m_pending.empty())
+		return 0;
+
+	std::vector<std::pair<ID3D12Fence*, UINT64>> completed;
+	auto getCompletedValue = [&completed](ID3D12Fence* fence)
+	{
+		for (const auto& known : completed)
+		{
+			if (known.first == fence)
+				return known.second;
+		}
+
+		const UINT64 value = fence->GetCompletedValue();
+		completed.emplace_back(fence, value);
+		return value;
+	};
+
+	const size_t count = m_pending.size();
+	auto released = std::remove_if(m_pending.begin(), m_pending.end(), [&](const Entry& entry)
+	{
+		if (getCompletedValue(entry.fence.Get()) < entry.fenceValue)
+			return false;
+
+		m_pendingBufferBytes -= entry.bufferBytes;
+		return true;
+	});
+	m_pending.erase(released, m_pending.end());
+
+	return count - m_pending.size();
+}
@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------------------
+// File: DeferredReleaseQueue.h
+//
+// Holds the last reference to objects the GPU may still be reading, such as staging
+// heaps and replaced textures, and drops it once the fence value of the submission that
+// last used each one has completed.
+//
+// Not thread-safe: use it from the thread that submits to the queue.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <deque>
+
+namespace DirectX
+{
+	class DeferredReleaseQueue
+	{
+	public:
+		DeferredReleaseQueue();
+
+		// Releases whatever is still queued without waiting: wait for the fences first.
+		~DeferredReleaseQueue();
+
+		DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+		DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+
+		// Takes over object, typically moved in, until fence reaches fenceValue. Null objects
+		// are ignored, so a staging heap that may not have been needed can go straight in.
+		// Without a fence, object is released right away.
+		void Enqueue(Microsoft::WRL::ComPtr<IUnknown> object, _In_ ID3D12Fence* fence, UINT64 fenceValue);
+
+		// Releases every object whose fence value has completed; returns how many went.
+		size_t Collect();
+
+		size_t GetPendingCount() const { return m_pending.size(); }
+
+		// Size of the buffers still queued, which covers every upload heap
+		UINT64 GetPendingBufferBytes() const { return m_pendingBufferBytes; }
+
+	private:
+		struct Entry
+		{
+			Microsoft::WRL::ComPtr<IUnknown>	object;
+			Microsoft::WRL::ComPtr<ID3D12Fence>	fence;
+			UINT64								fenceValue;
+			UINT64								bufferBytes;
+		};
+
+		std::deque<Entry>						m_pending;
+		UINT64									m_pendingBufferBytes;
+	};
+}
@@ -0,0 +1,240 @@
+//--------------------------------------------------------------------------------------
+// File: GeometryHeap.cpp
+//
+// Free space is a first-fit list of blocks kept sorted by offset, merged with its
+// neighbours on every Free. Static geometry is allocated once and rarely freed, so the
+// list stays short.
+//--------------------------------------------------------------------------------------
+
+#include "GeometryHeap.h"
+#include "d3dx12.h"
+
+#include <exception>
+#include <iterator>
+#include <string.h>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void ThrowIfFailed(HRESULT hr)
+	{
+		if (FAILED(hr))
+		{
+			throw std::exception();
+		}
+	}
+
+	inline UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+GeometryHeap::GeometryHeap(ID3D12Device* device, UINT64 size, ResourceStateManager* states, UploadRingBuffer* uploadRing) :
+	m_device(device),
+	m_states(states),
+	m_uploadRing(uploadRing),
+	m_size(size),
+	m_freeBytes(size)
+{
+	if (!m_states || !size)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	// Buffers are always created in COMMON
+	ThrowIfFailed(m_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&m_buffer)));
+	m_states->Register(m_buffer.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+	m_freeBlocks[0] = size;
+}
+
+GeometryHeap::~GeometryHeap()
+{
+	m_states->Unregister(m_buffer.Get());
+}
+
+HRESULT GeometryHeap::Upload(ID3D12GraphicsCommandList* cmdList, const GeometryUpload* uploads, size_t count,
+	GeometryAllocation* allocations, ComPtr<ID3D12Resource>& uploadHeap)
+{
+	if (!cmdList || !uploads || !allocations)
+		return E_POINTER;
+
+	// Lay the batch out as it will sit in the buffer; the block is aligned to the largest
+	// alignment, so every offset in it keeps its own
+	UINT64 batchSize = 0;
+	UINT64 batchAlignment = 4;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const UINT64 alignment = uploads[i].alignment ? uploads[i].alignment : 4;
+		if ((alignment & (alignment - 1)) || (uploads[i].size && !uploads[i].data))
+			return E_INVALIDARG;
+
+		const UINT64 offset = AlignUp(batchSize, alignment);
+		allocations[i].offset = offset;
+		allocations[i].size = uploads[i].size;
+		allocations[i].blockOffset = batchSize;
+		allocations[i].blockSize = offset + uploads[i].size - batchSize;
+
+		batchSize = offset + uploads[i].size;
+		if (alignment > batchAlignment)
+		{
+			batchAlignment = alignment;
+		}
+	}
+
+	if (!batchSize)
+		return S_OK;
+
+	UINT64 base;
+	if (!Allocate(batchSize, batchAlignment, base))
+		return E_OUTOFMEMORY;
+
+	// Buffer copies have no alignment requirement of their own
+	UploadAllocation staging;
+	HRESULT hr = AcquireUploadSpace(batchSize, uploadHeap, staging);
+	if (FAILED(hr))
+	{
+		Release(base, batchSize);
+		return hr;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		memcpy(staging.cpuAddress + allocations[i].offset, uploads[i].data, static_cast<size_t>(uploads[i].size));
+
+		allocations[i].offset += base;
+		allocations[i].blockOffset += base;
+		allocations[i].gpuAddress = m_buffer->GetGPUVirtualAddress() + allocations[i].offset;
+	}
+
+	if (uploadHeap)
+	{
+		uploadHeap->Unmap(0, nullptr);
+	}
+
+	m_states->Transition(m_buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	m_states->Flush(cmdList);
+	cmdList->CopyBufferRegion(m_buffer.Get(), base, staging.resource, staging.offset, batchSize);
+	m_states->BeginTransition(m_buffer.Get(), READ_STATE);
+
+	return S_OK;
+}
+
+void GeometryHeap::Free(const GeometryAllocation& allocation)
+{
+	if (allocation.blockSize)
+	{
+		Release(allocation.blockOffset, allocation.blockSize);
+	}
+}
+
+UINT64 GeometryHeap::GetLargestFreeBlock() const
+{
+	UINT64 largest = 0;
+	for (const auto& block : m_freeBlocks)
+	{
+		if (block.second > largest)
+		{
+			largest = block.second;
+		}
+	}
+
+	return largest;
+}
+
+
+//--------------------------------------------------------------------------------------
+bool GeometryHeap::Allocate(UINT64 size, UINT64 alignment, UINT64& offset)
+{
+	for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+	{
+		const UINT64 blockOffset = it->first;
+		const UINT64 blockSize = it->second;
+		const UINT64 aligned = AlignUp(blockOffset, alignment);
+		if (aligned + size > blockOffset + blockSize)
+			continue;
+
+		// Whatever alignment skips stays free in front
+		m_freeBlocks.erase(it);
+		if (aligned > blockOffset)
+		{
+			m_freeBlocks[blockOffset] = aligned - blockOffset;
+		}
+		if (aligned + size < blockOffset + blockSize)
+		{
+			m_freeBlocks[aligned + size] = blockOffset + blockSize - aligned - size;
+		}
+
+		m_freeBytes -= size;
+		offset = aligned;
+		return true;
+	}
+
+	return false;
+}
+
+void GeometryHeap::Release(UINT64 offset, UINT64 size)
+{
+	m_freeBytes += size;
+
+	auto next = m_freeBlocks.lower_bound(offset);
+	if (next != m_freeBlocks.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = m_freeBlocks.erase(next);
+	}
+
+	if (next != m_freeBlocks.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	m_freeBlocks[offset] = size;
+}
+
+HRESULT GeometryHeap::AcquireUploadSpace(UINT64 size, ComPtr<ID3D12Resource>& uploadHeap, UploadAllocation& allocation)
+{
+	uploadHeap = nullptr;
+	if (m_uploadRing && SUCCEEDED(m_uploadRing->Allocate(size, 4, allocation)))
+		return S_OK;
+
+	HRESULT hr = m_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(uploadHeap.ReleaseAndGetAddressOf()));
+	if (FAILED(hr))
+		return hr;
+
+	// Written only, never read back
+	void* cpuAddress = nullptr;
+	const D3D12_RANGE readRange = { 0, 0 };
+	hr = uploadHeap->Map(0, &readRange, &cpuAddress);
+	if (FAILED(hr))
+	{
+		uploadHeap = nullptr;
+		return hr;
+	}
+
+	allocation.resource = uploadHeap.Get();
+	allocation.offset = 0;
+	allocation.cpuAddress = static_cast<uint8_t*>(cpuAddress);
+	allocation.gpuAddress = uploadHeap->GetGPUVirtualAddress();
+	return S_OK;
+}
@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------------------
+// File: GeometryHeap.h
+//
+// Static vertex and index data in one large DEFAULT heap buffer, so draws read it from
+// video memory instead of across the bus. Meshes are sub-allocated from the buffer, and
+// each batch is staged contiguously and filled with a single CopyBufferRegion.
+//
+// Not thread-safe: use it from the thread that records the command lists.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <map>
+
+#include "ResourceStateManager.h"
+#include "UploadRingBuffer.h"
+
+namespace DirectX
+{
+	struct GeometryUpload
+	{
+		const void*					data;
+		UINT64						size;
+		UINT64						alignment;		// Power of two; 0 for 4
+	};
+
+	struct GeometryAllocation
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS	gpuAddress;		// For the vertex or index buffer view
+		UINT64						offset;			// Into the heap's buffer
+		UINT64						size;
+		UINT64						blockOffset;	// What Free gives back, alignment padding included
+		UINT64						blockSize;
+	};
+
+	class GeometryHeap
+	{
+	public:
+		// Both states a draw reads geometry in, so one buffer can hold vertices and indices
+		static const D3D12_RESOURCE_STATES READ_STATE =
+			static_cast<D3D12_RESOURCE_STATES>(D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
+		// The buffer is registered with states, which must outlive the heap, as must
+		// uploadRing when one is given. Throws if the buffer can't be created.
+		GeometryHeap(_In_ ID3D12Device* device, UINT64 size, _In_ ResourceStateManager* states,
+			_In_opt_ UploadRingBuffer* uploadRing = nullptr);
+		~GeometryHeap();
+
+		GeometryHeap(const GeometryHeap&) = delete;
+		GeometryHeap& operator=(const GeometryHeap&) = delete;
+
+		// Allocates the whole batch as one block, stages it through the upload ring, or a
+		// dedicated upload heap returned in uploadHeap when the ring has no room, and records
+		// one CopyBufferRegion. The buffer's transition back to READ_STATE is begun, not
+		// ended: ask the state manager for READ_STATE and flush before drawing. Keep
+		// uploadHeap alive until cmdList has executed. Returns E_OUTOFMEMORY when the heap
+		// has no block large enough, and leaves it unchanged on failure.
+		HRESULT Upload(_In_ ID3D12GraphicsCommandList* cmdList, _In_reads_(count) const GeometryUpload* uploads,
+			size_t count, _Out_writes_(count) GeometryAllocation* allocations,
+			Microsoft::WRL::ComPtr<ID3D12Resource>& uploadHeap);
+
+		// Returns an allocation's space once no submitted work reads it any more
+		void Free(const GeometryAllocation& allocation);
+
+		ID3D12Resource* GetResource() const { return m_buffer.Get(); }
+		UINT64 GetSize() const { return m_size; }
+		UINT64 GetUsedSize() const { return m_size - m_freeBytes; }
+		UINT64 GetLargestFreeBlock() const;
+
+	private:
+		bool Allocate(UINT64 size, UINT64 alignment, _Out_ UINT64& offset);
+		void Release(UINT64 offset, UINT64 size);
+		HRESULT AcquireUploadSpace(UINT64 size, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadHeap, UploadAllocation& allocation);
+
+		Microsoft::WRL::ComPtr<ID3D12Device>		m_device;
+		Microsoft::WRL::ComPtr<ID3D12Resource>		m_buffer;
+		ResourceStateManager*						m_states;
+		UploadRingBuffer*							m_uploadRing;
+		UINT64										m_size;
+
+		std::map<UINT64, UINT64>					m_freeBlocks;	// Offset to size, never adjacent
+		UINT64										m_freeBytes;
+	};
+}
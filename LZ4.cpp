@@ -0,0 +1,244 @@
+//--------------------------------------------------------------------------------------
+// File: LZ4.cpp
+//
+// A block is a run of sequences: a token (literal count in the high nibble, match length
+// minus 4 in the low one), the literals, a 16-bit little-endian offset and the match.
+// Counts of 15 continue in extra bytes that add up until one is below 255. The last
+// sequence has literals only, the last 5 bytes are always literals, and the last match
+// starts at least 12 bytes before the end.
+//--------------------------------------------------------------------------------------
+
+#include "LZ4.h"
+
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t LAST_LITERALS = 5;
+	const size_t MATCH_FIND_LIMIT = 12;
+	const size_t MAX_OFFSET = 65535;
+	const uint32_t HASH_LOG = 12;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	// Writes the bytes that continue a count of 15 or more
+	bool WriteCountExtension(uint8_t*& op, const uint8_t* oend, size_t count)
+	{
+		for (;;)
+		{
+			if (op >= oend)
+				return false;
+
+			if (count < 255)
+			{
+				*op++ = static_cast<uint8_t>(count);
+				return true;
+			}
+
+			*op++ = 255;
+			count -= 255;
+		}
+	}
+
+	bool ReadCountExtension(const uint8_t*& ip, const uint8_t* iend, size_t& count)
+	{
+		uint32_t b;
+		do
+		{
+			if (ip >= iend)
+				return false;
+
+			b = *ip++;
+			count += b;
+		} while (b == 255);
+
+		return true;
+	}
+
+	bool WriteSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+	{
+		if (op >= oend)
+			return false;
+
+		uint8_t* token = op++;
+		*token = static_cast<uint8_t>(((literalCount >= 15) ? 15 : literalCount) << 4);
+		if (literalCount >= 15 && !WriteCountExtension(op, oend, literalCount - 15))
+			return false;
+
+		if (literalCount > size_t(oend - op))
+			return false;
+
+		memcpy(op, literals, literalCount);
+		op += literalCount;
+
+		// A sequence without a match ends the block
+		if (!matchLength)
+			return true;
+
+		if (oend - op < 2)
+			return false;
+
+		*op++ = static_cast<uint8_t>(offset);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+
+		const size_t length = matchLength - MIN_MATCH;
+		*token |= static_cast<uint8_t>((length >= 15) ? 15 : length);
+		return length < 15 || WriteCountExtension(op, oend, length - 15);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+size_t DirectX::LZ4CompressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t DirectX::LZ4CompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dest, size_t destCapacity)
+{
+	if (!src || !dest)
+		return 0;
+
+	uint8_t* op = dest;
+	const uint8_t* const oend = dest + destCapacity;
+	size_t anchor = 0;
+
+	if (srcSize > MATCH_FIND_LIMIT)
+	{
+		uint32_t table[1 << HASH_LOG] = {};
+
+		const size_t matchLimit = srcSize - LAST_LITERALS;
+		const size_t searchLimit = srcSize - MATCH_FIND_LIMIT;
+
+		size_t ip = 1;
+		while (ip < searchLimit)
+		{
+			const uint32_t sequence = Read32(src + ip);
+			const uint32_t h = Hash(sequence);
+			size_t candidate = table[h];
+			table[h] = static_cast<uint32_t>(ip);
+
+			if (candidate >= ip || ip - candidate > MAX_OFFSET || Read32(src + candidate) != sequence)
+			{
+				// Step further the longer nothing matches, so incompressible data stays cheap
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			while (ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1])
+			{
+				--ip;
+				--candidate;
+			}
+
+			size_t length = MIN_MATCH;
+			while (ip + length < matchLimit && src[ip + length] == src[candidate + length])
+				++length;
+
+			if (!WriteSequence(op, oend, src + anchor, ip - anchor, ip - candidate, length))
+				return 0;
+
+			ip += length;
+			anchor = ip;
+
+			if (ip < searchLimit)
+				table[Hash(Read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+		}
+	}
+
+	if (!WriteSequence(op, oend, src + anchor, srcSize - anchor, 0, 0))
+		return 0;
+
+	return static_cast<size_t>(op - dest);
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::LZ4DecompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dest, size_t destSize)
+{
+	if (!src || !dest)
+		return false;
+
+	const uint8_t* ip = src;
+	const uint8_t* const iend = src + srcSize;
+	uint8_t* op = dest;
+	uint8_t* const oend = dest + destSize;
+
+	for (;;)
+	{
+		if (ip >= iend)
+			return false;
+
+		const uint32_t token = *ip++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadCountExtension(ip, iend, literalCount))
+			return false;
+
+		if (literalCount > size_t(iend - ip) || literalCount > size_t(oend - op))
+			return false;
+
+		memcpy(op, ip, literalCount);
+		ip += literalCount;
+		op += literalCount;
+
+		if (ip == iend)
+			return op == oend;
+
+		if (iend - ip < 2)
+			return false;
+
+		const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+		ip += 2;
+		if (!offset || offset > size_t(op - dest))
+			return false;
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadCountExtension(ip, iend, length))
+			return false;
+
+		length += MIN_MATCH;
+		if (length > size_t(oend - op))
+			return false;
+
+		const uint8_t* match = op - offset;
+		if (offset >= length)
+		{
+			memcpy(op, match, length);
+			op += length;
+		}
+		else if (offset >= 8)
+		{
+			// Overlapping, but each 8-byte step only reads bytes already written
+			uint8_t* const end = op + length;
+			while (end - op >= 8)
+			{
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			}
+			while (op < end)
+				*op++ = *match++;
+		}
+		else
+		{
+			// Short offsets repeat a pattern, e.g. offset 1 is a run of one byte
+			for (size_t i = 0; i < length; ++i)
+				op[i] = match[i];
+			op += length;
+		}
+	}
+}
@@ -0,0 +1,26 @@
+//--------------------------------------------------------------------------------------
+// File: LZ4.h
+//
+// Self-contained LZ4 block codec (the raw block format of lz4_Block_format.md, without
+// the frame wrapper), used for DDSZ chunks. Blocks it writes decode with any LZ4
+// implementation and the other way round.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DirectX
+{
+	// Worst-case compressed size of srcSize bytes
+	size_t LZ4CompressBound(size_t srcSize);
+
+	// Greedy single-pass compressor. Returns the compressed size, or 0 when the result
+	// would not fit in destCapacity bytes.
+	size_t LZ4CompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dest, size_t destCapacity);
+
+	// Decodes a block that must expand to exactly destSize bytes. Every read and write is
+	// bounds-checked, so corrupt input returns false instead of overrunning either buffer.
+	bool LZ4DecompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dest, size_t destSize);
+}
@@ -0,0 +1,374 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.cpp
+//
+// 2x2 box downsampling for 8-bit UNORM formats. Four-channel rows take an SSE2 or NEON
+// path; everything else, and the odd pixels at the end of a row, go through the scalar
+// loop. Every path rounds the same way, (a + b + c + d + 2) / 4.
+//
+// _SRGB formats average their color channels in linear space instead: each byte is
+// decoded through a 256-entry table and the average is encoded again through a small
+// piecewise-linear one, so no pow() is evaluated per pixel. Alpha is averaged as is.
+//--------------------------------------------------------------------------------------
+
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIPGEN_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define MIPGEN_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// Below this many destination bytes a level is filtered on the calling thread
+	const size_t PARALLEL_DOWNSAMPLE_THRESHOLD = 256 * 1024;
+	const uint32_t DOWNSAMPLE_BAND_ROWS = 32;
+
+	// Linear -> sRGB8 for floats in [2^-13, 1). The exponent and top three mantissa bits
+	// of the float pick an entry: (bias >> 9) in the high half and scale in the low half of
+	// a line fitted to that stretch of the curve, which the next eight mantissa bits index.
+	// The result is within 0.544 of the exact value, so it is almost always the correctly
+	// rounded one; everything below 2^-13 encodes to 0.
+	const uint32_t LINEAR_TO_SRGB_MIN_BITS = (127 - 13) << 23;
+	const uint32_t LINEAR_TO_SRGB_MAX_BITS = 0x3f7fffff;    // Largest float below 1
+
+	const uint32_t g_LinearToSRGB[104] =
+	{
+		0x0073000d, 0x007a000d, 0x0080000d, 0x0087000d, 0x008d000d, 0x0094000d, 0x009a000d, 0x00a1000d,
+		0x00a7001a, 0x00b4001a, 0x00c1001a, 0x00ce001a, 0x00da001a, 0x00e7001a, 0x00f4001a, 0x0101001a,
+		0x010e0033, 0x01280033, 0x01410033, 0x015b0033, 0x01750033, 0x018f0033, 0x01a80033, 0x01c20033,
+		0x01dc0067, 0x020f0067, 0x02430067, 0x02760067, 0x02aa0067, 0x02dd0067, 0x03110067, 0x03440067,
+		0x037800ce, 0x03df00ce, 0x044600ce, 0x04ad00ce, 0x051400ce, 0x057b00c5, 0x05dd00bc, 0x063b00b5,
+		0x06970158, 0x07420142, 0x07e30130, 0x087b0120, 0x090b0112, 0x09940106, 0x0a1700fc, 0x0a9500f2,
+		0x0b0f01cb, 0x0bf401ae, 0x0ccb0195, 0x0d950180, 0x0e56016e, 0x0f0d015e, 0x0fbc0150, 0x10630143,
+		0x11070264, 0x1238023e, 0x1357021d, 0x14660201, 0x156601e9, 0x165a01d3, 0x174401c0, 0x182401af,
+		0x18fe0331, 0x1a9602fe, 0x1c1502d2, 0x1d7e02ad, 0x1ed4028d, 0x201a0270, 0x21520256, 0x227d0240,
+		0x239f0443, 0x25c003fe, 0x27bf03c4, 0x29a10392, 0x2b6a0367, 0x2d1d0341, 0x2ebe031f, 0x304d0300,
+		0x31d105b0, 0x34a80555, 0x37520507, 0x39d504c5, 0x3c37048b, 0x3e7c0458, 0x40a8042a, 0x42bd0401,
+		0x44c20798, 0x488e071e, 0x4c1c06b6, 0x4f76065d, 0x52a50610, 0x55ac05cc, 0x5892058f, 0x5b590559,
+		0x5e0c0a23, 0x631c0980, 0x67db08f6, 0x6c55087f, 0x70940818, 0x74a007bd, 0x787d076c, 0x7c330723
+	};
+
+	struct SRGBToLinearTable
+	{
+		float values[256];
+
+		SRGBToLinearTable()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const float c = i / 255.0f;
+				values[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+	};
+
+	const float* GetSRGBToLinear()
+	{
+		static const SRGBToLinearTable s_table;
+		return s_table.values;
+	}
+
+	inline uint32_t LinearToSRGB(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		// Also catches NaN
+		if (!(bits > LINEAR_TO_SRGB_MIN_BITS && value > 0.0f))
+			bits = LINEAR_TO_SRGB_MIN_BITS;
+		else if (bits > LINEAR_TO_SRGB_MAX_BITS)
+			bits = LINEAR_TO_SRGB_MAX_BITS;
+
+		const uint32_t entry = g_LinearToSRGB[(bits - LINEAR_TO_SRGB_MIN_BITS) >> 20];
+		const uint32_t bias = (entry >> 16) << 9;
+		const uint32_t scale = entry & 0xffff;
+		return (bias + scale * ((bits >> 12) & 0xff)) >> 16;
+	}
+
+#if defined(MIPGEN_SSE2)
+	__m128i LinearToSRGB4(__m128 value)
+	{
+		// maxps returns its second operand for NaN
+		const __m128 clamped = _mm_min_ps(
+			_mm_max_ps(value, _mm_castsi128_ps(_mm_set1_epi32(LINEAR_TO_SRGB_MIN_BITS))),
+			_mm_castsi128_ps(_mm_set1_epi32(LINEAR_TO_SRGB_MAX_BITS)));
+		const __m128i bits = _mm_castps_si128(clamped);
+
+		// SSE2 has no gather
+		alignas(16) uint32_t index[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(index),
+			_mm_srli_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(LINEAR_TO_SRGB_MIN_BITS)), 20));
+		const __m128i entry = _mm_setr_epi32(
+			static_cast<int>(g_LinearToSRGB[index[0]]), static_cast<int>(g_LinearToSRGB[index[1]]),
+			static_cast<int>(g_LinearToSRGB[index[2]]), static_cast<int>(g_LinearToSRGB[index[3]]));
+
+		// One madd gives (bias >> 9) * 512 + scale * t; every half fits in a signed 16 bits
+		const __m128i t = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bits, 12), _mm_set1_epi32(0xff)),
+			_mm_set1_epi32(512 << 16));
+		return _mm_srli_epi32(_mm_madd_epi16(entry, t), 16);
+	}
+#elif defined(MIPGEN_NEON)
+	uint32x4_t LinearToSRGB4(float32x4_t value)
+	{
+		const float32x4_t minValue = vreinterpretq_f32_u32(vdupq_n_u32(LINEAR_TO_SRGB_MIN_BITS));
+		const float32x4_t maxValue = vreinterpretq_f32_u32(vdupq_n_u32(LINEAR_TO_SRGB_MAX_BITS));
+
+		// vmaxq_f32 propagates NaN, so select instead
+		const float32x4_t clamped = vminq_f32(vbslq_f32(vcgtq_f32(value, minValue), value, minValue), maxValue);
+		const uint32x4_t bits = vreinterpretq_u32_f32(clamped);
+
+		uint32_t index[4];
+		vst1q_u32(index, vshrq_n_u32(vsubq_u32(bits, vdupq_n_u32(LINEAR_TO_SRGB_MIN_BITS)), 20));
+		const uint32_t entries[4] =
+		{
+			g_LinearToSRGB[index[0]], g_LinearToSRGB[index[1]], g_LinearToSRGB[index[2]], g_LinearToSRGB[index[3]]
+		};
+		const uint32x4_t entry = vld1q_u32(entries);
+
+		const uint32x4_t bias = vshlq_n_u32(vshrq_n_u32(entry, 16), 9);
+		const uint32x4_t scale = vandq_u32(entry, vdupq_n_u32(0xffff));
+		const uint32x4_t t = vandq_u32(vshrq_n_u32(bits, 12), vdupq_n_u32(0xff));
+		return vshrq_n_u32(vmlaq_u32(bias, scale, t), 16);
+	}
+#endif
+
+	bool IsSRGB(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+			|| format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+			|| format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	}
+
+	size_t GetChannelCount(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8_TYPELESS:
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+			return 1;
+
+		case DXGI_FORMAT_R8G8_TYPELESS:
+		case DXGI_FORMAT_R8G8_UNORM:
+			return 2;
+
+		case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return 4;
+
+		default:
+			return 0;
+		}
+	}
+
+	// Filters pixels [first, last) of one destination row from two source rows
+	void DownsampleRowScalar(size_t channels, const uint8_t* row0, const uint8_t* row1,
+		uint32_t srcWidth, uint8_t* dest, uint32_t first, uint32_t last)
+	{
+		for (uint32_t x = first; x < last; ++x)
+		{
+			const size_t x0 = size_t(2 * x) * channels;
+			const size_t x1 = size_t(std::min(2 * x + 1, srcWidth - 1)) * channels;
+			for (size_t c = 0; c < channels; ++c)
+			{
+				dest[x * channels + c] = static_cast<uint8_t>(
+					(row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+		}
+	}
+
+	// Four-channel pixels whose source pair lies wholly inside the row; returns how many
+	// destination pixels it wrote
+	uint32_t DownsampleRow4(const uint8_t* row0, const uint8_t* row1, uint8_t* dest, uint32_t pairs)
+	{
+		uint32_t x = 0;
+#if defined(MIPGEN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(2);
+
+		// Two source pixels per 8 bytes -> one destination pixel
+		auto sum = [&](__m128i a, __m128i b)
+		{
+			const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+			const __m128i total = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+			return _mm_srli_epi16(_mm_add_epi16(total, round), 2);
+		};
+
+		for (; x + 4 <= pairs; x += 4)
+		{
+			const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+			const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+			const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_packus_epi16(sum(a0, b0), sum(a1, b1)));
+		}
+#elif defined(MIPGEN_NEON)
+		for (; x + 8 <= pairs; x += 8)
+		{
+			const uint8x16x4_t a = vld4q_u8(row0 + x * 8);
+			const uint8x16x4_t b = vld4q_u8(row1 + x * 8);
+
+			uint8x8x4_t out;
+			for (int c = 0; c < 4; ++c)
+			{
+				out.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c])), 2);
+			}
+			vst4_u8(dest + x * 4, out);
+		}
+#else
+		(void)row0;
+		(void)row1;
+		(void)dest;
+		(void)pairs;
+#endif
+		return x;
+	}
+
+	// Four-channel sRGB: color is averaged in linear space, one pixel per vector
+	void DownsampleRowSRGB(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth,
+		uint8_t* dest, uint32_t destWidth)
+	{
+		const float* toLinear = GetSRGBToLinear();
+
+		for (uint32_t x = 0; x < destWidth; ++x)
+		{
+			const uint8_t* p[4] =
+			{
+				row0 + size_t(2 * x) * 4,
+				row0 + size_t(std::min(2 * x + 1, srcWidth - 1)) * 4,
+				row1 + size_t(2 * x) * 4,
+				row1 + size_t(std::min(2 * x + 1, srcWidth - 1)) * 4
+			};
+
+			uint8_t* out = dest + size_t(x) * 4;
+#if defined(MIPGEN_SSE2)
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < 4; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_setr_ps(toLinear[p[k][0]], toLinear[p[k][1]], toLinear[p[k][2]], 0.0f));
+			}
+
+			const __m128i rgb = LinearToSRGB4(_mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+			const __m128i words = _mm_packs_epi32(rgb, rgb);
+			const __m128i bytes = _mm_packus_epi16(words, words);
+			const uint32_t packed = static_cast<uint32_t>(_mm_cvtsi128_si32(bytes));
+			memcpy(out, &packed, 3);
+#elif defined(MIPGEN_NEON)
+			float32x4_t sum = vdupq_n_f32(0.0f);
+			for (int k = 0; k < 4; ++k)
+			{
+				const float lanes[4] = { toLinear[p[k][0]], toLinear[p[k][1]], toLinear[p[k][2]], 0.0f };
+				sum = vaddq_f32(sum, vld1q_f32(lanes));
+			}
+
+			uint32_t rgb[4];
+			vst1q_u32(rgb, LinearToSRGB4(vmulq_n_f32(sum, 0.25f)));
+			for (int c = 0; c < 3; ++c)
+			{
+				out[c] = static_cast<uint8_t>(rgb[c]);
+			}
+#else
+			for (int c = 0; c < 3; ++c)
+			{
+				const float sum = toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]];
+				out[c] = static_cast<uint8_t>(LinearToSRGB(sum * 0.25f));
+			}
+#endif
+			out[3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) >> 2);
+		}
+	}
+
+	void DownsampleRows(size_t channels, bool srgb,
+		const uint8_t* src, size_t srcRowPitch, uint32_t width, uint32_t height,
+		uint8_t* dest, size_t destRowPitch, uint32_t destWidth,
+		uint32_t firstRow, uint32_t lastRow)
+	{
+		for (uint32_t y = firstRow; y < lastRow; ++y)
+		{
+			const uint8_t* row0 = src + srcRowPitch * (2 * y);
+			const uint8_t* row1 = src + srcRowPitch * std::min(2 * y + 1, height - 1);
+			uint8_t* out = dest + destRowPitch * y;
+
+			if (srgb)
+			{
+				DownsampleRowSRGB(row0, row1, width, out, destWidth);
+				continue;
+			}
+
+			const uint32_t done = (channels == 4) ? DownsampleRow4(row0, row1, out, width / 2) : 0;
+			DownsampleRowScalar(channels, row0, row1, width, out, done, destWidth);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsMipGenerationSupported(DXGI_FORMAT format)
+{
+	return GetChannelCount(format) != 0;
+}
+
+uint32_t DirectX::GetMipChainLength(uint32_t width, uint32_t height)
+{
+	uint32_t largest = std::max(width, height);
+	uint32_t count = 1;
+	while (largest > 1)
+	{
+		largest >>= 1;
+		++count;
+	}
+
+	return count;
+}
+
+
+//--------------------------------------------------------------------------------------
+void DirectX::DownsampleBox(DXGI_FORMAT format,
+	const uint8_t* src,
+	size_t srcRowPitch,
+	uint32_t width,
+	uint32_t height,
+	uint8_t* dest,
+	size_t destRowPitch,
+	ThreadPool* pool)
+{
+	const size_t channels = GetChannelCount(format);
+	if (!channels || !src || !dest || !width || !height)
+		return;
+
+	const bool srgb = IsSRGB(format);
+	const uint32_t destWidth = std::max(width >> 1, 1u);
+	const uint32_t destHeight = std::max(height >> 1, 1u);
+
+	if (!pool || size_t(destWidth) * channels * destHeight < PARALLEL_DOWNSAMPLE_THRESHOLD)
+	{
+		DownsampleRows(channels, srgb, src, srcRowPitch, width, height, dest, destRowPitch, destWidth, 0, destHeight);
+		return;
+	}
+
+	const size_t bands = (destHeight + DOWNSAMPLE_BAND_ROWS - 1) / DOWNSAMPLE_BAND_ROWS;
+	pool->ParallelFor(bands, [&](size_t band)
+	{
+		const uint32_t first = static_cast<uint32_t>(band) * DOWNSAMPLE_BAND_ROWS;
+		DownsampleRows(channels, srgb, src, srcRowPitch, width, height, dest, destRowPitch, destWidth,
+			first, std::min(first + DOWNSAMPLE_BAND_ROWS, destHeight));
+	});
+}
@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.h
+//
+// CPU mip generation for textures that ship without a mip chain. Each level is a 2x2
+// box filter of the one above it, spread over a ThreadPool in bands of rows when the
+// level is large enough for that to pay off. _SRGB formats are filtered in linear space.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DirectX
+{
+	class ThreadPool;
+
+	// 8-bit UNORM formats with one, two or four channels
+	bool IsMipGenerationSupported(DXGI_FORMAT format);
+
+	// Number of levels in a full chain down to 1x1
+	uint32_t GetMipChainLength(uint32_t width, uint32_t height);
+
+	// Writes the box-filtered half-size level of src (width x height) to dest, which is
+	// max(1, width / 2) x max(1, height / 2). An odd last row or column is dropped, and a
+	// dimension of 1 is filtered along the other axis only.
+	void DownsampleBox(DXGI_FORMAT format,
+	                   const uint8_t* src,
+	                   size_t srcRowPitch,
+	                   uint32_t width,
+	                   uint32_t height,
+	                   uint8_t* dest,
+	                   size_t destRowPitch,
+	                   ThreadPool* pool = nullptr);
+}
@@ -0,0 +1,332 @@
+//--------------------------------------------------------------------------------------
+// File: PlacedResourceAllocator.cpp
+//
+// Pools are created on first use. A block is added when no block in the pool has room,
+// and a block left empty is released on Collect, except the first of its pool, so a
+// pool that empties and fills again each frame doesn't create a heap each time.
+//--------------------------------------------------------------------------------------
+
+#include "PlacedResourceAllocator.h"
+
+#include <exception>
+#include <utility>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void ThrowIfFailed(HRESULT hr)
+	{
+		if (FAILED(hr))
+		{
+			throw std::exception();
+		}
+	}
+
+	const UINT HEAP_TYPE_COUNT = 4;		// DEFAULT, UPLOAD and READBACK; not CUSTOM
+}
+
+PlacedResourceAllocator::PlacedResourceAllocator(ID3D12Device* device, UINT64 blockSize) :
+	m_device(device),
+	m_blockSize((blockSize + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1)),
+	m_mixedHeaps(false),
+	m_pools(HEAP_TYPE_COUNT * POOL_CATEGORY_COUNT)
+{
+	if (!m_blockSize)
+	{
+		m_blockSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	m_mixedHeaps = options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+}
+
+PlacedResourceAllocator::~PlacedResourceAllocator()
+{
+	// Resources before the heaps they were placed in
+	m_pending.clear();
+	m_allocations.clear();
+	m_pools.clear();
+}
+
+HRESULT PlacedResourceAllocator::CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc,
+	D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue, ComPtr<ID3D12Resource>& resource)
+{
+	if (!UINT(heapType) || UINT(heapType) >= HEAP_TYPE_COUNT)
+		return E_INVALIDARG;
+
+	D3D12_RESOURCE_DESC placedDesc = desc;
+	const D3D12_RESOURCE_ALLOCATION_INFO info = GetAllocationInfo(placedDesc);
+	if (info.SizeInBytes == UINT64_MAX)
+		return E_INVALIDARG;
+
+	Allocation allocation = {};
+	allocation.heapType = heapType;
+	allocation.size = info.SizeInBytes;
+
+	// MSAA needs 4MB placement, and large resources would leave most of a block unused
+	if (info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT || info.SizeInBytes > m_blockSize / 2)
+	{
+		D3D12_HEAP_PROPERTIES heapProperties = {};
+		heapProperties.Type = heapType;
+
+		HRESULT hr = m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, initialState,
+			clearValue, IID_PPV_ARGS(allocation.resource.ReleaseAndGetAddressOf()));
+		if (FAILED(hr))
+			return hr;
+	}
+	else
+	{
+		Pool& pool = GetPool(heapType, desc);
+
+		Block* block = nullptr;
+		UINT64 offset = 0;
+		for (auto& candidate : pool.blocks)
+		{
+			allocation.range = candidate.ranges->Allocate(info.SizeInBytes, info.Alignment, offset);
+			if (allocation.range)
+			{
+				block = &candidate;
+				break;
+			}
+		}
+
+		if (!block)
+		{
+			HRESULT hr = AddBlock(pool);
+			if (FAILED(hr))
+				return hr;
+
+			block = &pool.blocks.back();
+			allocation.range = block->ranges->Allocate(info.SizeInBytes, info.Alignment, offset);
+			if (!allocation.range)
+				return E_OUTOFMEMORY;
+		}
+
+		allocation.pool = &pool;
+		allocation.ranges = block->ranges.get();
+
+		HRESULT hr = m_device->CreatePlacedResource(block->heap.Get(), offset, &placedDesc, initialState,
+			clearValue, IID_PPV_ARGS(allocation.resource.ReleaseAndGetAddressOf()));
+		if (FAILED(hr))
+		{
+			allocation.ranges->Free(allocation.range);
+			return hr;
+		}
+	}
+
+	resource = allocation.resource;
+	m_allocations[resource.Get()] = std::move(allocation);
+	return S_OK;
+}
+
+void PlacedResourceAllocator::Release(ID3D12Resource* resource, ID3D12Fence* fence, UINT64 fenceValue)
+{
+	auto it = m_allocations.find(resource);
+	if (it == m_allocations.end())
+		return;
+
+	if (!fence)
+	{
+		Free(it->second);
+	}
+	else
+	{
+		PendingRelease pending;
+		pending.fence = fence;
+		pending.fenceValue = fenceValue;
+		pending.allocation = std::move(it->second);
+		m_pending.push_back(std::move(pending));
+	}
+
+	m_allocations.erase(it);
+}
+
+void PlacedResourceAllocator::Collect()
+{
+	// Releases are queued in submission order per fence, but may come from several fences
+	for (auto it = m_pending.begin(); it != m_pending.end();)
+	{
+		if (it->fence->GetCompletedValue() < it->fenceValue)
+		{
+			++it;
+			continue;
+		}
+
+		Free(it->allocation);
+		it = m_pending.erase(it);
+	}
+
+	for (auto& pool : m_pools)
+	{
+		if (!pool)
+			continue;
+
+		for (size_t i = pool->blocks.size(); i-- > 1;)
+		{
+			if (pool->blocks[i].ranges->IsEmpty())
+			{
+				if (m_onHeapChanged)
+				{
+					m_onHeapChanged(pool->blocks[i].heap.Get(), false);
+				}
+				pool->blocks.erase(pool->blocks.begin() + i);
+			}
+		}
+	}
+}
+
+PlacedAllocatorStatistics PlacedResourceAllocator::GetStatistics(D3D12_HEAP_TYPE heapType) const
+{
+	PlacedAllocatorStatistics stats = {};
+
+	for (const auto& pool : m_pools)
+	{
+		if (!pool || pool->heapType != heapType)
+			continue;
+
+		for (const auto& block : pool->blocks)
+		{
+			const TLSFStatistics ranges = block.ranges->GetStatistics();
+			stats.blockBytes += ranges.size;
+			stats.usedBytes += ranges.usedBytes;
+			stats.freeBytes += ranges.size - ranges.usedBytes;
+			stats.allocations += ranges.allocations;
+			stats.freeRanges += ranges.freeBlocks;
+			if (ranges.largestFreeBlock > stats.largestFreeRange)
+			{
+				stats.largestFreeRange = ranges.largestFreeBlock;
+			}
+			++stats.blocks;
+		}
+	}
+
+	auto addCommitted = [&stats, heapType](const Allocation& allocation)
+	{
+		if (!allocation.pool && allocation.heapType == heapType)
+		{
+			stats.committedBytes += allocation.size;
+			++stats.committedResources;
+		}
+	};
+
+	for (const auto& allocation : m_allocations)
+	{
+		addCommitted(allocation.second);
+	}
+	for (const auto& pending : m_pending)
+	{
+		addCommitted(pending.allocation);
+	}
+
+	return stats;
+}
+
+void PlacedResourceAllocator::SetHeapCallback(PlacedHeapCallback onHeapChanged)
+{
+	m_onHeapChanged = std::move(onHeapChanged);
+	if (!m_onHeapChanged)
+		return;
+
+	for (const auto& pool : m_pools)
+	{
+		if (!pool)
+			continue;
+
+		for (const auto& block : pool->blocks)
+		{
+			m_onHeapChanged(block.heap.Get(), true);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+PlacedResourceAllocator::Pool& PlacedResourceAllocator::GetPool(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc)
+{
+	// Tier 1 keeps buffers, textures and render targets in heaps of their own
+	POOL_CATEGORY category = POOL_CATEGORY_ALL;
+	D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+	if (!m_mixedHeaps)
+	{
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			category = POOL_CATEGORY_BUFFERS;
+			heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		}
+		else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+		{
+			category = POOL_CATEGORY_RT_DS_TEXTURES;
+			heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		}
+		else
+		{
+			category = POOL_CATEGORY_TEXTURES;
+			heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		}
+	}
+
+	std::unique_ptr<Pool>& pool = m_pools[UINT(heapType) * POOL_CATEGORY_COUNT + category];
+	if (!pool)
+	{
+		pool.reset(new Pool());
+		pool->heapType = heapType;
+		pool->heapFlags = heapFlags;
+	}
+
+	return *pool;
+}
+
+// Textures that fit get 4KB placement; everything else keeps the default 64KB. desc's
+// Alignment is set to match.
+D3D12_RESOURCE_ALLOCATION_INFO PlacedResourceAllocator::GetAllocationInfo(D3D12_RESOURCE_DESC& desc) const
+{
+	if (desc.Alignment == 0 && desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && desc.SampleDesc.Count <= 1
+		&& !(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)))
+	{
+		desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		const D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+		if (info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+			return info;
+
+		desc.Alignment = 0;
+	}
+
+	return m_device->GetResourceAllocationInfo(0, 1, &desc);
+}
+
+HRESULT PlacedResourceAllocator::AddBlock(Pool& pool)
+{
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = m_blockSize;
+	heapDesc.Properties.Type = pool.heapType;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = pool.heapFlags;
+
+	Block block;
+	HRESULT hr = m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&block.heap));
+	if (FAILED(hr))
+		return hr;
+
+	block.ranges.reset(new TLSFAllocator(m_blockSize));
+	pool.blocks.push_back(std::move(block));
+
+	if (m_onHeapChanged)
+	{
+		m_onHeapChanged(pool.blocks.back().heap.Get(), true);
+	}
+	return S_OK;
+}
+
+void PlacedResourceAllocator::Free(Allocation& allocation)
+{
+	allocation.resource = nullptr;
+	if (allocation.ranges)
+	{
+		allocation.ranges->Free(allocation.range);
+		allocation.ranges = nullptr;
+	}
+}
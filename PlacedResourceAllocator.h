@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------------
+// File: PlacedResourceAllocator.h
+//
+// Creates placed resources in large ID3D12Heap blocks instead of giving each resource an
+// implicit heap of its own. Each heap type, and on resource heap tier 1 each resource
+// category, has a pool of blocks carved up by a TLSFAllocator. Textures small enough
+// for 4KB placement get it; MSAA resources and anything larger than half a block are
+// created committed.
+//
+// Not thread-safe: use it from the thread that submits to the queue.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "TLSFAllocator.h"
+
+namespace DirectX
+{
+	struct PlacedAllocatorStatistics
+	{
+		UINT64	blockBytes;				// Heaps created, used or not
+		UINT64	usedBytes;
+		UINT64	freeBytes;
+		UINT64	largestFreeRange;
+		UINT64	committedBytes;			// Resources that didn't go in a block
+		UINT	blocks;
+		UINT	allocations;
+		UINT	freeRanges;
+		UINT	committedResources;
+
+		// 0 when the free space is all one range, approaching 1 as it splinters
+		float GetFragmentation() const { return freeBytes ? 1.0f - float(largestFreeRange) / float(freeBytes) : 0.0f; }
+	};
+
+	// Called with each block's heap when it is created (true) and before it is released
+	// (false), e.g. to register the heaps with a ResidencyManager
+	typedef std::function<void(ID3D12Heap* heap, bool created)> PlacedHeapCallback;
+
+	class PlacedResourceAllocator
+	{
+	public:
+		// blockSize is rounded up to 64KB. Throws if the device can't report its options.
+		PlacedResourceAllocator(_In_ ID3D12Device* device, UINT64 blockSize = 64 * 1024 * 1024);
+
+		// Releases every block: wait for the GPU to finish with the resources first.
+		~PlacedResourceAllocator();
+
+		PlacedResourceAllocator(const PlacedResourceAllocator&) = delete;
+		PlacedResourceAllocator& operator=(const PlacedResourceAllocator&) = delete;
+
+		// As CreateCommittedResource. The allocator keeps a reference until the resource
+		// is released through it.
+		HRESULT CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc,
+			D3D12_RESOURCE_STATES initialState, _In_opt_ const D3D12_CLEAR_VALUE* clearValue,
+			Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
+		// Gives the resource's memory back once fence reaches fenceValue; without a fence,
+		// right away. Don't use the resource after this, as its memory may be placed again.
+		void Release(_In_ ID3D12Resource* resource, _In_opt_ ID3D12Fence* fence, UINT64 fenceValue);
+
+		// Frees the memory of every release whose fence has completed, and the blocks left
+		// empty beyond the first of each pool.
+		void Collect();
+
+		PlacedAllocatorStatistics GetStatistics(D3D12_HEAP_TYPE heapType) const;
+
+		// Reports the blocks already created, then every one created or released after,
+		// except those the destructor releases. Committed resources stay the caller's.
+		void SetHeapCallback(PlacedHeapCallback onHeapChanged);
+
+	private:
+		enum POOL_CATEGORY
+		{
+			POOL_CATEGORY_ALL = 0,				// Resource heap tier 2
+			POOL_CATEGORY_BUFFERS,
+			POOL_CATEGORY_TEXTURES,
+			POOL_CATEGORY_RT_DS_TEXTURES,
+			POOL_CATEGORY_COUNT
+		};
+
+		struct Block
+		{
+			Microsoft::WRL::ComPtr<ID3D12Heap>	heap;
+			std::unique_ptr<TLSFAllocator>		ranges;
+		};
+
+		struct Pool
+		{
+			D3D12_HEAP_TYPE						heapType;
+			D3D12_HEAP_FLAGS					heapFlags;
+			std::vector<Block>					blocks;
+		};
+
+		struct Allocation
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource>	resource;
+			D3D12_HEAP_TYPE						heapType;
+			Pool*								pool;		// Null if committed
+			TLSFAllocator*						ranges;
+			UINT32								range;
+			UINT64								size;
+		};
+
+		struct PendingRelease
+		{
+			Microsoft::WRL::ComPtr<ID3D12Fence>	fence;
+			UINT64								fenceValue;
+			Allocation							allocation;
+		};
+
+		Pool& GetPool(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc);
+		D3D12_RESOURCE_ALLOCATION_INFO GetAllocationInfo(D3D12_RESOURCE_DESC& desc) const;
+		HRESULT AddBlock(Pool& pool);
+		void Free(Allocation& allocation);
+
+		Microsoft::WRL::ComPtr<ID3D12Device>				m_device;
+		UINT64												m_blockSize;
+		bool												m_mixedHeaps;	// Resource heap tier 2
+
+		std::vector<std::unique_ptr<Pool>>					m_pools;
+		std::unordered_map<ID3D12Resource*, Allocation>	m_allocations;
+		std::deque<PendingRelease>							m_pending;
+		PlacedHeapCallback									m_onHeapChanged;
+	};
+}
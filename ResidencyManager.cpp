@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// File: ResidencyManager.cpp
+//
+// Applies ResidencyPolicy decisions to a D3D12 device. Evictions and restores are issued
+// as one Evict and one MakeResident call per Update. Both calls are counted by the
+// runtime, and the policy only ever pairs them, so the counts never run ahead.
+//--------------------------------------------------------------------------------------
+
+#include "ResidencyManager.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+ResidencyManager::ResidencyManager(ID3D12Device* device, IDXGIAdapter3* adapter, UINT64 budget, UINT frameLatency) :
+	m_device(device),
+	m_adapter(adapter),
+	m_budget(budget),
+	m_policy(frameLatency)
+{
+}
+
+UINT32 ResidencyManager::Register(ID3D12Pageable* pageable, const ResidencyObjectDesc& desc, ResidencyMipCallback onMipsChanged)
+{
+	if (!pageable)
+		return 0;
+
+	const UINT32 object = m_policy.Register(desc);
+	if (!object)
+		return 0;
+
+	// The policy reuses handles, so the entries line up with them
+	if (object > m_entries.size())
+	{
+		m_entries.resize(object);
+	}
+
+	m_entries[object - 1].pageable = pageable;
+	m_entries[object - 1].onMipsChanged = std::move(onMipsChanged);
+	m_entries[object - 1].maxDroppedMips = desc.mipSizes ? desc.maxDroppedMips : 0;
+	m_entries[object - 1].texture = (desc.mipSizes != nullptr);
+	return object;
+}
+
+// What each mip takes in a linear layout, over every array slice. The swizzled layout
+// differs a little, but the proportions are what demotion needs. Returns the size the
+// texture is accounted as.
+UINT64 ResidencyManager::GetTextureSize(const D3D12_RESOURCE_DESC& desc, std::vector<UINT64>& mipSizes) const
+{
+	const UINT mipCount = desc.MipLevels;
+	const UINT arraySize = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) ? 1 : desc.DepthOrArraySize;
+	const UINT subresourceCount = mipCount * arraySize;
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(subresourceCount);
+	std::vector<UINT> numRows(subresourceCount);
+	m_device->GetCopyableFootprints(&desc, 0, subresourceCount, 0, footprints.data(), numRows.data(), nullptr, nullptr);
+
+	mipSizes.assign(mipCount, 0);
+	UINT64 mipTotal = 0;
+	for (UINT i = 0; i < subresourceCount; ++i)
+	{
+		const UINT64 bytes = UINT64(footprints[i].Footprint.RowPitch) * numRows[i] * footprints[i].Footprint.Depth;
+		mipSizes[i % mipCount] += bytes;
+		mipTotal += bytes;
+	}
+
+	return std::max<UINT64>(m_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes, mipTotal);
+}
+
+UINT32 ResidencyManager::RegisterResource(ID3D12Resource* resource, RESIDENCY_PRIORITY priority)
+{
+	if (!resource)
+		return 0;
+
+	const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+
+	ResidencyObjectDesc objectDesc = {};
+	objectDesc.size = m_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+	objectDesc.priority = priority;
+	return Register(resource, objectDesc, nullptr);
+}
+
+UINT32 ResidencyManager::RegisterHeap(ID3D12Heap* heap, RESIDENCY_PRIORITY priority)
+{
+	if (!heap)
+		return 0;
+
+	ResidencyObjectDesc objectDesc = {};
+	objectDesc.size = heap->GetDesc().SizeInBytes;
+	objectDesc.priority = priority;
+	return Register(heap, objectDesc, nullptr);
+}
+
+UINT32 ResidencyManager::RegisterTexture(ID3D12Resource* texture, RESIDENCY_PRIORITY priority,
+	UINT maxDroppedMips, ResidencyMipCallback onMipsChanged)
+{
+	if (!texture)
+		return 0;
+
+	const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		return 0;
+
+	std::vector<UINT64> mipSizes;
+	ResidencyObjectDesc objectDesc = {};
+	objectDesc.size = GetTextureSize(desc, mipSizes);
+	objectDesc.priority = priority;
+	objectDesc.mipSizes = mipSizes.data();
+	objectDesc.mipCount = desc.MipLevels;
+	objectDesc.maxDroppedMips = maxDroppedMips;
+	return Register(texture, objectDesc, std::move(onMipsChanged));
+}
+
+bool ResidencyManager::Replace(UINT32 object, ID3D12Pageable* pageable, UINT topMip)
+{
+	if (!object || object > m_entries.size() || !pageable)
+		return false;
+
+	Entry& entry = m_entries[object - 1];
+
+	std::vector<UINT64> mipSizes;
+	ResidencyObjectDesc objectDesc = {};
+
+	ComPtr<ID3D12Resource> resource;
+	ComPtr<ID3D12Heap> heap;
+	if (SUCCEEDED(pageable->QueryInterface(IID_PPV_ARGS(&resource))))
+	{
+		const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		if (entry.texture && desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			objectDesc.size = GetTextureSize(desc, mipSizes);
+			objectDesc.mipSizes = mipSizes.data();
+			objectDesc.mipCount = desc.MipLevels;
+			objectDesc.maxDroppedMips = (entry.maxDroppedMips > topMip) ? entry.maxDroppedMips - topMip : 0;
+		}
+		else
+		{
+			objectDesc.size = m_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+		}
+	}
+	else if (SUCCEEDED(pageable->QueryInterface(IID_PPV_ARGS(&heap))))
+	{
+		objectDesc.size = heap->GetDesc().SizeInBytes;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (!m_policy.Replace(object, objectDesc, topMip, pageable != entry.pageable, m_actions))
+		return false;
+
+	// A new object starts out resident: evicting it keeps it in step with the policy
+	entry.pageable = pageable;
+	if (!m_actions.empty())
+	{
+		m_device->Evict(1, &pageable);
+	}
+	return true;
+}
+
+void ResidencyManager::Unregister(UINT32 object)
+{
+	if (object && object <= m_entries.size())
+	{
+		m_policy.Unregister(object);
+		m_entries[object - 1].pageable = nullptr;
+		m_entries[object - 1].onMipsChanged = nullptr;
+		m_entries[object - 1].maxDroppedMips = 0;
+		m_entries[object - 1].texture = false;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+UINT64 ResidencyManager::GetBudget() const
+{
+	if (m_budget)
+		return m_budget;
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+	if (!m_adapter || FAILED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+		return UINT64_MAX;
+
+	// The swap chain, descriptor heaps and anything else not registered come off the top
+	const UINT64 usage = m_policy.GetUsage();
+	const UINT64 other = (info.CurrentUsage > usage) ? info.CurrentUsage - usage : 0;
+	return (info.Budget > other) ? info.Budget - other : 0;
+}
+
+HRESULT ResidencyManager::Update()
+{
+	m_policy.Update(GetBudget(), m_actions);
+
+	m_makeResident.clear();
+	m_evict.clear();
+	for (const auto& action : m_actions)
+	{
+		Entry& entry = m_entries[action.object - 1];
+		switch (action.type)
+		{
+		case RESIDENCY_ACTION_MAKE_RESIDENT:
+			m_makeResident.push_back(entry.pageable);
+			break;
+
+		case RESIDENCY_ACTION_EVICT:
+			m_evict.push_back(entry.pageable);
+			break;
+
+		default:
+			if (entry.onMipsChanged)
+			{
+				entry.onMipsChanged(action.topMip);
+			}
+			break;
+		}
+	}
+
+	// Evicting first makes room for what has to come back
+	HRESULT hr = S_OK;
+	if (!m_evict.empty())
+	{
+		hr = m_device->Evict(static_cast<UINT>(m_evict.size()), m_evict.data());
+	}
+	if (!m_makeResident.empty())
+	{
+		const HRESULT residentResult = m_device->MakeResident(static_cast<UINT>(m_makeResident.size()), m_makeResident.data());
+		if (SUCCEEDED(hr))
+		{
+			hr = residentResult;
+		}
+	}
+
+	return hr;
+}
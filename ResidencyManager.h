@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------------
+// File: ResidencyManager.h
+//
+// Keeps the GPU objects an app registers within a video memory budget. A ResidencyPolicy
+// decides; this applies its decisions with ID3D12Device::Evict and MakeResident, and
+// hands mip demotions to the texture's owner, which can reload it smaller.
+//
+// Not thread-safe: use it from the thread that submits the frame.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include <wrl.h>
+
+#include <functional>
+#include <vector>
+
+#include "ResidencyPolicy.h"
+
+namespace DirectX
+{
+	// Called with the new most detailed mip when a texture is demoted or promoted. The
+	// owner swaps in a copy without the mips above it and passes it to Replace.
+	typedef std::function<void(UINT topMip)> ResidencyMipCallback;
+
+	class ResidencyManager
+	{
+	public:
+		// With a budget of 0 the manager follows the adapter's local segment budget, less
+		// what the process uses outside the registered objects; without an adapter either,
+		// nothing is evicted. frameLatency is as for ResidencyPolicy.
+		ResidencyManager(_In_ ID3D12Device* device, _In_opt_ IDXGIAdapter3* adapter = nullptr,
+			UINT64 budget = 0, UINT frameLatency = 0);
+
+		ResidencyManager(const ResidencyManager&) = delete;
+		ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+		// The manager doesn't hold a reference: unregister an object before releasing it.
+		// Each returns 0 on failure.
+		UINT32 RegisterResource(_In_ ID3D12Resource* resource, RESIDENCY_PRIORITY priority = RESIDENCY_PRIORITY_NORMAL);
+		UINT32 RegisterHeap(_In_ ID3D12Heap* heap, RESIDENCY_PRIORITY priority = RESIDENCY_PRIORITY_NORMAL);
+
+		// A texture that may lose up to maxDroppedMips top mips under pressure. Its size is
+		// still accounted as its full mip chain less the mips dropped.
+		UINT32 RegisterTexture(_In_ ID3D12Resource* texture, RESIDENCY_PRIORITY priority,
+			UINT maxDroppedMips, ResidencyMipCallback onMipsChanged);
+
+		// Points a registered object at the copy that replaced it, and sizes it from the
+		// copy's desc. A texture's copy starts at topMip of the chain it was registered
+		// with, and may lose mips down to the same last one. pageable may be the one the
+		// object already stands for, e.g. a texture a cache served again. false if the copy
+		// can't stand in for the object, which then keeps its old sizes and pageable.
+		bool Replace(UINT32 object, _In_ ID3D12Pageable* pageable, UINT topMip = 0);
+		void Unregister(UINT32 object);
+
+		void SetPriority(UINT32 object, RESIDENCY_PRIORITY priority) { m_policy.SetPriority(object, priority); }
+
+		// Call for every object the frame being recorded references
+		void Use(UINT32 object) { m_policy.MarkUsed(object); }
+
+		// Call once per frame, after recording and before ExecuteCommandLists: objects used
+		// this frame are made resident, and the budget is enforced.
+		HRESULT Update();
+
+		void SetBudget(UINT64 budget) { m_budget = budget; }
+		UINT64 GetBudget() const;
+
+		ResidencyStatistics GetStatistics() const { return m_policy.GetStatistics(); }
+
+	private:
+		struct Entry
+		{
+			ID3D12Pageable*			pageable;
+			ResidencyMipCallback	onMipsChanged;
+			UINT					maxDroppedMips;	// Textures: as registered, from mip 0
+			bool					texture;
+		};
+
+		UINT32 Register(_In_ ID3D12Pageable* pageable, const ResidencyObjectDesc& desc, ResidencyMipCallback onMipsChanged);
+		UINT64 GetTextureSize(const D3D12_RESOURCE_DESC& desc, std::vector<UINT64>& mipSizes) const;
+
+		Microsoft::WRL::ComPtr<ID3D12Device>		m_device;
+		Microsoft::WRL::ComPtr<IDXGIAdapter3>		m_adapter;
+		UINT64										m_budget;
+		ResidencyPolicy								m_policy;
+
+		std::vector<Entry>							m_entries;		// Indexed by handle - 1
+		std::vector<ResidencyAction>				m_actions;
+		std::vector<ID3D12Pageable*>				m_makeResident;
+		std::vector<ID3D12Pageable*>				m_evict;
+	};
+}
@@ -0,0 +1,414 @@
+//--------------------------------------------------------------------------------------
+// File: ResidencyPolicy.cpp
+//
+// Usage is kept as a running total, adjusted on every registration, eviction, restore
+// and mip change, so an Update that has nothing to do costs one pass over the objects
+// used this frame.
+//--------------------------------------------------------------------------------------
+
+#include "ResidencyPolicy.h"
+
+#include <algorithm>
+#include <queue>
+
+using namespace DirectX;
+
+namespace
+{
+	// Promotion leaves 1/16 of the budget free, so a small change in usage doesn't demote
+	// the same mips again
+	const uint32_t PROMOTION_MARGIN_SHIFT = 4;
+}
+
+
+//--------------------------------------------------------------------------------------
+ResidencyPolicy::ResidencyPolicy(uint32_t frameLatency) :
+	m_frameLatency(frameLatency),
+	m_frame(1),
+	m_usage(0),
+	m_budget(0),
+	m_evictions(0),
+	m_restores(0),
+	m_demotions(0),
+	m_promotions(0)
+{
+}
+
+uint32_t ResidencyPolicy::Register(const ResidencyObjectDesc& desc)
+{
+	if (desc.priority > RESIDENCY_PRIORITY_PINNED || (desc.mipSizes && !desc.mipCount))
+		return 0;
+
+	Object object = {};
+	object.size = desc.size;
+	object.lastUsed = m_frame;
+	object.priority = desc.priority;
+	object.registered = true;
+	object.resident = true;
+
+	if (desc.mipSizes)
+	{
+		uint64_t total = 0;
+		for (uint32_t mip = 0; mip < desc.mipCount; ++mip)
+		{
+			total += desc.mipSizes[mip];
+		}
+		if (total > desc.size)
+			return 0;
+
+		// The least detailed mip always stays
+		object.mipSizes.assign(desc.mipSizes, desc.mipSizes + desc.mipCount);
+		object.maxDroppedMips = std::min(desc.maxDroppedMips, desc.mipCount - 1);
+	}
+
+	uint32_t index;
+	if (!m_freeObjects.empty())
+	{
+		index = m_freeObjects.back();
+		m_freeObjects.pop_back();
+		m_objects[index] = std::move(object);
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_objects.size());
+		m_objects.push_back(std::move(object));
+	}
+
+	m_usage += desc.size;
+	return index + 1;
+}
+
+void ResidencyPolicy::Unregister(uint32_t object)
+{
+	Object* entry = FindObject(object);
+	if (!entry)
+		return;
+
+	if (entry->resident)
+	{
+		m_usage -= GetResidentSize(*entry);
+	}
+
+	entry->registered = false;
+	entry->mipSizes.clear();
+	m_freeObjects.push_back(object - 1);
+}
+
+bool ResidencyPolicy::Replace(uint32_t object, const ResidencyObjectDesc& desc, uint32_t topMip, bool newCopy,
+	std::vector<ResidencyAction>& actions)
+{
+	actions.clear();
+
+	Object* entry = FindObject(object);
+	if (!entry || (desc.mipSizes && !desc.mipCount))
+		return false;
+
+	// Mips above the copy's need sizes from the object's chain, which a copy can't add to
+	if (topMip && (!desc.mipSizes || topMip > entry->mipSizes.size()))
+		return false;
+
+	uint64_t total = 0;
+	for (uint32_t mip = 0; mip < desc.mipCount && desc.mipSizes; ++mip)
+	{
+		total += desc.mipSizes[mip];
+	}
+	if (total > desc.size)
+		return false;
+
+	uint64_t droppedBytes = 0;
+	for (uint32_t mip = 0; mip < topMip; ++mip)
+	{
+		droppedBytes += entry->mipSizes[mip];
+	}
+
+	if (entry->resident)
+	{
+		m_usage -= GetResidentSize(*entry);
+		m_usage += desc.size;
+	}
+
+	if (desc.mipSizes)
+	{
+		entry->mipSizes.resize(topMip);
+		entry->mipSizes.insert(entry->mipSizes.end(), desc.mipSizes, desc.mipSizes + desc.mipCount);
+		entry->maxDroppedMips = topMip + std::min(desc.maxDroppedMips, desc.mipCount - 1);
+	}
+	else
+	{
+		entry->mipSizes.clear();
+		entry->maxDroppedMips = 0;
+	}
+
+	entry->size = droppedBytes + desc.size;
+	entry->droppedBytes = droppedBytes;
+	entry->topMip = topMip;
+
+	// Residency calls are counted: the object it already stood for is evicted as it is
+	if (newCopy && !entry->resident)
+	{
+		const ResidencyAction action = { object, RESIDENCY_ACTION_EVICT, 0 };
+		actions.push_back(action);
+	}
+	return true;
+}
+
+void ResidencyPolicy::SetPriority(uint32_t object, RESIDENCY_PRIORITY priority)
+{
+	Object* entry = FindObject(object);
+	if (entry && priority <= RESIDENCY_PRIORITY_PINNED)
+	{
+		entry->priority = priority;
+	}
+}
+
+void ResidencyPolicy::MarkUsed(uint32_t object)
+{
+	Object* entry = FindObject(object);
+	if (entry)
+	{
+		entry->lastUsed = m_frame;
+	}
+}
+
+ResidencyPolicy::Object* ResidencyPolicy::FindObject(uint32_t object)
+{
+	if (!object || object > m_objects.size() || !m_objects[object - 1].registered)
+		return nullptr;
+
+	return &m_objects[object - 1];
+}
+
+const ResidencyPolicy::Object* ResidencyPolicy::FindObject(uint32_t object) const
+{
+	if (!object || object > m_objects.size() || !m_objects[object - 1].registered)
+		return nullptr;
+
+	return &m_objects[object - 1];
+}
+
+
+//--------------------------------------------------------------------------------------
+void ResidencyPolicy::Update(uint64_t budget, std::vector<ResidencyAction>& actions)
+{
+	actions.clear();
+	m_budget = budget;
+
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+	{
+		Object& object = m_objects[i];
+		if (!object.registered || object.resident || object.lastUsed != m_frame)
+			continue;
+
+		object.resident = true;
+		m_usage += GetResidentSize(object);
+		++m_restores;
+
+		const ResidencyAction action = { i + 1, RESIDENCY_ACTION_MAKE_RESIDENT, object.topMip };
+		actions.push_back(action);
+	}
+
+	if (m_usage > budget)
+	{
+		Evict(budget, actions);
+		Demote(budget, actions);
+	}
+	else
+	{
+		Promote(budget, actions);
+	}
+
+	++m_frame;
+}
+
+void ResidencyPolicy::Evict(uint64_t budget, std::vector<ResidencyAction>& actions)
+{
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+	{
+		const Object& object = m_objects[i];
+		if (object.registered && object.resident && object.priority != RESIDENCY_PRIORITY_PINNED &&
+			object.lastUsed + m_frameLatency < m_frame)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	// Lowest priority, then least recently used, then largest
+	std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+	{
+		const Object& objectA = m_objects[a];
+		const Object& objectB = m_objects[b];
+		if (objectA.priority != objectB.priority)
+			return objectA.priority < objectB.priority;
+		if (objectA.lastUsed != objectB.lastUsed)
+			return objectA.lastUsed < objectB.lastUsed;
+		return GetResidentSize(objectA) > GetResidentSize(objectB);
+	});
+
+	for (uint32_t index : candidates)
+	{
+		if (m_usage <= budget)
+			break;
+
+		Object& object = m_objects[index];
+		object.resident = false;
+		m_usage -= GetResidentSize(object);
+		++m_evictions;
+
+		const ResidencyAction action = { index + 1, RESIDENCY_ACTION_EVICT, object.topMip };
+		actions.push_back(action);
+	}
+}
+
+void ResidencyPolicy::Demote(uint64_t budget, std::vector<ResidencyAction>& actions)
+{
+	if (m_usage <= budget)
+		return;
+
+	// Top of the queue: lowest priority, then the largest mip to drop, then least recently used.
+	// Only the object just demoted changes, so it is pushed back with its new key.
+	auto demoteFirst = [this](uint32_t a, uint32_t b)
+	{
+		const Object& objectA = m_objects[a];
+		const Object& objectB = m_objects[b];
+		if (objectA.priority != objectB.priority)
+			return objectA.priority > objectB.priority;
+		if (objectA.mipSizes[objectA.topMip] != objectB.mipSizes[objectB.topMip])
+			return objectA.mipSizes[objectA.topMip] < objectB.mipSizes[objectB.topMip];
+		return objectA.lastUsed > objectB.lastUsed;
+	};
+	std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(demoteFirst)> queue(demoteFirst);
+
+	std::vector<uint32_t> firstTopMips(m_objects.size(), UINT32_MAX);
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+	{
+		const Object& object = m_objects[i];
+		if (object.registered && object.resident && object.priority != RESIDENCY_PRIORITY_PINNED &&
+			object.topMip < object.maxDroppedMips)
+		{
+			queue.push(i);
+		}
+	}
+
+	std::vector<uint32_t> demoted;
+	while (m_usage > budget && !queue.empty())
+	{
+		const uint32_t index = queue.top();
+		queue.pop();
+
+		Object& object = m_objects[index];
+		if (firstTopMips[index] == UINT32_MAX)
+		{
+			firstTopMips[index] = object.topMip;
+			demoted.push_back(index);
+		}
+
+		const uint64_t mipSize = object.mipSizes[object.topMip++];
+		object.droppedBytes += mipSize;
+		m_usage -= mipSize;
+
+		if (object.topMip < object.maxDroppedMips)
+		{
+			queue.push(index);
+		}
+	}
+
+	for (uint32_t index : demoted)
+	{
+		++m_demotions;
+
+		const ResidencyAction action = { index + 1, RESIDENCY_ACTION_DEMOTE, m_objects[index].topMip };
+		actions.push_back(action);
+	}
+}
+
+void ResidencyPolicy::Promote(uint64_t budget, std::vector<ResidencyAction>& actions)
+{
+	const uint64_t limit = budget - (budget >> PROMOTION_MARGIN_SHIFT);
+	if (m_usage >= limit)
+		return;
+
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+	{
+		const Object& object = m_objects[i];
+		if (object.registered && object.resident && object.topMip)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	// Highest priority, then most recently used
+	std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+	{
+		const Object& objectA = m_objects[a];
+		const Object& objectB = m_objects[b];
+		if (objectA.priority != objectB.priority)
+			return objectA.priority > objectB.priority;
+		return objectA.lastUsed > objectB.lastUsed;
+	});
+
+	for (uint32_t index : candidates)
+	{
+		Object& object = m_objects[index];
+		const uint32_t topMip = object.topMip;
+		while (object.topMip && m_usage + object.mipSizes[object.topMip - 1] <= limit)
+		{
+			const uint64_t mipSize = object.mipSizes[--object.topMip];
+			object.droppedBytes -= mipSize;
+			m_usage += mipSize;
+		}
+
+		if (object.topMip != topMip)
+		{
+			++m_promotions;
+
+			const ResidencyAction action = { index + 1, RESIDENCY_ACTION_PROMOTE, object.topMip };
+			actions.push_back(action);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool ResidencyPolicy::IsResident(uint32_t object) const
+{
+	const Object* entry = FindObject(object);
+	return entry && entry->resident;
+}
+
+uint32_t ResidencyPolicy::GetTopMip(uint32_t object) const
+{
+	const Object* entry = FindObject(object);
+	return entry ? entry->topMip : 0;
+}
+
+ResidencyStatistics ResidencyPolicy::GetStatistics() const
+{
+	ResidencyStatistics stats = {};
+	stats.budget = m_budget;
+	stats.usage = m_usage;
+	stats.evictions = m_evictions;
+	stats.restores = m_restores;
+	stats.demotions = m_demotions;
+	stats.promotions = m_promotions;
+
+	for (const auto& object : m_objects)
+	{
+		if (!object.registered)
+			continue;
+
+		++stats.objects;
+		if (!object.resident)
+		{
+			++stats.evicted;
+			stats.evictedBytes += GetResidentSize(object);
+		}
+		if (object.topMip)
+		{
+			++stats.demoted;
+		}
+	}
+
+	return stats;
+}
@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------------------
+// File: ResidencyPolicy.h
+//
+// Device-independent residency bookkeeping: the size, priority and last use of every
+// registered GPU object, and the decisions that keep their total within a memory budget.
+// Update returns the evictions, restores and mip demotions for the caller to carry out;
+// ResidencyManager applies them to a D3D12 device. Like DDSLayout, this needs no device
+// or windows.h.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DirectX
+{
+	enum RESIDENCY_PRIORITY : uint8_t
+	{
+		RESIDENCY_PRIORITY_LOW      = 0,
+		RESIDENCY_PRIORITY_NORMAL,
+		RESIDENCY_PRIORITY_HIGH,
+		RESIDENCY_PRIORITY_PINNED,              // Never evicted or demoted
+	};
+
+	enum RESIDENCY_ACTION_TYPE
+	{
+		RESIDENCY_ACTION_MAKE_RESIDENT = 0,     // Evicted, but used this frame
+		RESIDENCY_ACTION_EVICT,
+		RESIDENCY_ACTION_DEMOTE,                // Drop the mips above topMip
+		RESIDENCY_ACTION_PROMOTE,               // Bring back the mips down to topMip
+	};
+
+	struct ResidencyAction
+	{
+		uint32_t                object;
+		RESIDENCY_ACTION_TYPE   type;
+		uint32_t                topMip;         // Most detailed mip kept; DEMOTE and PROMOTE only
+	};
+
+	struct ResidencyObjectDesc
+	{
+		uint64_t                size;           // With every mip
+		RESIDENCY_PRIORITY      priority;
+		const uint64_t*         mipSizes;       // Bytes each mip accounts for; null if it can't be demoted
+		uint32_t                mipCount;
+		uint32_t                maxDroppedMips; // How many of the top mips demotion may drop
+	};
+
+	struct ResidencyStatistics
+	{
+		uint64_t    budget;                     // As of the last Update
+		uint64_t    usage;                      // Resident objects, less their dropped mips
+		uint64_t    evictedBytes;
+		uint32_t    objects;
+		uint32_t    evicted;
+		uint32_t    demoted;                    // Resident or not, with at least one mip dropped
+		uint64_t    evictions;                  // Totals since creation
+		uint64_t    restores;
+		uint64_t    demotions;
+		uint64_t    promotions;
+	};
+
+	class ResidencyPolicy
+	{
+	public:
+		// frameLatency is how many frames the GPU may still be executing behind the one being
+		// recorded. An object used in any of them is not evicted.
+		explicit ResidencyPolicy(uint32_t frameLatency = 0);
+
+		// New objects count as resident and used this frame. 0 if desc is inconsistent.
+		uint32_t Register(const ResidencyObjectDesc& desc);
+		void Unregister(uint32_t object);
+
+		// The object now stands for a copy described by desc, whose mip 0 is the object's
+		// topMip: a texture reloaded without the mips a demotion dropped, or with them back.
+		// Its size, mip sizes and demotion limit follow the copy, counted from topMip; the
+		// mips above keep their sizes, so promotion can bring them back. Priority (desc's is
+		// ignored), last use and residency carry over. false, with nothing changed, if desc
+		// is inconsistent or topMip is past the object's mips.
+		//
+		// newCopy is set when the copy is a new GPU object, not the one the object already
+		// stood for. New objects start out resident, so for an evicted object actions is
+		// replaced with an EVICT of the copy; otherwise it is left empty.
+		bool Replace(uint32_t object, const ResidencyObjectDesc& desc, uint32_t topMip, bool newCopy,
+			std::vector<ResidencyAction>& actions);
+
+		void SetPriority(uint32_t object, RESIDENCY_PRIORITY priority);
+
+		// The object is referenced by the frame being recorded
+		void MarkUsed(uint32_t object);
+
+		// Ends the frame. Objects used this frame that were evicted are made resident first,
+		// whatever the budget. Over budget, resident objects the GPU is done with are evicted,
+		// lowest priority and least recently used first; if that isn't enough, demotable
+		// objects drop top mips, lowest priority and largest mip first, down to their limit.
+		// With budget to spare, demoted objects get their mips back, most recently used
+		// first, as long as usage stays a margin under budget so it doesn't flip back.
+		// Actions are ordered by type, with at most one DEMOTE or PROMOTE per object.
+		void Update(uint64_t budget, std::vector<ResidencyAction>& actions);
+
+		bool IsResident(uint32_t object) const;
+		uint32_t GetTopMip(uint32_t object) const;
+		uint64_t GetUsage() const { return m_usage; }
+		uint64_t GetFrame() const { return m_frame; }
+
+		ResidencyStatistics GetStatistics() const;
+
+	private:
+		struct Object
+		{
+			uint64_t                size;
+			uint64_t                droppedBytes;       // Of the mips above topMip
+			uint64_t                lastUsed;           // Frame
+			std::vector<uint64_t>   mipSizes;
+			uint32_t                topMip;
+			uint32_t                maxDroppedMips;
+			RESIDENCY_PRIORITY      priority;
+			bool                    registered;
+			bool                    resident;
+		};
+
+		Object* FindObject(uint32_t object);
+		const Object* FindObject(uint32_t object) const;
+		uint64_t GetResidentSize(const Object& object) const { return object.size - object.droppedBytes; }
+
+		void Evict(uint64_t budget, std::vector<ResidencyAction>& actions);
+		void Demote(uint64_t budget, std::vector<ResidencyAction>& actions);
+		void Promote(uint64_t budget, std::vector<ResidencyAction>& actions);
+
+		uint32_t                m_frameLatency;
+		std::vector<Object>     m_objects;          // Indexed by handle - 1
+		std::vector<uint32_t>   m_freeObjects;
+		uint64_t                m_frame;
+		uint64_t                m_usage;
+		uint64_t                m_budget;
+
+		uint64_t                m_evictions;
+		uint64_t                m_restores;
+		uint64_t                m_demotions;
+		uint64_t                m_promotions;
+	};
+}
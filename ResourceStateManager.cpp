@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceStateManager.cpp
+//
+// Maps resources to ResourceStateTracker handles and its transitions to D3D12 barriers.
+// Split halves become BEGIN_ONLY and END_ONLY transition barriers.
+//--------------------------------------------------------------------------------------
+
+#include "ResourceStateManager.h"
+
+using namespace DirectX;
+
+ResourceStateManager::ResourceStateManager(ID3D12Device* device) :
+	m_device(device)
+{
+}
+
+void ResourceStateManager::Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	if (!resource)
+		return;
+
+	Unregister(resource);
+
+	// Textures only promote to shader resource and copy states; the rest to any state
+	const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+	const RESOURCE_PROMOTION promotion = (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ||
+		(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS)) ? RESOURCE_PROMOTION_ANY : RESOURCE_PROMOTION_TEXTURE;
+
+	const UINT32 object = m_tracker.Register(GetSubresourceCount(desc), static_cast<uint32_t>(state), promotion);
+	if (!object)
+		return;
+
+	// The tracker reuses handles, so the resources line up with them
+	if (object > m_resources.size())
+	{
+		m_resources.resize(object);
+	}
+
+	m_resources[object - 1] = resource;
+	m_objects[resource] = object;
+}
+
+void ResourceStateManager::Unregister(ID3D12Resource* resource)
+{
+	auto it = m_objects.find(resource);
+	if (it == m_objects.end())
+		return;
+
+	m_tracker.Unregister(it->second);
+	m_resources[it->second - 1] = nullptr;
+	m_objects.erase(it);
+}
+
+void ResourceStateManager::Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresource)
+{
+	m_tracker.Transition(FindObject(resource), subresource, static_cast<uint32_t>(state));
+}
+
+void ResourceStateManager::BeginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresource)
+{
+	m_tracker.BeginTransition(FindObject(resource), subresource, static_cast<uint32_t>(state));
+}
+
+void ResourceStateManager::Flush(ID3D12GraphicsCommandList* cmdList)
+{
+	if (!m_tracker.HasPendingTransitions())
+		return;
+
+	m_tracker.Flush(m_transitions, cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY);
+
+	m_barriers.clear();
+	for (const auto& transition : m_transitions)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Flags = (transition.split == RESOURCE_TRANSITION_BEGIN) ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY
+			: (transition.split == RESOURCE_TRANSITION_END) ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY
+			: D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		barrier.Transition.pResource = m_resources[transition.object - 1];
+		barrier.Transition.Subresource = transition.subresource;
+		barrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(transition.before);
+		barrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(transition.after);
+		m_barriers.push_back(barrier);
+	}
+
+	if (!m_barriers.empty())
+	{
+		cmdList->ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+	}
+}
+
+void ResourceStateManager::FlushAll(ID3D12GraphicsCommandList* cmdList)
+{
+	m_tracker.EndSplitTransitions();
+	Flush(cmdList);
+}
+
+D3D12_RESOURCE_STATES ResourceStateManager::GetState(ID3D12Resource* resource, UINT subresource) const
+{
+	return static_cast<D3D12_RESOURCE_STATES>(m_tracker.GetState(FindObject(resource), subresource));
+}
+
+
+//--------------------------------------------------------------------------------------
+UINT32 ResourceStateManager::FindObject(ID3D12Resource* resource) const
+{
+	auto it = m_objects.find(resource);
+	return (it != m_objects.end()) ? it->second : 0;
+}
+
+UINT ResourceStateManager::GetSubresourceCount(const D3D12_RESOURCE_DESC& desc) const
+{
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		return 1;
+
+	const UINT arraySize = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) ? 1 : desc.DepthOrArraySize;
+
+	D3D12_FEATURE_DATA_FORMAT_INFO formatInfo = { desc.Format, 1 };
+	if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_FORMAT_INFO, &formatInfo, sizeof(formatInfo))))
+	{
+		formatInfo.PlaneCount = 1;
+	}
+
+	return UINT(desc.MipLevels) * arraySize * formatInfo.PlaneCount;
+}
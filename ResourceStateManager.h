@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceStateManager.h
+//
+// Keeps track of the state of registered D3D12 resources, subresource by subresource, so
+// callers ask for the state they need rather than writing out transitions. A
+// ResourceStateTracker decides which barriers that takes, leaving out those the implicit
+// promotion from COMMON makes unnecessary; this records each flush as a single
+// ResourceBarrier call.
+//
+// Not thread-safe: use it from the thread that records the command lists.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "ResourceStateTracker.h"
+
+namespace DirectX
+{
+	class ResourceStateManager
+	{
+	public:
+		// device is only used to count the planes of depth-stencil and planar formats
+		explicit ResourceStateManager(_In_ ID3D12Device* device);
+
+		ResourceStateManager(const ResourceStateManager&) = delete;
+		ResourceStateManager& operator=(const ResourceStateManager&) = delete;
+
+		// The manager doesn't hold a reference: unregister a resource before releasing it.
+		// Registering a resource again starts it over in state.
+		void Register(_In_ ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+		void Unregister(_In_ ID3D12Resource* resource);
+
+		// As for ResourceStateTracker. Unregistered resources are ignored.
+		void Transition(_In_ ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+			UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+		void BeginTransition(_In_ ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+			UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+		// Records every pending barrier on cmdList, in one ResourceBarrier call. Call before
+		// the commands that need the states asked for.
+		void Flush(_In_ ID3D12GraphicsCommandList* cmdList);
+
+		// Flush, with every split barrier still open ended: call before closing cmdList
+		void FlushAll(_In_ ID3D12GraphicsCommandList* cmdList);
+
+		// Call after each ExecuteCommandLists, on any queue, with the lists flushed since the
+		// last call: what the runtime decays to COMMON when they complete is tracked as such
+		void Decay() { m_tracker.Decay(); }
+
+		D3D12_RESOURCE_STATES GetState(_In_ ID3D12Resource* resource,
+			UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) const;
+
+		ResourceStateStatistics GetStatistics() const { return m_tracker.GetStatistics(); }
+
+	private:
+		UINT32 FindObject(_In_ ID3D12Resource* resource) const;
+		UINT GetSubresourceCount(const D3D12_RESOURCE_DESC& desc) const;
+
+		Microsoft::WRL::ComPtr<ID3D12Device>			m_device;
+		ResourceStateTracker							m_tracker;
+
+		std::unordered_map<ID3D12Resource*, UINT32>		m_objects;
+		std::vector<ID3D12Resource*>					m_resources;	// Indexed by handle - 1
+		std::vector<ResourceTransition>					m_transitions;
+		std::vector<D3D12_RESOURCE_BARRIER>				m_barriers;
+	};
+}
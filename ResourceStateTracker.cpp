@@ -0,0 +1,417 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceStateTracker.cpp
+//
+// Only objects touched since the last Flush are visited by it, so a frame that asks for
+// the states its resources are already in costs one comparison per request. Promotion
+// and decay follow the D3D12 implicit state transition rules.
+//--------------------------------------------------------------------------------------
+
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	// D3D12_RESOURCE_STATES values
+	const uint32_t STATE_COMMON = 0;
+	const uint32_t STATE_NON_PIXEL_SHADER_RESOURCE = 0x40;
+	const uint32_t STATE_PIXEL_SHADER_RESOURCE = 0x80;
+	const uint32_t STATE_COPY_DEST = 0x400;
+	const uint32_t STATE_COPY_SOURCE = 0x800;
+
+	// Vertex and constant buffer, index buffer, depth read, the shader resources, indirect
+	// argument, copy source and resolve source
+	const uint32_t READ_ONLY_STATES = 0x1 | 0x2 | 0x20 | 0x40 | 0x80 | 0x200 | 0x800 | 0x2000;
+
+	bool IsPromotable(RESOURCE_PROMOTION promotion, uint32_t state)
+	{
+		switch (promotion)
+		{
+		case RESOURCE_PROMOTION_TEXTURE:
+			return state == STATE_COPY_DEST || !(state & ~(STATE_NON_PIXEL_SHADER_RESOURCE | STATE_PIXEL_SHADER_RESOURCE | STATE_COPY_SOURCE));
+
+		case RESOURCE_PROMOTION_ANY:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+}
+
+ResourceStateTracker::ResourceStateTracker() :
+	m_statistics()
+{
+}
+
+uint32_t ResourceStateTracker::Register(uint32_t subresourceCount, uint32_t state, RESOURCE_PROMOTION promotion)
+{
+	if (!subresourceCount)
+		return 0;
+
+	uint32_t object;
+	if (!m_freeObjects.empty())
+	{
+		object = m_freeObjects.back();
+		m_freeObjects.pop_back();
+	}
+	else
+	{
+		m_objects.emplace_back();
+		object = static_cast<uint32_t>(m_objects.size());
+	}
+
+	Subresource subresource = {};
+	subresource.state = state;
+
+	Object& entry = m_objects[object - 1];
+	entry.subresources.assign(subresourceCount, subresource);
+	entry.openSplits = 0;
+	entry.promotion = promotion;
+	entry.registered = true;
+	entry.dirty = false;
+	entry.decaying = false;
+	return object;
+}
+
+void ResourceStateTracker::Unregister(uint32_t object)
+{
+	Object* entry = FindObject(object);
+	if (!entry)
+		return;
+
+	if (entry->dirty)
+	{
+		m_dirty.erase(std::find(m_dirty.begin(), m_dirty.end(), object));
+	}
+	if (entry->decaying)
+	{
+		m_decaying.erase(std::find(m_decaying.begin(), m_decaying.end(), object));
+	}
+
+	entry->subresources.clear();
+	entry->subresources.shrink_to_fit();
+	entry->openSplits = 0;
+	entry->registered = false;
+	entry->dirty = false;
+	entry->decaying = false;
+	m_freeObjects.push_back(object);
+}
+
+void ResourceStateTracker::Transition(uint32_t object, uint32_t subresource, uint32_t state)
+{
+	Request(object, subresource, state, false);
+}
+
+void ResourceStateTracker::BeginTransition(uint32_t object, uint32_t subresource, uint32_t state)
+{
+	Request(object, subresource, state, true);
+}
+
+void ResourceStateTracker::EndSplitTransitions()
+{
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+	{
+		Object& entry = m_objects[i];
+		if (!entry.registered || (!entry.openSplits && !entry.dirty))
+			continue;
+
+		bool changed = false;
+		for (auto& subresource : entry.subresources)
+		{
+			if (subresource.splitOpen && !subresource.endSplit)
+			{
+				subresource.endSplit = true;
+				changed = true;
+			}
+
+			// A split begun now couldn't be ended either
+			subresource.pendingSplit = false;
+		}
+
+		if (changed)
+		{
+			MarkDirty(i + 1, entry);
+		}
+	}
+}
+
+void ResourceStateTracker::Flush(std::vector<ResourceTransition>& transitions, bool copyQueue)
+{
+	transitions.clear();
+
+	for (uint32_t object : m_dirty)
+	{
+		Object& entry = m_objects[object - 1];
+		FlushObject(object, entry, copyQueue, transitions);
+		entry.dirty = false;
+	}
+	m_dirty.clear();
+
+	if (!transitions.empty())
+	{
+		++m_statistics.flushes;
+	}
+}
+
+void ResourceStateTracker::Decay()
+{
+	for (uint32_t object : m_decaying)
+	{
+		Object& entry = m_objects[object - 1];
+		for (auto& subresource : entry.subresources)
+		{
+			if (subresource.decays && !subresource.splitOpen)
+			{
+				subresource.state = STATE_COMMON;
+			}
+			subresource.decays = false;
+		}
+		entry.decaying = false;
+	}
+	m_decaying.clear();
+}
+
+uint32_t ResourceStateTracker::GetState(uint32_t object, uint32_t subresource) const
+{
+	const Object* entry = FindObject(object);
+	if (!entry)
+		return 0;
+
+	if (subresource == RESOURCE_ALL_SUBRESOURCES)
+	{
+		subresource = 0;
+	}
+	if (subresource >= entry->subresources.size())
+		return 0;
+
+	const Subresource& state = entry->subresources[subresource];
+	if (state.hasPending)
+		return state.pending;
+
+	return state.splitOpen ? state.splitTarget : state.state;
+}
+
+uint32_t ResourceStateTracker::GetSubresourceCount(uint32_t object) const
+{
+	const Object* entry = FindObject(object);
+	return entry ? static_cast<uint32_t>(entry->subresources.size()) : 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+ResourceStateTracker::Object* ResourceStateTracker::FindObject(uint32_t object)
+{
+	if (!object || object > m_objects.size() || !m_objects[object - 1].registered)
+		return nullptr;
+
+	return &m_objects[object - 1];
+}
+
+const ResourceStateTracker::Object* ResourceStateTracker::FindObject(uint32_t object) const
+{
+	if (!object || object > m_objects.size() || !m_objects[object - 1].registered)
+		return nullptr;
+
+	return &m_objects[object - 1];
+}
+
+void ResourceStateTracker::Request(uint32_t object, uint32_t subresource, uint32_t state, bool split)
+{
+	Object* entry = FindObject(object);
+	if (!entry)
+		return;
+
+	const uint32_t count = static_cast<uint32_t>(entry->subresources.size());
+	uint32_t first = subresource;
+	uint32_t last = subresource + 1;
+	if (subresource == RESOURCE_ALL_SUBRESOURCES)
+	{
+		first = 0;
+		last = count;
+	}
+	else if (subresource >= count)
+	{
+		return;
+	}
+
+	++m_statistics.requested;
+
+	bool changed = false;
+	for (uint32_t i = first; i < last; ++i)
+	{
+		if (RequestSubresource(entry->subresources[i], state, split))
+		{
+			changed = true;
+		}
+		else
+		{
+			++m_statistics.redundant;
+		}
+	}
+
+	if (changed)
+	{
+		MarkDirty(object, *entry);
+	}
+}
+
+bool ResourceStateTracker::RequestSubresource(Subresource& subresource, uint32_t state, bool split)
+{
+	bool changed = false;
+	uint32_t base = subresource.state;
+
+	if (subresource.splitOpen)
+	{
+		// Asking again for a split already begun leaves it open
+		if (split && !subresource.endSplit && !subresource.hasPending && state == subresource.splitTarget)
+			return false;
+
+		// A begun split can only be ended, so anything else comes after its END
+		changed = !subresource.endSplit;
+		subresource.endSplit = true;
+		base = subresource.splitTarget;
+	}
+
+	// Back to where the flush leaves it: whatever was pending is dropped
+	if (state == base)
+	{
+		changed = changed || subresource.hasPending;
+		subresource.hasPending = false;
+		return changed;
+	}
+
+	// Already pending: a full request means there is no gap left to split over
+	if (subresource.hasPending && subresource.pending == state)
+	{
+		const bool pendingSplit = subresource.pendingSplit && split;
+		changed = changed || pendingSplit != subresource.pendingSplit;
+		subresource.pendingSplit = pendingSplit;
+		return changed;
+	}
+
+	subresource.hasPending = true;
+	subresource.pending = state;
+	subresource.pendingSplit = split;
+	return true;
+}
+
+void ResourceStateTracker::MarkDirty(uint32_t object, Object& entry)
+{
+	if (!entry.dirty)
+	{
+		entry.dirty = true;
+		m_dirty.push_back(object);
+	}
+}
+
+void ResourceStateTracker::FlushObject(uint32_t object, Object& entry, bool copyQueue, std::vector<ResourceTransition>& transitions)
+{
+	const uint32_t count = static_cast<uint32_t>(entry.subresources.size());
+
+	// Every subresource going the same way goes as one barrier for the whole resource
+	auto append = [&]()
+	{
+		bool uniform = (m_scratch.size() == count);
+		for (size_t i = 1; uniform && i < m_scratch.size(); ++i)
+		{
+			uniform = m_scratch[i].before == m_scratch[0].before && m_scratch[i].after == m_scratch[0].after
+				&& m_scratch[i].split == m_scratch[0].split;
+		}
+
+		if (uniform)
+		{
+			m_scratch.resize(1);
+			m_scratch[0].subresource = RESOURCE_ALL_SUBRESOURCES;
+		}
+
+		for (const auto& transition : m_scratch)
+		{
+			transitions.push_back(transition);
+			++m_statistics.barriers;
+			if (transition.split == RESOURCE_TRANSITION_BEGIN)
+			{
+				++m_statistics.splitBarriers;
+			}
+		}
+		m_scratch.clear();
+	};
+
+	m_scratch.clear();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Subresource& subresource = entry.subresources[i];
+		if (!subresource.endSplit)
+			continue;
+
+		const ResourceTransition transition = { object, i, subresource.state, subresource.splitTarget, RESOURCE_TRANSITION_END };
+		m_scratch.push_back(transition);
+
+		subresource.state = subresource.splitTarget;
+		subresource.splitOpen = false;
+		subresource.endSplit = false;
+		subresource.decays = copyQueue || entry.promotion == RESOURCE_PROMOTION_ANY;
+		--entry.openSplits;
+	}
+	append();
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Subresource& subresource = entry.subresources[i];
+		if (!subresource.hasPending)
+			continue;
+
+		// A Decay since the request may have left it where it was going
+		if (subresource.pending == subresource.state && !subresource.splitOpen)
+		{
+			subresource.hasPending = false;
+			subresource.pendingSplit = false;
+			continue;
+		}
+
+		// The first access in a promotable state moves it there, split or not. Promotions to
+		// a read-only state decay; on a texture, any other state is kept until changed.
+		if (subresource.state == STATE_COMMON && !subresource.splitOpen && IsPromotable(entry.promotion, subresource.pending))
+		{
+			subresource.state = subresource.pending;
+			subresource.decays = copyQueue || entry.promotion == RESOURCE_PROMOTION_ANY || (subresource.pending & READ_ONLY_STATES) == subresource.pending;
+			subresource.hasPending = false;
+			subresource.pendingSplit = false;
+			++m_statistics.promotions;
+			continue;
+		}
+
+		const ResourceTransition transition = { object, i, subresource.state, subresource.pending,
+			subresource.pendingSplit ? RESOURCE_TRANSITION_BEGIN : RESOURCE_TRANSITION_FULL };
+		m_scratch.push_back(transition);
+
+		subresource.decays = copyQueue || entry.promotion == RESOURCE_PROMOTION_ANY;
+		if (subresource.pendingSplit)
+		{
+			subresource.splitOpen = true;
+			subresource.splitTarget = subresource.pending;
+			++entry.openSplits;
+		}
+		else
+		{
+			subresource.state = subresource.pending;
+		}
+		subresource.hasPending = false;
+		subresource.pendingSplit = false;
+	}
+	append();
+
+	bool decays = false;
+	for (uint32_t i = 0; i < count && !decays; ++i)
+	{
+		decays = entry.subresources[i].decays;
+	}
+
+	if (decays && !entry.decaying)
+	{
+		entry.decaying = true;
+		m_decaying.push_back(object);
+	}
+}
@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceStateTracker.h
+//
+// Device-independent resource state bookkeeping: the state every subresource of every
+// registered resource is in, the transitions asked for since the last flush, and the
+// split barriers left open. Flush turns them into the smallest list of barriers, with
+// redundant transitions dropped and whole-resource transitions merged into one, and no
+// barrier at all where a resource is implicitly promoted out of COMMON; Decay puts back
+// in COMMON what the runtime decays after ExecuteCommandLists.
+// ResourceStateManager records them on a D3D12 command list. Like ResidencyPolicy, this
+// needs no device or windows.h, and states are plain D3D12_RESOURCE_STATES bits.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DirectX
+{
+	// Same value as D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
+	const uint32_t RESOURCE_ALL_SUBRESOURCES = 0xffffffff;
+
+	enum RESOURCE_TRANSITION_SPLIT : uint8_t
+	{
+		RESOURCE_TRANSITION_FULL    = 0,
+		RESOURCE_TRANSITION_BEGIN,              // D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY
+		RESOURCE_TRANSITION_END,                // D3D12_RESOURCE_BARRIER_FLAG_END_ONLY
+	};
+
+	// Which states a resource can be implicitly promoted to from COMMON, and so what decays
+	// back to COMMON when a command list finishes executing
+	enum RESOURCE_PROMOTION : uint8_t
+	{
+		RESOURCE_PROMOTION_NONE     = 0,        // Every change of state takes a barrier
+		RESOURCE_PROMOTION_TEXTURE,             // Shader resource and copy states; read-only ones decay
+		RESOURCE_PROMOTION_ANY,                 // Buffers and simultaneous-access textures; always decay
+	};
+
+	struct ResourceTransition
+	{
+		uint32_t                    object;
+		uint32_t                    subresource;    // Or RESOURCE_ALL_SUBRESOURCES
+		uint32_t                    before;
+		uint32_t                    after;
+		RESOURCE_TRANSITION_SPLIT   split;
+	};
+
+	struct ResourceStateStatistics
+	{
+		uint64_t    requested;                  // Transition and BeginTransition calls
+		uint64_t    redundant;                  // Subresources asked for the state they were in
+		uint64_t    barriers;                   // Transitions flushed, split halves included
+		uint64_t    splitBarriers;              // BEGIN halves flushed
+		uint64_t    promotions;                 // Subresources that left COMMON without a barrier
+		uint64_t    flushes;                    // Flushes that had anything to record
+	};
+
+	class ResourceStateTracker
+	{
+	public:
+		ResourceStateTracker();
+
+		// A resource with subresourceCount subresources, all in state. 0 if subresourceCount is 0.
+		uint32_t Register(uint32_t subresourceCount, uint32_t state,
+			RESOURCE_PROMOTION promotion = RESOURCE_PROMOTION_NONE);
+
+		// Forgets the object, along with its pending transitions and any split left open
+		void Unregister(uint32_t object);
+
+		// The subresource has to be in state by the next Flush. Asking for the state it is
+		// already in, or will be in after the transitions pending, records nothing; asking
+		// again before the flush replaces the pending transition rather than adding one.
+		void Transition(uint32_t object, uint32_t subresource, uint32_t state);
+
+		// The subresource has to be in state only after some later work: the next Flush
+		// begins a split barrier, and the Flush after the next Transition of the subresource
+		// ends it. If that Transition comes before the next Flush there is no gap, and a
+		// single full barrier goes out instead.
+		void BeginTransition(uint32_t object, uint32_t subresource, uint32_t state);
+
+		// Has the next Flush end every split barrier still open. Split barriers can't outlive
+		// the command list, so do this before closing it.
+		void EndSplitTransitions();
+
+		// Replaces transitions with every barrier pending, ends before begins for the same
+		// subresource, in the order the objects were first touched since the last Flush.
+		// Promotions from COMMON are applied without one. Everything a copy queue's command
+		// list transitions decays, whatever the resource.
+		void Flush(std::vector<ResourceTransition>& transitions, bool copyQueue = false);
+
+		// The command lists flushed since the last call have been executed: what the runtime
+		// decays at the end of them goes back to COMMON. Call after every ExecuteCommandLists,
+		// before recording further; a split still open is left alone.
+		void Decay();
+
+		// The state last asked for, which barriers yet to be flushed or ended may still be
+		// reaching. For RESOURCE_ALL_SUBRESOURCES, that of subresource 0.
+		uint32_t GetState(uint32_t object, uint32_t subresource) const;
+		uint32_t GetSubresourceCount(uint32_t object) const;
+
+		bool HasPendingTransitions() const { return !m_dirty.empty(); }
+		ResourceStateStatistics GetStatistics() const { return m_statistics; }
+
+	private:
+		struct Subresource
+		{
+			uint32_t    state;              // As of the last Flush; the before state of an open split
+			uint32_t    pending;            // Asked for since; valid if hasPending
+			uint32_t    splitTarget;        // Valid if splitOpen
+			bool        hasPending;
+			bool        pendingSplit;       // pending is to begin a split
+			bool        splitOpen;          // BEGIN flushed, END not yet
+			bool        endSplit;           // END goes out at the next Flush
+			bool        decays;             // Back to COMMON at the next Decay
+		};
+
+		struct Object
+		{
+			std::vector<Subresource>    subresources;
+			uint32_t                    openSplits;
+			RESOURCE_PROMOTION          promotion;
+			bool                        registered;
+			bool                        dirty;      // In m_dirty
+			bool                        decaying;   // In m_decaying
+		};
+
+		Object* FindObject(uint32_t object);
+		const Object* FindObject(uint32_t object) const;
+
+		void Request(uint32_t object, uint32_t subresource, uint32_t state, bool split);
+		bool RequestSubresource(Subresource& subresource, uint32_t state, bool split);
+		void MarkDirty(uint32_t object, Object& entry);
+		void FlushObject(uint32_t object, Object& entry, bool copyQueue, std::vector<ResourceTransition>& transitions);
+
+		std::vector<Object>                 m_objects;      // Indexed by handle - 1
+		std::vector<uint32_t>               m_freeObjects;
+		std::vector<uint32_t>               m_dirty;        // Objects with anything to flush
+		std::vector<uint32_t>               m_decaying;     // Objects with a subresource to decay
+		std::vector<ResourceTransition>     m_scratch;      // One object's transitions while merging
+		ResourceStateStatistics             m_statistics;
+	};
+}
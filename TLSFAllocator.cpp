@@ -0,0 +1,351 @@
+//--------------------------------------------------------------------------------------
+// File: TLSFAllocator.cpp
+//
+// Sizes below SL_COUNT each get a list of their own; above that, the first level is the
+// highest set bit and the second level the next SL_LOG2 bits. Allocate rounds the size
+// up to the next list boundary, so any block in the list it finds fits without walking
+// the list. When the block found can't take the alignment, the search is repeated for
+// size + alignment - 1, and the front padding goes back as a free block.
+//--------------------------------------------------------------------------------------
+
+#include "TLSFAllocator.h"
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// value must not be 0
+	inline uint32_t FindLastSet(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+		_BitScanReverse64(&index, value);
+#else
+		if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+			return index + 32;
+		_BitScanReverse(&index, static_cast<unsigned long>(value));
+#endif
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	inline uint32_t FindFirstSet(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+		_BitScanForward64(&index, value);
+#else
+		if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+			return index;
+		_BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+		index += 32;
+#endif
+		return index;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+}
+
+TLSFAllocator::TLSFAllocator(uint64_t size) :
+	m_size(size),
+	m_flBitmap(0),
+	m_usedBytes(0),
+	m_allocations(0),
+	m_freeBlocks(0)
+{
+	memset(m_slBitmap, 0, sizeof(m_slBitmap));
+	memset(m_heads, 0xff, sizeof(m_heads));
+
+	if (size)
+	{
+		InsertFree(NewBlock(0, size));
+	}
+}
+
+uint32_t TLSFAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+	if (!size || !alignment || (alignment & (alignment - 1)) || size > m_size)
+		return 0;
+
+	// Blocks are usually aligned already, so the first block large enough is tried as is;
+	// failing that, one with room for any padding is searched for
+	uint32_t block = FindFree(size);
+	if (block != NONE)
+	{
+		const uint64_t blockOffset = m_blocks[block].offset;
+		const uint64_t aligned = (blockOffset + alignment - 1) & ~(alignment - 1);
+		if (aligned < blockOffset || aligned - blockOffset > m_blocks[block].size - size)
+		{
+			block = NONE;
+		}
+	}
+
+	if (block == NONE)
+	{
+		const uint64_t searchSize = size + alignment - 1;
+		if (searchSize < size)
+			return 0;
+
+		block = FindFree(searchSize);
+		if (block == NONE)
+			return 0;
+	}
+
+	RemoveFree(block);
+
+	uint32_t allocation = block;
+	const uint64_t blockOffset = m_blocks[block].offset;
+	const uint64_t padding = ((blockOffset + alignment - 1) & ~(alignment - 1)) - blockOffset;
+	if (padding)
+	{
+		// The padding stays behind as a free block of its own
+		allocation = SplitFront(block, padding);
+		InsertFree(block);
+	}
+
+	if (m_blocks[allocation].size > size)
+	{
+		InsertFree(SplitFront(allocation, size));
+	}
+
+	m_blocks[allocation].free = false;
+	m_usedBytes += size;
+	++m_allocations;
+
+	offset = m_blocks[allocation].offset;
+	return allocation + 1;
+}
+
+void TLSFAllocator::Free(uint32_t allocation)
+{
+	if (!allocation || allocation > m_blocks.size())
+		return;
+
+	uint32_t block = allocation - 1;
+	if (!m_blocks[block].used || m_blocks[block].free)
+		return;
+
+	m_usedBytes -= m_blocks[block].size;
+	--m_allocations;
+
+	// Merge with the free neighbours on either side
+	const uint32_t next = m_blocks[block].nextPhysical;
+	if (next != NONE && m_blocks[next].free)
+	{
+		RemoveFree(next);
+		m_blocks[block].size += m_blocks[next].size;
+		m_blocks[block].nextPhysical = m_blocks[next].nextPhysical;
+		if (m_blocks[block].nextPhysical != NONE)
+		{
+			m_blocks[m_blocks[block].nextPhysical].prevPhysical = block;
+		}
+		DeleteBlock(next);
+	}
+
+	const uint32_t prev = m_blocks[block].prevPhysical;
+	if (prev != NONE && m_blocks[prev].free)
+	{
+		RemoveFree(prev);
+		m_blocks[prev].size += m_blocks[block].size;
+		m_blocks[prev].nextPhysical = m_blocks[block].nextPhysical;
+		if (m_blocks[prev].nextPhysical != NONE)
+		{
+			m_blocks[m_blocks[prev].nextPhysical].prevPhysical = prev;
+		}
+		DeleteBlock(block);
+		block = prev;
+	}
+
+	InsertFree(block);
+}
+
+uint64_t TLSFAllocator::GetOffset(uint32_t allocation) const
+{
+	if (!allocation || allocation > m_blocks.size() || !m_blocks[allocation - 1].used)
+		return 0;
+
+	return m_blocks[allocation - 1].offset;
+}
+
+TLSFStatistics TLSFAllocator::GetStatistics() const
+{
+	TLSFStatistics stats = {};
+	stats.size = m_size;
+	stats.usedBytes = m_usedBytes;
+	stats.allocations = m_allocations;
+	stats.freeBlocks = m_freeBlocks;
+
+	// Every block in the highest list is larger than any below it
+	if (m_flBitmap)
+	{
+		const uint32_t fl = FindLastSet(m_flBitmap);
+		const uint32_t sl = FindLastSet(m_slBitmap[fl]);
+		for (uint32_t block = m_heads[fl][sl]; block != NONE; block = m_blocks[block].nextFree)
+		{
+			if (m_blocks[block].size > stats.largestFreeBlock)
+			{
+				stats.largestFreeBlock = m_blocks[block].size;
+			}
+		}
+	}
+
+	return stats;
+}
+
+
+//--------------------------------------------------------------------------------------
+void TLSFAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+	if (size < SL_COUNT)
+	{
+		fl = 0;
+		sl = static_cast<uint32_t>(size);
+		return;
+	}
+
+	const uint32_t msb = FindLastSet(size);
+	sl = static_cast<uint32_t>(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+	fl = msb - SL_LOG2 + 1;
+}
+
+uint32_t TLSFAllocator::NewBlock(uint64_t offset, uint64_t size)
+{
+	uint32_t block;
+	if (!m_freeSlots.empty())
+	{
+		block = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		block = static_cast<uint32_t>(m_blocks.size());
+		m_blocks.emplace_back();
+	}
+
+	Block& entry = m_blocks[block];
+	entry.offset = offset;
+	entry.size = size;
+	entry.prevPhysical = NONE;
+	entry.nextPhysical = NONE;
+	entry.prevFree = NONE;
+	entry.nextFree = NONE;
+	entry.free = false;
+	entry.used = true;
+	return block;
+}
+
+void TLSFAllocator::DeleteBlock(uint32_t block)
+{
+	m_blocks[block].used = false;
+	m_freeSlots.push_back(block);
+}
+
+void TLSFAllocator::InsertFree(uint32_t block)
+{
+	uint32_t fl, sl;
+	Mapping(m_blocks[block].size, fl, sl);
+
+	Block& entry = m_blocks[block];
+	entry.free = true;
+	entry.prevFree = NONE;
+	entry.nextFree = m_heads[fl][sl];
+	if (entry.nextFree != NONE)
+	{
+		m_blocks[entry.nextFree].prevFree = block;
+	}
+
+	m_heads[fl][sl] = block;
+	m_slBitmap[fl] |= 1u << sl;
+	m_flBitmap |= uint64_t(1) << fl;
+	++m_freeBlocks;
+}
+
+void TLSFAllocator::RemoveFree(uint32_t block)
+{
+	uint32_t fl, sl;
+	Mapping(m_blocks[block].size, fl, sl);
+
+	Block& entry = m_blocks[block];
+	if (entry.prevFree != NONE)
+	{
+		m_blocks[entry.prevFree].nextFree = entry.nextFree;
+	}
+	else
+	{
+		m_heads[fl][sl] = entry.nextFree;
+	}
+	if (entry.nextFree != NONE)
+	{
+		m_blocks[entry.nextFree].prevFree = entry.prevFree;
+	}
+
+	if (m_heads[fl][sl] == NONE)
+	{
+		m_slBitmap[fl] &= ~(1u << sl);
+		if (!m_slBitmap[fl])
+		{
+			m_flBitmap &= ~(uint64_t(1) << fl);
+		}
+	}
+
+	entry.free = false;
+	entry.prevFree = NONE;
+	entry.nextFree = NONE;
+	--m_freeBlocks;
+}
+
+uint32_t TLSFAllocator::FindFree(uint64_t size) const
+{
+	// Round up to the next list, so whatever is in it is large enough
+	if (size >= SL_COUNT)
+	{
+		const uint64_t rounded = size + (uint64_t(1) << (FindLastSet(size) - SL_LOG2)) - 1;
+		if (rounded < size)
+			return NONE;
+		size = rounded;
+	}
+
+	uint32_t fl, sl;
+	Mapping(size, fl, sl);
+
+	uint32_t slMap = m_slBitmap[fl] & (~0u << sl);
+	if (!slMap)
+	{
+		const uint64_t flMap = (fl + 1 < 64) ? m_flBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+		if (!flMap)
+			return NONE;
+
+		fl = FindFirstSet(flMap);
+		slMap = m_slBitmap[fl];
+	}
+
+	return m_heads[fl][FindFirstSet(slMap)];
+}
+
+// Cuts the first size bytes off block, which keeps them, and returns the rest as a new
+// block that is neither free nor listed
+uint32_t TLSFAllocator::SplitFront(uint32_t block, uint64_t size)
+{
+	const uint32_t rest = NewBlock(m_blocks[block].offset + size, m_blocks[block].size - size);
+	m_blocks[block].size = size;
+
+	m_blocks[rest].prevPhysical = block;
+	m_blocks[rest].nextPhysical = m_blocks[block].nextPhysical;
+	if (m_blocks[rest].nextPhysical != NONE)
+	{
+		m_blocks[m_blocks[rest].nextPhysical].prevPhysical = rest;
+	}
+	m_blocks[block].nextPhysical = rest;
+	return rest;
+}
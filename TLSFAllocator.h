@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// File: TLSFAllocator.h
+//
+// Two-level segregated fit allocator over a range of offsets, such as one ID3D12Heap.
+// Free blocks are binned by size class, with a bitmap per level, so Allocate and Free
+// take constant time whatever the number of blocks, and neighbouring free blocks are
+// merged as soon as they are freed. Like DDSLayout, this needs no device or windows.h;
+// PlacedResourceAllocator runs one per heap.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DirectX
+{
+	struct TLSFStatistics
+	{
+		uint64_t    size;
+		uint64_t    usedBytes;                  // Alignment padding counts as free
+		uint64_t    largestFreeBlock;
+		uint32_t    allocations;
+		uint32_t    freeBlocks;
+	};
+
+	class TLSFAllocator
+	{
+	public:
+		explicit TLSFAllocator(uint64_t size);
+
+		TLSFAllocator(const TLSFAllocator&) = delete;
+		TLSFAllocator& operator=(const TLSFAllocator&) = delete;
+
+		// alignment is a power of two. Returns 0 when size is 0 or no free block fits;
+		// otherwise a handle for Free, with offset set to the start of the allocation.
+		uint32_t Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+		void Free(uint32_t allocation);
+
+		uint64_t GetOffset(uint32_t allocation) const;
+		uint64_t GetSize() const { return m_size; }
+		bool IsEmpty() const { return m_allocations == 0; }
+
+		TLSFStatistics GetStatistics() const;
+
+	private:
+		static const uint32_t SL_LOG2 = 5;
+		static const uint32_t SL_COUNT = 1u << SL_LOG2;
+		static const uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+		static const uint32_t NONE = 0xffffffff;
+
+		struct Block
+		{
+			uint64_t    offset;
+			uint64_t    size;
+			uint32_t    prevPhysical;
+			uint32_t    nextPhysical;
+			uint32_t    prevFree;           // Free blocks only
+			uint32_t    nextFree;
+			bool        free;
+			bool        used;               // The slot holds a block
+		};
+
+		static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+		uint32_t NewBlock(uint64_t offset, uint64_t size);
+		void DeleteBlock(uint32_t block);
+		void InsertFree(uint32_t block);
+		void RemoveFree(uint32_t block);
+		uint32_t FindFree(uint64_t size) const;
+		uint32_t SplitFront(uint32_t block, uint64_t size);
+
+		uint64_t                m_size;
+		std::vector<Block>      m_blocks;       // Handles are index + 1
+		std::vector<uint32_t>   m_freeSlots;
+		uint64_t                m_flBitmap;
+		uint32_t                m_slBitmap[FL_COUNT];
+		uint32_t                m_heads[FL_COUNT][SL_COUNT];
+		uint64_t                m_usedBytes;
+		uint32_t                m_allocations;
+		uint32_t                m_freeBlocks;
+	};
+}
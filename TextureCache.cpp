@@ -0,0 +1,382 @@
+//--------------------------------------------------------------------------------------
+// File: TextureCache.cpp
+//
+// Shares DDS textures loaded through an AsyncTextureLoader. Requests for the same file,
+// maxsize and flags get the same load, keyed by the full path and checked against the
+// file's size and last-write time; with content hashing, identical files at different
+// paths share one load too. Handles are reference counted, and a texture without handles
+// is kept for reuse until the unreferenced budget pushes it out.
+//--------------------------------------------------------------------------------------
+
+#include "TextureCache.h"
+
+#include <wctype.h>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Flags that change the texture a file loads as; the rest only change how it is read
+	const DDS_LOADER_FLAGS CACHE_KEY_FLAGS = DDS_LOADER_FORCE_SRGB | DDS_LOADER_COMPRESS_BC | DDS_LOADER_COMPRESS_BC_QUALITY;
+
+	const DWORD HASH_READ_SIZE = 1024 * 1024;
+
+	UINT64 ToUInt64(DWORD high, DWORD low)
+	{
+		return (static_cast<UINT64>(high) << 32) | low;
+	}
+
+	bool GetFullPath(const wchar_t* fileName, std::wstring& fullPath)
+	{
+		DWORD length = GetFullPathNameW(fileName, 0, nullptr, nullptr);
+		if (!length)
+			return false;
+
+		fullPath.resize(length);
+		length = GetFullPathNameW(fileName, length, &fullPath[0], nullptr);
+		if (!length || length >= fullPath.size())
+			return false;
+
+		fullPath.resize(length);
+		return true;
+	}
+
+	bool GetFileVersion(const std::wstring& path, UINT64& fileSize, UINT64& lastWriteTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes))
+			return false;
+
+		fileSize = ToUInt64(attributes.nFileSizeHigh, attributes.nFileSizeLow);
+		lastWriteTime = ToUInt64(attributes.ftLastWriteTime.dwHighDateTime, attributes.ftLastWriteTime.dwLowDateTime);
+		return true;
+	}
+
+	// 64-bit FNV-1a over the whole file
+	bool HashFile(const std::wstring& path, UINT64& hash)
+	{
+		HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[HASH_READ_SIZE]);
+		bool ok = !!buffer;
+
+		hash = 0xcbf29ce484222325ull;
+		while (ok)
+		{
+			DWORD bytesRead = 0;
+			ok = !!ReadFile(hFile, buffer.get(), HASH_READ_SIZE, &bytesRead, nullptr);
+			if (!ok || !bytesRead)
+				break;
+
+			for (DWORD i = 0; i < bytesRead; ++i)
+			{
+				hash ^= buffer[i];
+				hash *= 0x100000001b3ull;
+			}
+		}
+
+		CloseHandle(hFile);
+		return ok;
+	}
+
+	bool IsFailedLoad(const TextureLoadFuture& load)
+	{
+		return load.wait_for(std::chrono::seconds(0)) == std::future_status::ready && FAILED(load.get().hr);
+	}
+}
+
+struct TextureCache::Entry
+{
+	TextureLoadFuture					load;
+	std::wstring						path;
+	std::weak_ptr<const CachedTexture>	handle;			// Expired while nobody holds one
+	std::vector<std::wstring>			pathKeys;		// pathKeys[0] is the path it was loaded from
+	bool								hasContentKey;
+	ContentKey							contentKey;
+	UINT64								bytes;			// 0 until the load resolves
+	bool								cached;			// Cleared once evicted; handles may outlive that
+	bool								unreferenced;
+	std::list<std::shared_ptr<Entry>>::iterator	unreferencedPosition;
+};
+
+TextureCache::TextureCache(AsyncTextureLoader* loader, UINT64 unreferencedBudget, bool hashContents) :
+	m_loader(loader),
+	m_unreferencedBudget(unreferencedBudget),
+	m_hashContents(hashContents),
+	m_hits(0),
+	m_contentHits(0),
+	m_misses(0),
+	m_evictions(0)
+{
+}
+
+TextureCache::~TextureCache()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_unreferenced.clear();
+	m_contents.clear();
+	m_paths.clear();
+}
+
+TextureHandle TextureCache::Load(const wchar_t* fileName, size_t maxsize, DDS_LOADER_FLAGS loadFlags)
+{
+	std::wstring fullPath;
+	if (!fileName || !GetFullPath(fileName, fullPath))
+	{
+		fullPath = fileName ? fileName : L"";
+	}
+
+	// Windows paths are case-insensitive
+	std::wstring pathKey = fullPath;
+	for (auto& c : pathKey)
+	{
+		c = static_cast<wchar_t>(towlower(c));
+	}
+
+	const UINT32 keyFlags = static_cast<UINT32>(loadFlags & CACHE_KEY_FLAGS);
+	pathKey += L'|' + std::to_wstring(maxsize) + L'|' + std::to_wstring(keyFlags);
+
+	UINT64 fileSize = 0;
+	UINT64 lastWriteTime = 0;
+	const bool versioned = GetFileVersion(fullPath, fileSize, lastWriteTime);
+
+	// Returns the handle of a current entry for pathKey, evicting a stale one
+	auto findByPath = [&]() -> TextureHandle
+	{
+		auto it = m_paths.find(pathKey);
+		if (it == m_paths.end())
+			return nullptr;
+
+		std::shared_ptr<Entry> entry = it->second.entry;
+		if (versioned && it->second.fileSize == fileSize && it->second.lastWriteTime == lastWriteTime && !IsFailedLoad(entry->load))
+		{
+			++m_hits;
+			return AcquireHandle(entry);
+		}
+
+		Evict(entry);
+		return nullptr;
+	};
+
+	TextureHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		handle = findByPath();
+		if (handle)
+			return handle;
+	}
+
+	// Hashed without the lock; another thread may add the path meanwhile, so look it up again
+	UINT64 hash = 0;
+	const bool hashed = versioned && m_hashContents && HashFile(fullPath, hash);
+	const ContentKey contentKey(hash, fileSize, maxsize, keyFlags);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	handle = findByPath();
+	if (handle)
+		return handle;
+
+	if (hashed)
+	{
+		auto it = m_contents.find(contentKey);
+		if (it != m_contents.end() && !IsFailedLoad(it->second->load))
+		{
+			std::shared_ptr<Entry> entry = it->second;
+			entry->pathKeys.push_back(pathKey);
+			m_paths[pathKey] = PathRecord{ entry, fileSize, lastWriteTime };
+
+			++m_hits;
+			++m_contentHits;
+			return AcquireHandle(entry);
+		}
+	}
+
+	++m_misses;
+
+	auto entry = std::make_shared<Entry>();
+	entry->load = m_loader->LoadDDSFromFile(fileName, maxsize, loadFlags);
+	entry->path = fullPath;
+	entry->hasContentKey = false;
+	entry->bytes = 0;
+	entry->cached = false;
+	entry->unreferenced = false;
+
+	// A file that can't be stamped can't be checked for changes, so its load is not shared
+	if (versioned)
+	{
+		entry->pathKeys.push_back(pathKey);
+		m_paths[pathKey] = PathRecord{ entry, fileSize, lastWriteTime };
+
+		if (hashed)
+		{
+			auto it = m_contents.find(contentKey);
+			if (it != m_contents.end())
+			{
+				it->second->hasContentKey = false;
+			}
+
+			entry->hasContentKey = true;
+			entry->contentKey = contentKey;
+			m_contents[contentKey] = entry;
+		}
+
+		entry->cached = true;
+	}
+
+	return AcquireHandle(entry);
+}
+
+void TextureCache::Trim(UINT64 budget)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	TrimLocked(budget);
+}
+
+void TextureCache::SetUnreferencedBudget(UINT64 budget)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_unreferencedBudget = budget;
+	TrimLocked(budget);
+}
+
+TextureCacheStatistics TextureCache::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	TextureCacheStatistics stats = {};
+	stats.hits = m_hits;
+	stats.contentHits = m_contentHits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+
+	for (const auto& it : m_paths)
+	{
+		Entry& entry = *it.second.entry;
+
+		// Entries found by content have several path keys; count each once
+		if (it.first != entry.pathKeys[0])
+			continue;
+
+		const UINT64 bytes = GetEntryBytes(entry);
+		++stats.textureCount;
+		stats.bytes += bytes;
+		if (entry.unreferenced)
+		{
+			++stats.unreferencedCount;
+			stats.unreferencedBytes += bytes;
+		}
+	}
+
+	return stats;
+}
+
+// Called with m_mutex held. The handle returned must not be dropped before the lock is.
+TextureHandle TextureCache::AcquireHandle(const std::shared_ptr<Entry>& entry)
+{
+	TextureHandle handle = entry->handle.lock();
+	if (handle)
+		return handle;
+
+	if (entry->unreferenced)
+	{
+		m_unreferenced.erase(entry->unreferencedPosition);
+		entry->unreferenced = false;
+	}
+
+	CachedTexture* texture = new CachedTexture;
+	texture->load = entry->load;
+	texture->path = entry->path;
+
+	// The deleter holds entry weakly: entry->handle points back at its control block
+	std::weak_ptr<Entry> weakEntry = entry;
+	handle.reset(texture, [this, weakEntry](const CachedTexture* texture)
+	{
+		delete texture;
+		Release(weakEntry);
+	});
+
+	entry->handle = handle;
+	return handle;
+}
+
+// Runs when the last handle to entry drops
+void TextureCache::Release(const std::weak_ptr<Entry>& weakEntry)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Load may have handed out a new handle between the drop and the lock
+	std::shared_ptr<Entry> entry = weakEntry.lock();
+	if (!entry || !entry->cached || !entry->handle.expired())
+		return;
+
+	m_unreferenced.push_front(entry);
+	entry->unreferencedPosition = m_unreferenced.begin();
+	entry->unreferenced = true;
+
+	TrimLocked(m_unreferencedBudget);
+}
+
+void TextureCache::Evict(const std::shared_ptr<Entry>& entry)
+{
+	if (!entry->cached)
+		return;
+
+	for (const auto& pathKey : entry->pathKeys)
+	{
+		m_paths.erase(pathKey);
+	}
+
+	if (entry->hasContentKey)
+	{
+		m_contents.erase(entry->contentKey);
+	}
+
+	if (entry->unreferenced)
+	{
+		m_unreferenced.erase(entry->unreferencedPosition);
+		entry->unreferenced = false;
+	}
+
+	entry->cached = false;
+	++m_evictions;
+}
+
+void TextureCache::TrimLocked(UINT64 budget)
+{
+	UINT64 unreferencedBytes = 0;
+	for (const auto& entry : m_unreferenced)
+	{
+		unreferencedBytes += GetEntryBytes(*entry);
+	}
+
+	// A budget of 0 also drops loads that have not resolved yet, which count as 0 bytes
+	while (!m_unreferenced.empty() && (!budget || unreferencedBytes > budget))
+	{
+		std::shared_ptr<Entry> entry = m_unreferenced.back();
+		unreferencedBytes -= entry->bytes;
+		Evict(entry);
+	}
+}
+
+UINT64 TextureCache::GetEntryBytes(Entry& entry) const
+{
+	if (!entry.bytes && entry.load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		const TextureLoadResult& result = entry.load.get();
+		if (SUCCEEDED(result.hr) && result.texture)
+		{
+			ComPtr<ID3D12Device> device;
+			if (SUCCEEDED(result.texture->GetDevice(IID_PPV_ARGS(&device))))
+			{
+				const D3D12_RESOURCE_DESC desc = result.texture->GetDesc();
+				entry.bytes = device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+			}
+		}
+	}
+
+	return entry.bytes;
+}
@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------------------
+// File: TextureCache.h
+//
+// Shares DDS textures loaded through an AsyncTextureLoader. Requests for the same file,
+// maxsize and flags get the same load, keyed by the full path and checked against the
+// file's size and last-write time; with content hashing, identical files at different
+// paths share one load too. Handles are reference counted, and a texture without handles
+// is kept for reuse until the unreferenced budget pushes it out.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncTextureLoader.h"
+
+namespace DirectX
+{
+	struct CachedTexture
+	{
+		TextureLoadFuture	load;
+		std::wstring		path;		// Full path of the file that was loaded
+	};
+
+	// Holding one keeps the texture in the cache. Dropping the last one only releases the
+	// cache's reference: commands already recorded with the texture still need it kept alive
+	// until they have executed.
+	typedef std::shared_ptr<const CachedTexture> TextureHandle;
+
+	struct TextureCacheStatistics
+	{
+		UINT64	hits;					// Served from the cache, by path or by content
+		UINT64	contentHits;			// The part of hits found by content hash under another path
+		UINT64	misses;					// Started a load
+		UINT64	evictions;
+		size_t	textureCount;
+		size_t	unreferencedCount;		// Kept without handles
+		UINT64	bytes;					// Allocation size of the textures that have resolved
+		UINT64	unreferencedBytes;
+	};
+
+	class TextureCache
+	{
+	public:
+		// loader must outlive the cache, and the cache its handles. unreferencedBudget is the
+		// size of textures without handles kept for reuse; 0 releases them on the last drop.
+		// hashContents hashes every file the path lookup misses, which reads it once more.
+		explicit TextureCache(_In_ AsyncTextureLoader* loader, UINT64 unreferencedBudget = 0, bool hashContents = false);
+		~TextureCache();
+
+		TextureCache(const TextureCache&) = delete;
+		TextureCache& operator=(const TextureCache&) = delete;
+
+		// Safe to call from any thread. STREAMING and MEMORY_MAPPED only change how a file is
+		// read, so they do not split entries. A load that failed, or whose file has changed
+		// since, is started again.
+		TextureHandle Load(_In_z_ const wchar_t* fileName, size_t maxsize = 0,
+			DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT);
+
+		// Evicts the least recently released textures until the unreferenced ones fit in budget
+		void Trim(UINT64 budget);
+		void SetUnreferencedBudget(UINT64 budget);
+
+		TextureCacheStatistics GetStatistics() const;
+
+	private:
+		struct Entry;
+
+		// Hash, file size, maxsize, flags
+		typedef std::tuple<UINT64, UINT64, size_t, UINT32> ContentKey;
+
+		struct PathRecord
+		{
+			std::shared_ptr<Entry>	entry;
+			UINT64					fileSize;
+			UINT64					lastWriteTime;
+		};
+
+		TextureHandle AcquireHandle(const std::shared_ptr<Entry>& entry);
+		void Release(const std::weak_ptr<Entry>& weakEntry);
+		void Evict(const std::shared_ptr<Entry>& entry);
+		void TrimLocked(UINT64 budget);
+		UINT64 GetEntryBytes(Entry& entry) const;
+
+		AsyncTextureLoader*									m_loader;
+		UINT64												m_unreferencedBudget;
+		bool												m_hashContents;
+
+		mutable std::mutex									m_mutex;
+		std::unordered_map<std::wstring, PathRecord>		m_paths;		// Path key: full path, maxsize and flags
+		std::map<ContentKey, std::shared_ptr<Entry>>		m_contents;
+		std::list<std::shared_ptr<Entry>>					m_unreferenced;	// Most recently released first
+
+		UINT64												m_hits;
+		UINT64												m_contentHits;
+		UINT64												m_misses;
+		UINT64												m_evictions;
+	};
+}
@@ -0,0 +1,235 @@
+//--------------------------------------------------------------------------------------
+// File: TextureFootprints.cpp
+//
+// CPU implementation of ID3D12Device::GetCopyableFootprints, built on the format traits
+// table. Subresources are ordered mip, then array slice, then plane, as the device
+// orders them.
+//--------------------------------------------------------------------------------------
+
+#include "TextureFootprints.h"
+#include "DXGIFormatTraits.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	struct PlaneFormat
+	{
+		DXGI_FORMAT format;             // Format the plane is copied as
+		UINT        log2SubsampleX;     // Plane size relative to the luma plane
+		UINT        log2SubsampleY;
+	};
+
+	// Returns the number of planes and fills planes[], or 0 when the layout isn't modelled
+	UINT GetPlaneFormats(DXGI_FORMAT format, PlaneFormat planes[2])
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_NV12:
+		case DXGI_FORMAT_420_OPAQUE:
+			planes[0] = { DXGI_FORMAT_R8_TYPELESS, 0, 0 };
+			planes[1] = { DXGI_FORMAT_R8G8_TYPELESS, 1, 1 };
+			return 2;
+
+		case DXGI_FORMAT_P010:
+		case DXGI_FORMAT_P016:
+			planes[0] = { DXGI_FORMAT_R16_TYPELESS, 0, 0 };
+			planes[1] = { DXGI_FORMAT_R16G16_TYPELESS, 1, 1 };
+			return 2;
+
+		case DXGI_FORMAT_NV11:
+			planes[0] = { DXGI_FORMAT_R8_TYPELESS, 0, 0 };
+			planes[1] = { DXGI_FORMAT_R8G8_TYPELESS, 2, 0 };
+			return 2;
+
+		case DXGI_FORMAT_P208:
+			planes[0] = { DXGI_FORMAT_R8_TYPELESS, 0, 0 };
+			planes[1] = { DXGI_FORMAT_R8G8_TYPELESS, 1, 0 };
+			return 2;
+
+		// Depth and stencil are separate planes whose copy formats depend on the hardware
+		case DXGI_FORMAT_R32G8X24_TYPELESS:
+		case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+		case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+		case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+		case DXGI_FORMAT_R24G8_TYPELESS:
+		case DXGI_FORMAT_D24_UNORM_S8_UINT:
+		case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+		case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+		case DXGI_FORMAT_V208:
+		case DXGI_FORMAT_V408:
+			return 0;
+
+		default:
+			if (!GetBitsPerPixel(format))
+				return 0;
+
+			planes[0] = { format, 0, 0 };
+			return 1;
+		}
+	}
+
+	inline UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	UINT GetFullMipCount(const D3D12_RESOURCE_DESC& desc)
+	{
+		UINT64 largest = std::max<UINT64>(desc.Width, desc.Height);
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+			largest = std::max<UINT64>(largest, desc.DepthOrArraySize);
+
+		UINT count = 1;
+		while (largest > 1)
+		{
+			largest >>= 1;
+			++count;
+		}
+
+		return count;
+	}
+
+	HRESULT GetBufferFootprint(
+		const D3D12_RESOURCE_DESC& desc,
+		UINT firstSubresource,
+		UINT numSubresources,
+		UINT64 baseOffset,
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+		UINT* numRows,
+		UINT64* rowSizesInBytes,
+		UINT64* totalBytes)
+	{
+		if (firstSubresource != 0 || numSubresources != 1 || desc.Width > UINT_MAX)
+			return E_INVALIDARG;
+
+		if (layouts)
+		{
+			layouts[0].Offset = baseOffset;
+			layouts[0].Footprint.Format = DXGI_FORMAT_UNKNOWN;
+			layouts[0].Footprint.Width = static_cast<UINT>(desc.Width);
+			layouts[0].Footprint.Height = 1;
+			layouts[0].Footprint.Depth = 1;
+			layouts[0].Footprint.RowPitch = static_cast<UINT>(AlignUp(desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+		}
+		if (numRows)
+			numRows[0] = 1;
+		if (rowSizesInBytes)
+			rowSizesInBytes[0] = desc.Width;
+		if (totalBytes)
+			*totalBytes = desc.Width;
+
+		return S_OK;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetCopyableFootprints12(
+	const D3D12_RESOURCE_DESC& desc,
+	UINT firstSubresource,
+	UINT numSubresources,
+	UINT64 baseOffset,
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+	UINT* numRows,
+	UINT64* rowSizesInBytes,
+	UINT64* totalBytes)
+{
+	// Matches the device, which reports failure through an all-ones total
+	if (totalBytes)
+		*totalBytes = UINT64(-1);
+
+	if (baseOffset & (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1))
+		return E_INVALIDARG;
+
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		return GetBufferFootprint(desc, firstSubresource, numSubresources, baseOffset, layouts, numRows, rowSizesInBytes, totalBytes);
+
+	if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE1D &&
+		desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D &&
+		desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+		return E_INVALIDARG;
+
+	if (!desc.Width || !desc.Height || !desc.DepthOrArraySize || desc.SampleDesc.Count > 1)
+		return E_INVALIDARG;
+
+	PlaneFormat planes[2];
+	const UINT planeCount = GetPlaneFormats(desc.Format, planes);
+	if (!planeCount)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	const bool isVolume = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D);
+	const UINT mipLevels = desc.MipLevels ? desc.MipLevels : GetFullMipCount(desc);
+	const UINT arraySize = isVolume ? 1 : desc.DepthOrArraySize;
+	const UINT64 subresourceCount = UINT64(mipLevels) * arraySize * planeCount;
+
+	if (!numSubresources || UINT64(firstSubresource) + numSubresources > subresourceCount)
+		return E_INVALIDARG;
+
+	UINT64 offset = 0;
+	UINT64 total = 0;
+	for (UINT i = 0; i < numSubresources; ++i)
+	{
+		const UINT subresource = firstSubresource + i;
+		const UINT mip = subresource % mipLevels;
+		const PlaneFormat& plane = planes[subresource / (mipLevels * arraySize)];
+		const DXGIFormatTraits& traits = GetFormatTraits(plane.format);
+
+		const UINT64 lumaWidth = std::max<UINT64>(desc.Width >> mip, 1);
+		const UINT lumaHeight = std::max<UINT>(desc.Height >> mip, 1);
+		const UINT depth = isVolume ? std::max<UINT>(desc.DepthOrArraySize >> mip, 1) : 1;
+
+		const UINT64 width = (lumaWidth + (UINT64(1) << plane.log2SubsampleX) - 1) >> plane.log2SubsampleX;
+		const UINT height = (lumaHeight + (1u << plane.log2SubsampleY) - 1) >> plane.log2SubsampleY;
+
+		// Rows are counted in elements: a BC row is a row of 4x4 blocks
+		const UINT64 elementsWide = (width + (UINT64(1) << traits.log2ElementWidth) - 1) >> traits.log2ElementWidth;
+		const UINT rows = (height + (1u << traits.log2ElementHeight) - 1) >> traits.log2ElementHeight;
+		const UINT64 rowSize = (elementsWide * traits.bitsPerElement + 7) >> 3;
+		const UINT64 rowPitch = AlignUp(rowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+		if (rowPitch > UINT_MAX || (elementsWide << traits.log2ElementWidth) > UINT_MAX)
+			return E_INVALIDARG;
+
+		if (layouts)
+		{
+			layouts[i].Offset = baseOffset + offset;
+			layouts[i].Footprint.Format = plane.format;
+			layouts[i].Footprint.Width = static_cast<UINT>(elementsWide << traits.log2ElementWidth);
+			layouts[i].Footprint.Height = rows << traits.log2ElementHeight;
+			layouts[i].Footprint.Depth = depth;
+			layouts[i].Footprint.RowPitch = static_cast<UINT>(rowPitch);
+		}
+		if (numRows)
+			numRows[i] = rows;
+		if (rowSizesInBytes)
+			rowSizesInBytes[i] = rowSize;
+
+		// The last row of a subresource isn't padded out to the row pitch
+		total = offset + rowPitch * (UINT64(rows) * depth - 1) + rowSize;
+		offset = AlignUp(total, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	}
+
+	if (totalBytes)
+		*totalBytes = total;
+
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+UINT64 DirectX::GetRequiredIntermediateSize12(
+	const D3D12_RESOURCE_DESC& desc,
+	UINT firstSubresource,
+	UINT numSubresources)
+{
+	UINT64 totalBytes = 0;
+	if (FAILED(GetCopyableFootprints12(desc, firstSubresource, numSubresources, 0, nullptr, nullptr, nullptr, &totalBytes)))
+		return 0;
+
+	return totalBytes;
+}
@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------
+// File: TextureFootprints.h
+//
+// CPU implementation of ID3D12Device::GetCopyableFootprints. It follows the same
+// placement rules (256-byte row pitch, 512-byte subresource offsets, BC block rows,
+// one subresource per plane for planar formats). Upload space can therefore be sized
+// and packed on any thread, or offline, without a device.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+
+namespace DirectX
+{
+	// Same contract as ID3D12Device::GetCopyableFootprints; any output may be null. baseOffset
+	// must be a multiple of D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT. Returns E_INVALIDARG for
+	// a bad description or subresource range. Formats whose plane layout isn't modelled
+	// (depth-stencil formats with a stencil plane, V208, V408) return ERROR_NOT_SUPPORTED;
+	// ask the device for those.
+	HRESULT GetCopyableFootprints12(
+		const D3D12_RESOURCE_DESC& desc,
+		UINT firstSubresource,
+		UINT numSubresources,
+		UINT64 baseOffset,
+		_Out_writes_opt_(numSubresources) D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+		_Out_writes_opt_(numSubresources) UINT* numRows,
+		_Out_writes_opt_(numSubresources) UINT64* rowSizesInBytes,
+		_Out_opt_ UINT64* totalBytes);
+
+	// Upload buffer size for a subresource range, as GetRequiredIntermediateSize in d3dx12.h
+	// computes it, but from the description alone. Returns 0 when the range can't be laid out.
+	UINT64 GetRequiredIntermediateSize12(
+		const D3D12_RESOURCE_DESC& desc,
+		UINT firstSubresource,
+		UINT numSubresources);
+}
@@ -0,0 +1,142 @@
+//--------------------------------------------------------------------------------------
+// File: ThreadPool.cpp
+//
+// Fixed-size pool of worker threads draining a FIFO task queue
+//--------------------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace DirectX;
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+	m_stopping(false)
+{
+	if (threadCount == 0)
+	{
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+	}
+
+	m_threads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::WorkerMain, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	Shutdown();
+}
+
+void ThreadPool::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+
+	// Workers drain whatever is still queued before they exit
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_wake.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+	if (count <= 1 || m_threads.empty())
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	// Shared so that helpers which only get to run after the last index is claimed can
+	// still look at the counter safely; they never touch body once it is exhausted.
+	struct Batch
+	{
+		std::atomic<size_t>					next;
+		std::atomic<size_t>					done;
+		size_t								count;
+		const std::function<void(size_t)>*	body;
+		std::mutex							mutex;
+		std::condition_variable				finished;
+	};
+
+	auto batch = std::make_shared<Batch>();
+	batch->next = 0;
+	batch->done = 0;
+	batch->count = count;
+	batch->body = &body;
+
+	auto run = [batch]()
+	{
+		for (;;)
+		{
+			const size_t i = batch->next.fetch_add(1);
+			if (i >= batch->count)
+			{
+				return;
+			}
+
+			(*batch->body)(i);
+
+			if (batch->done.fetch_add(1) + 1 == batch->count)
+			{
+				std::lock_guard<std::mutex> lock(batch->mutex);
+				batch->finished.notify_all();
+			}
+		}
+	};
+
+	const size_t helpers = std::min<size_t>(count - 1, m_threads.size());
+	for (size_t i = 0; i < helpers; ++i)
+	{
+		Enqueue(run);
+	}
+
+	run();
+
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->finished.wait(lock, [&batch] { return batch->done.load() == batch->count; });
+}
+
+void ThreadPool::WorkerMain()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+			if (m_tasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+
+		task();
+	}
+}
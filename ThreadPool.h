@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// File: ThreadPool.h
+//
+// Fixed-size pool of worker threads draining a FIFO task queue
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DirectX
+{
+	class ThreadPool
+	{
+	public:
+		// threadCount == 0 uses one thread per hardware thread, minus the caller's
+		explicit ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();	// Shutdown
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Enqueue(std::function<void()> task);
+
+		// Runs body(0) .. body(count - 1) across the pool and returns once all have finished.
+		// The calling thread takes indices too, so this completes even when every worker is
+		// busy, including when called from a task on this pool.
+		void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+		// Runs what is still queued, then joins the workers. ParallelFor keeps working after
+		// this, on the calling thread alone; Enqueue must not be called again.
+		void Shutdown();
+
+		unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+	private:
+		void WorkerMain();
+
+		std::vector<std::thread>			m_threads;
+		std::deque<std::function<void()>>	m_tasks;
+		std::mutex							m_mutex;
+		std::condition_variable				m_wake;
+		bool								m_stopping;
+	};
+}
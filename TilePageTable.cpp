@@ -0,0 +1,359 @@
+//--------------------------------------------------------------------------------------
+// File: TilePageTable.cpp
+//
+// Tiles keep the same shape in texels at every mip, so the tile covering (x, y) one mip
+// coarser is simply (x / 2, y / 2). Tiles are numbered mip by mip, row by row.
+//--------------------------------------------------------------------------------------
+
+#include "TilePageTable.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t NO_TILE = UINT32_MAX;
+
+	uint32_t GetMipSize(uint32_t size, uint32_t mip)
+	{
+		return std::max<uint32_t>(size >> mip, 1);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+TilePageTable::TilePageTable() :
+	m_desc(),
+	m_pagedMips(0),
+	m_frame(1),
+	m_requests(0),
+	m_mapped(0),
+	m_evicted(0)
+{
+}
+
+bool TilePageTable::Initialize(const TiledTextureDesc& desc, uint32_t physicalTileCount)
+{
+	if (!desc.width || !desc.height || !desc.mipCount || desc.mipCount > 32 ||
+		desc.packedMipStart > desc.mipCount || !desc.tileWidth || !desc.tileHeight ||
+		!physicalTileCount)
+	{
+		return false;
+	}
+
+	m_desc = desc;
+	m_pagedMips = desc.packedMipStart;
+
+	m_mipOffsets.resize(m_pagedMips);
+	uint64_t tileCount = 0;
+	for (uint32_t mip = 0; mip < m_pagedMips; ++mip)
+	{
+		m_mipOffsets[mip] = static_cast<uint32_t>(tileCount);
+		tileCount += uint64_t(GetTilesX(mip)) * GetTilesY(mip);
+		if (tileCount >= NO_TILE)
+			return false;
+	}
+
+	Tile empty = {};
+	empty.physicalTile = TILE_NOT_MAPPED;
+	empty.state = TILE_STATE_NOT_MAPPED;
+	m_tiles.assign(static_cast<size_t>(tileCount), empty);
+
+	m_queue.clear();
+	m_lru.clear();
+
+	// Handed out from the back, so tile 0 goes first
+	m_freeTiles.resize(physicalTileCount);
+	for (uint32_t i = 0; i < physicalTileCount; ++i)
+	{
+		m_freeTiles[i] = physicalTileCount - 1 - i;
+	}
+
+	m_frame = 1;
+	m_requests = 0;
+	m_mapped = 0;
+	m_evicted = 0;
+	return true;
+}
+
+uint32_t TilePageTable::GetTilesX(uint32_t mip) const
+{
+	return (GetMipSize(m_desc.width, mip) + m_desc.tileWidth - 1) / m_desc.tileWidth;
+}
+
+uint32_t TilePageTable::GetTilesY(uint32_t mip) const
+{
+	return (GetMipSize(m_desc.height, mip) + m_desc.tileHeight - 1) / m_desc.tileHeight;
+}
+
+
+//--------------------------------------------------------------------------------------
+uint32_t TilePageTable::GetTileIndex(uint32_t mip, uint32_t x, uint32_t y) const
+{
+	if (mip >= m_pagedMips || x >= GetTilesX(mip) || y >= GetTilesY(mip))
+		return NO_TILE;
+
+	return m_mipOffsets[mip] + y * GetTilesX(mip) + x;
+}
+
+TileCoordinate TilePageTable::GetTileCoordinate(uint32_t index) const
+{
+	const uint32_t mip = static_cast<uint32_t>(std::upper_bound(m_mipOffsets.begin(), m_mipOffsets.end(), index) - m_mipOffsets.begin()) - 1;
+	const uint32_t local = index - m_mipOffsets[mip];
+	const uint32_t tilesX = GetTilesX(mip);
+
+	TileCoordinate coordinate = { local % tilesX, local / tilesX, mip };
+	return coordinate;
+}
+
+uint32_t TilePageTable::GetParentIndex(uint32_t index) const
+{
+	const TileCoordinate tile = GetTileCoordinate(index);
+	return GetTileIndex(tile.mip + 1, tile.x / 2, tile.y / 2);
+}
+
+void TilePageTable::Touch(uint32_t index)
+{
+	Tile& tile = m_tiles[index];
+	tile.lastUsed = m_frame;
+
+	if (tile.state == TILE_STATE_LOADING || tile.state == TILE_STATE_RESIDENT)
+	{
+		m_lru.splice(m_lru.begin(), m_lru, tile.lruPosition);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+void TilePageTable::RequestTile(uint32_t mip, uint32_t x, uint32_t y)
+{
+	for (uint32_t index = GetTileIndex(mip, x, y); index != NO_TILE; index = GetParentIndex(index))
+	{
+		Tile& tile = m_tiles[index];
+
+		// Once this frame is enough for the whole chain above it
+		if (tile.lastUsed == m_frame)
+			break;
+
+		Touch(index);
+
+		if (tile.state == TILE_STATE_NOT_MAPPED)
+		{
+			tile.state = TILE_STATE_QUEUED;
+			m_queue.push_back(index);
+			++m_requests;
+		}
+	}
+}
+
+void TilePageTable::AddFeedback(const uint8_t* minMips, uint32_t width, uint32_t height, size_t rowPitch)
+{
+	if (!minMips || !width || !height || m_tiles.empty())
+		return;
+
+	for (uint32_t fy = 0; fy < height; ++fy)
+	{
+		const uint8_t* row = minMips + rowPitch * fy;
+
+		// The texels of mip 0 this row of regions covers
+		const uint32_t y0 = static_cast<uint32_t>(uint64_t(fy) * m_desc.height / height);
+		const uint32_t y1 = std::max(y0, static_cast<uint32_t>(uint64_t(fy + 1) * m_desc.height / height) - 1);
+
+		for (uint32_t fx = 0; fx < width; ++fx)
+		{
+			const uint32_t mip = row[fx];
+			if (mip == TILE_FEEDBACK_NONE || mip >= m_pagedMips)
+				continue;
+
+			const uint32_t x0 = static_cast<uint32_t>(uint64_t(fx) * m_desc.width / width);
+			const uint32_t x1 = std::max(x0, static_cast<uint32_t>(uint64_t(fx + 1) * m_desc.width / width) - 1);
+
+			const uint32_t lastX = std::min((x1 >> mip) / m_desc.tileWidth, GetTilesX(mip) - 1);
+			const uint32_t lastY = std::min((y1 >> mip) / m_desc.tileHeight, GetTilesY(mip) - 1);
+			for (uint32_t ty = (y0 >> mip) / m_desc.tileHeight; ty <= lastY; ++ty)
+			{
+				for (uint32_t tx = (x0 >> mip) / m_desc.tileWidth; tx <= lastX; ++tx)
+				{
+					RequestTile(mip, tx, ty);
+				}
+			}
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+bool TilePageTable::AcquirePhysicalTile(uint32_t& physicalTile, std::vector<TileMapping>& unmappings)
+{
+	if (!m_freeTiles.empty())
+	{
+		physicalTile = m_freeTiles.back();
+		m_freeTiles.pop_back();
+		return true;
+	}
+
+	// Loading tiles have a copy in flight, and tiles used this frame may be sampled by it
+	for (auto it = m_lru.rbegin(); it != m_lru.rend(); ++it)
+	{
+		const uint32_t index = *it;
+		Tile& tile = m_tiles[index];
+		if (tile.lastUsed == m_frame)
+			break;
+
+		if (tile.state != TILE_STATE_RESIDENT || tile.mappedChildren)
+			continue;
+
+		const TileMapping unmapping = { GetTileCoordinate(index), tile.physicalTile };
+		unmappings.push_back(unmapping);
+
+		const uint32_t parent = GetParentIndex(index);
+		if (parent != NO_TILE)
+		{
+			--m_tiles[parent].mappedChildren;
+		}
+
+		physicalTile = tile.physicalTile;
+		m_lru.erase(tile.lruPosition);
+		tile.physicalTile = TILE_NOT_MAPPED;
+		tile.state = TILE_STATE_NOT_MAPPED;
+		++m_evicted;
+		return true;
+	}
+
+	return false;
+}
+
+void TilePageTable::Update(uint32_t maxMappings, std::vector<TileMapping>& unmappings, std::vector<TileMapping>& mappings)
+{
+	unmappings.clear();
+	mappings.clear();
+
+	// Requests last one frame; feedback renews the ones still wanted. A tile's parents are
+	// touched with it, so most recent first also puts them ahead of it.
+	auto stale = std::remove_if(m_queue.begin(), m_queue.end(), [this](uint32_t index)
+	{
+		if (m_tiles[index].lastUsed == m_frame)
+			return false;
+
+		m_tiles[index].state = TILE_STATE_NOT_MAPPED;
+		return true;
+	});
+	m_queue.erase(stale, m_queue.end());
+
+	std::stable_sort(m_queue.begin(), m_queue.end(), [this](uint32_t a, uint32_t b)
+	{
+		return GetTileCoordinate(a).mip > GetTileCoordinate(b).mip;
+	});
+
+	size_t kept = 0;
+	for (size_t i = 0; i < m_queue.size(); ++i)
+	{
+		const uint32_t index = m_queue[i];
+		Tile& tile = m_tiles[index];
+
+		const uint32_t parent = GetParentIndex(index);
+		uint32_t physicalTile = TILE_NOT_MAPPED;
+		if (mappings.size() >= maxMappings ||
+			(parent != NO_TILE && m_tiles[parent].physicalTile == TILE_NOT_MAPPED) ||
+			!AcquirePhysicalTile(physicalTile, unmappings))
+		{
+			m_queue[kept++] = index;
+			continue;
+		}
+
+		tile.physicalTile = physicalTile;
+		tile.state = TILE_STATE_LOADING;
+		m_lru.push_front(index);
+		tile.lruPosition = m_lru.begin();
+		if (parent != NO_TILE)
+		{
+			++m_tiles[parent].mappedChildren;
+		}
+
+		const TileMapping mapping = { GetTileCoordinate(index), physicalTile };
+		mappings.push_back(mapping);
+		++m_mapped;
+	}
+
+	m_queue.resize(kept);
+	++m_frame;
+}
+
+void TilePageTable::CompleteLoads(const TileMapping* tiles, size_t count)
+{
+	for (size_t i = 0; i < count && tiles; ++i)
+	{
+		const uint32_t index = GetTileIndex(tiles[i].tile.mip, tiles[i].tile.x, tiles[i].tile.y);
+		if (index == NO_TILE)
+			continue;
+
+		Tile& tile = m_tiles[index];
+		if (tile.state == TILE_STATE_LOADING && tile.physicalTile == tiles[i].physicalTile)
+		{
+			tile.state = TILE_STATE_RESIDENT;
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+uint32_t TilePageTable::GetPhysicalTile(uint32_t mip, uint32_t x, uint32_t y) const
+{
+	const uint32_t index = GetTileIndex(mip, x, y);
+	return (index == NO_TILE) ? TILE_NOT_MAPPED : m_tiles[index].physicalTile;
+}
+
+bool TilePageTable::IsResident(uint32_t mip, uint32_t x, uint32_t y) const
+{
+	if (mip >= m_pagedMips)
+		return mip < m_desc.mipCount;
+
+	const uint32_t index = GetTileIndex(mip, x, y);
+	return index != NO_TILE && m_tiles[index].state == TILE_STATE_RESIDENT;
+}
+
+void TilePageTable::GetResidencyMap(std::vector<uint8_t>& residency) const
+{
+	residency.clear();
+	if (!m_pagedMips)
+		return;
+
+	const uint32_t tilesX = GetTilesX(0);
+	const uint32_t tilesY = GetTilesY(0);
+	residency.resize(size_t(tilesX) * tilesY);
+
+	for (uint32_t y = 0; y < tilesY; ++y)
+	{
+		for (uint32_t x = 0; x < tilesX; ++x)
+		{
+			uint32_t finest = m_pagedMips;
+			while (finest > 0 && IsResident(finest - 1, x >> (finest - 1), y >> (finest - 1)))
+			{
+				--finest;
+			}
+
+			residency[size_t(y) * tilesX + x] = static_cast<uint8_t>(finest);
+		}
+	}
+}
+
+TilePageTableStatistics TilePageTable::GetStatistics() const
+{
+	TilePageTableStatistics stats = {};
+	stats.requests = m_requests;
+	stats.mapped = m_mapped;
+	stats.evicted = m_evicted;
+	stats.queued = static_cast<uint32_t>(m_queue.size());
+	stats.freePhysicalTiles = static_cast<uint32_t>(m_freeTiles.size());
+
+	for (const auto& tile : m_tiles)
+	{
+		if (tile.state == TILE_STATE_RESIDENT)
+			++stats.resident;
+		else if (tile.state == TILE_STATE_LOADING)
+			++stats.loading;
+	}
+
+	return stats;
+}
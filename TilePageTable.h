@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------
+// File: TilePageTable.h
+//
+// Device-independent page table for a reserved (tiled) 2D texture: which 64KB tiles of
+// which mips are backed by a tile of the physical pool, which are wanted, and which go
+// when the pool runs out. Feedback and explicit requests queue tiles; Update hands back
+// the mapping changes for the caller to apply with UpdateTileMappings and fill with
+// copies. Like DDSLayout, this needs no device or windows.h.
+//
+// A tile is only mapped after every coarser tile above it, and only evicted once no
+// finer tile below it is mapped, so sampling can always fall back to the finest resident
+// mip. The packed mip tail is not paged: the caller keeps it mapped for the lifetime of
+// the texture.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <vector>
+
+namespace DirectX
+{
+	const uint32_t TILE_NOT_MAPPED = UINT32_MAX;
+
+	// Feedback value for a region that wasn't sampled
+	const uint8_t TILE_FEEDBACK_NONE = 0xFF;
+
+	struct TileCoordinate
+	{
+		uint32_t    x;                      // In tiles of mip
+		uint32_t    y;
+		uint32_t    mip;
+	};
+
+	struct TiledTextureDesc
+	{
+		uint32_t    width;                  // Mip 0, in texels
+		uint32_t    height;
+		uint32_t    mipCount;
+		uint32_t    packedMipStart;         // First mip of the packed tail; mipCount if it has none
+		uint32_t    tileWidth;              // Texels per tile, from the format's standard tile shape
+		uint32_t    tileHeight;
+	};
+
+	struct TileMapping
+	{
+		TileCoordinate  tile;
+		uint32_t        physicalTile;       // Index into the pool
+	};
+
+	struct TilePageTableStatistics
+	{
+		uint64_t    requests;               // Tiles queued, counting each once until it is mapped
+		uint64_t    mapped;
+		uint64_t    evicted;
+		uint32_t    resident;               // Loaded and usable
+		uint32_t    loading;                // Mapped, waiting for CompleteLoads
+		uint32_t    queued;
+		uint32_t    freePhysicalTiles;
+	};
+
+	class TilePageTable
+	{
+	public:
+		TilePageTable();
+
+		// physicalTileCount is the size of the pool the paged mips share. False if desc
+		// is inconsistent or the pool is empty.
+		bool Initialize(const TiledTextureDesc& desc, uint32_t physicalTileCount);
+
+		const TiledTextureDesc& GetDesc() const { return m_desc; }
+
+		// Tiles across and down mip, which must be below packedMipStart
+		uint32_t GetTilesX(uint32_t mip) const;
+		uint32_t GetTilesY(uint32_t mip) const;
+
+		// Queues the tile and every coarser tile covering it, and marks them all used this
+		// frame. Mips at or past packedMipStart are always resident and are ignored.
+		void RequestTile(uint32_t mip, uint32_t x, uint32_t y);
+
+		// Sampler or readback feedback: one byte per region, the finest mip sampled there or
+		// TILE_FEEDBACK_NONE. The regions split mip 0 evenly across width x height entries.
+		void AddFeedback(const uint8_t* minMips, uint32_t width, uint32_t height, size_t rowPitch);
+
+		// Ends the frame. Maps up to maxMappings queued tiles, coarsest first, each to a free
+		// physical tile or else to the one held by the least recently used tile that isn't
+		// needed this frame and has no finer tile resident below it. The tiles losing their
+		// physical tile come back in unmappings, before the mappings reusing it. New mappings
+		// are loading until CompleteLoads. Tiles that can't be placed stay queued, but only
+		// for the next Update if they are requested again in the meantime.
+		void Update(uint32_t maxMappings, std::vector<TileMapping>& unmappings, std::vector<TileMapping>& mappings);
+
+		// The data of these mapped tiles has reached the GPU, so they can be sampled
+		void CompleteLoads(const TileMapping* tiles, size_t count);
+
+		// TILE_NOT_MAPPED unless the tile is loading or resident
+		uint32_t GetPhysicalTile(uint32_t mip, uint32_t x, uint32_t y) const;
+		bool IsResident(uint32_t mip, uint32_t x, uint32_t y) const;
+
+		// Finest resident mip over each tile of mip 0, row by row (GetTilesX(0) x
+		// GetTilesY(0) entries), for the shader to clamp its level of detail to. Regions
+		// with nothing resident above the tail get packedMipStart.
+		void GetResidencyMap(std::vector<uint8_t>& residency) const;
+
+		TilePageTableStatistics GetStatistics() const;
+
+	private:
+		enum TILE_STATE : uint8_t
+		{
+			TILE_STATE_NOT_MAPPED = 0,
+			TILE_STATE_QUEUED,
+			TILE_STATE_LOADING,
+			TILE_STATE_RESIDENT,
+		};
+
+		struct Tile
+		{
+			uint32_t                        physicalTile;
+			uint32_t                        mappedChildren;     // Finer tiles below this one that hold a physical tile
+			uint64_t                        lastUsed;           // Frame
+			TILE_STATE                      state;
+			std::list<uint32_t>::iterator   lruPosition;        // Valid while mapped
+		};
+
+		uint32_t GetTileIndex(uint32_t mip, uint32_t x, uint32_t y) const;
+		TileCoordinate GetTileCoordinate(uint32_t index) const;
+		uint32_t GetParentIndex(uint32_t index) const;          // UINT32_MAX for the coarsest paged mip
+		void Touch(uint32_t index);
+		bool AcquirePhysicalTile(uint32_t& physicalTile, std::vector<TileMapping>& unmappings);
+
+		TiledTextureDesc        m_desc;
+		uint32_t                m_pagedMips;
+		std::vector<uint32_t>   m_mipOffsets;       // First tile index of each paged mip
+		std::vector<Tile>       m_tiles;
+		std::vector<uint32_t>   m_queue;
+		std::vector<uint32_t>   m_freeTiles;
+		std::list<uint32_t>     m_lru;              // Mapped tiles, most recently used first
+		uint64_t                m_frame;
+
+		uint64_t                m_requests;
+		uint64_t                m_mapped;
+		uint64_t                m_evicted;
+	};
+}
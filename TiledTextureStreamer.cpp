@@ -0,0 +1,579 @@
+//--------------------------------------------------------------------------------------
+// File: TiledTextureStreamer.cpp
+//
+// Each Update is one submission: UpdateTileMappings for the tiles the page table moved,
+// then a command list that copies the new tiles out of upload space. Both go to the same
+// queue, so the copies land in the tiles just mapped and the frame queued after them
+// samples the result. A batch's tiles are handed back to the page table as resident once
+// its fence completes.
+//--------------------------------------------------------------------------------------
+
+#include "TiledTextureStreamer.h"
+
+#include "DXGIFormatTraits.h"
+
+#include <algorithm>
+#include <exception>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void ThrowIfFailed(HRESULT hr)
+	{
+		if (FAILED(hr))
+		{
+			throw std::exception();
+		}
+	}
+
+	UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// The part of a mip one tile covers, in elements (texels or 4x4 blocks)
+	struct TileRegion
+	{
+		UINT	x;				// Texels, for the copy destination
+		UINT	y;
+		UINT	width;
+		UINT	height;
+		UINT	elementX;
+		UINT	elementY;
+		UINT	elementsWide;
+		UINT	elementsHigh;
+		UINT	rowBytes;
+		UINT	rowPitch;		// In upload space
+	};
+
+	TileRegion GetTileRegion(const DDSTextureLayout& layout, const TiledTextureDesc& desc, const TileCoordinate& tile)
+	{
+		const DXGIFormatTraits& traits = GetFormatTraits(layout.format);
+		const DDSSubresourceLayout& mip = layout.subresources[tile.mip];
+
+		TileRegion region;
+		region.x = tile.x * desc.tileWidth;
+		region.y = tile.y * desc.tileHeight;
+		region.width = std::min<UINT>(desc.tileWidth, mip.width - region.x);
+		region.height = std::min<UINT>(desc.tileHeight, mip.height - region.y);
+		region.elementX = region.x >> traits.log2ElementWidth;
+		region.elementY = region.y >> traits.log2ElementHeight;
+		region.elementsWide = (region.width + (1u << traits.log2ElementWidth) - 1) >> traits.log2ElementWidth;
+		region.elementsHigh = (region.height + (1u << traits.log2ElementHeight) - 1) >> traits.log2ElementHeight;
+		region.rowBytes = region.elementsWide * (traits.bitsPerElement / 8);
+		region.rowPitch = static_cast<UINT>(AlignUp(region.rowBytes, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+		return region;
+	}
+}
+
+TiledTextureStreamer::TiledTextureStreamer(ID3D12Device* device, ID3D12CommandQueue* commandQueue,
+	const wchar_t* fileName, UINT poolTileCount, UploadRingBuffer* uploadRing) :
+	m_device(device),
+	m_commandQueue(commandQueue),
+	m_uploadRing(uploadRing),
+	m_fenceValue(0),
+	m_fenceEvent(nullptr),
+	m_file(INVALID_HANDLE_VALUE),
+	m_fileMapping(nullptr),
+	m_fileView(nullptr),
+	m_packedMipInfo()
+{
+	try
+	{
+		ThrowIfFailed(m_device->CreateFence(m_fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+
+		m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		if (m_fenceEvent == nullptr)
+		{
+			ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+		}
+
+		ComPtr<ID3D12CommandAllocator> allocator = AcquireAllocator();
+		ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+		ThrowIfFailed(m_commandList->Close());
+		m_freeAllocators.push_back(allocator);
+
+		OpenFile(fileName);
+		CreateTexture(poolTileCount);
+		UploadPackedMips();
+	}
+	catch (...)
+	{
+		Close();
+		throw;
+	}
+}
+
+TiledTextureStreamer::~TiledTextureStreamer()
+{
+	Close();
+}
+
+void TiledTextureStreamer::Close()
+{
+	// Nothing is released while the GPU may still read it
+	if (m_fence)
+	{
+		WaitForFence(m_fenceValue);
+		m_inFlight.clear();
+		m_releaseQueue.Collect();
+	}
+
+	if (m_fileView)
+	{
+		UnmapViewOfFile(m_fileView);
+		m_fileView = nullptr;
+	}
+	if (m_fileMapping)
+	{
+		CloseHandle(m_fileMapping);
+		m_fileMapping = nullptr;
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+	if (m_fenceEvent)
+	{
+		CloseHandle(m_fenceEvent);
+		m_fenceEvent = nullptr;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+void TiledTextureStreamer::OpenFile(const wchar_t* fileName)
+{
+	if (!fileName)
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	m_file = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_file, &fileSize))
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	// Tiles are read straight from the view, so the whole file has to fit in it
+	if (static_cast<UINT64>(fileSize.QuadPart) > SIZE_MAX)
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+
+	m_fileMapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_fileMapping)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	m_fileView = static_cast<const uint8_t*>(MapViewOfFile(m_fileMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_fileView)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	const size_t size = static_cast<size_t>(fileSize.QuadPart);
+	if (ParseDDS(m_fileView, size, m_layout) != DDS_PARSE_OK)
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+
+	// One 2D surface whose rows are whole bytes, copied as they are in the file
+	const DXGIFormatTraits& traits = GetFormatTraits(m_layout.format);
+	if (m_layout.dimension != DDS_TEXTURE_DIMENSION_2D || m_layout.arraySize != 1 || m_layout.isCubeMap ||
+		m_layout.conversion != DDS_CONVERSION_NONE || (traits.bitsPerElement % 8) != 0 ||
+		(traits.formatClass != DXGI_FORMAT_CLASS_UNCOMPRESSED && traits.formatClass != DXGI_FORMAT_CLASS_BC))
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+	}
+}
+
+void TiledTextureStreamer::CreateTexture(UINT poolTileCount)
+{
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	if (options.TiledResourcesTier == D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+	}
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = m_layout.width;
+	desc.Height = m_layout.height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = static_cast<UINT16>(m_layout.mipCount);
+	desc.Format = m_layout.format;
+	desc.SampleDesc.Count = 1;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+
+	ThrowIfFailed(m_device->CreateReservedResource(&desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_texture)));
+
+	UINT tileCount = 0;
+	D3D12_TILE_SHAPE tileShape = {};
+	UINT subresourceTilingCount = 1;
+	D3D12_SUBRESOURCE_TILING subresourceTiling = {};
+	m_device->GetResourceTiling(m_texture.Get(), &tileCount, &m_packedMipInfo, &tileShape,
+		&subresourceTilingCount, 0, &subresourceTiling);
+
+	TiledTextureDesc tiledDesc = {};
+	tiledDesc.width = m_layout.width;
+	tiledDesc.height = m_layout.height;
+	tiledDesc.mipCount = m_layout.mipCount;
+	tiledDesc.packedMipStart = m_packedMipInfo.NumStandardMips;
+	tiledDesc.tileWidth = tileShape.WidthInTexels;
+	tiledDesc.tileHeight = tileShape.HeightInTexels;
+	if (!m_pageTable.Initialize(tiledDesc, poolTileCount))
+	{
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = UINT64(poolTileCount) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+	heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+	ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_poolHeap)));
+
+	if (m_packedMipInfo.NumPackedMips)
+	{
+		heapDesc.SizeInBytes = UINT64(m_packedMipInfo.NumTilesForPackedMips) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+		ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_packedHeap)));
+
+		D3D12_TILED_RESOURCE_COORDINATE coordinate = {};
+		coordinate.Subresource = m_packedMipInfo.NumStandardMips;
+
+		D3D12_TILE_REGION_SIZE regionSize = {};
+		regionSize.NumTiles = m_packedMipInfo.NumTilesForPackedMips;
+
+		const UINT heapOffset = 0;
+		m_commandQueue->UpdateTileMappings(m_texture.Get(), 1, &coordinate, &regionSize, m_packedHeap.Get(),
+			1, nullptr, &heapOffset, &regionSize.NumTiles, D3D12_TILE_MAPPING_FLAG_NONE);
+	}
+}
+
+void TiledTextureStreamer::UploadPackedMips()
+{
+	Batch batch = {};
+	batch.allocator = AcquireAllocator();
+	ThrowIfFailed(m_commandList->Reset(batch.allocator.Get(), nullptr));
+
+	ComPtr<ID3D12Resource> uploadHeap;
+	const UINT firstPacked = m_packedMipInfo.NumStandardMips;
+	const UINT packedCount = m_layout.mipCount - firstPacked;
+	if (packedCount)
+	{
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(packedCount);
+		std::vector<UINT> numRows(packedCount);
+		std::vector<UINT64> rowSizes(packedCount);
+		UINT64 totalBytes = 0;
+		const D3D12_RESOURCE_DESC desc = m_texture->GetDesc();
+		m_device->GetCopyableFootprints(&desc, firstPacked, packedCount, 0, footprints.data(), numRows.data(), rowSizes.data(), &totalBytes);
+
+		UploadAllocation allocation;
+		ThrowIfFailed(AcquireUploadSpace(totalBytes, uploadHeap, allocation));
+
+		for (UINT i = 0; i < packedCount; ++i)
+		{
+			const DDSSubresourceLayout& source = m_layout.subresources[firstPacked + i];
+			const uint8_t* src = m_fileView + m_layout.headerSize + source.offset;
+			uint8_t* dst = allocation.cpuAddress + footprints[i].Offset;
+			const size_t rowBytes = static_cast<size_t>(std::min<UINT64>(rowSizes[i], source.rowPitch));
+
+			for (UINT row = 0; row < numRows[i]; ++row)
+			{
+				memcpy(dst + UINT64(row) * footprints[i].Footprint.RowPitch, src + row * source.rowPitch, rowBytes);
+			}
+
+			D3D12_TEXTURE_COPY_LOCATION destination = {};
+			destination.pResource = m_texture.Get();
+			destination.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			destination.SubresourceIndex = firstPacked + i;
+
+			D3D12_TEXTURE_COPY_LOCATION upload = {};
+			upload.pResource = allocation.resource;
+			upload.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			upload.PlacedFootprint = footprints[i];
+			upload.PlacedFootprint.Offset += allocation.offset;
+
+			m_commandList->CopyTextureRegion(&destination, 0, 0, 0, &upload, nullptr);
+		}
+	}
+
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	barrier.Transition.pResource = m_texture.Get();
+	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+	barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	m_commandList->ResourceBarrier(1, &barrier);
+
+	Submit(batch, std::move(uploadHeap));
+}
+
+
+//--------------------------------------------------------------------------------------
+void TiledTextureStreamer::Update(UINT maxTileLoads)
+{
+	Retire(m_fence->GetCompletedValue());
+
+	std::vector<TileMapping> unmappings;
+	std::vector<TileMapping> mappings;
+	m_pageTable.Update(maxTileLoads, unmappings, mappings);
+
+	ApplyMappings(unmappings, mappings);
+	if (mappings.empty())
+		return;
+
+	std::vector<UINT64> offsets(mappings.size());
+	UINT64 totalBytes = 0;
+	for (size_t i = 0; i < mappings.size(); ++i)
+	{
+		offsets[i] = totalBytes;
+		totalBytes = AlignUp(totalBytes + GetTileUploadSize(mappings[i].tile), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	}
+
+	Batch batch = {};
+	batch.allocator = AcquireAllocator();
+	ThrowIfFailed(m_commandList->Reset(batch.allocator.Get(), nullptr));
+
+	ComPtr<ID3D12Resource> uploadHeap;
+	UploadAllocation allocation;
+	ThrowIfFailed(AcquireUploadSpace(totalBytes, uploadHeap, allocation));
+
+	// Only the mips being written leave PIXEL_SHADER_RESOURCE
+	std::vector<UINT> mips;
+	for (const auto& mapping : mappings)
+	{
+		mips.push_back(mapping.tile.mip);
+	}
+	std::sort(mips.begin(), mips.end());
+	mips.erase(std::unique(mips.begin(), mips.end()), mips.end());
+
+	std::vector<D3D12_RESOURCE_BARRIER> barriers(mips.size());
+	for (size_t i = 0; i < mips.size(); ++i)
+	{
+		barriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barriers[i].Transition.pResource = m_texture.Get();
+		barriers[i].Transition.Subresource = mips[i];
+		barriers[i].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+		barriers[i].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+	}
+	m_commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+	for (size_t i = 0; i < mappings.size(); ++i)
+	{
+		CopyTile(mappings[i], allocation, offsets[i]);
+	}
+
+	for (auto& barrier : barriers)
+	{
+		std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+	}
+	m_commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+	batch.mappings.swap(mappings);
+	Submit(batch, std::move(uploadHeap));
+}
+
+void TiledTextureStreamer::Flush()
+{
+	WaitForFence(m_fenceValue);
+	Retire(m_fenceValue);
+}
+
+void TiledTextureStreamer::ApplyMappings(const std::vector<TileMapping>& unmappings, const std::vector<TileMapping>& mappings)
+{
+	std::vector<D3D12_TILED_RESOURCE_COORDINATE> coordinates;
+	std::vector<D3D12_TILE_REGION_SIZE> regionSizes;
+
+	auto gatherRegions = [&](const std::vector<TileMapping>& tiles)
+	{
+		coordinates.resize(tiles.size());
+		regionSizes.resize(tiles.size());
+		for (size_t i = 0; i < tiles.size(); ++i)
+		{
+			coordinates[i].X = tiles[i].tile.x;
+			coordinates[i].Y = tiles[i].tile.y;
+			coordinates[i].Z = 0;
+			coordinates[i].Subresource = tiles[i].tile.mip;
+
+			regionSizes[i] = D3D12_TILE_REGION_SIZE();
+			regionSizes[i].NumTiles = 1;
+		}
+	};
+
+	// Evicted tiles are unbound first, so they never alias the tiles reusing their memory
+	if (!unmappings.empty())
+	{
+		gatherRegions(unmappings);
+
+		const D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NULL;
+		const UINT rangeTileCount = static_cast<UINT>(unmappings.size());
+		m_commandQueue->UpdateTileMappings(m_texture.Get(), rangeTileCount, coordinates.data(), regionSizes.data(),
+			nullptr, 1, &rangeFlags, nullptr, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+	}
+
+	if (!mappings.empty())
+	{
+		gatherRegions(mappings);
+
+		std::vector<UINT> heapOffsets(mappings.size());
+		std::vector<UINT> rangeTileCounts(mappings.size(), 1);
+		for (size_t i = 0; i < mappings.size(); ++i)
+		{
+			heapOffsets[i] = mappings[i].physicalTile;
+		}
+
+		const UINT count = static_cast<UINT>(mappings.size());
+		m_commandQueue->UpdateTileMappings(m_texture.Get(), count, coordinates.data(), regionSizes.data(),
+			m_poolHeap.Get(), count, nullptr, heapOffsets.data(), rangeTileCounts.data(), D3D12_TILE_MAPPING_FLAG_NONE);
+	}
+}
+
+HRESULT TiledTextureStreamer::AcquireUploadSpace(UINT64 size, ComPtr<ID3D12Resource>& uploadHeap, UploadAllocation& allocation)
+{
+	if (m_uploadRing && SUCCEEDED(m_uploadRing->Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, allocation)))
+		return S_OK;
+
+	D3D12_HEAP_PROPERTIES heapProperties = {};
+	heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	desc.Width = size;
+	desc.Height = 1;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.SampleDesc.Count = 1;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	HRESULT hr = m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(uploadHeap.ReleaseAndGetAddressOf()));
+	if (FAILED(hr))
+		return hr;
+
+	// Written only, never read back
+	void* cpuAddress = nullptr;
+	const D3D12_RANGE readRange = { 0, 0 };
+	hr = uploadHeap->Map(0, &readRange, &cpuAddress);
+	if (FAILED(hr))
+		return hr;
+
+	allocation.resource = uploadHeap.Get();
+	allocation.offset = 0;
+	allocation.cpuAddress = static_cast<uint8_t*>(cpuAddress);
+	allocation.gpuAddress = uploadHeap->GetGPUVirtualAddress();
+	return S_OK;
+}
+
+UINT64 TiledTextureStreamer::GetTileUploadSize(const TileCoordinate& tile) const
+{
+	const TileRegion region = GetTileRegion(m_layout, m_pageTable.GetDesc(), tile);
+	return UINT64(region.rowPitch) * region.elementsHigh;
+}
+
+void TiledTextureStreamer::CopyTile(const TileMapping& mapping, const UploadAllocation& allocation, UINT64 offset)
+{
+	const TileRegion region = GetTileRegion(m_layout, m_pageTable.GetDesc(), mapping.tile);
+	const DDSSubresourceLayout& source = m_layout.subresources[mapping.tile.mip];
+	const UINT bytesPerElement = GetFormatTraits(m_layout.format).bitsPerElement / 8;
+
+	const uint8_t* src = m_fileView + m_layout.headerSize + source.offset
+		+ UINT64(region.elementY) * source.rowPitch + UINT64(region.elementX) * bytesPerElement;
+	uint8_t* dst = allocation.cpuAddress + offset;
+	for (UINT row = 0; row < region.elementsHigh; ++row)
+	{
+		memcpy(dst + UINT64(row) * region.rowPitch, src + UINT64(row) * source.rowPitch, region.rowBytes);
+	}
+
+	D3D12_TEXTURE_COPY_LOCATION destination = {};
+	destination.pResource = m_texture.Get();
+	destination.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	destination.SubresourceIndex = mapping.tile.mip;
+
+	const DXGIFormatTraits& traits = GetFormatTraits(m_layout.format);
+
+	D3D12_TEXTURE_COPY_LOCATION upload = {};
+	upload.pResource = allocation.resource;
+	upload.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+	upload.PlacedFootprint.Offset = allocation.offset + offset;
+	upload.PlacedFootprint.Footprint.Format = m_layout.format;
+	upload.PlacedFootprint.Footprint.Width = region.elementsWide << traits.log2ElementWidth;
+	upload.PlacedFootprint.Footprint.Height = region.elementsHigh << traits.log2ElementHeight;
+	upload.PlacedFootprint.Footprint.Depth = 1;
+	upload.PlacedFootprint.Footprint.RowPitch = region.rowPitch;
+
+	// Blocks padding an edge tile out to 4x4 stop at the edge of the mip
+	const D3D12_BOX box = { 0, 0, 0, region.width, region.height, 1 };
+	m_commandList->CopyTextureRegion(&destination, region.x, region.y, 0, &upload, &box);
+}
+
+
+//--------------------------------------------------------------------------------------
+void TiledTextureStreamer::Submit(Batch& batch, ComPtr<ID3D12Resource> uploadHeap)
+{
+	ThrowIfFailed(m_commandList->Close());
+
+	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), ++m_fenceValue));
+
+	if (m_uploadRing)
+	{
+		m_uploadRing->Submit(m_fence.Get(), m_fenceValue);
+	}
+	m_releaseQueue.Enqueue(std::move(uploadHeap), m_fence.Get(), m_fenceValue);
+
+	batch.fenceValue = m_fenceValue;
+	m_inFlight.push_back(std::move(batch));
+}
+
+void TiledTextureStreamer::Retire(UINT64 completedValue)
+{
+	while (!m_inFlight.empty() && m_inFlight.front().fenceValue <= completedValue)
+	{
+		Batch& batch = m_inFlight.front();
+		m_pageTable.CompleteLoads(batch.mappings.data(), batch.mappings.size());
+		m_freeAllocators.push_back(batch.allocator);
+		m_inFlight.pop_front();
+	}
+
+	m_releaseQueue.Collect();
+}
+
+void TiledTextureStreamer::WaitForFence(UINT64 value)
+{
+	if (m_fence->GetCompletedValue() < value)
+	{
+		ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_fenceEvent));
+		WaitForSingleObject(m_fenceEvent, INFINITE);
+	}
+}
+
+ComPtr<ID3D12CommandAllocator> TiledTextureStreamer::AcquireAllocator()
+{
+	ComPtr<ID3D12CommandAllocator> allocator;
+	if (!m_freeAllocators.empty())
+	{
+		// Only batches that have retired give their allocator back
+		allocator = m_freeAllocators.back();
+		m_freeAllocators.pop_back();
+		ThrowIfFailed(allocator->Reset());
+		return allocator;
+	}
+
+	ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+	return allocator;
+}
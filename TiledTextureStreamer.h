@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------
+// File: TiledTextureStreamer.h
+//
+// Streams a large 2D DDS texture through a reserved resource. Only the 64KB tiles that
+// feedback asks for are backed, from a fixed pool heap managed by a TilePageTable; the
+// packed mip tail gets a heap of its own and stays mapped. Tiles are copied straight
+// out of a read-only mapping of the file, so the texture can be far larger than VRAM.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <deque>
+#include <vector>
+
+#include "DDSLayout.h"
+#include "DeferredReleaseQueue.h"
+#include "TilePageTable.h"
+#include "UploadRingBuffer.h"
+
+namespace DirectX
+{
+	class TiledTextureStreamer
+	{
+	public:
+		// fileName is a plain DDS file holding one 2D texture in a format the copy engine
+		// can place in 64KB tiles (uncompressed or BC, no legacy layouts). poolTileCount
+		// 64KB tiles back the paged mips. Uploads are staged through uploadRing when one is
+		// given; it must outlive the streamer. Throws if the device has no tiled resources
+		// support or the file can't be streamed. The packed tail is uploaded and the
+		// texture is left in PIXEL_SHADER_RESOURCE before this returns.
+		TiledTextureStreamer(_In_ ID3D12Device* device, _In_ ID3D12CommandQueue* commandQueue,
+			_In_z_ const wchar_t* fileName, UINT poolTileCount, _In_opt_ UploadRingBuffer* uploadRing = nullptr);
+		~TiledTextureStreamer();
+
+		TiledTextureStreamer(const TiledTextureStreamer&) = delete;
+		TiledTextureStreamer& operator=(const TiledTextureStreamer&) = delete;
+
+		ID3D12Resource* GetTexture() const { return m_texture.Get(); }
+
+		// Feed requests or feedback here between Updates. Its residency map is what the
+		// shader should clamp its level of detail to, as tiles outside it are not mapped.
+		TilePageTable& GetPageTable() { return m_pageTable; }
+		const TilePageTable& GetPageTable() const { return m_pageTable; }
+
+		// Call once per frame from the thread that owns the command queue, before the
+		// frame's command lists are executed. Marks the tiles whose copies have completed as
+		// resident, remaps the pool with UpdateTileMappings for up to maxTileLoads requested
+		// tiles, and submits their copies. The texture is back in PIXEL_SHADER_RESOURCE
+		// by the time anything queued after this call runs.
+		void Update(UINT maxTileLoads = 32);
+
+		// Blocks until every submitted tile copy has completed and retires it.
+		void Flush();
+
+	private:
+		struct Batch
+		{
+			UINT64										fenceValue;
+			std::vector<TileMapping>					mappings;
+			Microsoft::WRL::ComPtr<ID3D12CommandAllocator>	allocator;
+		};
+
+		void OpenFile(_In_z_ const wchar_t* fileName);
+		void Close();
+		void CreateTexture(UINT poolTileCount);
+		void UploadPackedMips();
+		void ApplyMappings(const std::vector<TileMapping>& unmappings, const std::vector<TileMapping>& mappings);
+		HRESULT AcquireUploadSpace(UINT64 size, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadHeap, UploadAllocation& allocation);
+		void CopyTile(const TileMapping& mapping, const UploadAllocation& allocation, UINT64 offset);
+		void WaitForFence(UINT64 value);
+		UINT64 GetTileUploadSize(const TileCoordinate& tile) const;
+		void Submit(Batch& batch, Microsoft::WRL::ComPtr<ID3D12Resource> uploadHeap);
+		void Retire(UINT64 completedValue);
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> AcquireAllocator();
+
+		Microsoft::WRL::ComPtr<ID3D12Device>				m_device;
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue>			m_commandQueue;
+		UploadRingBuffer*									m_uploadRing;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_commandList;
+		Microsoft::WRL::ComPtr<ID3D12Fence>					m_fence;
+		UINT64												m_fenceValue;
+		HANDLE												m_fenceEvent;
+
+		// The source stays mapped for the streamer's lifetime
+		HANDLE												m_file;
+		HANDLE												m_fileMapping;
+		const uint8_t*										m_fileView;
+		DDSTextureLayout									m_layout;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_texture;
+		Microsoft::WRL::ComPtr<ID3D12Heap>					m_poolHeap;
+		Microsoft::WRL::ComPtr<ID3D12Heap>					m_packedHeap;
+		D3D12_PACKED_MIP_INFO								m_packedMipInfo;
+		TilePageTable										m_pageTable;
+
+		std::deque<Batch>									m_inFlight;
+		DeferredReleaseQueue								m_releaseQueue;		// Upload heaps for when the ring had no room
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>	m_freeAllocators;
+	};
+}
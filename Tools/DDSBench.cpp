@@ -0,0 +1,1103 @@
+//--------------------------------------------------------------------------------------
+// File: DDSBench.cpp
+//
+// Benchmarks for the texture loading paths:
+//
+//   DDSBench <benchmark> [arguments]
+//
+// Run without arguments for the list. Each benchmark prints one line per variant it
+// compares. The ones that drive the D3D12 loader create a device (hardware, else WARP)
+// and record into a command list that is reset, never executed, so they time the CPU
+// side of a load only. It is a console program of its own, built from the repo root with
+// e.g.
+//
+//   cl /EHsc /O2 /I. Tools\DDSBench.cpp DDSTextureLoader.cpp BCDecoder.cpp BCEncoder.cpp DDSConvert.cpp
+//      DDSLayout.cpp DDSZ.cpp LZ4.cpp MipGenerator.cpp ResourceStateManager.cpp
+//      ResourceStateTracker.cpp TextureFootprints.cpp ThreadPool.cpp TLSFAllocator.cpp
+//      UploadRingBuffer.cpp d3d12.lib dxgi.lib
+//
+// Elsewhere only the device-independent benchmarks are built, with dxgiformat.h taken
+// from the DirectX-Headers package:
+//
+//   g++ -std=c++14 -O2 -I. -I<DirectX-Headers>/include/directx Tools/DDSBench.cpp
+//       BCDecoder.cpp DDSLayout.cpp DDSZ.cpp LZ4.cpp MipGenerator.cpp ThreadPool.cpp
+//       TLSFAllocator.cpp -pthread
+//--------------------------------------------------------------------------------------
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#include <dxgi1_4.h>
+
+#include "d3dx12.h"
+#include "DDSTextureLoader.h"
+#include "UploadRingBuffer.h"
+
+#pragma comment(lib, "psapi.lib")
+#endif
+
+#include "DXGIFormatTraits.h"
+#include "BCDecoder.h"
+#include "DDS.h"
+#include "DDSBenchBaseline.h"
+#include "DDSZ.h"
+#include "LZ4.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include "TLSFAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	double SecondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Parses "-n <count>" style options; returns false on a bad or missing value
+	bool ParseCount(int& i, int argc, char* argv[], unsigned int& count)
+	{
+		if (i + 1 >= argc)
+			return false;
+
+		const long value = strtol(argv[++i], nullptr, 10);
+		if (value <= 0)
+			return false;
+
+		count = static_cast<unsigned int>(value);
+		return true;
+	}
+
+	// Results are written here so the compiler can't drop the work that produced them
+	volatile uint64_t g_Sink;
+
+	//----------------------------------------------------------------------------------
+	// formats: sizing every subresource of large texture and cube arrays, as FillInitData
+	// does, with the switch-based GetSurfaceInfo the loader used to have against the
+	// traits table
+	//----------------------------------------------------------------------------------
+	template <typename SurfaceInfo>
+	double TimeSubresourceSizing(SurfaceInfo getSurfaceInfo, DXGI_FORMAT format, uint32_t width, uint32_t height,
+		uint32_t arraySize, uint32_t mipCount, unsigned int reps)
+	{
+		// Read back through a volatile so the sizes can't be worked out once for every rep
+		volatile uint32_t formatValue = format;
+
+		const BenchClock::time_point start = BenchClock::now();
+		for (unsigned int rep = 0; rep < reps; ++rep)
+		{
+			const DXGI_FORMAT fmt = static_cast<DXGI_FORMAT>(formatValue);
+			uint64_t total = 0;
+			for (uint32_t j = 0; j < arraySize; ++j)
+			{
+				size_t w = width;
+				size_t h = height;
+				for (uint32_t i = 0; i < mipCount; ++i)
+				{
+					size_t numBytes = 0;
+					size_t rowBytes = 0;
+					size_t numRows = 0;
+					getSurfaceInfo(w, h, fmt, &numBytes, &rowBytes, &numRows);
+					total += numBytes + rowBytes + numRows;
+
+					w = (w > 1) ? (w >> 1) : 1;
+					h = (h > 1) ? (h >> 1) : 1;
+				}
+			}
+			g_Sink = total;
+		}
+
+		return SecondsSince(start);
+	}
+
+	int BenchFormatTraits(int argc, char* argv[])
+	{
+		unsigned int reps = 200;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-n") || !ParseCount(i, argc, argv, reps))
+				return -1;
+		}
+
+		const struct { const char* name; uint32_t width; uint32_t height; uint32_t arraySize; uint32_t mipCount; } shapes[] =
+		{
+			{ "4096^2 x 2048 array",    4096, 4096, 2048, 13 },
+			{ "2048^2 x 341 cube array", 2048, 2048, 341 * 6, 12 },
+		};
+
+		const struct { const char* name; DXGI_FORMAT format; } formats[] =
+		{
+			{ "R8G8B8A8_UNORM",     DXGI_FORMAT_R8G8B8A8_UNORM },
+			{ "R16G16B16A16_FLOAT", DXGI_FORMAT_R16G16B16A16_FLOAT },
+			{ "BC1_UNORM",          DXGI_FORMAT_BC1_UNORM },
+			{ "BC7_UNORM_SRGB",     DXGI_FORMAT_BC7_UNORM_SRGB },
+			{ "NV12",               DXGI_FORMAT_NV12 },
+		};
+
+		printf("%-24s %-20s %12s %12s\n", "texture", "format", "switch ns", "table ns");
+		for (const auto& shape : shapes)
+		{
+			const double subresources = double(shape.arraySize) * shape.mipCount * reps;
+			for (const auto& format : formats)
+			{
+				// Lambdas rather than function pointers, so each is inlined as it is in the loader
+				const double baseline = TimeSubresourceSizing(
+					[](size_t w, size_t h, DXGI_FORMAT fmt, size_t* numBytes, size_t* rowBytes, size_t* numRows)
+					{
+						DDSBenchBaseline::GetSurfaceInfo(w, h, fmt, numBytes, rowBytes, numRows);
+					},
+					format.format, shape.width, shape.height, shape.arraySize, shape.mipCount, reps);
+				const double table = TimeSubresourceSizing(
+					[](size_t w, size_t h, DXGI_FORMAT fmt, size_t* numBytes, size_t* rowBytes, size_t* numRows)
+					{
+						GetFormatSurfaceInfo(w, h, fmt, numBytes, rowBytes, numRows);
+					},
+					format.format, shape.width, shape.height, shape.arraySize, shape.mipCount, reps);
+
+				printf("%-24s %-20s %12.2f %12.2f\n", shape.name, format.name,
+					1e9 * baseline / subresources, 1e9 * table / subresources);
+			}
+		}
+
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// srgb: DownsampleBox on an _SRGB level, whose conversions go through lookup tables,
+	// against the same filter converting every channel with powf. The plain UNORM filter
+	// is timed too, for the cost of the linear-space averaging itself, and the powf
+	// result is compared with the tables' to show how far they stray.
+	//----------------------------------------------------------------------------------
+	float SRGBToLinearPowf(uint8_t value)
+	{
+		const float c = value / 255.0f;
+		return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	uint8_t LinearToSRGBPowf(float value)
+	{
+		const float c = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::min(std::max(c * 255.0f + 0.5f, 0.0f), 255.0f));
+	}
+
+	// Even sizes only, which is all the benchmark uses
+	void DownsampleSRGBPowf(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dest)
+	{
+		const size_t srcRowPitch = size_t(width) * 4;
+		const size_t destRowPitch = srcRowPitch / 2;
+		for (uint32_t y = 0; y < height / 2; ++y)
+		{
+			const uint8_t* row0 = src + srcRowPitch * (2 * y);
+			const uint8_t* row1 = row0 + srcRowPitch;
+			uint8_t* out = dest + destRowPitch * y;
+			for (uint32_t x = 0; x < width / 2; ++x, out += 4)
+			{
+				const uint8_t* p[4] = { row0 + x * 8, row0 + x * 8 + 4, row1 + x * 8, row1 + x * 8 + 4 };
+				for (int c = 0; c < 3; ++c)
+				{
+					const float sum = SRGBToLinearPowf(p[0][c]) + SRGBToLinearPowf(p[1][c])
+						+ SRGBToLinearPowf(p[2][c]) + SRGBToLinearPowf(p[3][c]);
+					out[c] = LinearToSRGBPowf(sum * 0.25f);
+				}
+				out[3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) >> 2);
+			}
+		}
+	}
+
+	int BenchSRGBMips(int argc, char* argv[])
+	{
+		unsigned int reps = 10;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-n") || !ParseCount(i, argc, argv, reps))
+				return -1;
+		}
+
+		const uint32_t width = 4096;
+		const uint32_t height = 4096;
+		const size_t rowPitch = size_t(width) * 4;
+
+		// Noise, so no table entry or branch is favoured
+		std::vector<uint8_t> src(rowPitch * height);
+		uint32_t seed = 12345;
+		for (auto& value : src)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			value = static_cast<uint8_t>(seed >> 24);
+		}
+
+		std::vector<uint8_t> tableResult(src.size() / 4);
+		std::vector<uint8_t> powfResult(src.size() / 4);
+
+		const struct { const char* name; int kind; } variants[] =
+		{
+			{ "UNORM box filter",   0 },
+			{ "SRGB lookup tables", 1 },
+			{ "SRGB powf",          2 },
+		};
+
+		for (const auto& variant : variants)
+		{
+			double seconds = 0.0;
+			for (unsigned int rep = 0; rep <= reps; ++rep)
+			{
+				const BenchClock::time_point start = BenchClock::now();
+				switch (variant.kind)
+				{
+				case 0:
+					DownsampleBox(DXGI_FORMAT_R8G8B8A8_UNORM, src.data(), rowPitch, width, height, tableResult.data(), rowPitch / 2);
+					break;
+				case 1:
+					DownsampleBox(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, src.data(), rowPitch, width, height, tableResult.data(), rowPitch / 2);
+					break;
+				default:
+					DownsampleSRGBPowf(src.data(), width, height, powfResult.data());
+					break;
+				}
+
+				// The first rep builds the decode table and warms the caches
+				if (rep)
+				{
+					seconds += SecondsSince(start);
+				}
+			}
+
+			seconds /= reps;
+			printf("%-20s %8.2f ms %8.1f MP/s\n", variant.name, 1000.0 * seconds, double(width) * height / seconds / 1.0e6);
+		}
+
+		// tableResult holds the SRGB lookup result, the last DownsampleBox to run
+		size_t differing = 0;
+		int maxDifference = 0;
+		for (size_t i = 0; i < tableResult.size(); ++i)
+		{
+			const int difference = abs(int(tableResult[i]) - int(powfResult[i]));
+			differing += difference ? 1 : 0;
+			maxDifference = std::max(maxDifference, difference);
+		}
+
+		printf("lookup vs powf: %zu of %zu bytes differ, by at most %d\n", differing, tableResult.size(), maxDifference);
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// bc: DecodeBC megapixels per second for each format, to RGBA8 and to RGBA16F, on
+	// the calling thread and across a pool of every hardware thread. The blocks are
+	// random, which every BC1-BC5 block decodes from; BC7 blocks have their mode bits
+	// set so the eight modes come up equally often.
+	//----------------------------------------------------------------------------------
+	int BenchBCDecode(int argc, char* argv[])
+	{
+		unsigned int reps = 5;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-n") || !ParseCount(i, argc, argv, reps))
+				return -1;
+		}
+
+		const uint32_t width = 2048;
+		const uint32_t height = 2048;
+		const size_t blocks = size_t(width / 4) * (height / 4);
+
+		const struct { const char* name; DXGI_FORMAT format; size_t blockSize; } formats[] =
+		{
+			{ "BC1_UNORM",      DXGI_FORMAT_BC1_UNORM,      8 },
+			{ "BC2_UNORM",      DXGI_FORMAT_BC2_UNORM,      16 },
+			{ "BC3_UNORM",      DXGI_FORMAT_BC3_UNORM,      16 },
+			{ "BC4_UNORM",      DXGI_FORMAT_BC4_UNORM,      8 },
+			{ "BC5_SNORM",      DXGI_FORMAT_BC5_SNORM,      16 },
+			{ "BC7_UNORM",      DXGI_FORMAT_BC7_UNORM,      16 },
+			{ "BC7_UNORM_SRGB", DXGI_FORMAT_BC7_UNORM_SRGB, 16 },
+		};
+
+		const struct { const char* name; DXGI_FORMAT format; DXGI_FORMAT snormFormat; size_t pixelSize; } targets[] =
+		{
+			{ "RGBA8",   DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_SNORM,     4 },
+			{ "RGBA16F", DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, 8 },
+		};
+
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		if (!hardwareThreads)
+		{
+			hardwareThreads = 1;
+		}
+		ThreadPool pool(hardwareThreads - 1);
+
+		std::vector<uint8_t> src(blocks * 16);
+		std::vector<uint8_t> dest(size_t(width) * height * 8);
+
+		for (const auto& format : formats)
+		{
+			uint32_t seed = 12345;
+			for (auto& value : src)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				value = static_cast<uint8_t>(seed >> 24);
+			}
+
+			if (format.format == DXGI_FORMAT_BC7_UNORM || format.format == DXGI_FORMAT_BC7_UNORM_SRGB)
+			{
+				for (size_t i = 0; i < blocks; ++i)
+				{
+					// The mode is the number of zero bits below the lowest set one
+					const unsigned int mode = static_cast<unsigned int>(i % 8);
+					src[i * 16] = static_cast<uint8_t>((src[i * 16] & ~((2u << mode) - 1)) | (1u << mode));
+				}
+			}
+
+			const size_t srcRowPitch = (width / 4) * format.blockSize;
+			const bool snorm = (format.format == DXGI_FORMAT_BC5_SNORM);
+
+			for (const auto& target : targets)
+			{
+				const DXGI_FORMAT destFormat = snorm ? target.snormFormat : target.format;
+				const size_t destRowPitch = width * target.pixelSize;
+
+				for (unsigned int pass = 0; pass < ((hardwareThreads > 1) ? 2u : 1u); ++pass)
+				{
+					const unsigned int threads = pass ? hardwareThreads : 1;
+					ThreadPool* decodePool = pass ? &pool : nullptr;
+
+					double seconds = 0.0;
+					for (unsigned int rep = 0; rep <= reps; ++rep)
+					{
+						const BenchClock::time_point start = BenchClock::now();
+						if (!DecodeBC(format.format, src.data(), srcRowPitch, width, height, destFormat, dest.data(), destRowPitch, decodePool))
+						{
+							fprintf(stderr, "DDSBench: can't decode %s to %s\n", format.name, target.name);
+							return 1;
+						}
+
+						if (rep)
+						{
+							seconds += SecondsSince(start);
+						}
+					}
+
+					seconds /= reps;
+					printf("%-16s -> %-8s %2u thread%s %8.1f MP/s\n", format.name, target.name, threads, (threads > 1) ? "s" : " ",
+						double(width) * height / seconds / 1.0e6);
+				}
+			}
+		}
+
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// lz4: LZ4 block throughput over DDSZ-sized chunks, then PackDDSZ and ExpandDDSZ on
+	// the calling thread and across a pool of every hardware thread. Without a file the
+	// data is a synthetic 4096^2 RGBA8 image, smooth gradients with a little noise, packed
+	// as a DDS file of its own. Rates are of the unpacked bytes.
+	//----------------------------------------------------------------------------------
+	bool ReadWholeFile(const char* fileName, std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(fileName, "rb");
+		if (!file)
+			return false;
+
+		bool success = !fseek(file, 0, SEEK_END);
+		const long size = success ? ftell(file) : -1;
+		success = success && size > 0 && !fseek(file, 0, SEEK_SET);
+		if (success)
+		{
+			data.resize(static_cast<size_t>(size));
+			success = fread(data.data(), 1, data.size(), file) == data.size();
+		}
+
+		fclose(file);
+		return success;
+	}
+
+	void MakeSyntheticDDS(uint32_t width, uint32_t height, std::vector<uint8_t>& data)
+	{
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_HEADER_FLAGS_TEXTURE;
+		header.height = height;
+		header.width = width;
+		header.mipMapCount = 1;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+		DDS_HEADER_DXT10 extension = {};
+		extension.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+		extension.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		extension.arraySize = 1;
+
+		const size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+		data.resize(headerSize + size_t(width) * height * 4);
+		memcpy(data.data(), &DDS_MAGIC, sizeof(uint32_t));
+		memcpy(data.data() + sizeof(uint32_t), &header, sizeof(header));
+		memcpy(data.data() + sizeof(uint32_t) + sizeof(DDS_HEADER), &extension, sizeof(extension));
+
+		uint8_t* pixels = data.data() + headerSize;
+		uint32_t seed = 12345;
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x, pixels += 4)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				const uint32_t noise = (seed >> 28) & 3;
+				pixels[0] = static_cast<uint8_t>(x / 16 + noise);
+				pixels[1] = static_cast<uint8_t>(y / 16 + noise);
+				pixels[2] = static_cast<uint8_t>((x + y) / 32);
+				pixels[3] = 255;
+			}
+		}
+	}
+
+	int BenchLZ4(int argc, char* argv[])
+	{
+		const char* inputName = nullptr;
+		unsigned int reps = 5;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (!strcmp(argv[i], "-n"))
+			{
+				if (!ParseCount(i, argc, argv, reps))
+					return -1;
+			}
+			else if (!inputName)
+			{
+				inputName = argv[i];
+			}
+			else
+			{
+				return -1;
+			}
+		}
+
+		std::vector<uint8_t> ddsData;
+		if (inputName)
+		{
+			if (!ReadWholeFile(inputName, ddsData))
+			{
+				fprintf(stderr, "DDSBench: can't read %s\n", inputName);
+				return 1;
+			}
+		}
+		else
+		{
+			MakeSyntheticDDS(4096, 4096, ddsData);
+		}
+
+		const double megabytes = ddsData.size() / (1024.0 * 1024.0);
+		const size_t chunkSize = DDSZ_DEFAULT_CHUNK_SIZE;
+		const size_t chunkCount = (ddsData.size() + chunkSize - 1) / chunkSize;
+
+		std::vector<uint8_t> packed(chunkCount * LZ4CompressBound(chunkSize));
+		std::vector<size_t> packedSizes(chunkCount);
+		std::vector<uint8_t> unpacked(ddsData.size());
+
+		double compressSeconds = 0.0;
+		double decompressSeconds = 0.0;
+		for (unsigned int rep = 0; rep <= reps; ++rep)
+		{
+			BenchClock::time_point start = BenchClock::now();
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				const size_t size = std::min(chunkSize, ddsData.size() - i * chunkSize);
+				packedSizes[i] = LZ4CompressBlock(ddsData.data() + i * chunkSize, size,
+					packed.data() + i * LZ4CompressBound(chunkSize), LZ4CompressBound(chunkSize));
+			}
+			if (rep)
+			{
+				compressSeconds += SecondsSince(start);
+			}
+
+			start = BenchClock::now();
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				const size_t size = std::min(chunkSize, ddsData.size() - i * chunkSize);
+				if (!LZ4DecompressBlock(packed.data() + i * LZ4CompressBound(chunkSize), packedSizes[i],
+					unpacked.data() + i * chunkSize, size))
+				{
+					fprintf(stderr, "DDSBench: LZ4 round trip failed\n");
+					return 1;
+				}
+			}
+			if (rep)
+			{
+				decompressSeconds += SecondsSince(start);
+			}
+		}
+
+		size_t packedTotal = 0;
+		for (size_t size : packedSizes)
+		{
+			packedTotal += size;
+		}
+
+		printf("%s, %.1f MB, LZ4 ratio %.3f\n", inputName ? inputName : "synthetic 4096^2 R8G8B8A8", megabytes,
+			double(packedTotal) / ddsData.size());
+		printf("  LZ4 blocks     compress %8.1f MB/s  decompress %8.1f MB/s\n",
+			megabytes * reps / compressSeconds, megabytes * reps / decompressSeconds);
+
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		if (!hardwareThreads)
+		{
+			hardwareThreads = 1;
+		}
+		ThreadPool pool(hardwareThreads - 1);
+
+		for (unsigned int pass = 0; pass < ((hardwareThreads > 1) ? 2u : 1u); ++pass)
+		{
+			ThreadPool* packPool = pass ? &pool : nullptr;
+
+			double packSeconds = 0.0;
+			double expandSeconds = 0.0;
+			for (unsigned int rep = 0; rep <= reps; ++rep)
+			{
+				std::vector<uint8_t> ddszData;
+				BenchClock::time_point start = BenchClock::now();
+				if (PackDDSZ(ddsData.data(), ddsData.size(), ddszData, DDSZ_CODEC_LZ4, chunkSize, packPool) != DDS_PARSE_OK)
+				{
+					fprintf(stderr, "DDSBench: can't pack %s as DDSZ\n", inputName ? inputName : "the synthetic image");
+					return 1;
+				}
+				if (rep)
+				{
+					packSeconds += SecondsSince(start);
+				}
+
+				std::unique_ptr<uint8_t[]> expanded;
+				size_t expandedSize = 0;
+				start = BenchClock::now();
+				if (ExpandDDSZ(ddszData.data(), ddszData.size(), expanded, expandedSize, packPool) != DDS_PARSE_OK)
+				{
+					fprintf(stderr, "DDSBench: can't expand the DDSZ file\n");
+					return 1;
+				}
+				if (rep)
+				{
+					expandSeconds += SecondsSince(start);
+				}
+			}
+
+			const unsigned int threads = pass ? hardwareThreads : 1;
+			printf("  DDSZ %2u thread%s PackDDSZ %8.1f MB/s  ExpandDDSZ %8.1f MB/s\n", threads, pass ? "s" : " ",
+				megabytes * reps / packSeconds, megabytes * reps / expandSeconds);
+		}
+
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// tlsf: TLSFAllocator Allocate/Free pairs per second with a steady number of live
+	// allocations, placed-resource sized and aligned to 4 KB or 64 KB, against a first-fit
+	// free list sorted by offset as GeometryHeap keeps. Each pair frees a random live
+	// allocation and allocates a new one in its place.
+	//----------------------------------------------------------------------------------
+	class FirstFitList
+	{
+	public:
+		explicit FirstFitList(uint64_t size) { m_free[0] = size; }
+
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+		{
+			for (auto it = m_free.begin(); it != m_free.end(); ++it)
+			{
+				const uint64_t aligned = (it->first + alignment - 1) & ~(alignment - 1);
+				if (aligned + size > it->first + it->second)
+					continue;
+
+				const uint64_t blockOffset = it->first;
+				const uint64_t blockEnd = it->first + it->second;
+				m_free.erase(it);
+				if (aligned > blockOffset)
+					m_free[blockOffset] = aligned - blockOffset;
+				if (aligned + size < blockEnd)
+					m_free[aligned + size] = blockEnd - aligned - size;
+
+				offset = aligned;
+				return true;
+			}
+			return false;
+		}
+
+		void Free(uint64_t offset, uint64_t size)
+		{
+			auto it = m_free.emplace(offset, size).first;
+
+			auto next = std::next(it);
+			if (next != m_free.end() && it->first + it->second == next->first)
+			{
+				it->second += next->second;
+				m_free.erase(next);
+			}
+			if (it != m_free.begin())
+			{
+				auto prev = std::prev(it);
+				if (prev->first + prev->second == it->first)
+				{
+					prev->second += it->second;
+					m_free.erase(it);
+				}
+			}
+		}
+
+	private:
+		std::map<uint64_t, uint64_t> m_free;	// Offset to size
+	};
+
+	struct BenchAllocation
+	{
+		uint64_t	size;
+		uint64_t	alignment;
+		uint64_t	offset;
+		uint32_t	handle;
+	};
+
+	template <typename Allocator>
+	double TimeAllocatorChurn(Allocator& allocator, std::vector<BenchAllocation>& live,
+		const std::vector<BenchAllocation>& requests, const std::vector<uint32_t>& victims, size_t& failures)
+	{
+		failures = 0;
+		const BenchClock::time_point start = BenchClock::now();
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			BenchAllocation& slot = live[victims[i]];
+			if (slot.size)
+			{
+				allocator.Free(slot);
+			}
+
+			slot = requests[i];
+			if (!allocator.Allocate(slot))
+			{
+				slot.size = 0;
+				++failures;
+			}
+		}
+		return SecondsSince(start);
+	}
+
+	struct TLSFBench
+	{
+		TLSFAllocator	allocator;
+
+		explicit TLSFBench(uint64_t size) : allocator(size) {}
+		bool Allocate(BenchAllocation& a) { a.handle = allocator.Allocate(a.size, a.alignment, a.offset); return a.handle != 0; }
+		void Free(const BenchAllocation& a) { allocator.Free(a.handle); }
+	};
+
+	struct FirstFitBench
+	{
+		FirstFitList	allocator;
+
+		explicit FirstFitBench(uint64_t size) : allocator(size) {}
+		bool Allocate(BenchAllocation& a) { return allocator.Allocate(a.size, a.alignment, a.offset); }
+		void Free(const BenchAllocation& a) { allocator.Free(a.offset, a.size); }
+	};
+
+	int BenchTLSF(int argc, char* argv[])
+	{
+		unsigned int reps = 200000;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-n") || !ParseCount(i, argc, argv, reps))
+				return -1;
+		}
+
+		// 4 KB to 4 MB, mostly small; buffers and small textures 4 KB aligned, the rest 64 KB
+		uint32_t seed = 12345;
+		auto random = [&seed](uint32_t range)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) % range;
+		};
+		auto randomRequest = [&random]()
+		{
+			BenchAllocation request = {};
+			request.size = uint64_t(4096) << (random(4) ? random(6) : 6 + random(5));
+			request.alignment = (request.size <= 65536 && random(2)) ? 4096 : 65536;
+			return request;
+		};
+
+		const uint64_t heapSize = uint64_t(16) * 1024 * 1024 * 1024;
+		const uint32_t liveCounts[] = { 256, 4096, 16384 };
+		for (uint32_t liveCount : liveCounts)
+		{
+			std::vector<BenchAllocation> requests(reps);
+			std::vector<uint32_t> victims(reps);
+			for (unsigned int i = 0; i < reps; ++i)
+			{
+				requests[i] = randomRequest();
+				victims[i] = random(liveCount);
+			}
+
+			// Both start from the same heap, filled to liveCount allocations in order
+			std::vector<BenchAllocation> fill(liveCount);
+			for (auto& request : fill)
+			{
+				request = randomRequest();
+			}
+
+			TLSFBench tlsf(heapSize);
+			FirstFitBench firstFit(heapSize);
+			std::vector<BenchAllocation> tlsfLive = fill;
+			std::vector<BenchAllocation> firstFitLive = fill;
+			for (uint32_t i = 0; i < liveCount; ++i)
+			{
+				tlsf.Allocate(tlsfLive[i]);
+				firstFit.Allocate(firstFitLive[i]);
+			}
+
+			size_t tlsfFailures = 0;
+			size_t firstFitFailures = 0;
+			const double tlsfSeconds = TimeAllocatorChurn(tlsf, tlsfLive, requests, victims, tlsfFailures);
+			const double firstFitSeconds = TimeAllocatorChurn(firstFit, firstFitLive, requests, victims, firstFitFailures);
+
+			const TLSFStatistics stats = tlsf.allocator.GetStatistics();
+			printf("%5u live  TLSF %8.2f M allocs/s  first-fit list %8.2f M allocs/s  %6.1fx  (%u free blocks, %zu/%zu failed)\n",
+				liveCount, reps / tlsfSeconds / 1.0e6, reps / firstFitSeconds / 1.0e6, firstFitSeconds / tlsfSeconds,
+				stats.freeBlocks, tlsfFailures, firstFitFailures);
+		}
+
+		return 0;
+	}
+
+#if defined(_WIN32)
+	using Microsoft::WRL::ComPtr;
+
+	// Device and a command list to record into; the list is reset after every load, never
+	// executed
+	struct BenchDevice
+	{
+		ComPtr<ID3D12Device>				device;
+		ComPtr<ID3D12CommandAllocator>		allocator;
+		ComPtr<ID3D12GraphicsCommandList>	cmdList;
+
+		bool Create()
+		{
+			if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+			{
+				ComPtr<IDXGIFactory4> factory;
+				ComPtr<IDXGIAdapter> warpAdapter;
+				if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))) ||
+					FAILED(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter))) ||
+					FAILED(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+				{
+					return false;
+				}
+			}
+
+			return SUCCEEDED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))
+				&& SUCCEEDED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&cmdList)));
+		}
+
+		void ResetList()
+		{
+			cmdList->Close();
+			allocator->Reset();
+			cmdList->Reset(allocator.Get(), nullptr);
+		}
+	};
+
+	std::wstring Widen(const char* text)
+	{
+		const int length = MultiByteToWideChar(CP_ACP, 0, text, -1, nullptr, 0);
+		std::wstring wide(length > 0 ? length : 1, L'\0');
+		MultiByteToWideChar(CP_ACP, 0, text, -1, &wide[0], length);
+		wide.resize(wcslen(wide.c_str()));
+		return wide;
+	}
+
+	uint64_t QueryFileSize(const wchar_t* fileName)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &attributes))
+			return 0;
+
+		return (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	}
+
+	//----------------------------------------------------------------------------------
+	// mmap: CreateDDSTextureFromFile12 reading the file into a heap copy against
+	// DDS_LOADER_MEMORY_MAPPED. The process peaks are only meaningful when a single mode
+	// runs, so they are printed then.
+	//----------------------------------------------------------------------------------
+	int BenchMappedLoad(int argc, char* argv[])
+	{
+		const char* inputName = nullptr;
+		unsigned int loads = 20;
+		bool runRead = true;
+		bool runMapped = true;
+
+		for (int i = 0; i < argc; ++i)
+		{
+			if (!strcmp(argv[i], "-n"))
+			{
+				if (!ParseCount(i, argc, argv, loads))
+					return -1;
+			}
+			else if (!strcmp(argv[i], "read"))
+			{
+				runMapped = false;
+			}
+			else if (!strcmp(argv[i], "mapped"))
+			{
+				runRead = false;
+			}
+			else if (!inputName)
+			{
+				inputName = argv[i];
+			}
+			else
+			{
+				return -1;
+			}
+		}
+
+		if (!inputName || (!runRead && !runMapped))
+			return -1;
+
+		const std::wstring fileName = Widen(inputName);
+		const uint64_t fileSize = QueryFileSize(fileName.c_str());
+
+		BenchDevice bench;
+		if (!bench.Create())
+		{
+			fprintf(stderr, "DDSBench: can't create a D3D12 device\n");
+			return 1;
+		}
+
+		const struct { const char* name; DDS_LOADER_FLAGS flags; bool run; } modes[] =
+		{
+			{ "read",   DDS_LOADER_DEFAULT,         runRead },
+			{ "mapped", DDS_LOADER_MEMORY_MAPPED,   runMapped },
+		};
+
+		for (const auto& mode : modes)
+		{
+			if (!mode.run)
+				continue;
+
+			// One untimed load so both modes start with the file in the system cache
+			double seconds = 0.0;
+			for (unsigned int i = 0; i <= loads; ++i)
+			{
+				ComPtr<ID3D12Resource> texture;
+				ComPtr<ID3D12Resource> uploadHeap;
+
+				const BenchClock::time_point start = BenchClock::now();
+				const HRESULT hr = CreateDDSTextureFromFile12(bench.device.Get(), bench.cmdList.Get(), fileName.c_str(),
+					texture, uploadHeap, 0, mode.flags);
+				if (i)
+				{
+					seconds += SecondsSince(start);
+				}
+
+				bench.ResetList();
+				if (FAILED(hr))
+				{
+					fprintf(stderr, "DDSBench: %s: load failed (%08X)\n", inputName, static_cast<unsigned int>(hr));
+					return 1;
+				}
+			}
+
+			printf("%-8s %8.3f ms/load %10.1f MB/s\n", mode.name, 1000.0 * seconds / loads,
+				seconds > 0.0 ? fileSize * double(loads) / seconds / (1024.0 * 1024.0) : 0.0);
+		}
+
+		if (runRead != runMapped)
+		{
+			PROCESS_MEMORY_COUNTERS counters = {};
+			counters.cb = sizeof(counters);
+			if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			{
+				printf("peak working set %.1f MB, peak commit %.1f MB\n",
+					counters.PeakWorkingSetSize / (1024.0 * 1024.0), counters.PeakPagefileUsage / (1024.0 * 1024.0));
+			}
+		}
+
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	// copy: UploadTextureBatch12 filling the upload footprint for an 8K texture and a
+	// texture array, on the calling thread alone and then with pools of 1..N workers. The
+	// upload space comes from a ring whose fence is signalled from the CPU, so the timings
+	// are the copy and the recording, not upload heap creation.
+	//----------------------------------------------------------------------------------
+	int BenchParallelCopy(int argc, char* argv[])
+	{
+		unsigned int reps = 5;
+		for (int i = 0; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-n") || !ParseCount(i, argc, argv, reps))
+				return -1;
+		}
+
+		BenchDevice bench;
+		ComPtr<ID3D12Fence> fence;
+		if (!bench.Create() || FAILED(bench.device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence))))
+		{
+			fprintf(stderr, "DDSBench: can't create a D3D12 device\n");
+			return 1;
+		}
+		UINT64 fenceValue = 0;
+
+		const struct { const char* name; UINT width; UINT height; UINT16 arraySize; } shapes[] =
+		{
+			{ "8192^2 R8G8B8A8",            8192, 8192, 1 },
+			{ "2048^2 x 16 array R8G8B8A8", 2048, 2048, 16 },
+		};
+
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		if (!hardwareThreads)
+		{
+			hardwareThreads = 1;
+		}
+
+		for (const auto& shape : shapes)
+		{
+			const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, shape.width, shape.height, shape.arraySize, 1);
+			const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+
+			ComPtr<ID3D12Resource> texture;
+			if (FAILED(bench.device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &desc,
+				D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&texture))))
+			{
+				fprintf(stderr, "DDSBench: can't create the %s texture\n", shape.name);
+				return 1;
+			}
+
+			// Room for one batch wherever the previous one ended
+			const UINT64 uploadBytes = GetRequiredIntermediateSize(texture.Get(), 0, shape.arraySize);
+			UploadRingBuffer ring(bench.device.Get(), 2 * uploadBytes + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+			const size_t rowPitch = size_t(shape.width) * 4;
+			const size_t slicePitch = rowPitch * shape.height;
+			std::vector<uint8_t> pixels(slicePitch * shape.arraySize, 0x5A);
+			std::vector<D3D12_SUBRESOURCE_DATA> subresources(shape.arraySize);
+			for (UINT16 i = 0; i < shape.arraySize; ++i)
+			{
+				subresources[i].pData = pixels.data() + slicePitch * i;
+				subresources[i].RowPitch = static_cast<LONG_PTR>(rowPitch);
+				subresources[i].SlicePitch = static_cast<LONG_PTR>(slicePitch);
+			}
+
+			TextureUpload12 upload = {};
+			upload.texture = texture.Get();
+			upload.subresources = subresources.data();
+			upload.numSubresources = shape.arraySize;
+
+			printf("%s, %.0f MB\n", shape.name, pixels.size() / (1024.0 * 1024.0));
+
+			// 0 workers is the copy on the calling thread, without a pool
+			double singleThreaded = 0.0;
+			for (unsigned int workers = 0; workers < hardwareThreads; workers = workers ? workers * 2 : 1)
+			{
+				std::unique_ptr<ThreadPool> pool(workers ? new ThreadPool(workers) : nullptr);
+
+				// One untimed upload to fault in the ring and the source pixels
+				double seconds = 0.0;
+				for (unsigned int rep = 0; rep <= reps; ++rep)
+				{
+					ComPtr<ID3D12Resource> uploadHeap;
+
+					const BenchClock::time_point start = BenchClock::now();
+					const HRESULT hr = UploadTextureBatch12(bench.device.Get(), bench.cmdList.Get(), &upload, 1, uploadHeap, &ring, pool.get());
+					if (rep)
+					{
+						seconds += SecondsSince(start);
+					}
+
+					ring.Submit(fence.Get(), ++fenceValue);
+					fence->Signal(fenceValue);
+					bench.ResetList();
+					if (FAILED(hr))
+					{
+						fprintf(stderr, "DDSBench: upload failed (%08X)\n", static_cast<unsigned int>(hr));
+						return 1;
+					}
+				}
+
+				seconds /= reps;
+				if (!workers)
+				{
+					singleThreaded = seconds;
+				}
+
+				printf("  %2u thread%s %8.2f ms %7.2f GB/s %5.2fx\n", workers + 1, workers ? "s" : " ", 1000.0 * seconds,
+					pixels.size() / seconds / (1024.0 * 1024.0 * 1024.0), singleThreaded / seconds);
+			}
+		}
+
+		return 0;
+	}
+#endif
+
+	struct Benchmark
+	{
+		const char*	name;
+		const char*	arguments;
+		int			(*run)(int argc, char* argv[]);		// -1 for a usage error
+	};
+
+	const Benchmark g_Benchmarks[] =
+	{
+#if defined(_WIN32)
+		{ "mmap",       "<file.dds> [read|mapped] [-n <loads>]",    BenchMappedLoad },
+		{ "copy",       "[-n <reps>]",                              BenchParallelCopy },
+#endif
+		{ "formats",    "[-n <reps>]",                              BenchFormatTraits },
+		{ "srgb",       "[-n <reps>]",                              BenchSRGBMips },
+		{ "bc",         "[-n <reps>]",                              BenchBCDecode },
+		{ "lz4",        "[<file.dds>] [-n <reps>]",                 BenchLZ4 },
+		{ "tlsf",       "[-n <pairs>]",                             BenchTLSF },
+	};
+
+	int Usage()
+	{
+		fprintf(stderr, "usage: DDSBench <benchmark> [arguments]\n");
+		for (const auto& benchmark : g_Benchmarks)
+		{
+			fprintf(stderr, "  %-10s %s\n", benchmark.name, benchmark.arguments);
+		}
+		return 1;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+		return Usage();
+
+	for (const auto& benchmark : g_Benchmarks)
+	{
+		if (!strcmp(argv[1], benchmark.name))
+		{
+			const int result = benchmark.run(argc - 2, argv + 2);
+			if (result < 0)
+			{
+				fprintf(stderr, "usage: DDSBench %s %s\n", benchmark.name, benchmark.arguments);
+				return 1;
+			}
+			return result;
+		}
+	}
+
+	return Usage();
+}
@@ -0,0 +1,153 @@
+//--------------------------------------------------------------------------------------
+// File: DDSZPack.cpp
+//
+// Command-line packer for DDSZ files (see DDSZ.h):
+//
+//   DDSZPack [-c <chunk KB>] [-s] <input.dds> [output]
+//
+// -c sets the chunk size (default 256 KB); -s stores the chunks uncompressed. The output
+// defaults to the input name with its extension replaced by .ddsz. It is a console
+// program of its own, built from the repo root with e.g.
+//
+//   cl /EHsc /O2 /I. Tools\DDSZPack.cpp DDSZ.cpp LZ4.cpp DDSLayout.cpp ThreadPool.cpp
+//--------------------------------------------------------------------------------------
+
+#include "DDSZ.h"
+#include "ThreadPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	bool ReadWholeFile(const char* fileName, std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(fileName, "rb");
+		if (!file)
+			return false;
+
+		bool ok = fseek(file, 0, SEEK_END) == 0;
+		const long size = ok ? ftell(file) : -1;
+		ok = ok && size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+		if (ok)
+		{
+			data.resize(static_cast<size_t>(size));
+			ok = fread(data.data(), 1, data.size(), file) == data.size();
+		}
+
+		fclose(file);
+		return ok;
+	}
+
+	bool WriteWholeFile(const char* fileName, const std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(fileName, "wb");
+		if (!file)
+			return false;
+
+		const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+		return (fclose(file) == 0) && ok;
+	}
+
+	const char* GetStatusText(DDS_PARSE_STATUS status)
+	{
+		switch (status)
+		{
+		case DDS_PARSE_INVALID_ARG:     return "invalid argument";
+		case DDS_PARSE_NOT_DDS:         return "not a DDS file";
+		case DDS_PARSE_INVALID_DATA:    return "inconsistent DDS headers";
+		case DDS_PARSE_NOT_SUPPORTED:   return "unsupported DDS layout";
+		case DDS_PARSE_END_OF_FILE:     return "file shorter than its headers describe";
+		case DDS_PARSE_OUT_OF_MEMORY:   return "out of memory";
+		default:                        return "unknown error";
+		}
+	}
+
+	int Usage()
+	{
+		fprintf(stderr, "usage: DDSZPack [-c <chunk KB>] [-s] <input.dds> [output]\n");
+		return 1;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	size_t chunkSize = DDSZ_DEFAULT_CHUNK_SIZE;
+	DDSZ_CODEC codec = DDSZ_CODEC_LZ4;
+	const char* inputName = nullptr;
+	const char* outputName = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-c") && i + 1 < argc)
+		{
+			const long kb = strtol(argv[++i], nullptr, 10);
+			if (kb <= 0)
+				return Usage();
+			chunkSize = static_cast<size_t>(kb) * 1024;
+		}
+		else if (!strcmp(argv[i], "-s"))
+		{
+			codec = DDSZ_CODEC_NONE;
+		}
+		else if (!inputName)
+		{
+			inputName = argv[i];
+		}
+		else if (!outputName)
+		{
+			outputName = argv[i];
+		}
+		else
+		{
+			return Usage();
+		}
+	}
+
+	if (!inputName)
+		return Usage();
+
+	std::string defaultOutput;
+	if (!outputName)
+	{
+		defaultOutput = inputName;
+		const size_t dot = defaultOutput.find_last_of('.');
+		const size_t slash = defaultOutput.find_last_of("/\\");
+		if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+			defaultOutput.resize(dot);
+		defaultOutput += ".ddsz";
+		outputName = defaultOutput.c_str();
+	}
+
+	std::vector<uint8_t> ddsData;
+	if (!ReadWholeFile(inputName, ddsData))
+	{
+		fprintf(stderr, "DDSZPack: can't read %s\n", inputName);
+		return 1;
+	}
+
+	ThreadPool pool;
+	std::vector<uint8_t> ddszData;
+	const DDS_PARSE_STATUS status = PackDDSZ(ddsData.data(), ddsData.size(), ddszData, codec, chunkSize, &pool);
+	if (status != DDS_PARSE_OK)
+	{
+		fprintf(stderr, "DDSZPack: %s: %s\n", inputName, GetStatusText(status));
+		return 1;
+	}
+
+	if (!WriteWholeFile(outputName, ddszData))
+	{
+		fprintf(stderr, "DDSZPack: can't write %s\n", outputName);
+		return 1;
+	}
+
+	printf("%s -> %s: %zu -> %zu bytes (%.1f%%)\n", inputName, outputName,
+		ddsData.size(), ddszData.size(), ddsData.empty() ? 0.0 : 100.0 * ddszData.size() / ddsData.size());
+	return 0;
+}
@@ -0,0 +1,323 @@
+//--------------------------------------------------------------------------------------
+// File: LZ4Test.cpp
+//
+// Round trips through LZ4CompressBlock and LZ4DecompressBlock, blocks written by hand to
+// the LZ4 block format as other implementations produce them, and corrupt input: bad
+// offsets and lengths, every truncation of a valid block, and random bit flips. Decoding
+// writes into a buffer with guard bytes after it, which must come through untouched.
+// Built from the repo root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\LZ4Test.cpp LZ4.cpp
+//   g++ -std=c++14 -I. Tools/Tests/LZ4Test.cpp LZ4.cpp
+//--------------------------------------------------------------------------------------
+
+#include "LZ4.h"
+#include "UnitTest.h"
+
+#include <string.h>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const size_t GUARD_SIZE = 64;
+	const uint8_t GUARD_VALUE = 0xCD;
+
+	uint32_t g_Seed = 1;
+
+	uint32_t Random()
+	{
+		g_Seed = g_Seed * 1664525u + 1013904223u;
+		return g_Seed >> 8;
+	}
+
+	// Decodes into destSize bytes followed by guard bytes; false if the guard was touched
+	bool Decompress(const std::vector<uint8_t>& block, size_t destSize, std::vector<uint8_t>& dest, bool& result)
+	{
+		dest.assign(destSize + GUARD_SIZE, GUARD_VALUE);
+
+		// An exact-size copy, so reading past the end shows up under a memory checker
+		std::unique_ptr<uint8_t[]> src(new uint8_t[block.empty() ? 1 : block.size()]);
+		if (!block.empty())
+		{
+			memcpy(src.get(), block.data(), block.size());
+		}
+		result = LZ4DecompressBlock(src.get(), block.size(), dest.data(), destSize);
+
+		for (size_t i = destSize; i < dest.size(); ++i)
+		{
+			if (dest[i] != GUARD_VALUE)
+				return false;
+		}
+
+		dest.resize(destSize);
+		return true;
+	}
+
+	std::vector<uint8_t> Compress(const std::vector<uint8_t>& data)
+	{
+		// An empty vector may have no storage, and null is always rejected
+		static const uint8_t s_empty = 0;
+
+		std::vector<uint8_t> block(LZ4CompressBound(data.size()));
+		const size_t size = LZ4CompressBlock(data.empty() ? &s_empty : data.data(), data.size(), block.data(), block.size());
+		CHECK(size != 0);
+		block.resize(size);
+		return block;
+	}
+
+	void CheckRoundTrip(const char* name, const std::vector<uint8_t>& data)
+	{
+		UnitTest::SetContext("%s, %zu bytes", name, data.size());
+
+		const std::vector<uint8_t> block = Compress(data);
+		CHECK(block.size() <= LZ4CompressBound(data.size()));
+
+		std::vector<uint8_t> decoded;
+		bool result = false;
+		CHECK(Decompress(block, data.size(), decoded, result));
+		CHECK(result);
+		CHECK(decoded == data);
+
+		// The size is part of the contract: one byte more or less is an error
+		CHECK(Decompress(block, data.size() + 1, decoded, result));
+		CHECK(!result);
+		if (!data.empty())
+		{
+			CHECK(Decompress(block, data.size() - 1, decoded, result));
+			CHECK(!result);
+		}
+
+		UnitTest::ClearContext();
+	}
+
+	void TestRoundTrips()
+	{
+		CheckRoundTrip("empty", std::vector<uint8_t>());
+
+		// Around the sizes where the compressor starts looking for matches
+		for (size_t size = 1; size <= 20; ++size)
+		{
+			CheckRoundTrip("zeros", std::vector<uint8_t>(size, 0));
+		}
+
+		CheckRoundTrip("zeros", std::vector<uint8_t>(1024 * 1024, 0));
+
+		std::vector<uint8_t> random(256 * 1024);
+		for (auto& value : random)
+		{
+			value = static_cast<uint8_t>(Random());
+		}
+		CheckRoundTrip("random", random);
+
+		// Short repeating patterns give matches that overlap their own output
+		for (size_t period = 1; period <= 9; ++period)
+		{
+			std::vector<uint8_t> pattern(4096 + period);
+			for (size_t i = 0; i < pattern.size(); ++i)
+			{
+				pattern[i] = static_cast<uint8_t>(i % period + 1);
+			}
+			CheckRoundTrip("pattern", pattern);
+		}
+
+		// Matches near and past the 64KB window, and literal and match runs long enough to
+		// need several count bytes
+		std::vector<uint8_t> windowed(200 * 1024);
+		for (size_t i = 0; i < 65536; ++i)
+		{
+			windowed[i] = static_cast<uint8_t>(Random());
+		}
+		memmove(&windowed[65535], &windowed[0], 65536);
+		memmove(&windowed[140000], &windowed[1], 50000);
+		CheckRoundTrip("windowed", windowed);
+
+		// Image-like: smooth gradients with a little noise
+		std::vector<uint8_t> image(512 * 512 * 4);
+		for (size_t i = 0; i < image.size(); ++i)
+		{
+			const size_t pixel = i / 4;
+			image[i] = static_cast<uint8_t>((pixel % 512) / 2 + (pixel / 512) / 4 + (Random() & 3) * (i % 4 == 3 ? 0 : 1));
+		}
+		CheckRoundTrip("image", image);
+	}
+
+	// Blocks laid out by hand as the reference implementation writes them
+	void TestKnownBlocks()
+	{
+		struct KnownBlock
+		{
+			const char*				name;
+			std::vector<uint8_t>	block;
+			const char*				expected;
+		};
+
+		const KnownBlock blocks[] =
+		{
+			{ "literals only", { 0x50, 'h', 'e', 'l', 'l', 'o' }, "hello" },
+			{ "overlapping match",
+				{ 0x35, 'a', 'b', 'c', 0x03, 0x00, 0x50, '1', '2', '3', '4', '5' },
+				"abcabcabcabc12345" },
+			{ "run of one byte",
+				{ 0x1F, 'z', 0x01, 0x00, 0x05, 0x50, '1', '2', '3', '4', '5' },
+				"zzzzzzzzzzzzzzzzzzzzzzzzz12345" },
+			{ "long literal run",
+				{ 0xF0, 0x05, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't' },
+				"abcdefghijklmnopqrst" },
+		};
+
+		for (const auto& known : blocks)
+		{
+			UnitTest::SetContext("%s", known.name);
+
+			const size_t size = strlen(known.expected);
+			std::vector<uint8_t> decoded;
+			bool result = false;
+			CHECK(Decompress(known.block, size, decoded, result));
+			CHECK(result);
+			CHECK(decoded.size() == size && !memcmp(decoded.data(), known.expected, size));
+		}
+
+		// A count that continues through a 255 byte: 15 + 255 + 0 literals
+		std::vector<uint8_t> block = { 0xF0, 0xFF, 0x00 };
+		std::vector<uint8_t> expected(270);
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			expected[i] = static_cast<uint8_t>(i);
+		}
+		block.insert(block.end(), expected.begin(), expected.end());
+
+		UnitTest::SetContext("count of 255");
+		std::vector<uint8_t> decoded;
+		bool result = false;
+		CHECK(Decompress(block, expected.size(), decoded, result));
+		CHECK(result);
+		CHECK(decoded == expected);
+
+		UnitTest::ClearContext();
+	}
+
+	void CheckRejected(const char* name, const std::vector<uint8_t>& block, size_t destSize)
+	{
+		UnitTest::SetContext("%s", name);
+
+		std::vector<uint8_t> decoded;
+		bool result = true;
+		CHECK(Decompress(block, destSize, decoded, result));
+		CHECK(!result);
+
+		UnitTest::ClearContext();
+	}
+
+	void TestCorruptBlocks()
+	{
+		CheckRejected("no input", std::vector<uint8_t>(), 0);
+		CheckRejected("offset 0", { 0x10, 'a', 0x00, 0x00, 0x50, '1', '2', '3', '4', '5' }, 10);
+		CheckRejected("offset before the output", { 0x10, 'a', 0x02, 0x00, 0x50, '1', '2', '3', '4', '5' }, 10);
+		CheckRejected("match past the output", { 0x1F, 'z', 0x01, 0x00, 0x05, 0x50, '1', '2', '3', '4', '5' }, 20);
+		CheckRejected("literals past the input", { 0x50, 'h', 'e', 'l' }, 5);
+		CheckRejected("literals past the output", { 0x50, 'h', 'e', 'l', 'l', 'o' }, 3);
+		CheckRejected("unfinished count", { 0xF0, 0xFF, 0xFF }, 600);
+		CheckRejected("half an offset", { 0x10, 'a', 0x01 }, 10);
+		CheckRejected("no last literals", { 0x10, 'a', 0x01, 0x00 }, 5);
+
+		// Every truncation of a valid block fails cleanly
+		std::vector<uint8_t> data(8192);
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = static_cast<uint8_t>((i % 37) < 20 ? i % 7 : Random());
+		}
+
+		const std::vector<uint8_t> block = Compress(data);
+		size_t guardFailures = 0;
+		size_t accepted = 0;
+		for (size_t size = 0; size < block.size(); ++size)
+		{
+			const std::vector<uint8_t> truncated(block.begin(), block.begin() + size);
+			std::vector<uint8_t> decoded;
+			bool result = false;
+			guardFailures += Decompress(truncated, data.size(), decoded, result) ? 0 : 1;
+			accepted += result ? 1 : 0;
+		}
+
+		UnitTest::SetContext("truncated blocks");
+		CHECK_EQUAL(size_t(0), guardFailures);
+		CHECK_EQUAL(size_t(0), accepted);
+
+		// Random damage may still decode to something of the right size, but must never
+		// write outside the buffer
+		guardFailures = 0;
+		for (int trial = 0; trial < 20000; ++trial)
+		{
+			std::vector<uint8_t> damaged = block;
+			const int flips = 1 + static_cast<int>(Random() % 4);
+			for (int i = 0; i < flips; ++i)
+			{
+				damaged[Random() % damaged.size()] ^= static_cast<uint8_t>(1u << (Random() % 8));
+			}
+
+			std::vector<uint8_t> decoded;
+			bool result = false;
+			guardFailures += Decompress(damaged, data.size(), decoded, result) ? 0 : 1;
+		}
+
+		UnitTest::SetContext("damaged blocks");
+		CHECK_EQUAL(size_t(0), guardFailures);
+
+		guardFailures = 0;
+		for (int trial = 0; trial < 20000; ++trial)
+		{
+			std::vector<uint8_t> garbage(1 + Random() % 64);
+			for (auto& value : garbage)
+			{
+				value = static_cast<uint8_t>(Random());
+			}
+
+			std::vector<uint8_t> decoded;
+			bool result = false;
+			guardFailures += Decompress(garbage, Random() % 512, decoded, result) ? 0 : 1;
+		}
+
+		UnitTest::SetContext("random blocks");
+		CHECK_EQUAL(size_t(0), guardFailures);
+
+		UnitTest::ClearContext();
+	}
+
+	void TestCompressCapacity()
+	{
+		std::vector<uint8_t> random(4096);
+		for (auto& value : random)
+		{
+			value = static_cast<uint8_t>(Random());
+		}
+
+		// Too small for incompressible data: 0, and nothing written past the capacity
+		std::vector<uint8_t> block(random.size() + GUARD_SIZE, GUARD_VALUE);
+		CHECK_EQUAL(size_t(0), LZ4CompressBlock(random.data(), random.size(), block.data(), random.size()));
+
+		bool guardIntact = true;
+		for (size_t i = random.size(); i < block.size(); ++i)
+		{
+			guardIntact = guardIntact && (block[i] == GUARD_VALUE);
+		}
+		CHECK(guardIntact);
+
+		CHECK_EQUAL(size_t(0), LZ4CompressBlock(random.data(), random.size(), block.data(), 0));
+		CHECK_EQUAL(size_t(0), LZ4CompressBlock(nullptr, 0, block.data(), block.size()));
+		CHECK(!LZ4DecompressBlock(nullptr, 0, block.data(), 0));
+	}
+}
+
+
+int main()
+{
+	TestRoundTrips();
+	TestKnownBlocks();
+	TestCorruptBlocks();
+	TestCompressCapacity();
+
+	return UnitTest::Report("LZ4Test");
+}
@@ -0,0 +1,602 @@
+//--------------------------------------------------------------------------------------
+// File: ResidencyPolicyTest.cpp
+//
+// Runs ResidencyPolicy against a simulated device: the actions each Update returns are
+// applied to a model of what is resident and which mips are loaded, and the memory that
+// model uses is checked against the policy's usage and the budget. Covers registration,
+// eviction order, restores, frame latency, pinned objects, mip demotion and promotion,
+// and Replace sizing an object from the copy that stands in for it. Built from the repo
+// root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\ResidencyPolicyTest.cpp ResidencyPolicy.cpp
+//   g++ -std=c++14 -I. Tools/Tests/ResidencyPolicyTest.cpp ResidencyPolicy.cpp
+//--------------------------------------------------------------------------------------
+
+#include "ResidencyPolicy.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	uint32_t g_Seed = 1;
+
+	uint32_t Random()
+	{
+		g_Seed = g_Seed * 1664525u + 1013904223u;
+		return g_Seed >> 8;
+	}
+
+	// What the device holds for one object, as the actions left it
+	struct SimulatedObject
+	{
+		uint64_t                size;
+		std::vector<uint64_t>   mipSizes;       // Of the full chain
+		uint32_t                maxDroppedMips;
+		uint32_t                topMip;
+		RESIDENCY_PRIORITY      priority;
+		bool                    resident;
+		bool                    registered;
+	};
+
+	class SimulatedDevice
+	{
+	public:
+		explicit SimulatedDevice(uint32_t frameLatency = 0) : policy(frameLatency) {}
+
+		uint32_t Register(uint64_t size, RESIDENCY_PRIORITY priority,
+			const std::vector<uint64_t>& mipSizes = std::vector<uint64_t>(), uint32_t maxDroppedMips = 0)
+		{
+			ResidencyObjectDesc desc = {};
+			desc.size = size;
+			desc.priority = priority;
+			desc.mipSizes = mipSizes.empty() ? nullptr : mipSizes.data();
+			desc.mipCount = static_cast<uint32_t>(mipSizes.size());
+			desc.maxDroppedMips = maxDroppedMips;
+
+			const uint32_t object = policy.Register(desc);
+			if (object)
+			{
+				if (object > objects.size())
+				{
+					objects.resize(object);
+				}
+
+				SimulatedObject& simulated = objects[object - 1];
+				simulated.size = size;
+				simulated.mipSizes = mipSizes;
+				simulated.maxDroppedMips = mipSizes.empty() ? 0 : std::min<uint32_t>(maxDroppedMips, desc.mipCount - 1);
+				simulated.topMip = 0;
+				simulated.priority = priority;
+				simulated.resident = true;
+				simulated.registered = true;
+			}
+			return object;
+		}
+
+		void Unregister(uint32_t object)
+		{
+			policy.Unregister(object);
+			objects[object - 1].registered = false;
+		}
+
+		// Ends the frame and applies its actions; false if they break the ordering contract
+		bool Update(uint64_t budget)
+		{
+			policy.Update(budget, actions);
+			return Apply();
+		}
+
+		// Replaces the object's copy, a new object that starts out resident when newCopy is
+		// set, and applies the actions. false if the policy refuses the copy, or the device
+		// and the policy no longer agree on whether the object is resident.
+		bool Replace(uint32_t object, const ResidencyObjectDesc& desc, uint32_t topMip, bool newCopy = true)
+		{
+			if (!policy.Replace(object, desc, topMip, newCopy, actions))
+				return false;
+
+			if (newCopy)
+			{
+				objects[object - 1].resident = true;
+			}
+			return Apply() && objects[object - 1].resident == policy.IsResident(object);
+		}
+
+		// false if the actions break the ordering contract, or evict or restore an object
+		// twice: residency calls are counted, so either would leave the device out of step
+		bool Apply()
+		{
+			bool ordered = true;
+			std::vector<bool> mipsChanged(objects.size(), false);
+			for (size_t i = 0; i < actions.size(); ++i)
+			{
+				const ResidencyAction& action = actions[i];
+				SimulatedObject& object = objects[action.object - 1];
+				ordered = ordered && object.registered && (!i || actions[i - 1].type <= action.type);
+
+				switch (action.type)
+				{
+				case RESIDENCY_ACTION_MAKE_RESIDENT:
+					ordered = ordered && !object.resident;
+					object.resident = true;
+					break;
+
+				case RESIDENCY_ACTION_EVICT:
+					ordered = ordered && object.resident;
+					object.resident = false;
+					break;
+
+				default:
+					ordered = ordered && !mipsChanged[action.object - 1] && action.topMip <= object.maxDroppedMips
+						&& (action.type == RESIDENCY_ACTION_DEMOTE ? action.topMip > object.topMip : action.topMip < object.topMip);
+					mipsChanged[action.object - 1] = true;
+					object.topMip = action.topMip;
+					break;
+				}
+			}
+			return ordered;
+		}
+
+		uint64_t GetResidentSize(const SimulatedObject& object) const
+		{
+			uint64_t size = object.size;
+			for (uint32_t mip = 0; mip < object.topMip; ++mip)
+			{
+				size -= object.mipSizes[mip];
+			}
+			return size;
+		}
+
+		uint64_t GetUsage() const
+		{
+			uint64_t usage = 0;
+			for (const auto& object : objects)
+			{
+				if (object.registered && object.resident)
+				{
+					usage += GetResidentSize(object);
+				}
+			}
+			return usage;
+		}
+
+		bool HasAction(uint32_t object, RESIDENCY_ACTION_TYPE type, uint32_t topMip = 0) const
+		{
+			for (const auto& action : actions)
+			{
+				if (action.object == object && action.type == type &&
+					(type < RESIDENCY_ACTION_DEMOTE || action.topMip == topMip))
+					return true;
+			}
+			return false;
+		}
+
+		ResidencyPolicy                 policy;
+		std::vector<SimulatedObject>    objects;        // Indexed by handle - 1
+		std::vector<ResidencyAction>    actions;
+	};
+
+	const uint64_t NO_BUDGET_LIMIT = UINT64_MAX;
+
+	void TestRegister()
+	{
+		SimulatedDevice device;
+		const std::vector<uint64_t> mips = { 64, 16, 4, 1 };
+
+		ResidencyObjectDesc desc = {};
+		desc.size = 100;
+		desc.priority = static_cast<RESIDENCY_PRIORITY>(RESIDENCY_PRIORITY_PINNED + 1);
+		CHECK_EQUAL(0u, device.policy.Register(desc));
+		desc.priority = RESIDENCY_PRIORITY_NORMAL;
+		desc.mipSizes = mips.data();
+		desc.mipCount = 0;
+		CHECK_EQUAL(0u, device.policy.Register(desc));
+		desc.mipCount = 4;
+		desc.size = 84;
+		CHECK_EQUAL(0u, device.policy.Register(desc));
+		CHECK_EQUAL(uint64_t(0), device.policy.GetUsage());
+
+		const uint32_t a = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+		const uint32_t b = device.Register(85, RESIDENCY_PRIORITY_NORMAL, mips, 10);
+		CHECK_EQUAL(1u, a);
+		CHECK_EQUAL(2u, b);
+		CHECK_EQUAL(uint64_t(185), device.policy.GetUsage());
+		CHECK(device.policy.IsResident(b));
+		CHECK_EQUAL(0u, device.policy.GetTopMip(b));
+
+		// Handles are reused, and a stale one is ignored
+		device.Unregister(a);
+		CHECK_EQUAL(uint64_t(85), device.policy.GetUsage());
+		CHECK(!device.policy.IsResident(a));
+		device.policy.Unregister(a);
+		device.policy.MarkUsed(a);
+		CHECK_EQUAL(uint64_t(85), device.policy.GetUsage());
+		CHECK_EQUAL(a, device.Register(50, RESIDENCY_PRIORITY_LOW));
+		CHECK_EQUAL(uint64_t(135), device.policy.GetUsage());
+
+		CHECK(!device.policy.IsResident(0));
+		CHECK(!device.policy.IsResident(99));
+
+		const ResidencyStatistics stats = device.policy.GetStatistics();
+		CHECK_EQUAL(2u, stats.objects);
+		CHECK_EQUAL(0u, stats.evicted);
+	}
+
+	void TestEviction()
+	{
+		SimulatedDevice device;
+		const uint32_t low = device.Register(100, RESIDENCY_PRIORITY_LOW);
+		const uint32_t normal = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+		const uint32_t older = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+		const uint32_t pinned = device.Register(100, RESIDENCY_PRIORITY_PINNED);
+
+		// Everything fits: nothing to do
+		CHECK(device.Update(NO_BUDGET_LIMIT));
+		CHECK(device.actions.empty());
+
+		// Frame 2 uses normal, frame 3 uses nothing
+		device.policy.MarkUsed(normal);
+		CHECK(device.Update(NO_BUDGET_LIMIT));
+
+		// Lowest priority goes first, and only as much as the budget needs
+		UnitTest::SetContext("budget 350");
+		CHECK(device.Update(350));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK(device.HasAction(low, RESIDENCY_ACTION_EVICT));
+		CHECK_EQUAL(uint64_t(300), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// Then the least recently used of the same priority
+		UnitTest::SetContext("budget 200");
+		CHECK(device.Update(200));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK(device.HasAction(older, RESIDENCY_ACTION_EVICT));
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// Pinned objects stay, even when that leaves usage over budget
+		UnitTest::SetContext("budget 0");
+		CHECK(device.Update(0));
+		CHECK(device.HasAction(normal, RESIDENCY_ACTION_EVICT));
+		CHECK(!device.HasAction(pinned, RESIDENCY_ACTION_EVICT));
+		CHECK(device.policy.IsResident(pinned));
+		CHECK_EQUAL(uint64_t(100), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// An evicted object used again comes back first, whatever the budget, and something
+		// else makes room for it
+		UnitTest::SetContext("restore");
+		device.policy.MarkUsed(older);
+		device.policy.SetPriority(pinned, RESIDENCY_PRIORITY_NORMAL);
+		CHECK(device.Update(100));
+		CHECK(device.HasAction(older, RESIDENCY_ACTION_MAKE_RESIDENT));
+		CHECK(device.HasAction(pinned, RESIDENCY_ACTION_EVICT));
+		CHECK(device.policy.IsResident(older));
+		CHECK_EQUAL(uint64_t(100), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		const ResidencyStatistics stats = device.policy.GetStatistics();
+		CHECK_EQUAL(uint64_t(4), stats.evictions);
+		CHECK_EQUAL(uint64_t(1), stats.restores);
+		CHECK_EQUAL(3u, stats.evicted);
+		CHECK_EQUAL(uint64_t(300), stats.evictedBytes);
+
+		UnitTest::ClearContext();
+	}
+
+	void TestFrameLatency()
+	{
+		// The GPU may still be two frames behind
+		SimulatedDevice device(2);
+		const uint32_t a = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+		const uint32_t b = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+
+		// Registered in frame 1; frames 2 and 3 may still be reading them
+		CHECK(device.Update(0));
+		CHECK(device.actions.empty());
+		device.policy.MarkUsed(b);
+		CHECK(device.Update(0));
+		CHECK(device.actions.empty());
+		CHECK(device.Update(0));
+		CHECK(device.actions.empty());
+
+		// Frame 4: a was last used in frame 1, b in frame 2
+		CHECK(device.Update(0));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK(device.HasAction(a, RESIDENCY_ACTION_EVICT));
+		CHECK(device.Update(0));
+		CHECK(device.HasAction(b, RESIDENCY_ACTION_EVICT));
+		CHECK_EQUAL(uint64_t(0), device.policy.GetUsage());
+	}
+
+	void TestDemotion()
+	{
+		SimulatedDevice device;
+		const uint32_t small = device.Register(85, RESIDENCY_PRIORITY_NORMAL, { 64, 16, 4, 1 }, 10);
+		const uint32_t large = device.Register(341, RESIDENCY_PRIORITY_NORMAL, { 256, 64, 16, 4, 1 }, 2);
+
+		// Used every frame, so nothing can be evicted and only mips can go
+		auto update = [&](uint64_t budget)
+		{
+			device.policy.MarkUsed(small);
+			device.policy.MarkUsed(large);
+			const bool ordered = device.Update(budget);
+			CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+			return ordered;
+		};
+
+		// The largest mip goes first: large's 256 covers it
+		UnitTest::SetContext("budget 200");
+		CHECK(update(200));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK(device.HasAction(large, RESIDENCY_ACTION_DEMOTE, 1));
+		CHECK_EQUAL(uint64_t(170), device.policy.GetUsage());
+
+		// Then small's 64 and large's 64, each object reported once at its final mip
+		UnitTest::SetContext("budget 50");
+		CHECK(update(50));
+		CHECK_EQUAL(size_t(2), device.actions.size());
+		CHECK(device.HasAction(small, RESIDENCY_ACTION_DEMOTE, 1));
+		CHECK(device.HasAction(large, RESIDENCY_ACTION_DEMOTE, 2));
+		CHECK_EQUAL(uint64_t(42), device.policy.GetUsage());
+
+		// large stops at its limit of two mips; small goes down to its last mip, never past it
+		UnitTest::SetContext("budget 0");
+		CHECK(update(0));
+		CHECK(device.HasAction(small, RESIDENCY_ACTION_DEMOTE, 3));
+		CHECK(!device.HasAction(large, RESIDENCY_ACTION_DEMOTE, 3));
+		CHECK_EQUAL(3u, device.policy.GetTopMip(small));
+		CHECK_EQUAL(2u, device.policy.GetTopMip(large));
+		CHECK_EQUAL(uint64_t(1 + 21), device.policy.GetUsage());
+
+		CHECK(update(0));
+		CHECK(device.actions.empty());
+
+		// Room for small's mips but not large's 64 under the margin: most recently used first,
+		// then as far as each object fits
+		UnitTest::SetContext("budget 120");
+		device.policy.MarkUsed(small);
+		CHECK(device.Update(120));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK(device.HasAction(small, RESIDENCY_ACTION_PROMOTE, 0));
+		CHECK_EQUAL(uint64_t(85 + 21), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// The margin keeps a budget just over usage from bringing a mip straight back
+		UnitTest::SetContext("margin");
+		CHECK(update(85 + 21 + 64));
+		CHECK(device.actions.empty());
+		CHECK(update(2 * (85 + 341)));
+		CHECK(device.HasAction(large, RESIDENCY_ACTION_PROMOTE, 0));
+		CHECK_EQUAL(uint64_t(85 + 341), device.policy.GetUsage());
+
+		const ResidencyStatistics stats = device.policy.GetStatistics();
+		CHECK_EQUAL(0u, stats.demoted);
+		CHECK_EQUAL(uint64_t(4), stats.demotions);
+		CHECK_EQUAL(uint64_t(2), stats.promotions);
+
+		UnitTest::ClearContext();
+	}
+
+	void TestPinnedMips()
+	{
+		SimulatedDevice device;
+		const uint32_t pinned = device.Register(85, RESIDENCY_PRIORITY_PINNED, { 64, 16, 4, 1 }, 3);
+		const uint32_t low = device.Register(85, RESIDENCY_PRIORITY_LOW, { 64, 16, 4, 1 }, 3);
+
+		// Lower priority is demoted all the way before anything else is looked at
+		device.policy.MarkUsed(pinned);
+		device.policy.MarkUsed(low);
+		CHECK(device.Update(0));
+		CHECK(device.HasAction(low, RESIDENCY_ACTION_DEMOTE, 3));
+		CHECK_EQUAL(size_t(1), device.actions.size());
+		CHECK_EQUAL(0u, device.policy.GetTopMip(pinned));
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+	}
+
+	ResidencyObjectDesc MakeDesc(uint64_t size, const std::vector<uint64_t>& mipSizes, uint32_t maxDroppedMips)
+	{
+		ResidencyObjectDesc desc = {};
+		desc.size = size;
+		desc.priority = RESIDENCY_PRIORITY_NORMAL;
+		desc.mipSizes = mipSizes.empty() ? nullptr : mipSizes.data();
+		desc.mipCount = static_cast<uint32_t>(mipSizes.size());
+		desc.maxDroppedMips = maxDroppedMips;
+		return desc;
+	}
+
+	void TestReplace()
+	{
+		SimulatedDevice device;
+		const uint32_t texture = device.Register(85, RESIDENCY_PRIORITY_NORMAL, { 64, 16, 4, 1 }, 3);
+		const uint32_t other = device.Register(100, RESIDENCY_PRIORITY_NORMAL);
+
+		device.policy.MarkUsed(texture);
+		device.policy.MarkUsed(other);
+		CHECK(device.Update(125));
+		CHECK(device.HasAction(texture, RESIDENCY_ACTION_DEMOTE, 1));
+		CHECK_EQUAL(uint64_t(121), device.policy.GetUsage());
+
+		// The smaller copy the owner loads after the demotion: mips 1.. of the chain, with an
+		// allocation a little larger than its mips
+		UnitTest::SetContext("reloaded smaller");
+		const std::vector<uint64_t> reduced = { 16, 4, 1 };
+		CHECK(device.Replace(texture, MakeDesc(24, reduced, 1), 1));
+		CHECK(device.actions.empty());
+		CHECK_EQUAL(1u, device.policy.GetTopMip(texture));
+		CHECK_EQUAL(uint64_t(124), device.policy.GetUsage());
+		device.objects[texture - 1].size = 64 + 24;
+		device.objects[texture - 1].maxDroppedMips = 2;
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// The copy's limit counts from its own mip 0
+		device.policy.MarkUsed(texture);
+		device.policy.MarkUsed(other);
+		CHECK(device.Update(0));
+		CHECK(device.HasAction(texture, RESIDENCY_ACTION_DEMOTE, 2));
+		CHECK_EQUAL(uint64_t(100 + 8), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// Promotion brings back the mips above the copy at their old sizes
+		UnitTest::SetContext("promoted");
+		device.policy.MarkUsed(texture);
+		CHECK(device.Update(NO_BUDGET_LIMIT));
+		CHECK(device.HasAction(texture, RESIDENCY_ACTION_PROMOTE, 0));
+		CHECK_EQUAL(uint64_t(100 + 88), device.policy.GetUsage());
+
+		// ...and the full-size copy that follows is sized from its own desc
+		CHECK(device.Replace(texture, MakeDesc(96, { 64, 16, 4, 1 }, 3), 0));
+		CHECK_EQUAL(uint64_t(100 + 96), device.policy.GetUsage());
+		device.objects[texture - 1].size = 96;
+		device.objects[texture - 1].maxDroppedMips = 3;
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// Inconsistent copies leave the object as it was
+		UnitTest::SetContext("rejected");
+		CHECK(!device.Replace(texture, MakeDesc(10, { 16, 4, 1 }, 1), 1));
+		CHECK(!device.Replace(texture, MakeDesc(10, std::vector<uint64_t>(), 0), 1));
+		CHECK(!device.Replace(texture, MakeDesc(100, { 1 }, 0), 5));
+		CHECK(!device.Replace(0, MakeDesc(100, std::vector<uint64_t>(), 0), 0));
+		CHECK_EQUAL(uint64_t(100 + 96), device.policy.GetUsage());
+		CHECK_EQUAL(0u, device.policy.GetTopMip(texture));
+
+		// An evicted object takes its new size when it is next made resident
+		UnitTest::SetContext("evicted");
+		device.policy.MarkUsed(texture);
+		CHECK(device.Update(100));
+		CHECK(device.HasAction(other, RESIDENCY_ACTION_EVICT));
+		CHECK(device.Replace(other, MakeDesc(40, std::vector<uint64_t>(), 0), 0));
+		CHECK(device.HasAction(other, RESIDENCY_ACTION_EVICT));
+		CHECK_EQUAL(uint64_t(96), device.policy.GetUsage());
+
+		// The same object handed back, as a cache serving the current copy again does: it
+		// is already evicted, so nothing more is
+		UnitTest::SetContext("same object, evicted");
+		CHECK(device.Replace(other, MakeDesc(40, std::vector<uint64_t>(), 0), 0, false));
+		CHECK(device.actions.empty());
+		CHECK(!device.policy.IsResident(other));
+		UnitTest::SetContext("evicted");
+		device.objects[other - 1].size = 40;
+		device.policy.MarkUsed(other);
+		device.policy.MarkUsed(texture);
+		CHECK(device.Update(NO_BUDGET_LIMIT));
+		CHECK(device.HasAction(other, RESIDENCY_ACTION_MAKE_RESIDENT));
+		CHECK_EQUAL(uint64_t(136), device.policy.GetUsage());
+		CHECK_EQUAL(device.GetUsage(), device.policy.GetUsage());
+
+		// Resident, the same object or a new one needs nothing
+		UnitTest::SetContext("resident");
+		CHECK(device.Replace(other, MakeDesc(40, std::vector<uint64_t>(), 0), 0, false));
+		CHECK(device.actions.empty());
+		CHECK(device.Replace(other, MakeDesc(40, std::vector<uint64_t>(), 0), 0));
+		CHECK(device.actions.empty());
+		CHECK(device.policy.IsResident(other));
+
+		// A copy without mips can no longer be demoted
+		UnitTest::SetContext("no mips");
+		CHECK(device.Replace(texture, MakeDesc(96, std::vector<uint64_t>(), 0), 0));
+		device.objects[texture - 1].maxDroppedMips = 0;
+		device.policy.MarkUsed(texture);
+		device.policy.MarkUsed(other);
+		CHECK(device.Update(0));
+		CHECK(device.actions.empty());
+		CHECK_EQUAL(uint64_t(136), device.policy.GetUsage());
+
+		UnitTest::ClearContext();
+	}
+
+	// Random registrations, uses and budgets. After every Update the simulated device must
+	// use exactly what the policy reports, and anything over budget must be because nothing
+	// more could go: every resident object is pinned, in flight, or demoted to its limit.
+	void TestRandomBudgets()
+	{
+		const uint32_t frameLatency = 1;
+		SimulatedDevice device(frameLatency);
+		std::vector<uint32_t> live;
+		std::vector<uint64_t> lastUsed;
+
+		size_t misordered = 0;
+		size_t usageMismatches = 0;
+		size_t overBudget = 0;
+		for (int frame = 0; frame < 2000; ++frame)
+		{
+			if (live.size() < 64 && (Random() % 4) == 0)
+			{
+				const RESIDENCY_PRIORITY priority = static_cast<RESIDENCY_PRIORITY>(Random() % 4);
+				std::vector<uint64_t> mips;
+				uint64_t size = 0;
+				if (Random() % 2)
+				{
+					for (uint64_t mipSize = 1 + Random() % (1 << 16); mipSize; mipSize >>= 2)
+					{
+						mips.push_back(mipSize);
+						size += mipSize;
+					}
+				}
+				size += Random() % 4096;
+				live.push_back(device.Register(size, priority, mips, Random() % 8));
+				CHECK(live.back() != 0);
+				if (live.back() > lastUsed.size())
+				{
+					lastUsed.resize(live.back());
+				}
+				lastUsed[live.back() - 1] = device.policy.GetFrame();
+			}
+			if (!live.empty() && (Random() % 16) == 0)
+			{
+				const size_t index = Random() % live.size();
+				device.Unregister(live[index]);
+				live.erase(live.begin() + index);
+			}
+
+			for (uint32_t object : live)
+			{
+				if (Random() % 3 == 0)
+				{
+					device.policy.MarkUsed(object);
+					lastUsed[object - 1] = device.policy.GetFrame();
+				}
+			}
+
+			const uint64_t budget = Random() % (1 << 20);
+			const uint64_t currentFrame = device.policy.GetFrame();
+			misordered += device.Update(budget) ? 0 : 1;
+			usageMismatches += (device.GetUsage() == device.policy.GetUsage()) ? 0 : 1;
+
+			if (device.policy.GetUsage() > budget)
+			{
+				for (uint32_t object : live)
+				{
+					// Objects in flight can't be evicted, but can still lose mips
+					const SimulatedObject& simulated = device.objects[object - 1];
+					const bool inFlight = lastUsed[object - 1] + frameLatency >= currentFrame;
+					const bool stuck = !simulated.resident || simulated.priority == RESIDENCY_PRIORITY_PINNED ||
+						(inFlight && simulated.topMip == simulated.maxDroppedMips);
+					overBudget += stuck ? 0 : 1;
+				}
+			}
+		}
+
+		UnitTest::SetContext("random budgets");
+		CHECK_EQUAL(size_t(0), misordered);
+		CHECK_EQUAL(size_t(0), usageMismatches);
+		CHECK_EQUAL(size_t(0), overBudget);
+		UnitTest::ClearContext();
+	}
+}
+
+
+int main()
+{
+	TestRegister();
+	TestEviction();
+	TestFrameLatency();
+	TestDemotion();
+	TestPinnedMips();
+	TestReplace();
+	TestRandomBudgets();
+
+	return UnitTest::Report("ResidencyPolicyTest");
+}
@@ -0,0 +1,406 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceStateTrackerTest.cpp
+//
+// Checks ResourceStateTracker: whole-resource transitions merging into one barrier and
+// mixed subresource states splitting into several, redundant and replaced requests,
+// split barriers begun and ended across flushes, promotion out of COMMON for each kind of
+// resource, and what Decay puts back in COMMON. Built from the repo root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\ResourceStateTrackerTest.cpp ResourceStateTracker.cpp
+//   g++ -std=c++14 -I. Tools/Tests/ResourceStateTrackerTest.cpp ResourceStateTracker.cpp
+//--------------------------------------------------------------------------------------
+
+#include "ResourceStateTracker.h"
+#include "UnitTest.h"
+
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// D3D12_RESOURCE_STATES values
+	const uint32_t c_Common = 0;
+	const uint32_t c_RenderTarget = 0x4;
+	const uint32_t c_UnorderedAccess = 0x8;
+	const uint32_t c_NonPixelShaderResource = 0x40;
+	const uint32_t c_PixelShaderResource = 0x80;
+	const uint32_t c_CopyDest = 0x400;
+	const uint32_t c_CopySource = 0x800;
+
+	std::vector<ResourceTransition> g_Transitions;
+
+	void Flush(ResourceStateTracker& tracker, bool copyQueue = false)
+	{
+		tracker.Flush(g_Transitions, copyQueue);
+	}
+
+	bool IsTransition(size_t index, uint32_t object, uint32_t subresource, uint32_t before, uint32_t after,
+		RESOURCE_TRANSITION_SPLIT split = RESOURCE_TRANSITION_FULL)
+	{
+		if (index >= g_Transitions.size())
+			return false;
+
+		const ResourceTransition& transition = g_Transitions[index];
+		return transition.object == object && transition.subresource == subresource
+			&& transition.before == before && transition.after == after && transition.split == split;
+	}
+
+	void TestWholeResource()
+	{
+		ResourceStateTracker tracker;
+		CHECK_EQUAL(0u, tracker.Register(0, c_Common));
+
+		const uint32_t texture = tracker.Register(4, c_Common);
+		CHECK(texture != 0);
+		CHECK_EQUAL(4u, tracker.GetSubresourceCount(texture));
+		CHECK(!tracker.HasPendingTransitions());
+
+		// Every subresource going the same way is one barrier
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		CHECK(tracker.HasPendingTransitions());
+		CHECK_EQUAL(c_RenderTarget, tracker.GetState(texture, 2));
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_Common, c_RenderTarget));
+
+		// Asking for the state it is in records nothing
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		CHECK(!tracker.HasPendingTransitions());
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+
+		// Asking again before the flush replaces the pending transition, and asking for
+		// where it already is drops it
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopySource);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget, c_CopySource));
+
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopySource);
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+
+		// Out of range requests and unknown objects are ignored
+		tracker.Transition(texture, 4, c_RenderTarget);
+		tracker.Transition(texture + 1, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		tracker.Transition(0, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		CHECK(!tracker.HasPendingTransitions());
+
+		const ResourceStateStatistics stats = tracker.GetStatistics();
+		CHECK_EQUAL(6u, stats.requested);
+		CHECK_EQUAL(4u, stats.redundant);
+		CHECK_EQUAL(2u, stats.barriers);
+		CHECK_EQUAL(2u, stats.flushes);
+	}
+
+	void TestSubresources()
+	{
+		ResourceStateTracker tracker;
+		const uint32_t texture = tracker.Register(4, c_RenderTarget);
+
+		tracker.Transition(texture, 1, c_PixelShaderResource);
+		CHECK_EQUAL(c_PixelShaderResource, tracker.GetState(texture, 1));
+		CHECK_EQUAL(c_RenderTarget, tracker.GetState(texture, 0));
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 1, c_RenderTarget, c_PixelShaderResource));
+
+		// Only the subresource not already there moves, and on its own
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 1, c_PixelShaderResource, c_RenderTarget));
+
+		// Every subresource moving, but from different states, takes a barrier each
+		tracker.Transition(texture, 0, c_PixelShaderResource);
+		tracker.Transition(texture, 2, c_CopySource);
+		Flush(tracker);
+		CHECK_EQUAL(2u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 0, c_RenderTarget, c_PixelShaderResource));
+		CHECK(IsTransition(1, texture, 2, c_RenderTarget, c_CopySource));
+
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		Flush(tracker);
+		CHECK_EQUAL(4u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 0, c_PixelShaderResource, c_CopyDest));
+		CHECK(IsTransition(1, texture, 1, c_RenderTarget, c_CopyDest));
+		CHECK(IsTransition(2, texture, 2, c_CopySource, c_CopyDest));
+		CHECK(IsTransition(3, texture, 3, c_RenderTarget, c_CopyDest));
+
+		// Subresources asked for one by one still merge once they all go the same way
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			tracker.Transition(texture, i, c_PixelShaderResource);
+		}
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_CopyDest, c_PixelShaderResource));
+
+		// Objects come out in the order they were first touched
+		const uint32_t other = tracker.Register(1, c_Common);
+		tracker.Transition(other, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		tracker.Transition(texture, 3, c_RenderTarget);
+		Flush(tracker);
+		CHECK_EQUAL(2u, g_Transitions.size());
+		CHECK(IsTransition(0, other, RESOURCE_ALL_SUBRESOURCES, c_Common, c_CopyDest));
+		CHECK(IsTransition(1, texture, 3, c_PixelShaderResource, c_RenderTarget));
+	}
+
+	void TestSplitBarriers()
+	{
+		ResourceStateTracker tracker;
+		const uint32_t texture = tracker.Register(2, c_RenderTarget);
+
+		// Begun at one flush, ended at the flush after the next request
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		CHECK_EQUAL(c_PixelShaderResource, tracker.GetState(texture, 0));
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget, c_PixelShaderResource, RESOURCE_TRANSITION_BEGIN));
+
+		// Asking to begin it again leaves it open; nothing goes out until it's needed
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		CHECK(!tracker.HasPendingTransitions());
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget, c_PixelShaderResource, RESOURCE_TRANSITION_END));
+		CHECK_EQUAL(c_PixelShaderResource, tracker.GetState(texture, 0));
+
+		// With the full request before the flush there is no gap: one full barrier
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource, c_RenderTarget));
+
+		// A different state after a split: the END goes out first, then the new barrier
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopySource);
+		Flush(tracker);
+		CHECK_EQUAL(2u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget, c_PixelShaderResource, RESOURCE_TRANSITION_END));
+		CHECK(IsTransition(1, texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource, c_CopySource));
+
+		// EndSplitTransitions ends what is open, and turns a split not yet begun into a full barrier
+		tracker.BeginTransition(texture, 0, c_RenderTarget);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 0, c_CopySource, c_RenderTarget, RESOURCE_TRANSITION_BEGIN));
+		tracker.BeginTransition(texture, 1, c_RenderTarget);
+		tracker.EndSplitTransitions();
+		Flush(tracker);
+		CHECK_EQUAL(2u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 0, c_CopySource, c_RenderTarget, RESOURCE_TRANSITION_END));
+		CHECK(IsTransition(1, texture, 1, c_CopySource, c_RenderTarget));
+		tracker.EndSplitTransitions();
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+
+		// A split on one subresource, then the whole resource asked for: an END for it
+		// and a full barrier for the other, never merged
+		tracker.BeginTransition(texture, 1, c_PixelShaderResource);
+		Flush(tracker);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		CHECK_EQUAL(2u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, 1, c_RenderTarget, c_PixelShaderResource, RESOURCE_TRANSITION_END));
+		CHECK(IsTransition(1, texture, 0, c_RenderTarget, c_PixelShaderResource));
+
+		const ResourceStateStatistics stats = tracker.GetStatistics();
+		CHECK_EQUAL(4u, stats.splitBarriers);
+		CHECK_EQUAL(12u, stats.barriers);
+
+		// Unregistering forgets a split left open
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopySource);
+		Flush(tracker);
+		tracker.Unregister(texture);
+		tracker.EndSplitTransitions();
+		CHECK(!tracker.HasPendingTransitions());
+	}
+
+	void TestPromotion()
+	{
+		ResourceStateTracker tracker;
+
+		// Textures promote to shader resource and copy states without a barrier
+		const uint32_t texture = tracker.Register(2, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+		CHECK_EQUAL(c_PixelShaderResource, tracker.GetState(texture, 1));
+		CHECK_EQUAL(2u, tracker.GetStatistics().promotions);
+
+		// Out of anything but COMMON it takes a barrier
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_CopySource);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource, c_CopySource));
+
+		struct Case
+		{
+			RESOURCE_PROMOTION	promotion;
+			uint32_t			state;
+			bool				promoted;
+		};
+
+		const Case cases[] =
+		{
+			{ RESOURCE_PROMOTION_TEXTURE,	c_PixelShaderResource | c_NonPixelShaderResource,	true },
+			{ RESOURCE_PROMOTION_TEXTURE,	c_CopySource | c_PixelShaderResource,				true },
+			{ RESOURCE_PROMOTION_TEXTURE,	c_CopyDest,											true },
+			{ RESOURCE_PROMOTION_TEXTURE,	c_CopyDest | c_PixelShaderResource,					false },
+			{ RESOURCE_PROMOTION_TEXTURE,	c_RenderTarget,										false },
+			{ RESOURCE_PROMOTION_TEXTURE,	c_UnorderedAccess,									false },
+			{ RESOURCE_PROMOTION_ANY,		c_RenderTarget,										true },
+			{ RESOURCE_PROMOTION_ANY,		c_UnorderedAccess,									true },
+			{ RESOURCE_PROMOTION_NONE,		c_PixelShaderResource,								false },
+			{ RESOURCE_PROMOTION_NONE,		c_CopyDest,											false },
+		};
+
+		for (const auto& test : cases)
+		{
+			UnitTest::SetContext("promotion %d to 0x%x", static_cast<int>(test.promotion), test.state);
+
+			const uint32_t object = tracker.Register(1, c_Common, test.promotion);
+			tracker.Transition(object, RESOURCE_ALL_SUBRESOURCES, test.state);
+			Flush(tracker);
+			CHECK_EQUAL(test.promoted ? 0u : 1u, g_Transitions.size());
+			CHECK_EQUAL(test.state, tracker.GetState(object, 0));
+
+			// A split from COMMON is promoted too, with no BEGIN or END
+			const uint32_t split = tracker.Register(1, c_Common, test.promotion);
+			tracker.BeginTransition(split, RESOURCE_ALL_SUBRESOURCES, test.state);
+			Flush(tracker);
+			CHECK_EQUAL(test.promoted ? 0u : 1u, g_Transitions.size());
+			tracker.Transition(split, RESOURCE_ALL_SUBRESOURCES, test.state);
+			Flush(tracker);
+			CHECK_EQUAL(test.promoted ? 0u : 1u, g_Transitions.size());
+
+			tracker.Unregister(object);
+			tracker.Unregister(split);
+		}
+		UnitTest::ClearContext();
+
+		// Promoted per subresource: the one already out of COMMON takes a barrier
+		const uint32_t mixed = tracker.Register(2, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		tracker.Transition(mixed, 0, c_CopyDest);
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+		tracker.Transition(mixed, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, mixed, 0, c_CopyDest, c_PixelShaderResource));
+	}
+
+	void TestDecay()
+	{
+		ResourceStateTracker tracker;
+
+		// Read-only promotions decay; a texture promoted to COPY_DEST stays there
+		const uint32_t read = tracker.Register(1, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		const uint32_t write = tracker.Register(1, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		tracker.Transition(read, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		tracker.Transition(write, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+		tracker.Decay();
+		CHECK_EQUAL(c_Common, tracker.GetState(read, 0));
+		CHECK_EQUAL(c_CopyDest, tracker.GetState(write, 0));
+
+		// So the next list promotes it again, and a texture left in COPY_DEST takes a barrier
+		tracker.Transition(read, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		tracker.Transition(write, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, write, RESOURCE_ALL_SUBRESOURCES, c_CopyDest, c_PixelShaderResource));
+		CHECK_EQUAL(3u, tracker.GetStatistics().promotions);
+
+		// Explicit transitions on a texture don't decay
+		tracker.Transition(read, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		Flush(tracker);
+		tracker.Decay();
+		CHECK_EQUAL(c_RenderTarget, tracker.GetState(read, 0));
+		CHECK_EQUAL(c_PixelShaderResource, tracker.GetState(write, 0));
+
+		// On a copy queue everything decays, promoted or not
+		const uint32_t copied = tracker.Register(2, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		tracker.Transition(copied, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		Flush(tracker, true);
+		CHECK(g_Transitions.empty());
+		tracker.Transition(copied, 1, c_CopySource);
+		Flush(tracker, true);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		tracker.Decay();
+		CHECK_EQUAL(c_Common, tracker.GetState(copied, 0));
+		CHECK_EQUAL(c_Common, tracker.GetState(copied, 1));
+
+		// Buffers decay whatever they were moved to, promoted or not
+		const uint32_t buffer = tracker.Register(1, c_Common, RESOURCE_PROMOTION_ANY);
+		tracker.Transition(buffer, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		Flush(tracker);
+		tracker.Transition(buffer, RESOURCE_ALL_SUBRESOURCES, c_UnorderedAccess);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, buffer, RESOURCE_ALL_SUBRESOURCES, c_CopyDest, c_UnorderedAccess));
+		tracker.Decay();
+		CHECK_EQUAL(c_Common, tracker.GetState(buffer, 0));
+
+		// Only what was flushed since the last Decay goes back
+		const uint32_t texture = tracker.Register(1, c_Common, RESOURCE_PROMOTION_TEXTURE);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		tracker.Decay();
+		tracker.Decay();
+		CHECK_EQUAL(c_Common, tracker.GetState(texture, 0));
+
+		// A request for COMMON made before the decay needs nothing once it has happened
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_Common);
+		tracker.Decay();
+		Flush(tracker);
+		CHECK(g_Transitions.empty());
+
+		// A split still open is left alone
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource);
+		Flush(tracker);
+		tracker.BeginTransition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		Flush(tracker);
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource, c_RenderTarget, RESOURCE_TRANSITION_BEGIN));
+		tracker.Decay();
+		tracker.Transition(texture, RESOURCE_ALL_SUBRESOURCES, c_RenderTarget);
+		Flush(tracker);
+		CHECK_EQUAL(1u, g_Transitions.size());
+		CHECK(IsTransition(0, texture, RESOURCE_ALL_SUBRESOURCES, c_PixelShaderResource, c_RenderTarget, RESOURCE_TRANSITION_END));
+
+		// An object unregistered before the decay is forgotten, and its handle reused cleanly
+		tracker.Transition(buffer, RESOURCE_ALL_SUBRESOURCES, c_CopyDest);
+		Flush(tracker);
+		tracker.Unregister(buffer);
+		tracker.Decay();
+		const uint32_t reused = tracker.Register(1, c_RenderTarget, RESOURCE_PROMOTION_ANY);
+		CHECK_EQUAL(buffer, reused);
+		tracker.Decay();
+		CHECK_EQUAL(c_RenderTarget, tracker.GetState(reused, 0));
+	}
+}
+
+
+int main()
+{
+	TestWholeResource();
+	TestSubresources();
+	TestSplitBarriers();
+	TestPromotion();
+	TestDecay();
+
+	return UnitTest::Report("ResourceStateTrackerTest");
+}
@@ -0,0 +1,254 @@
+//--------------------------------------------------------------------------------------
+// File: TLSFAllocatorTest.cpp
+//
+// Checks TLSFAllocator: bad requests, alignment from 1 byte to 64 KB, neighbouring free
+// blocks merging back into one, and a long randomized run of allocations and frees
+// checked against a shadow copy of every live range for overlap, alignment, bounds and
+// the statistics. Built from the repo root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\TLSFAllocatorTest.cpp TLSFAllocator.cpp
+//   g++ -std=c++14 -I. Tools/Tests/TLSFAllocatorTest.cpp TLSFAllocator.cpp
+//--------------------------------------------------------------------------------------
+
+#include "TLSFAllocator.h"
+#include "UnitTest.h"
+
+#include <iterator>
+#include <map>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint64_t c_HeapSize = 64 * 1024 * 1024;
+
+	struct LiveRange
+	{
+		uint64_t	size;
+		uint32_t	allocation;
+	};
+
+	// The allocations live in allocator, keyed by offset
+	typedef std::map<uint64_t, LiveRange> LiveRanges;
+
+	uint32_t g_Seed = 12345;
+
+	uint32_t Random(uint32_t range)
+	{
+		g_Seed = g_Seed * 1664525u + 1013904223u;
+		return (g_Seed >> 8) % range;
+	}
+
+	// Sizes from a few bytes to a few MB, most of them small as placed resources are
+	uint64_t RandomSize()
+	{
+		const uint32_t log2 = Random(8) ? 4 + Random(14) : 18 + Random(5);
+		return (uint64_t(1) << log2) + Random(1u << log2);
+	}
+
+	bool Overlaps(const LiveRanges& live, uint64_t offset, uint64_t size)
+	{
+		auto next = live.lower_bound(offset);
+		if (next != live.end() && next->first < offset + size)
+			return true;
+		if (next != live.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second.size > offset)
+				return true;
+		}
+		return false;
+	}
+
+	void TestBadRequests()
+	{
+		TLSFAllocator allocator(c_HeapSize);
+		uint64_t offset = 1;
+
+		CHECK_EQUAL(0u, allocator.Allocate(0, 16, offset));
+		CHECK_EQUAL(0u, allocator.Allocate(16, 0, offset));
+		CHECK_EQUAL(0u, allocator.Allocate(16, 3, offset));
+		CHECK_EQUAL(0u, allocator.Allocate(c_HeapSize + 1, 1, offset));
+		CHECK_EQUAL(0u, allocator.Allocate(~uint64_t(0), 1, offset));
+		CHECK(allocator.IsEmpty());
+
+		// Freeing nothing, or what was never handed out, is ignored
+		allocator.Free(0);
+		allocator.Free(1000);
+		CHECK_EQUAL(0u, allocator.GetOffset(1000));
+
+		// The whole range, then nothing more
+		const uint32_t whole = allocator.Allocate(c_HeapSize, 65536, offset);
+		CHECK(whole != 0);
+		CHECK_EQUAL(0u, offset);
+		CHECK_EQUAL(0u, allocator.Allocate(1, 1, offset));
+		CHECK_EQUAL(0u, allocator.GetStatistics().freeBlocks);
+
+		// Freed twice: the second is ignored
+		allocator.Free(whole);
+		allocator.Free(whole);
+		CHECK(allocator.IsEmpty());
+		CHECK_EQUAL(c_HeapSize, allocator.GetStatistics().largestFreeBlock);
+
+		TLSFAllocator empty(0);
+		CHECK_EQUAL(0u, empty.Allocate(1, 1, offset));
+		CHECK_EQUAL(0u, empty.GetStatistics().freeBlocks);
+	}
+
+	void TestAlignment()
+	{
+		TLSFAllocator allocator(c_HeapSize);
+
+		// An odd size first, so nothing after it starts aligned by accident
+		uint64_t offset = 0;
+		CHECK(allocator.Allocate(3, 1, offset) != 0);
+
+		for (uint64_t alignment = 1; alignment <= 65536; alignment <<= 1)
+		{
+			UnitTest::SetContext("alignment %llu", static_cast<unsigned long long>(alignment));
+
+			const uint32_t allocation = allocator.Allocate(alignment + 5, alignment, offset);
+			CHECK(allocation != 0);
+			CHECK_EQUAL(0u, offset & (alignment - 1));
+			CHECK_EQUAL(offset, allocator.GetOffset(allocation));
+		}
+		UnitTest::ClearContext();
+
+		// The padding in front of the aligned allocations went back as free blocks
+		const TLSFStatistics stats = allocator.GetStatistics();
+		CHECK_EQUAL(18u, stats.allocations);
+		CHECK(stats.freeBlocks > 1);
+	}
+
+	void TestMerge()
+	{
+		TLSFAllocator allocator(4096);
+		uint64_t offsets[4] = {};
+		uint32_t allocations[4] = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			allocations[i] = allocator.Allocate(1024, 1024, offsets[i]);
+			CHECK_EQUAL(uint64_t(i) * 1024, offsets[i]);
+		}
+		CHECK_EQUAL(4096u, allocator.GetStatistics().usedBytes);
+
+		// Two free neighbours make one block
+		allocator.Free(allocations[1]);
+		allocator.Free(allocations[2]);
+		TLSFStatistics stats = allocator.GetStatistics();
+		CHECK_EQUAL(1u, stats.freeBlocks);
+		CHECK_EQUAL(2048u, stats.largestFreeBlock);
+
+		uint64_t offset = 0;
+		const uint32_t middle = allocator.Allocate(2048, 1, offset);
+		CHECK(middle != 0);
+		CHECK_EQUAL(1024u, offset);
+		allocator.Free(middle);
+
+		// Freeing the ends merges both ways, back to the whole range
+		allocator.Free(allocations[0]);
+		allocator.Free(allocations[3]);
+		stats = allocator.GetStatistics();
+		CHECK(allocator.IsEmpty());
+		CHECK_EQUAL(1u, stats.freeBlocks);
+		CHECK_EQUAL(4096u, stats.largestFreeBlock);
+		CHECK_EQUAL(0u, stats.usedBytes);
+	}
+
+	void TestRandomized()
+	{
+		TLSFAllocator allocator(c_HeapSize);
+		LiveRanges live;
+		std::vector<uint64_t> offsets;
+		uint64_t usedBytes = 0;
+		uint32_t failures = 0;
+
+		for (uint32_t step = 0; step < 200000; ++step)
+		{
+			// Phases of mostly allocating and mostly freeing, so the heap fills up and
+			// drains several times over
+			const bool fill = ((step / 20000) & 1) == 0;
+			if (!live.empty() && Random(100) < (fill ? 30u : 70u))
+			{
+				const size_t index = Random(static_cast<uint32_t>(offsets.size()));
+				const auto it = live.find(offsets[index]);
+				if (!CHECK(it != live.end()))
+					return;
+
+				allocator.Free(it->second.allocation);
+				usedBytes -= it->second.size;
+				live.erase(it);
+				offsets[index] = offsets.back();
+				offsets.pop_back();
+				continue;
+			}
+
+			const uint64_t size = RandomSize();
+			const uint64_t alignment = uint64_t(1) << Random(17);
+			const uint64_t largestFree = allocator.GetStatistics().largestFreeBlock;
+
+			uint64_t offset = 0;
+			const uint32_t allocation = allocator.Allocate(size, alignment, offset);
+			if (!allocation)
+			{
+				// A block with room for any padding, even rounded up to its list, always fits
+				if (!CHECK(largestFree < 2 * (size + alignment)))
+					return;
+
+				++failures;
+				continue;
+			}
+
+			UnitTest::SetContext("step %u, size %llu, alignment %llu at %llu", step,
+				static_cast<unsigned long long>(size), static_cast<unsigned long long>(alignment),
+				static_cast<unsigned long long>(offset));
+
+			if (!CHECK_EQUAL(0u, offset & (alignment - 1))
+				|| !CHECK(offset + size <= c_HeapSize)
+				|| !CHECK(!Overlaps(live, offset, size)))
+				return;
+
+			CHECK_EQUAL(offset, allocator.GetOffset(allocation));
+			UnitTest::ClearContext();
+
+			const LiveRange range = { size, allocation };
+			live[offset] = range;
+			offsets.push_back(offset);
+			usedBytes += size;
+
+			if ((step & 1023) == 0)
+			{
+				const TLSFStatistics stats = allocator.GetStatistics();
+				CHECK_EQUAL(usedBytes, stats.usedBytes);
+				CHECK_EQUAL(live.size(), stats.allocations);
+				CHECK(stats.largestFreeBlock <= c_HeapSize - usedBytes);
+			}
+		}
+
+		// Some requests should have found the heap too full or fragmented
+		CHECK(failures > 0);
+
+		for (const auto& range : live)
+		{
+			allocator.Free(range.second.allocation);
+		}
+
+		const TLSFStatistics stats = allocator.GetStatistics();
+		CHECK(allocator.IsEmpty());
+		CHECK_EQUAL(0u, stats.usedBytes);
+		CHECK_EQUAL(1u, stats.freeBlocks);
+		CHECK_EQUAL(c_HeapSize, stats.largestFreeBlock);
+	}
+}
+
+
+int main()
+{
+	TestBadRequests();
+	TestAlignment();
+	TestMerge();
+	TestRandomized();
+
+	return UnitTest::Report("TLSFAllocatorTest");
+}
@@ -0,0 +1,403 @@
+//--------------------------------------------------------------------------------------
+// File: TextureFootprintsTest.cpp
+//
+// Checks GetCopyableFootprints12 against a table of the footprints
+// ID3D12Device::GetCopyableFootprints reports: offsets, formats, sizes, row pitches, row
+// counts, row sizes and total bytes. The table covers BC, planar, depth, 3D, array and
+// odd-sized textures, subresource ranges and the 512-byte placement of a base offset.
+//
+// On Windows, -device also checks the table and GetCopyableFootprints12 against the
+// device for every subresource of every row, and -record prints the device's footprints
+// in the table's own layout. Built from the repo root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\TextureFootprintsTest.cpp TextureFootprints.cpp d3d12.lib dxgi.lib
+//   g++ -std=c++14 -I. -I<DirectX-Headers>/include/directx -I<DirectX-Headers>/include/wsl/stubs
+//       Tools/Tests/TextureFootprintsTest.cpp TextureFootprints.cpp
+//--------------------------------------------------------------------------------------
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <dxgi1_4.h>
+#include <wrl.h>
+#endif
+
+#include "TextureFootprints.h"
+#include "UnitTest.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	struct ExpectedFootprint
+	{
+		UINT			subresource;
+		UINT64			offset;
+		DXGI_FORMAT		format;         // UNKNOWN: not compared (depth, see below)
+		UINT			width;
+		UINT			height;
+		UINT			depth;
+		UINT			rowPitch;
+		UINT			numRows;
+		UINT64			rowSize;
+	};
+
+	struct FootprintCase
+	{
+		const char*					name;
+		D3D12_RESOURCE_DIMENSION	dimension;
+		UINT64						width;
+		UINT						height;
+		UINT16						depthOrArraySize;
+		UINT16						mipLevels;
+		DXGI_FORMAT					format;
+		UINT						firstSubresource;
+		UINT						numSubresources;
+		UINT64						baseOffset;
+		UINT64						totalBytes;
+		std::vector<ExpectedFootprint>	footprints;    // Any subset of the range
+	};
+
+	// Whether a device reports a depth format or its typeless twin for the depth plane is
+	// left to the -device comparison, so those rows only check the sizes
+	const FootprintCase g_Cases[] =
+	{
+		{ "R8G8B8A8 500x500", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 500, 500, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 1, 0, 1023952,
+			{
+				{ 0,      0, DXGI_FORMAT_R8G8B8A8_UNORM, 500, 500, 1, 2048, 500, 2000 },
+			} },
+		{ "R8G8B8A8 500x500 at 1024", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 500, 500, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 1, 1024, 1023952,
+			{
+				{ 0,   1024, DXGI_FORMAT_R8G8B8A8_UNORM, 500, 500, 1, 2048, 500, 2000 },
+			} },
+		{ "R8G8B8A8 256x256 full chain", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 256, 256, 1, 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 9, 0, 359940,
+			{
+				{ 0,      0, DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1024, 256, 1024 },
+				{ 1, 262144, DXGI_FORMAT_R8G8B8A8_UNORM, 128, 128, 1,  512, 128,  512 },
+				{ 2, 327680, DXGI_FORMAT_R8G8B8A8_UNORM,  64,  64, 1,  256,  64,  256 },
+				{ 3, 344064, DXGI_FORMAT_R8G8B8A8_UNORM,  32,  32, 1,  256,  32,  128 },
+				{ 4, 352256, DXGI_FORMAT_R8G8B8A8_UNORM,  16,  16, 1,  256,  16,   64 },
+				{ 5, 356352, DXGI_FORMAT_R8G8B8A8_UNORM,   8,   8, 1,  256,   8,   32 },
+				{ 6, 358400, DXGI_FORMAT_R8G8B8A8_UNORM,   4,   4, 1,  256,   4,   16 },
+				{ 7, 359424, DXGI_FORMAT_R8G8B8A8_UNORM,   2,   2, 1,  256,   2,    8 },
+				{ 8, 359936, DXGI_FORMAT_R8G8B8A8_UNORM,   1,   1, 1,  256,   1,    4 },
+			} },
+		{ "R8G8B8A8 256x256 mips 3-4", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 256, 256, 1, 0, DXGI_FORMAT_R8G8B8A8_UNORM, 3, 2, 0, 12096,
+			{
+				{ 3,      0, DXGI_FORMAT_R8G8B8A8_UNORM,  32,  32, 1,  256,  32,  128 },
+				{ 4,   8192, DXGI_FORMAT_R8G8B8A8_UNORM,  16,  16, 1,  256,  16,   64 },
+			} },
+		{ "R8 33x17", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 33, 17, 1, 2, DXGI_FORMAT_R8_UNORM, 0, 2, 0, 6416,
+			{
+				{ 0,      0, DXGI_FORMAT_R8_UNORM,        33,  17, 1,  256,  17,   33 },
+				{ 1,   4608, DXGI_FORMAT_R8_UNORM,        16,   8, 1,  256,   8,   16 },
+			} },
+		{ "BC1 13x7", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 13, 7, 1, 4, DXGI_FORMAT_BC1_UNORM, 0, 4, 0, 1544,
+			{
+				{ 0,      0, DXGI_FORMAT_BC1_UNORM,       16,   8, 1,  256,   2,   32 },
+				{ 1,    512, DXGI_FORMAT_BC1_UNORM,        8,   4, 1,  256,   1,   16 },
+				{ 2,   1024, DXGI_FORMAT_BC1_UNORM,        4,   4, 1,  256,   1,    8 },
+				{ 3,   1536, DXGI_FORMAT_BC1_UNORM,        4,   4, 1,  256,   1,    8 },
+			} },
+		{ "BC7 64x64 x3 array", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 64, 64, 3, 2, DXGI_FORMAT_BC7_UNORM_SRGB, 0, 6, 0, 18304,
+			{
+				{ 0,      0, DXGI_FORMAT_BC7_UNORM_SRGB,  64,  64, 1,  256,  16,  256 },
+				{ 1,   4096, DXGI_FORMAT_BC7_UNORM_SRGB,  32,  32, 1,  256,   8,  128 },
+				{ 2,   6144, DXGI_FORMAT_BC7_UNORM_SRGB,  64,  64, 1,  256,  16,  256 },
+				{ 3,  10240, DXGI_FORMAT_BC7_UNORM_SRGB,  32,  32, 1,  256,   8,  128 },
+				{ 4,  12288, DXGI_FORMAT_BC7_UNORM_SRGB,  64,  64, 1,  256,  16,  256 },
+				{ 5,  16384, DXGI_FORMAT_BC7_UNORM_SRGB,  32,  32, 1,  256,   8,  128 },
+			} },
+		{ "R16G16B16A16F 32x16x8 volume", D3D12_RESOURCE_DIMENSION_TEXTURE3D, 32, 16, 8, 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, 6, 0, 44040,
+			{
+				{ 0,      0, DXGI_FORMAT_R16G16B16A16_FLOAT, 32, 16, 8, 256, 16,  256 },
+				{ 1,  32768, DXGI_FORMAT_R16G16B16A16_FLOAT, 16,  8, 4, 256,  8,  128 },
+				{ 2,  40960, DXGI_FORMAT_R16G16B16A16_FLOAT,  8,  4, 2, 256,  4,   64 },
+				{ 3,  43008, DXGI_FORMAT_R16G16B16A16_FLOAT,  4,  2, 1, 256,  2,   32 },
+				{ 4,  43520, DXGI_FORMAT_R16G16B16A16_FLOAT,  2,  1, 1, 256,  1,   16 },
+				{ 5,  44032, DXGI_FORMAT_R16G16B16A16_FLOAT,  1,  1, 1, 256,  1,    8 },
+			} },
+		{ "R32F 1000 x2 1D array", D3D12_RESOURCE_DIMENSION_TEXTURE1D, 1000, 1, 2, 1, DXGI_FORMAT_R32_FLOAT, 0, 2, 0, 8096,
+			{
+				{ 0,      0, DXGI_FORMAT_R32_FLOAT,     1000,   1, 1, 4096,   1, 4000 },
+				{ 1,   4096, DXGI_FORMAT_R32_FLOAT,     1000,   1, 1, 4096,   1, 4000 },
+			} },
+		{ "NV12 64x32", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 64, 32, 1, 1, DXGI_FORMAT_NV12, 0, 2, 0, 12096,
+			{
+				{ 0,      0, DXGI_FORMAT_R8_TYPELESS,     64,  32, 1,  256,  32,   64 },
+				{ 1,   8192, DXGI_FORMAT_R8G8_TYPELESS,   32,  16, 1,  256,  16,   64 },
+			} },
+		{ "P010 16x16 x2 array", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 16, 16, 2, 1, DXGI_FORMAT_P010, 0, 4, 0, 12064,
+			{
+				{ 0,      0, DXGI_FORMAT_R16_TYPELESS,    16,  16, 1,  256,  16,   32 },
+				{ 1,   4096, DXGI_FORMAT_R16_TYPELESS,    16,  16, 1,  256,  16,   32 },
+				{ 2,   8192, DXGI_FORMAT_R16G16_TYPELESS,  8,   8, 1,  256,   8,   32 },
+				{ 3,  10240, DXGI_FORMAT_R16G16_TYPELESS,  8,   8, 1,  256,   8,   32 },
+			} },
+		{ "D32_FLOAT 640x480", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 640, 480, 1, 1, DXGI_FORMAT_D32_FLOAT, 0, 1, 0, 1228800,
+			{
+				{ 0,      0, DXGI_FORMAT_UNKNOWN,        640, 480, 1, 2560, 480, 2560 },
+			} },
+		{ "D16_UNORM 100x100", D3D12_RESOURCE_DIMENSION_TEXTURE2D, 100, 100, 1, 1, DXGI_FORMAT_D16_UNORM, 0, 1, 0, 25544,
+			{
+				{ 0,      0, DXGI_FORMAT_UNKNOWN,        100, 100, 1,  256, 100,  200 },
+			} },
+	};
+
+	D3D12_RESOURCE_DESC GetDesc(const FootprintCase& test)
+	{
+		D3D12_RESOURCE_DESC desc;
+		memset(&desc, 0, sizeof(desc));
+		desc.Dimension = test.dimension;
+		desc.Width = test.width;
+		desc.Height = test.height;
+		desc.DepthOrArraySize = test.depthOrArraySize;
+		desc.MipLevels = test.mipLevels;
+		desc.Format = test.format;
+		desc.SampleDesc.Count = 1;
+		return desc;
+	}
+
+	struct Footprints
+	{
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>	layouts;
+		std::vector<UINT>								numRows;
+		std::vector<UINT64>								rowSizes;
+		UINT64											totalBytes;
+
+		explicit Footprints(UINT count) : layouts(count), numRows(count), rowSizes(count), totalBytes(0) {}
+	};
+
+	// Checks computed footprints against one case of the table
+	void CheckFootprints(const FootprintCase& test, const Footprints& actual, const char* source)
+	{
+		UnitTest::SetContext("%s: %s", source, test.name);
+		CHECK_EQUAL(test.totalBytes, actual.totalBytes);
+
+		for (const auto& expected : test.footprints)
+		{
+			UnitTest::SetContext("%s: %s, subresource %u", source, test.name, expected.subresource);
+			if (!CHECK(expected.subresource >= test.firstSubresource && expected.subresource - test.firstSubresource < test.numSubresources))
+				continue;
+
+			const UINT i = expected.subresource - test.firstSubresource;
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = actual.layouts[i];
+			CHECK_EQUAL(expected.offset, layout.Offset);
+			if (expected.format != DXGI_FORMAT_UNKNOWN)
+			{
+				CHECK_EQUAL(expected.format, layout.Footprint.Format);
+			}
+			CHECK_EQUAL(expected.width, layout.Footprint.Width);
+			CHECK_EQUAL(expected.height, layout.Footprint.Height);
+			CHECK_EQUAL(expected.depth, layout.Footprint.Depth);
+			CHECK_EQUAL(expected.rowPitch, layout.Footprint.RowPitch);
+			CHECK_EQUAL(expected.numRows, actual.numRows[i]);
+			CHECK_EQUAL(expected.rowSize, actual.rowSizes[i]);
+		}
+
+		UnitTest::ClearContext();
+	}
+
+	void TestTable()
+	{
+		for (const auto& test : g_Cases)
+		{
+			const D3D12_RESOURCE_DESC desc = GetDesc(test);
+
+			Footprints actual(test.numSubresources);
+			const HRESULT hr = GetCopyableFootprints12(desc, test.firstSubresource, test.numSubresources, test.baseOffset,
+				actual.layouts.data(), actual.numRows.data(), actual.rowSizes.data(), &actual.totalBytes);
+
+			UnitTest::SetContext("%s", test.name);
+			if (CHECK(SUCCEEDED(hr)))
+			{
+				CheckFootprints(test, actual, "GetCopyableFootprints12");
+			}
+			UnitTest::ClearContext();
+
+			// Every output is optional, and the total doesn't depend on the others
+			UINT64 totalBytes = 0;
+			CHECK(SUCCEEDED(GetCopyableFootprints12(desc, test.firstSubresource, test.numSubresources, test.baseOffset,
+				nullptr, nullptr, nullptr, &totalBytes)));
+			CHECK_EQUAL(test.totalBytes, totalBytes);
+		}
+	}
+
+	void TestInvalidArguments()
+	{
+		D3D12_RESOURCE_DESC desc = GetDesc(g_Cases[0]);
+		UINT64 totalBytes = 0;
+
+		// The base offset has to keep subresources on 512-byte boundaries
+		CHECK(GetCopyableFootprints12(desc, 0, 1, 256, nullptr, nullptr, nullptr, &totalBytes) == E_INVALIDARG);
+		CHECK_EQUAL(UINT64(-1), totalBytes);
+		CHECK(SUCCEEDED(GetCopyableFootprints12(desc, 0, 1, 512, nullptr, nullptr, nullptr, &totalBytes)));
+
+		// Past the last subresource, and an empty range
+		CHECK(GetCopyableFootprints12(desc, 1, 1, 0, nullptr, nullptr, nullptr, &totalBytes) == E_INVALIDARG);
+		CHECK(GetCopyableFootprints12(desc, 0, 0, 0, nullptr, nullptr, nullptr, &totalBytes) == E_INVALIDARG);
+
+		desc.SampleDesc.Count = 4;
+		CHECK(GetCopyableFootprints12(desc, 0, 1, 0, nullptr, nullptr, nullptr, &totalBytes) == E_INVALIDARG);
+		desc.SampleDesc.Count = 1;
+
+		desc.Width = 0;
+		CHECK(GetCopyableFootprints12(desc, 0, 1, 0, nullptr, nullptr, nullptr, &totalBytes) == E_INVALIDARG);
+		CHECK_EQUAL(UINT64(0), GetRequiredIntermediateSize12(desc, 0, 1));
+	}
+
+	void TestDepthStencil()
+	{
+		// A stencil plane's copy format is up to the hardware; the device has to be asked
+		const DXGI_FORMAT formats[] =
+		{
+			DXGI_FORMAT_D24_UNORM_S8_UINT,
+			DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+			DXGI_FORMAT_R24G8_TYPELESS,
+		};
+
+		for (DXGI_FORMAT format : formats)
+		{
+			D3D12_RESOURCE_DESC desc = GetDesc(g_Cases[0]);
+			desc.Format = format;
+
+			UINT64 totalBytes = 0;
+			UnitTest::SetContext("format %d", static_cast<int>(format));
+			CHECK(GetCopyableFootprints12(desc, 0, 1, 0, nullptr, nullptr, nullptr, &totalBytes) == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+			CHECK_EQUAL(UINT64(-1), totalBytes);
+		}
+
+		UnitTest::ClearContext();
+	}
+
+	void TestRequiredIntermediateSize()
+	{
+		for (const auto& test : g_Cases)
+		{
+			UnitTest::SetContext("%s", test.name);
+			CHECK_EQUAL(test.totalBytes, GetRequiredIntermediateSize12(GetDesc(test), test.firstSubresource, test.numSubresources));
+		}
+
+		UnitTest::ClearContext();
+	}
+
+#if defined(_WIN32)
+	using Microsoft::WRL::ComPtr;
+
+	ComPtr<ID3D12Device> CreateDevice()
+	{
+		ComPtr<ID3D12Device> device;
+		if (SUCCEEDED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+			return device;
+
+		ComPtr<IDXGIFactory4> factory;
+		ComPtr<IDXGIAdapter> warpAdapter;
+		if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))) &&
+			SUCCEEDED(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter))))
+		{
+			D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
+		}
+
+		return device;
+	}
+
+	Footprints GetDeviceFootprints(ID3D12Device* device, const FootprintCase& test)
+	{
+		const D3D12_RESOURCE_DESC desc = GetDesc(test);
+
+		Footprints footprints(test.numSubresources);
+		device->GetCopyableFootprints(&desc, test.firstSubresource, test.numSubresources, test.baseOffset,
+			footprints.layouts.data(), footprints.numRows.data(), footprints.rowSizes.data(), &footprints.totalBytes);
+		return footprints;
+	}
+
+	// The table against the device, then GetCopyableFootprints12 against the device for
+	// every subresource, not just the ones the table lists
+	void TestAgainstDevice(ID3D12Device* device)
+	{
+		for (const auto& test : g_Cases)
+		{
+			const Footprints expected = GetDeviceFootprints(device, test);
+			CheckFootprints(test, expected, "device");
+
+			Footprints actual(test.numSubresources);
+			GetCopyableFootprints12(GetDesc(test), test.firstSubresource, test.numSubresources, test.baseOffset,
+				actual.layouts.data(), actual.numRows.data(), actual.rowSizes.data(), &actual.totalBytes);
+
+			UnitTest::SetContext("device vs GetCopyableFootprints12: %s", test.name);
+			CHECK_EQUAL(expected.totalBytes, actual.totalBytes);
+			for (UINT i = 0; i < test.numSubresources; ++i)
+			{
+				UnitTest::SetContext("device vs GetCopyableFootprints12: %s, subresource %u", test.name, test.firstSubresource + i);
+				CHECK_EQUAL(expected.layouts[i].Offset, actual.layouts[i].Offset);
+				CHECK_EQUAL(expected.layouts[i].Footprint.Format, actual.layouts[i].Footprint.Format);
+				CHECK_EQUAL(expected.layouts[i].Footprint.Width, actual.layouts[i].Footprint.Width);
+				CHECK_EQUAL(expected.layouts[i].Footprint.Height, actual.layouts[i].Footprint.Height);
+				CHECK_EQUAL(expected.layouts[i].Footprint.Depth, actual.layouts[i].Footprint.Depth);
+				CHECK_EQUAL(expected.layouts[i].Footprint.RowPitch, actual.layouts[i].Footprint.RowPitch);
+				CHECK_EQUAL(expected.numRows[i], actual.numRows[i]);
+				CHECK_EQUAL(expected.rowSizes[i], actual.rowSizes[i]);
+			}
+		}
+
+		UnitTest::ClearContext();
+	}
+
+	// Prints the device's footprints as table rows, formats as their DXGI_FORMAT values
+	void RecordFromDevice(ID3D12Device* device)
+	{
+		for (const auto& test : g_Cases)
+		{
+			const Footprints footprints = GetDeviceFootprints(device, test);
+			printf("// %s: total %llu\n", test.name, static_cast<unsigned long long>(footprints.totalBytes));
+			for (UINT i = 0; i < test.numSubresources; ++i)
+			{
+				const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = footprints.layouts[i];
+				printf("{ %u, %6llu, %3d, %4u, %4u, %u, %4u, %4u, %4llu },\n", test.firstSubresource + i,
+					static_cast<unsigned long long>(layout.Offset), static_cast<int>(layout.Footprint.Format),
+					layout.Footprint.Width, layout.Footprint.Height, layout.Footprint.Depth, layout.Footprint.RowPitch,
+					footprints.numRows[i], static_cast<unsigned long long>(footprints.rowSizes[i]));
+			}
+		}
+	}
+#endif
+}
+
+
+int main(int argc, char* argv[])
+{
+#if defined(_WIN32)
+	if (argc > 1)
+	{
+		ComPtr<ID3D12Device> device = CreateDevice();
+		if (!device)
+		{
+			fprintf(stderr, "TextureFootprintsTest: can't create a D3D12 device\n");
+			return 1;
+		}
+
+		if (!strcmp(argv[1], "-record"))
+		{
+			RecordFromDevice(device.Get());
+			return 0;
+		}
+
+		if (!strcmp(argv[1], "-device"))
+		{
+			TestAgainstDevice(device.Get());
+		}
+	}
+#else
+	(void)argc;
+	(void)argv;
+#endif
+
+	TestTable();
+	TestInvalidArguments();
+	TestDepthStencil();
+	TestRequiredIntermediateSize();
+
+	return UnitTest::Report("TextureFootprintsTest");
+}
@@ -0,0 +1,405 @@
+//--------------------------------------------------------------------------------------
+// File: TilePageTableTest.cpp
+//
+// Checks TilePageTable: the tile grid of each mip, mapping coarsest first within the
+// per-frame limit, loading versus resident tiles, which tile an eviction takes and which
+// it must leave alone, requests expiring, feedback maps at several resolutions and the
+// finest-resident-mip map built from them. Built from the repo root with e.g.
+//
+//   cl /EHsc /I. Tools\Tests\TilePageTableTest.cpp TilePageTable.cpp
+//   g++ -std=c++14 -I. Tools/Tests/TilePageTableTest.cpp TilePageTable.cpp
+//--------------------------------------------------------------------------------------
+
+#include "TilePageTable.h"
+#include "UnitTest.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// 1024x1024 RGBA8 in 128x128 tiles, with the tail from mip 3: mip 0 is 8x8 tiles,
+	// mip 1 4x4 and mip 2 2x2
+	const TiledTextureDesc c_Desc = { 1024, 1024, 11, 3, 128, 128 };
+
+	std::vector<TileMapping> g_Unmappings;
+	std::vector<TileMapping> g_Mappings;
+
+	void Update(TilePageTable& table, uint32_t maxMappings = 64)
+	{
+		table.Update(maxMappings, g_Unmappings, g_Mappings);
+	}
+
+	void CompleteLoads(TilePageTable& table)
+	{
+		table.CompleteLoads(g_Mappings.data(), g_Mappings.size());
+	}
+
+	bool IsTile(const TileMapping& mapping, uint32_t mip, uint32_t x, uint32_t y)
+	{
+		return mapping.tile.mip == mip && mapping.tile.x == x && mapping.tile.y == y;
+	}
+
+	void TestInitialize()
+	{
+		TilePageTable table;
+
+		TiledTextureDesc desc = c_Desc;
+		CHECK(!table.Initialize(desc, 0));
+		desc.width = 0;
+		CHECK(!table.Initialize(desc, 16));
+		desc = c_Desc;
+		desc.packedMipStart = desc.mipCount + 1;
+		CHECK(!table.Initialize(desc, 16));
+		desc = c_Desc;
+		desc.tileHeight = 0;
+		CHECK(!table.Initialize(desc, 16));
+
+		CHECK(table.Initialize(c_Desc, 16));
+		CHECK_EQUAL(8u, table.GetTilesX(0));
+		CHECK_EQUAL(4u, table.GetTilesY(1));
+		CHECK_EQUAL(2u, table.GetTilesX(2));
+
+		// Partial tiles at the right and bottom edges count as whole ones
+		desc = c_Desc;
+		desc.width = 1000;
+		desc.height = 600;
+		CHECK(table.Initialize(desc, 16));
+		CHECK_EQUAL(8u, table.GetTilesX(0));
+		CHECK_EQUAL(5u, table.GetTilesY(0));
+		CHECK_EQUAL(4u, table.GetTilesX(1));
+		CHECK_EQUAL(3u, table.GetTilesY(1));
+		CHECK_EQUAL(2u, table.GetTilesY(2));
+
+		// The tail is always resident, and there's nothing past the last mip
+		CHECK(table.IsResident(3, 0, 0));
+		CHECK(table.IsResident(10, 0, 0));
+		CHECK(!table.IsResident(11, 0, 0));
+		CHECK(!table.IsResident(0, 8, 0));
+		CHECK_EQUAL(TILE_NOT_MAPPED, table.GetPhysicalTile(0, 0, 5));
+
+		const TilePageTableStatistics stats = table.GetStatistics();
+		CHECK_EQUAL(16u, stats.freePhysicalTiles);
+		CHECK_EQUAL(0u, stats.resident);
+	}
+
+	void TestMapAndLoad()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 16));
+
+		// A tile brings every coarser tile above it, and they map coarsest first
+		table.RequestTile(0, 5, 6);
+		CHECK_EQUAL(3u, table.GetStatistics().queued);
+
+		Update(table);
+		CHECK(g_Unmappings.empty());
+		if (CHECK_EQUAL(size_t(3), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Mappings[0], 2, 1, 1));
+			CHECK(IsTile(g_Mappings[1], 1, 2, 3));
+			CHECK(IsTile(g_Mappings[2], 0, 5, 6));
+			CHECK_EQUAL(0u, g_Mappings[0].physicalTile);
+			CHECK_EQUAL(1u, g_Mappings[1].physicalTile);
+			CHECK_EQUAL(2u, g_Mappings[2].physicalTile);
+		}
+
+		// Mapped, but not usable until the copies land
+		TilePageTableStatistics stats = table.GetStatistics();
+		CHECK_EQUAL(uint64_t(3), stats.requests);
+		CHECK_EQUAL(uint64_t(3), stats.mapped);
+		CHECK_EQUAL(3u, stats.loading);
+		CHECK_EQUAL(0u, stats.resident);
+		CHECK_EQUAL(0u, stats.queued);
+		CHECK_EQUAL(13u, stats.freePhysicalTiles);
+		CHECK_EQUAL(2u, table.GetPhysicalTile(0, 5, 6));
+		CHECK(!table.IsResident(0, 5, 6));
+
+		// A completion for a physical tile the tile no longer holds is ignored
+		TileMapping stale = g_Mappings[2];
+		stale.physicalTile = 7;
+		table.CompleteLoads(&stale, 1);
+		CHECK(!table.IsResident(0, 5, 6));
+
+		CompleteLoads(table);
+		stats = table.GetStatistics();
+		CHECK_EQUAL(3u, stats.resident);
+		CHECK_EQUAL(0u, stats.loading);
+		CHECK(table.IsResident(0, 5, 6));
+		CHECK(table.IsResident(2, 1, 1));
+
+		// Already mapped: another request maps nothing
+		table.RequestTile(0, 5, 6);
+		Update(table);
+		CHECK(g_Mappings.empty());
+		CHECK_EQUAL(uint64_t(3), table.GetStatistics().requests);
+	}
+
+	void TestMappingLimit()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 16));
+
+		table.RequestTile(0, 0, 0);
+		Update(table, 1);
+		if (CHECK_EQUAL(size_t(1), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Mappings[0], 2, 0, 0));
+		}
+		CHECK_EQUAL(2u, table.GetStatistics().queued);
+
+		// The rest wait for the next frame, if they are still wanted
+		table.RequestTile(0, 0, 0);
+		Update(table, 1);
+		if (CHECK_EQUAL(size_t(1), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Mappings[0], 1, 0, 0));
+		}
+
+		// Not requested again, so it expires
+		Update(table, 1);
+		CHECK(g_Mappings.empty());
+		CHECK_EQUAL(0u, table.GetStatistics().queued);
+
+		// And counts as a new request when it comes back
+		table.RequestTile(0, 0, 0);
+		CHECK_EQUAL(uint64_t(4), table.GetStatistics().requests);
+		Update(table);
+		if (CHECK_EQUAL(size_t(1), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Mappings[0], 0, 0, 0));
+		}
+
+		// A limit of zero maps nothing but keeps the requests of this frame
+		table.RequestTile(0, 1, 0);
+		Update(table, 0);
+		CHECK(g_Mappings.empty());
+		CHECK_EQUAL(1u, table.GetStatistics().queued);
+	}
+
+	void TestEviction()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 4));
+
+		// Frame 1 fills three tiles with a chain, frame 2 the last one
+		table.RequestTile(0, 0, 0);
+		Update(table);
+		CompleteLoads(table);
+
+		table.RequestTile(0, 1, 0);
+		Update(table);
+		CHECK(g_Unmappings.empty());
+		CHECK_EQUAL(size_t(1), g_Mappings.size());
+		CompleteLoads(table);
+		CHECK_EQUAL(0u, table.GetStatistics().freePhysicalTiles);
+
+		// The pool is full: the least recently used leaf goes, (0, 0) from frame 1
+		table.RequestTile(0, 0, 1);
+		Update(table);
+		if (CHECK_EQUAL(size_t(1), g_Unmappings.size()) && CHECK_EQUAL(size_t(1), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Unmappings[0], 0, 0, 0));
+			CHECK(IsTile(g_Mappings[0], 0, 0, 1));
+			CHECK_EQUAL(g_Unmappings[0].physicalTile, g_Mappings[0].physicalTile);
+		}
+		CHECK_EQUAL(TILE_NOT_MAPPED, table.GetPhysicalTile(0, 0, 0));
+		CHECK(!table.IsResident(0, 0, 0));
+		CompleteLoads(table);
+
+		// Then (1, 0) from frame 2
+		table.RequestTile(0, 1, 1);
+		Update(table);
+		if (CHECK_EQUAL(size_t(1), g_Unmappings.size()))
+		{
+			CHECK(IsTile(g_Unmappings[0], 0, 1, 0));
+		}
+		CompleteLoads(table);
+
+		const TilePageTableStatistics stats = table.GetStatistics();
+		CHECK_EQUAL(uint64_t(2), stats.evicted);
+		CHECK_EQUAL(uint64_t(6), stats.mapped);
+		CHECK_EQUAL(4u, stats.resident);
+	}
+
+	void TestEvictionKeepsParents()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 3));
+
+		table.RequestTile(0, 0, 0);
+		Update(table);
+		CompleteLoads(table);
+
+		// mip 2 (0, 0) and mip 1 (0, 0) are older in the LRU order but have a mapped tile
+		// below them, so the mip 0 leaf is the one that goes
+		table.RequestTile(2, 1, 0);
+		Update(table);
+		if (CHECK_EQUAL(size_t(1), g_Unmappings.size()) && CHECK_EQUAL(size_t(1), g_Mappings.size()))
+		{
+			CHECK(IsTile(g_Unmappings[0], 0, 0, 0));
+			CHECK(IsTile(g_Mappings[0], 2, 1, 0));
+		}
+		CompleteLoads(table);
+
+		// Now mip 1 (0, 0) is a leaf, and the oldest one
+		table.RequestTile(2, 1, 1);
+		Update(table);
+		if (CHECK_EQUAL(size_t(1), g_Unmappings.size()))
+		{
+			CHECK(IsTile(g_Unmappings[0], 1, 0, 0));
+		}
+	}
+
+	void TestEvictionSkipsBusyTiles()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 3));
+
+		// Loading tiles have a copy in flight
+		table.RequestTile(0, 0, 0);
+		Update(table);
+		table.RequestTile(2, 1, 0);
+		Update(table);
+		CHECK(g_Unmappings.empty());
+		CHECK(g_Mappings.empty());
+		CHECK_EQUAL(1u, table.GetStatistics().queued);
+
+		// Tiles used this frame may be sampled by it
+		TilePageTable used;
+		CHECK(used.Initialize(c_Desc, 3));
+		used.RequestTile(0, 0, 0);
+		Update(used);
+		CompleteLoads(used);
+
+		used.RequestTile(0, 0, 0);
+		used.RequestTile(2, 1, 0);
+		Update(used);
+		CHECK(g_Unmappings.empty());
+		CHECK(g_Mappings.empty());
+
+		// The next frame they are fair game again
+		used.RequestTile(2, 1, 0);
+		Update(used);
+		CHECK_EQUAL(size_t(1), g_Unmappings.size());
+		CHECK_EQUAL(size_t(1), g_Mappings.size());
+	}
+
+	void CheckResidencyMap(const TilePageTable& table, const char* const expected[8])
+	{
+		std::vector<uint8_t> residency;
+		table.GetResidencyMap(residency);
+		if (!CHECK_EQUAL(size_t(64), residency.size()))
+			return;
+
+		for (uint32_t y = 0; y < 8; ++y)
+		{
+			char row[9] = {};
+			for (uint32_t x = 0; x < 8; ++x)
+			{
+				row[x] = static_cast<char>('0' + residency[y * 8 + x]);
+			}
+
+			UnitTest::SetContext("residency row %u: %s, expected %s", y, row, expected[y]);
+			CHECK(!strcmp(row, expected[y]));
+		}
+
+		UnitTest::ClearContext();
+	}
+
+	void TestFeedback()
+	{
+		TilePageTable table;
+		CHECK(table.Initialize(c_Desc, 64));
+
+		// Nothing resident: every region falls back to the tail
+		const char* const empty[8] =
+		{
+			"33333333", "33333333", "33333333", "33333333", "33333333", "33333333", "33333333", "33333333",
+		};
+		CheckResidencyMap(table, empty);
+
+		// One region per mip 0 tile. Mips in the tail are ignored.
+		uint8_t minMips[8][8];
+		memset(minMips, TILE_FEEDBACK_NONE, sizeof(minMips));
+		minMips[5][3] = 0;
+		minMips[0][0] = 1;
+		minMips[7][7] = 7;
+
+		table.AddFeedback(&minMips[0][0], 8, 8, 8);
+		CHECK_EQUAL(5u, table.GetStatistics().queued);
+
+		Update(table);
+		if (CHECK_EQUAL(size_t(5), g_Mappings.size()))
+		{
+			CHECK_EQUAL(2u, g_Mappings[0].tile.mip);
+			CHECK_EQUAL(2u, g_Mappings[1].tile.mip);
+			CHECK_EQUAL(0u, g_Mappings[4].tile.mip);
+		}
+		CHECK_EQUAL(TILE_NOT_MAPPED, table.GetPhysicalTile(0, 0, 0));
+		CHECK(table.GetPhysicalTile(0, 3, 5) != TILE_NOT_MAPPED);
+		CHECK(table.GetPhysicalTile(1, 0, 0) != TILE_NOT_MAPPED);
+
+		// Loading tiles don't count yet
+		CheckResidencyMap(table, empty);
+
+		CompleteLoads(table);
+		const char* const resident[8] =
+		{
+			"11223333",
+			"11223333",
+			"22223333",
+			"22223333",
+			"22113333",
+			"22103333",
+			"22223333",
+			"22223333",
+		};
+		CheckResidencyMap(table, resident);
+
+		// Coarser feedback: a region covers 2x2 tiles of mip 0
+		TilePageTable coarse;
+		CHECK(coarse.Initialize(c_Desc, 64));
+		uint8_t coarseMips[4][4];
+		memset(coarseMips, TILE_FEEDBACK_NONE, sizeof(coarseMips));
+		coarseMips[1][1] = 0;
+		coarse.AddFeedback(&coarseMips[0][0], 4, 4, 4);
+		CHECK_EQUAL(6u, coarse.GetStatistics().queued);
+		Update(coarse);
+		CHECK(coarse.GetPhysicalTile(0, 2, 2) != TILE_NOT_MAPPED);
+		CHECK(coarse.GetPhysicalTile(0, 3, 3) != TILE_NOT_MAPPED);
+		CHECK(coarse.GetPhysicalTile(1, 1, 1) != TILE_NOT_MAPPED);
+		CHECK(coarse.GetPhysicalTile(2, 0, 0) != TILE_NOT_MAPPED);
+
+		// Finer feedback, with padding between rows: several regions share a tile
+		TilePageTable fine;
+		CHECK(fine.Initialize(c_Desc, 64));
+		std::vector<uint8_t> fineMips(16 * 20, TILE_FEEDBACK_NONE);
+		fineMips[15 * 20 + 15] = 0;
+		fineMips[15 * 20 + 14] = 0;
+		fineMips[0] = 2;
+		fine.AddFeedback(fineMips.data(), 16, 16, 20);
+		CHECK_EQUAL(4u, fine.GetStatistics().queued);
+		Update(fine);
+		CHECK(fine.GetPhysicalTile(0, 7, 7) != TILE_NOT_MAPPED);
+		CHECK(fine.GetPhysicalTile(1, 3, 3) != TILE_NOT_MAPPED);
+		CHECK(fine.GetPhysicalTile(2, 1, 1) != TILE_NOT_MAPPED);
+		CHECK(fine.GetPhysicalTile(2, 0, 0) != TILE_NOT_MAPPED);
+	}
+}
+
+
+int main()
+{
+	TestInitialize();
+	TestMapAndLoad();
+	TestMappingLimit();
+	TestEviction();
+	TestEvictionKeepsParents();
+	TestEvictionSkipsBusyTiles();
+	TestFeedback();
+
+	return UnitTest::Report("TilePageTableTest");
+}
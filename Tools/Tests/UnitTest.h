@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// File: UnitTest.h
+//
+// Checks for the standalone test programs in this directory. A failed check prints where
+// and what failed and carries on, so one run lists every failure; main ends with
+// UnitTest::Report, which returns non-zero when anything failed.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace UnitTest
+{
+	struct State
+	{
+		unsigned int	checks;
+		unsigned int	failures;
+		char			context[256];   // Printed with each failure, e.g. the table row
+	};
+
+	inline State& GetState()
+	{
+		static State state = {};
+		return state;
+	}
+
+	// Describes what the checks that follow are looking at, printf-style
+	inline void SetContext(const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		vsnprintf(GetState().context, sizeof(GetState().context), format, args);
+		va_end(args);
+	}
+
+	inline void ClearContext()
+	{
+		GetState().context[0] = '\0';
+	}
+
+	inline bool Check(bool passed, const char* expression, const char* file, int line)
+	{
+		State& state = GetState();
+		++state.checks;
+		if (!passed)
+		{
+			++state.failures;
+			fprintf(stderr, "%s(%d): %s%scheck failed: %s\n", file, line,
+				state.context, state.context[0] ? ": " : "", expression);
+		}
+		return passed;
+	}
+
+	// Values are printed as integers, which covers the sizes, offsets and handles tested
+	template <typename T, typename U>
+	bool CheckEqual(const T& expected, const U& actual, const char* expression, const char* file, int line)
+	{
+		State& state = GetState();
+		++state.checks;
+		if (expected == actual)
+			return true;
+
+		++state.failures;
+		fprintf(stderr, "%s(%d): %s%s%s: expected %lld, got %lld\n", file, line,
+			state.context, state.context[0] ? ": " : "", expression,
+			static_cast<long long>(expected), static_cast<long long>(actual));
+		return false;
+	}
+
+	inline int Report(const char* name)
+	{
+		const State& state = GetState();
+		printf("%s: %u checks, %u failed\n", name, state.checks, state.failures);
+		return state.failures ? 1 : 0;
+	}
+}
+
+#define CHECK(expression) \
+	UnitTest::Check(!!(expression), #expression, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+	UnitTest::CheckEqual((expected), (actual), #actual, __FILE__, __LINE__)
@@ -0,0 +1,123 @@
+//--------------------------------------------------------------------------------------
+// File: UploadRingBuffer.cpp
+//
+// Linear ring allocator over one persistently mapped UPLOAD buffer. Allocations are
+// handed out in order and reclaimed in order once the fence value of the submission
+// that consumed them has completed.
+//--------------------------------------------------------------------------------------
+
+#include "UploadRingBuffer.h"
+#include "d3dx12.h"
+
+#include <exception>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void ThrowIfFailed(HRESULT hr)
+	{
+		if (FAILED(hr))
+		{
+			throw std::exception();
+		}
+	}
+}
+
+UploadRingBuffer::UploadRingBuffer(ID3D12Device* device, UINT64 size) :
+	m_cpuBase(nullptr),
+	m_gpuBase(0),
+	m_size(size),
+	m_head(0),
+	m_tail(0),
+	m_submitted(0)
+{
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_buffer)));
+
+	// Mapped for the lifetime of the ring; upload heaps are write-combined, never read back.
+	CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
+	ThrowIfFailed(m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_cpuBase)));
+
+	m_gpuBase = m_buffer->GetGPUVirtualAddress();
+}
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+	if (m_buffer)
+	{
+		m_buffer->Unmap(0, nullptr);
+	}
+}
+
+HRESULT UploadRingBuffer::Allocate(UINT64 size, UINT64 alignment, UploadAllocation& allocation)
+{
+	allocation = {};
+
+	if (alignment == 0)
+		alignment = 1;
+
+	if ((alignment & (alignment - 1)) || alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+		return E_INVALIDARG;
+
+	if (size == 0 || size > m_size)
+		return E_OUTOFMEMORY;
+
+	UINT64 position = m_head;
+	UINT64 offset = position % m_size;
+	UINT64 aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+	if (aligned + size > m_size)
+	{
+		// Doesn't fit before the end of the buffer: skip the tail end and wrap to offset 0
+		position += m_size - offset;
+		offset = 0;
+		aligned = 0;
+	}
+
+	const UINT64 newHead = position + (aligned - offset) + size;
+	if (newHead - m_tail > m_size)
+	{
+		Reclaim();
+		if (newHead - m_tail > m_size)
+			return E_OUTOFMEMORY;
+	}
+
+	m_head = newHead;
+
+	allocation.resource = m_buffer.Get();
+	allocation.offset = aligned;
+	allocation.cpuAddress = m_cpuBase + aligned;
+	allocation.gpuAddress = m_gpuBase + aligned;
+
+	return S_OK;
+}
+
+void UploadRingBuffer::Submit(ID3D12Fence* fence, UINT64 fenceValue)
+{
+	if (m_head == m_submitted)
+		return;
+
+	Submission submission = { fence, fenceValue, m_head };
+	m_submissions.push_back(submission);
+	m_submitted = m_head;
+}
+
+void UploadRingBuffer::Reclaim()
+{
+	while (!m_submissions.empty())
+	{
+		const Submission& submission = m_submissions.front();
+		if (submission.fence->GetCompletedValue() < submission.fenceValue)
+			break;
+
+		m_tail = submission.head;
+		m_submissions.pop_front();
+	}
+}
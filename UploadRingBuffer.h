@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------
+// File: UploadRingBuffer.h
+//
+// Linear ring allocator over one persistently mapped UPLOAD buffer. Allocations are
+// handed out in order and reclaimed in order once the fence value of the submission
+// that consumed them has completed.
+//
+// Not thread-safe: use it from the thread that submits to the queue.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <deque>
+#include <stdint.h>
+
+namespace DirectX
+{
+	struct UploadAllocation
+	{
+		ID3D12Resource*				resource;		// The ring's buffer
+		UINT64						offset;			// Byte offset into resource
+		uint8_t*					cpuAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS	gpuAddress;
+	};
+
+	class UploadRingBuffer
+	{
+	public:
+		UploadRingBuffer(_In_ ID3D12Device* device, UINT64 size);
+		~UploadRingBuffer();
+
+		UploadRingBuffer(const UploadRingBuffer&) = delete;
+		UploadRingBuffer& operator=(const UploadRingBuffer&) = delete;
+
+		// alignment must be a power of two no larger than 64KB. Returns E_OUTOFMEMORY when
+		// the space is still in use by the GPU or the request is larger than the ring.
+		HRESULT Allocate(UINT64 size, UINT64 alignment, _Out_ UploadAllocation& allocation);
+
+		// Everything allocated since the previous Submit is reclaimed once fence reaches
+		// fenceValue. Call after the command lists that read those allocations are queued.
+		void Submit(_In_ ID3D12Fence* fence, UINT64 fenceValue);
+
+		// Releases the space of every submission whose fence has completed.
+		void Reclaim();
+
+		ID3D12Resource* GetResource() const { return m_buffer.Get(); }
+		UINT64 GetSize() const { return m_size; }
+		UINT64 GetUsedSize() const { return m_head - m_tail; }
+
+	private:
+		struct Submission
+		{
+			Microsoft::WRL::ComPtr<ID3D12Fence>	fence;
+			UINT64								fenceValue;
+			UINT64								head;
+		};
+
+		Microsoft::WRL::ComPtr<ID3D12Resource>	m_buffer;
+		uint8_t*								m_cpuBase;
+		D3D12_GPU_VIRTUAL_ADDRESS				m_gpuBase;
+		UINT64									m_size;
+
+		// Monotonic byte positions; the physical offset is position % m_size
+		UINT64									m_head;		// next free byte
+		UINT64									m_tail;		// oldest byte still in use
+		UINT64									m_submitted;	// head as of the last Submit
+
+		std::deque<Submission>					m_submissions;
+	};
+}